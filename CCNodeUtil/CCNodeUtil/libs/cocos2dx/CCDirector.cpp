@@ -36,6 +36,7 @@ THE SOFTWARE.
 #include "textures/CCTextureCache.h"
 #include "sprite_nodes/CCSpriteFrameCache.h"
 #include "cocoa/CCAutoreleasePool.h"
+#include "cocoa/CCObjectPool.h"
 #include "platform/platform.h"
 #include "platform/CCFileUtils.h"
 #include "CCApplication.h"
@@ -53,6 +54,9 @@ THE SOFTWARE.
 #include "kazmath/kazmath.h"
 #include "kazmath/GL/matrix.h"
 #include "support/CCProfiling.h"
+#include "support/CCJobSystem.h"
+#include "support/CCUploadScheduler.h"
+#include "particle_nodes/CCParticleSystem.h"
 #include "CCEGLView.h"
 #include <string>
 
@@ -214,6 +218,12 @@ void CCDirector::drawScene(void)
         m_pScheduler->update(m_fDeltaTime);
     }
 
+    // particle systems stepped on the job system must be done before anything is drawn
+    CCParticleSystem::syncParallelUpdate();
+
+    // uploads which were postponed to keep the previous frames smooth
+    CCUploadScheduler::sharedUploadScheduler()->processUploads();
+
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     /* to avoid flickr, nextScene MUST be here: after tick and before draw.
@@ -397,6 +407,7 @@ void CCDirector::purgeCachedData(void)
         CCTextureCache::sharedTextureCache()->removeUnusedTextures();
     }
     CCFileUtils::sharedFileUtils()->purgeCachedEntries();
+    CCObjectPool::purgeAllPools();
 }
 
 float CCDirector::getZEye(void)
@@ -634,6 +645,13 @@ void CCDirector::purgeDirector()
     // purge bitmap cache
     CCLabelBMFont::purgeCachedData();
 
+    // particle systems still waiting for their step
+    CCParticleSystem::purgePendingUpdates();
+
+    // stop the worker threads before the caches their jobs may refer to go away
+    CCJobSystem::purgeSharedJobSystem();
+    CCUploadScheduler::purgeSharedUploadScheduler();
+
     // purge all managed caches
     CCAnimationCache::purgeSharedAnimationCache();
     CCSpriteFrameCache::purgeSharedSpriteFrameCache();
@@ -31,6 +31,7 @@ THE SOFTWARE.
 #include "support/data_support/ccCArray.h"
 #include "cocoa/CCArray.h"
 #include "script_support/CCScriptSupport.h"
+#include "support/CCJobSystem.h"
 
 using namespace std;
 
@@ -775,6 +776,9 @@ void CCScheduler::resumeTargets(CCSet* pTargetsToResume)
 // main loop
 void CCScheduler::update(float dt)
 {
+    // hand the results of jobs finished on worker threads to the main thread
+    CCJobSystem::dispatchCompletedJobs();
+
     m_bUpdateHashLocked = true;
 
     if (m_fTimeScale != 1.0f)
@@ -28,6 +28,7 @@ THE SOFTWARE.
 #define __CCSCHEDULER_H__
 
 #include "cocoa/CCObject.h"
+#include "cocoa/CCObjectPool.h"
 #include "support/data_support/uthash.h"
 
 NS_CC_BEGIN
@@ -51,6 +52,7 @@ class CCSet;
 //
 class CC_DLL CCTimer : public CCObject
 {
+    CC_POOLED_ALLOCATION(timerPool)
 public:
     CCTimer(void);
     
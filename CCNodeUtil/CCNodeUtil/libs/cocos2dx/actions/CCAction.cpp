@@ -40,6 +40,7 @@ CCAction::CCAction()
 :m_pOriginalTarget(NULL)
 ,m_pTarget(NULL)
 ,m_nTag(kCCActionTagInvalid)
+,m_uTweenSlot(kCCActionTweenSlotNone)
 {
 }
 
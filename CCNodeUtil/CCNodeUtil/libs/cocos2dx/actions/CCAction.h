@@ -28,6 +28,7 @@ THE SOFTWARE.
 #define __ACTIONS_CCACTION_H__
 
 #include "cocoa/CCObject.h"
+#include "cocoa/CCObjectPool.h"
 #include "cocoa/CCGeometry.h"
 #include "platform/CCPlatformMacros.h"
 
@@ -38,6 +39,9 @@ enum {
     kCCActionTagInvalid = -1,
 };
 
+//! Tween slot of actions that are not batched by CCActionManager
+#define kCCActionTweenSlotNone 0xffffffff
+
 /**
  * @addtogroup actions
  * @{
@@ -48,6 +52,7 @@ enum {
  */
 class CC_DLL CCAction : public CCObject 
 {
+    CC_POOLED_ALLOCATION(actionPool)
 public:
     CCAction(void);
     virtual ~CCAction(void);
@@ -109,6 +114,10 @@ protected:
     CCNode    *m_pTarget;
     /** The action tag. An identifier of the action */
     int     m_nTag;
+
+    friend class CCActionManager;
+    /** slot of the action in the CCActionManager tween batches, kCCActionTweenSlotNone when it is stepped through step() */
+    unsigned int m_uTweenSlot;
 };
 
 /** 
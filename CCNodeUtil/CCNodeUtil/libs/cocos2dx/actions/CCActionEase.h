@@ -62,6 +62,7 @@ public:
     static CCActionEase* create(CCActionInterval *pAction);
 
 protected:
+    friend class CCActionManager;
     /** The inner action */
     CCActionInterval *m_pInner;
 };
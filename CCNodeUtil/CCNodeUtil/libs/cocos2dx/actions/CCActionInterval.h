@@ -87,6 +87,7 @@ public:
     float getAmplitudeRate(void);
 
 protected:
+    friend class CCActionManager;
     float m_elapsed;
     bool   m_bFirstTick;
 };
@@ -270,6 +271,7 @@ public:
     virtual void update(float time);
     
 protected:
+    friend class CCActionManager;
     float m_fDstAngleX;
     float m_fStartAngleX;
     float m_fDiffAngleX;
@@ -325,6 +327,7 @@ public:
     /** creates the action */
     static CCMoveBy* create(float duration, const CCPoint& deltaPosition);
 protected:
+    friend class CCActionManager;
     CCPoint m_positionDelta;
     CCPoint m_startPosition;
     CCPoint m_previousPosition;
@@ -507,6 +510,7 @@ public:
     /** creates the action with and X factor and a Y factor */
     static CCScaleTo* create(float duration, float sx, float sy);
 protected:
+    friend class CCActionManager;
     float m_fScaleX;
     float m_fScaleY;
     float m_fStartScaleX;
@@ -608,6 +612,7 @@ public:
     /** creates an action with duration and opacity */
     static CCFadeTo* create(float duration, GLubyte opacity);
 protected:
+    friend class CCActionManager;
     GLubyte m_toOpacity;
     GLubyte m_fromOpacity;
 };
@@ -630,6 +635,7 @@ public:
     /** creates an action with duration and color */
     static CCTintTo* create(float duration, GLubyte red, GLubyte green, GLubyte blue);
 protected:
+    friend class CCActionManager;
     ccColor3B m_to;
     ccColor3B m_from;
 };
@@ -26,12 +26,17 @@ THE SOFTWARE.
 ****************************************************************************/
 
 #include "CCActionManager.h"
+#include "CCActionInterval.h"
+#include "CCActionEase.h"
+#include "support/CCPointExtension.h"
 #include "base_nodes/CCNode.h"
 #include "CCScheduler.h"
 #include "ccMacros.h"
 #include "support/data_support/ccCArray.h"
 #include "support/data_support/uthash.h"
 #include "cocoa/CCSet.h"
+#include <typeinfo>
+#include <vector>
 
 NS_CC_BEGIN
 //
@@ -45,15 +50,158 @@ typedef struct _hashElement
     CCAction                    *currentAction;
     bool                        currentActionSalvaged;
     bool                        paused;
+    unsigned int                tweens;         // how many of the actions are stepped by the tween batches
     UT_hash_handle                hh;
 } tHashElement;
 
+//
+// tween batches
+//
+enum {
+    kCCTweenMove,
+    kCCTweenScale,
+    kCCTweenRotate,
+    kCCTweenFade,
+    kCCTweenTint,
+    // removed while the batches were locked, swept at the end of updateTweens
+    kCCTweenDead,
+};
+
+// every batch holds the tweens sharing one easing curve
+enum {
+    kCCTweenEaseLinear,
+    kCCTweenEaseIn,
+    kCCTweenEaseOut,
+    kCCTweenEaseInOut,
+    kCCTweenEaseSineIn,
+    kCCTweenEaseSineOut,
+    kCCTweenEaseSineInOut,
+    kCCTweenEaseExponentialIn,
+    kCCTweenEaseExponentialOut,
+    kCCTweenEaseExponentialInOut,
+    kCCTweenEaseCount,
+};
+
+#define kCCTweenChannels    4
+#define kCCTweenIndexBits   24
+#define kCCTweenIndexMask   ((1 << kCCTweenIndexBits) - 1)
+
+// Structure of arrays, one element per running tween
+typedef struct _tweenBatch
+{
+    std::vector<CCActionInterval*>  actions;        // the action as added to the manager (the ease, if eased)
+    std::vector<CCNode*>            targets;
+    std::vector<CCRGBAProtocol*>    rgba;           // fade and tint targets, cast once
+    std::vector<tHashElement*>      elements;
+    std::vector<unsigned char>      kinds;
+    std::vector<unsigned char>      active;         // 1 if the target is not paused, refreshed every frame
+    std::vector<unsigned char>      firstTick;
+    std::vector<float>              elapsed;
+    std::vector<float>              duration;
+    std::vector<float>              rate;           // of the rate eases, read from the action every frame
+    std::vector<float>              time;           // eased, 0..1
+    std::vector<float>              from[kCCTweenChannels];
+    std::vector<float>              delta[kCCTweenChannels];
+    std::vector<float>              value[kCCTweenChannels];
+} tTweenBatch;
+
+static int tweenKindOfAction(CCActionInterval *pAction)
+{
+    const std::type_info& type = typeid(*pAction);
+
+    if (type == typeid(CCMoveTo) || type == typeid(CCMoveBy))
+    {
+        return kCCTweenMove;
+    }
+    if (type == typeid(CCScaleTo) || type == typeid(CCScaleBy))
+    {
+        return kCCTweenScale;
+    }
+    if (type == typeid(CCRotateTo))
+    {
+        return kCCTweenRotate;
+    }
+    if (type == typeid(CCFadeTo))
+    {
+        return kCCTweenFade;
+    }
+    if (type == typeid(CCTintTo))
+    {
+        return kCCTweenTint;
+    }
+    return -1;
+}
+
+static int tweenEasingOfAction(CCActionInterval *pAction)
+{
+    const std::type_info& type = typeid(*pAction);
+
+    if (type == typeid(CCEaseIn))               return kCCTweenEaseIn;
+    if (type == typeid(CCEaseOut))              return kCCTweenEaseOut;
+    if (type == typeid(CCEaseInOut))            return kCCTweenEaseInOut;
+    if (type == typeid(CCEaseSineIn))           return kCCTweenEaseSineIn;
+    if (type == typeid(CCEaseSineOut))          return kCCTweenEaseSineOut;
+    if (type == typeid(CCEaseSineInOut))        return kCCTweenEaseSineInOut;
+    if (type == typeid(CCEaseExponentialIn))    return kCCTweenEaseExponentialIn;
+    if (type == typeid(CCEaseExponentialOut))   return kCCTweenEaseExponentialOut;
+    if (type == typeid(CCEaseExponentialInOut)) return kCCTweenEaseExponentialInOut;
+    return -1;
+}
+
+// Same curves as the CCActionEase subclasses, one loop per curve so the compiler can vectorize them
+static void easeTweenBatch(int easing, float *t, const float *rate, unsigned int n)
+{
+    unsigned int i;
+    switch (easing)
+    {
+    case kCCTweenEaseIn:
+        for (i = 0; i < n; ++i) t[i] = powf(t[i], rate[i]);
+        break;
+    case kCCTweenEaseOut:
+        for (i = 0; i < n; ++i) t[i] = powf(t[i], 1 / rate[i]);
+        break;
+    case kCCTweenEaseInOut:
+        for (i = 0; i < n; ++i)
+        {
+            float x = t[i] * 2;
+            t[i] = x < 1 ? 0.5f * powf(x, rate[i]) : 1.0f - 0.5f * powf(2 - x, rate[i]);
+        }
+        break;
+    case kCCTweenEaseSineIn:
+        for (i = 0; i < n; ++i) t[i] = -1 * cosf(t[i] * (float)M_PI_2) + 1;
+        break;
+    case kCCTweenEaseSineOut:
+        for (i = 0; i < n; ++i) t[i] = sinf(t[i] * (float)M_PI_2);
+        break;
+    case kCCTweenEaseSineInOut:
+        for (i = 0; i < n; ++i) t[i] = -0.5f * (cosf((float)M_PI * t[i]) - 1);
+        break;
+    case kCCTweenEaseExponentialIn:
+        for (i = 0; i < n; ++i) t[i] = t[i] == 0 ? 0 : powf(2, 10 * (t[i]/1 - 1)) - 1 * 0.001f;
+        break;
+    case kCCTweenEaseExponentialOut:
+        for (i = 0; i < n; ++i) t[i] = t[i] == 1 ? 1 : (-powf(2, -10 * t[i] / 1) + 1);
+        break;
+    case kCCTweenEaseExponentialInOut:
+        for (i = 0; i < n; ++i)
+        {
+            float x = t[i] / 0.5f;
+            t[i] = x < 1 ? 0.5f * powf(2, 10 * (x - 1)) : 0.5f * (-powf(2, -10 * (x - 1)) + 2);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
 CCActionManager::CCActionManager(void)
 : m_pTargets(NULL), 
   m_pCurrentTarget(NULL),
-  m_bCurrentTargetSalvaged(false)
+  m_bCurrentTargetSalvaged(false),
+  m_pTweenBatches(NULL),
+  m_bTweensLocked(false)
 {
-
+    m_pTweenBatches = new tTweenBatch[kCCTweenEaseCount];
 }
 
 CCActionManager::~CCActionManager(void)
@@ -61,12 +209,18 @@ CCActionManager::~CCActionManager(void)
     CCLOGINFO("cocos2d: deallocing %p", this);
 
     removeAllActions();
+
+    CC_SAFE_DELETE_ARRAY(m_pTweenBatches);
 }
 
 // private
 
 void CCActionManager::deleteHashElement(tHashElement *pElement)
 {
+    if (pElement->tweens > 0)
+    {
+        removeTweensFromHashElement(pElement);
+    }
     ccArrayFree(pElement->actions);
     HASH_DEL(m_pTargets, pElement);
     pElement->target->release();
@@ -91,6 +245,11 @@ void CCActionManager::removeActionAtIndex(unsigned int uIndex, tHashElement *pEl
 {
     CCAction *pAction = (CCAction*)pElement->actions->arr[uIndex];
 
+    if (pAction->m_uTweenSlot != kCCActionTweenSlotNone)
+    {
+        removeTween(pAction);
+    }
+
     if (pAction == pElement->currentAction && (! pElement->currentActionSalvaged))
     {
         pElement->currentAction->retain();
@@ -192,6 +351,10 @@ void CCActionManager::addAction(CCAction *pAction, CCNode *pTarget, bool paused)
      ccArrayAppendObject(pElement->actions, pAction);
  
      pAction->startWithTarget(pTarget);
+
+#if CC_ACTION_MANAGER_BATCH_TWEENS
+     addTween(pAction, pElement);
+#endif
 }
 
 // remove
@@ -224,6 +387,10 @@ void CCActionManager::removeAllActionsFromTarget(CCObject *pTarget)
             pElement->currentActionSalvaged = true;
         }
 
+        if (pElement->tweens > 0)
+        {
+            removeTweensFromHashElement(pElement);
+        }
         ccArrayRemoveAllObjects(pElement->actions);
         if (m_pCurrentTarget == pElement)
         {
@@ -343,14 +510,16 @@ void CCActionManager::update(float dt)
         m_pCurrentTarget = elt;
         m_bCurrentTargetSalvaged = false;
 
-        if (! m_pCurrentTarget->paused)
+        // targets running nothing but batched tweens have nothing to step here
+        if (! m_pCurrentTarget->paused && m_pCurrentTarget->tweens < m_pCurrentTarget->actions->num)
         {
             // The 'actions' CCMutableArray may change while inside this loop.
             for (m_pCurrentTarget->actionIndex = 0; m_pCurrentTarget->actionIndex < m_pCurrentTarget->actions->num;
                 m_pCurrentTarget->actionIndex++)
             {
                 m_pCurrentTarget->currentAction = (CCAction*)m_pCurrentTarget->actions->arr[m_pCurrentTarget->actionIndex];
-                if (m_pCurrentTarget->currentAction == NULL)
+                if (m_pCurrentTarget->currentAction == NULL
+                    || m_pCurrentTarget->currentAction->m_uTweenSlot != kCCActionTweenSlotNone)
                 {
                     continue;
                 }
@@ -393,6 +562,384 @@ void CCActionManager::update(float dt)
 
     // issue #635
     m_pCurrentTarget = NULL;
+
+    updateTweens(dt);
+}
+
+// tweens
+
+bool CCActionManager::addTween(CCAction *pAction, tHashElement *pElement)
+{
+    CCActionInterval *pOuter = dynamic_cast<CCActionInterval*>(pAction);
+    if (pOuter == NULL)
+    {
+        return false;
+    }
+
+    int easing = kCCTweenEaseLinear;
+    float rate = 1.0f;
+    CCActionInterval *pTween = pOuter;
+
+    int kind = tweenKindOfAction(pOuter);
+    if (kind < 0)
+    {
+        easing = tweenEasingOfAction(pOuter);
+        if (easing < 0)
+        {
+            return false;
+        }
+
+        pTween = ((CCActionEase*)pOuter)->m_pInner;
+        kind = tweenKindOfAction(pTween);
+        if (kind < 0)
+        {
+            return false;
+        }
+
+        CCEaseRateAction *pRateAction = dynamic_cast<CCEaseRateAction*>(pOuter);
+        if (pRateAction)
+        {
+            rate = pRateAction->getRate();
+        }
+    }
+
+    CCNode *pTarget = pAction->getTarget();
+    CCRGBAProtocol *pRGBA = NULL;
+    float from[kCCTweenChannels] = { 0, 0, 0, 0 };
+    float delta[kCCTweenChannels] = { 0, 0, 0, 0 };
+
+    switch (kind)
+    {
+    case kCCTweenMove:
+        {
+            CCMoveBy *pMove = (CCMoveBy*)pTween;
+            from[0] = pMove->m_startPosition.x;
+            from[1] = pMove->m_startPosition.y;
+            delta[0] = pMove->m_positionDelta.x;
+            delta[1] = pMove->m_positionDelta.y;
+            // channels 2 and 3 hold the position set on the previous frame, see CCMoveBy::update
+            from[2] = pMove->m_previousPosition.x;
+            from[3] = pMove->m_previousPosition.y;
+        }
+        break;
+    case kCCTweenScale:
+        {
+            CCScaleTo *pScale = (CCScaleTo*)pTween;
+            from[0] = pScale->m_fStartScaleX;
+            from[1] = pScale->m_fStartScaleY;
+            delta[0] = pScale->m_fDeltaX;
+            delta[1] = pScale->m_fDeltaY;
+        }
+        break;
+    case kCCTweenRotate:
+        {
+            CCRotateTo *pRotate = (CCRotateTo*)pTween;
+            from[0] = pRotate->m_fStartAngleX;
+            from[1] = pRotate->m_fStartAngleY;
+            delta[0] = pRotate->m_fDiffAngleX;
+            delta[1] = pRotate->m_fDiffAngleY;
+        }
+        break;
+    case kCCTweenFade:
+        {
+            pRGBA = dynamic_cast<CCRGBAProtocol*>(pTarget);
+            if (pRGBA == NULL)
+            {
+                // nothing to animate, let the generic path run it out
+                return false;
+            }
+            CCFadeTo *pFade = (CCFadeTo*)pTween;
+            from[0] = pFade->m_fromOpacity;
+            delta[0] = (float)(pFade->m_toOpacity - pFade->m_fromOpacity);
+        }
+        break;
+    case kCCTweenTint:
+        {
+            pRGBA = dynamic_cast<CCRGBAProtocol*>(pTarget);
+            if (pRGBA == NULL)
+            {
+                return false;
+            }
+            CCTintTo *pTint = (CCTintTo*)pTween;
+            from[0] = pTint->m_from.r;
+            from[1] = pTint->m_from.g;
+            from[2] = pTint->m_from.b;
+            delta[0] = (float)(pTint->m_to.r - pTint->m_from.r);
+            delta[1] = (float)(pTint->m_to.g - pTint->m_from.g);
+            delta[2] = (float)(pTint->m_to.b - pTint->m_from.b);
+        }
+        break;
+    }
+
+    tTweenBatch& batch = m_pTweenBatches[easing];
+    unsigned int uIndex = batch.actions.size();
+    CCAssert(uIndex <= kCCTweenIndexMask, "Too many running tweens");
+
+    batch.actions.push_back(pOuter);
+    batch.targets.push_back(pTarget);
+    batch.rgba.push_back(pRGBA);
+    batch.elements.push_back(pElement);
+    batch.kinds.push_back((unsigned char)kind);
+    batch.active.push_back(1);
+    batch.firstTick.push_back(pOuter->m_bFirstTick ? 1 : 0);
+    batch.elapsed.push_back(pOuter->m_elapsed);
+    batch.duration.push_back(pOuter->getDuration());
+    batch.rate.push_back(rate);
+    batch.time.push_back(0);
+    for (int c = 0; c < kCCTweenChannels; ++c)
+    {
+        batch.from[c].push_back(from[c]);
+        batch.delta[c].push_back(delta[c]);
+        batch.value[c].push_back(from[c]);
+    }
+
+    pAction->m_uTweenSlot = ((unsigned int)easing << kCCTweenIndexBits) | uIndex;
+    pElement->tweens++;
+
+    return true;
+}
+
+void CCActionManager::removeTween(CCAction *pAction)
+{
+    unsigned int uSlot = pAction->m_uTweenSlot;
+    CCAssert(uSlot != kCCActionTweenSlotNone, "");
+
+    tTweenBatch& batch = m_pTweenBatches[uSlot >> kCCTweenIndexBits];
+    unsigned int uIndex = uSlot & kCCTweenIndexMask;
+
+    pAction->m_uTweenSlot = kCCActionTweenSlotNone;
+    batch.elements[uIndex]->tweens--;
+
+    if (m_bTweensLocked)
+    {
+        // updateTweens is walking the batch, only mark it
+        batch.kinds[uIndex] = kCCTweenDead;
+        batch.actions[uIndex] = NULL;
+        batch.elements[uIndex] = NULL;
+    }
+    else
+    {
+        eraseTween(uSlot >> kCCTweenIndexBits, uIndex);
+    }
+}
+
+void CCActionManager::eraseTween(int easing, unsigned int uIndex)
+{
+    tTweenBatch& batch = m_pTweenBatches[easing];
+
+    // swap with the last tween
+    unsigned int uLast = batch.actions.size() - 1;
+    if (uIndex != uLast)
+    {
+        batch.actions[uIndex] = batch.actions[uLast];
+        batch.targets[uIndex] = batch.targets[uLast];
+        batch.rgba[uIndex] = batch.rgba[uLast];
+        batch.elements[uIndex] = batch.elements[uLast];
+        batch.kinds[uIndex] = batch.kinds[uLast];
+        batch.active[uIndex] = batch.active[uLast];
+        batch.firstTick[uIndex] = batch.firstTick[uLast];
+        batch.elapsed[uIndex] = batch.elapsed[uLast];
+        batch.duration[uIndex] = batch.duration[uLast];
+        batch.rate[uIndex] = batch.rate[uLast];
+        batch.time[uIndex] = batch.time[uLast];
+        for (int c = 0; c < kCCTweenChannels; ++c)
+        {
+            batch.from[c][uIndex] = batch.from[c][uLast];
+            batch.delta[c][uIndex] = batch.delta[c][uLast];
+            batch.value[c][uIndex] = batch.value[c][uLast];
+        }
+
+        if (batch.actions[uIndex])
+        {
+            batch.actions[uIndex]->m_uTweenSlot = ((unsigned int)easing << kCCTweenIndexBits) | uIndex;
+        }
+    }
+
+    batch.actions.pop_back();
+    batch.targets.pop_back();
+    batch.rgba.pop_back();
+    batch.elements.pop_back();
+    batch.kinds.pop_back();
+    batch.active.pop_back();
+    batch.firstTick.pop_back();
+    batch.elapsed.pop_back();
+    batch.duration.pop_back();
+    batch.rate.pop_back();
+    batch.time.pop_back();
+    for (int c = 0; c < kCCTweenChannels; ++c)
+    {
+        batch.from[c].pop_back();
+        batch.delta[c].pop_back();
+        batch.value[c].pop_back();
+    }
+}
+
+void CCActionManager::removeTweensFromHashElement(tHashElement *pElement)
+{
+    for (unsigned int i = 0; i < pElement->actions->num && pElement->tweens > 0; ++i)
+    {
+        CCAction *pAction = (CCAction*)pElement->actions->arr[i];
+        if (pAction->m_uTweenSlot != kCCActionTweenSlotNone)
+        {
+            removeTween(pAction);
+        }
+    }
+}
+
+void CCActionManager::updateTweens(float dt)
+{
+    std::vector<CCAction*> finished;
+
+    for (int easing = 0; easing < kCCTweenEaseCount; ++easing)
+    {
+        tTweenBatch& batch = m_pTweenBatches[easing];
+        unsigned int n = batch.actions.size();
+        if (n == 0)
+        {
+            continue;
+        }
+
+        unsigned char *active = &batch.active[0];
+        unsigned char *firstTick = &batch.firstTick[0];
+        float *elapsed = &batch.elapsed[0];
+        const float *duration = &batch.duration[0];
+        float *time = &batch.time[0];
+        unsigned int i;
+
+        for (i = 0; i < n; ++i)
+        {
+            active[i] = (batch.kinds[i] != kCCTweenDead && ! batch.elements[i]->paused) ? 1 : 0;
+        }
+
+        // setRate() may be called on a running action
+        if (easing == kCCTweenEaseIn || easing == kCCTweenEaseOut || easing == kCCTweenEaseInOut)
+        {
+            for (i = 0; i < n; ++i)
+            {
+                if (active[i])
+                {
+                    batch.rate[i] = ((CCEaseRateAction*)batch.actions[i])->getRate();
+                }
+            }
+        }
+
+        // same as CCActionInterval::step, for the whole batch
+        for (i = 0; i < n; ++i)
+        {
+            float e = firstTick[i] ? 0 : elapsed[i] + dt;
+            elapsed[i] = active[i] ? e : elapsed[i];
+            firstTick[i] = active[i] ? 0 : firstTick[i];
+            time[i] = MAX(0, MIN(1, elapsed[i] / MAX(duration[i], FLT_EPSILON)));
+        }
+
+        easeTweenBatch(easing, time, &batch.rate[0], n);
+
+        for (int c = 0; c < kCCTweenChannels; ++c)
+        {
+            const float *from = &batch.from[c][0];
+            const float *delta = &batch.delta[c][0];
+            float *value = &batch.value[c][0];
+            for (i = 0; i < n; ++i)
+            {
+                value[i] = from[i] + delta[i] * time[i];
+            }
+        }
+
+        // setters may run arbitrary code, removals are deferred until the batch is done.
+        // Tweens added by a setter may reallocate the batch, so it is indexed from here on.
+        m_bTweensLocked = true;
+
+        for (i = 0; i < n; ++i)
+        {
+            if (! batch.active[i] || batch.kinds[i] == kCCTweenDead)
+            {
+                continue;
+            }
+
+            CCNode *pTarget = batch.targets[i];
+            m_pCurrentTarget = batch.elements[i];
+            m_bCurrentTargetSalvaged = false;
+
+            switch (batch.kinds[i])
+            {
+            case kCCTweenMove:
+                {
+                    // stackable like CCMoveBy: carry over whatever moved the node since the last frame
+                    const CCPoint& currentPos = pTarget->getPosition();
+                    float driftX = currentPos.x - batch.from[2][i];
+                    float driftY = currentPos.y - batch.from[3][i];
+                    batch.from[0][i] += driftX;
+                    batch.from[1][i] += driftY;
+                    CCPoint newPos = ccp(batch.value[0][i] + driftX, batch.value[1][i] + driftY);
+                    batch.from[2][i] = newPos.x;
+                    batch.from[3][i] = newPos.y;
+                    pTarget->setPosition(newPos);
+                }
+                break;
+            case kCCTweenScale:
+                pTarget->setScaleX(batch.value[0][i]);
+                pTarget->setScaleY(batch.value[1][i]);
+                break;
+            case kCCTweenRotate:
+                pTarget->setRotationX(batch.value[0][i]);
+                pTarget->setRotationY(batch.value[1][i]);
+                break;
+            case kCCTweenFade:
+                batch.rgba[i]->setOpacity((GLubyte)batch.value[0][i]);
+                break;
+            case kCCTweenTint:
+                batch.rgba[i]->setColor(ccc3((GLubyte)batch.value[0][i],
+                                             (GLubyte)batch.value[1][i],
+                                             (GLubyte)batch.value[2][i]));
+                break;
+            }
+
+            if (batch.kinds[i] != kCCTweenDead)
+            {
+                // keep getElapsed() and isDone() of the action object truthful
+                CCActionInterval *pAction = batch.actions[i];
+                pAction->m_elapsed = batch.elapsed[i];
+                pAction->m_bFirstTick = false;
+
+                if (batch.elapsed[i] >= batch.duration[i])
+                {
+                    // retained, a setter further down the batch may remove it
+                    pAction->retain();
+                    finished.push_back(pAction);
+                }
+            }
+
+            // only delete currentTarget if no actions were scheduled during the setters (issue #481)
+            if (m_bCurrentTargetSalvaged && m_pCurrentTarget->actions->num == 0)
+            {
+                deleteHashElement(m_pCurrentTarget);
+            }
+        }
+
+        m_pCurrentTarget = NULL;
+        m_bTweensLocked = false;
+
+        // sweep the tweens removed while the batch was locked
+        for (i = batch.actions.size(); i > 0; --i)
+        {
+            if (batch.kinds[i - 1] == kCCTweenDead)
+            {
+                eraseTween(easing, i - 1);
+            }
+        }
+    }
+
+    for (std::vector<CCAction*>::iterator it = finished.begin(); it != finished.end(); ++it)
+    {
+        CCAction *pAction = *it;
+        // it may have been stopped by a setter of another tween already
+        if (pAction->m_uTweenSlot != kCCActionTweenSlotNone)
+        {
+            pAction->stop();
+            removeAction(pAction);
+        }
+        pAction->release();
+    }
 }
 
 NS_CC_END
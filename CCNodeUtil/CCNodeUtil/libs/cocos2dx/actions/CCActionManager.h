@@ -37,6 +37,7 @@ NS_CC_BEGIN
 class CCSet;
 
 struct _hashElement;
+struct _tweenBatch;
 
 /**
  * @addtogroup actions
@@ -52,6 +53,10 @@ struct _hashElement;
     - When you want to run an action where the target is different from a CCNode. 
     - When you want to pause / resume the actions
  
+ Top level CCMoveBy/CCMoveTo, CCScaleTo/CCScaleBy, CCRotateTo, CCFadeTo and CCTintTo actions,
+ optionally wrapped in a rate, sine or exponential ease, are stepped in packed batches
+ (one per easing curve) instead of through CCAction::step. Every other action uses the generic path.
+ 
  @since v0.8
  */
 class CC_DLL CCActionManager : public CCObject
@@ -121,10 +126,20 @@ protected:
     void actionAllocWithHashElement(struct _hashElement *pElement);
     void update(float dt);
 
+    // batched tweens
+    bool addTween(CCAction *pAction, struct _hashElement *pElement);
+    void removeTween(CCAction *pAction);
+    void eraseTween(int easing, unsigned int uIndex);
+    void removeTweensFromHashElement(struct _hashElement *pElement);
+    void updateTweens(float dt);
+
 protected:
     struct _hashElement    *m_pTargets;
     struct _hashElement    *m_pCurrentTarget;
     bool            m_bCurrentTargetSalvaged;
+    struct _tweenBatch     *m_pTweenBatches;
+    // If true removeTween will only mark tweens as dead, they are swept at the end of updateTweens
+    bool            m_bTweensLocked;
 };
 
 // end of actions group
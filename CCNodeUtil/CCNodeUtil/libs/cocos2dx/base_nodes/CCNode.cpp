@@ -51,6 +51,10 @@ NS_CC_BEGIN
 // XXX: Yes, nodes might have a sort problem once every 15 days if the game runs at 60 FPS and each frame sprites are reordered.
 static int s_globalOrderOfArrival = 1;
 
+// bumped whenever the transform of any node, or the parent of any node, changes.
+// The node which changed keeps the new value in m_uTransformEpoch.
+static unsigned int s_uTransformEpoch = 0;
+
 CCNode::CCNode(void)
 : m_nZOrder(0)
 , m_fVertexZ(0.0f)
@@ -80,6 +84,7 @@ CCNode::CCNode(void)
 , m_pUserObject(NULL)
 , m_bTransformDirty(true)
 , m_bInverseDirty(true)
+, m_uTransformEpoch(0)
 , m_nScriptHandler(0)
 , m_nUpdateScriptHandler(0)
 , m_pShaderProgram(NULL)
@@ -143,6 +148,7 @@ void CCNode::setSkewX(float newSkewX)
 {
     m_fSkewX = newSkewX;
     m_bTransformDirty = m_bInverseDirty = true;
+    m_uTransformEpoch = ++s_uTransformEpoch;
 }
 
 float CCNode::getSkewY()
@@ -155,6 +161,7 @@ void CCNode::setSkewY(float newSkewY)
     m_fSkewY = newSkewY;
 
     m_bTransformDirty = m_bInverseDirty = true;
+    m_uTransformEpoch = ++s_uTransformEpoch;
 }
 
 /// zOrder getter
@@ -205,6 +212,7 @@ void CCNode::setRotation(float newRotation)
 {
     m_fRotationX = m_fRotationY = newRotation;
     m_bTransformDirty = m_bInverseDirty = true;
+    m_uTransformEpoch = ++s_uTransformEpoch;
 }
 
 float CCNode::getRotationX()
@@ -216,6 +224,7 @@ void CCNode::setRotationX(float fRotationX)
 {
     m_fRotationX = fRotationX;
     m_bTransformDirty = m_bInverseDirty = true;
+    m_uTransformEpoch = ++s_uTransformEpoch;
 }
 
 float CCNode::getRotationY()
@@ -227,6 +236,7 @@ void CCNode::setRotationY(float fRotationY)
 {
     m_fRotationY = fRotationY;
     m_bTransformDirty = m_bInverseDirty = true;
+    m_uTransformEpoch = ++s_uTransformEpoch;
 }
 
 /// scale getter
@@ -241,6 +251,7 @@ void CCNode::setScale(float scale)
 {
     m_fScaleX = m_fScaleY = scale;
     m_bTransformDirty = m_bInverseDirty = true;
+    m_uTransformEpoch = ++s_uTransformEpoch;
 }
 
 /// scaleX getter
@@ -254,6 +265,7 @@ void CCNode::setScaleX(float newScaleX)
 {
     m_fScaleX = newScaleX;
     m_bTransformDirty = m_bInverseDirty = true;
+    m_uTransformEpoch = ++s_uTransformEpoch;
 }
 
 /// scaleY getter
@@ -267,6 +279,7 @@ void CCNode::setScaleY(float newScaleY)
 {
     m_fScaleY = newScaleY;
     m_bTransformDirty = m_bInverseDirty = true;
+    m_uTransformEpoch = ++s_uTransformEpoch;
 }
 
 /// position getter
@@ -280,6 +293,7 @@ void CCNode::setPosition(const CCPoint& newPosition)
 {
     m_obPosition = newPosition;
     m_bTransformDirty = m_bInverseDirty = true;
+    m_uTransformEpoch = ++s_uTransformEpoch;
 }
 
 void CCNode::getPosition(float* x, float* y)
@@ -381,6 +395,7 @@ void CCNode::setAnchorPoint(const CCPoint& point)
         m_obAnchorPoint = point;
         m_obAnchorPointInPoints = ccp(m_obContentSize.width * m_obAnchorPoint.x, m_obContentSize.height * m_obAnchorPoint.y );
         m_bTransformDirty = m_bInverseDirty = true;
+        m_uTransformEpoch = ++s_uTransformEpoch;
     }
 }
 
@@ -398,6 +413,7 @@ void CCNode::setContentSize(const CCSize & size)
 
         m_obAnchorPointInPoints = ccp(m_obContentSize.width * m_obAnchorPoint.x, m_obContentSize.height * m_obAnchorPoint.y );
         m_bTransformDirty = m_bInverseDirty = true;
+        m_uTransformEpoch = ++s_uTransformEpoch;
     }
 }
 
@@ -416,6 +432,7 @@ CCNode * CCNode::getParent()
 void CCNode::setParent(CCNode * var)
 {
     m_pParent = var;
+    m_uTransformEpoch = ++s_uTransformEpoch;
 }
 
 /// isRelativeAnchorPoint getter
@@ -430,6 +447,7 @@ void CCNode::ignoreAnchorPointForPosition(bool newValue)
     {
 		m_bIgnoreAnchorPointForPosition = newValue;
 		m_bTransformDirty = m_bInverseDirty = true;
+		m_uTransformEpoch = ++s_uTransformEpoch;
 	}
 }
 
@@ -1095,6 +1113,24 @@ void CCNode::update(float fDelta)
     }
 }
 
+unsigned int CCNode::getTransformEpoch()
+{
+    return s_uTransformEpoch;
+}
+
+bool CCNode::isWorldTransformChangedSince(unsigned int uEpoch)
+{
+    // the epoch wraps around: a node left alone for 2^31 changes may be reported as changed, never the opposite
+    for (CCNode *pNode = this; pNode != NULL; pNode = pNode->m_pParent)
+    {
+        if ((int)(pNode->m_uTransformEpoch - uEpoch) > 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 CCAffineTransform CCNode::nodeToParentTransform(void)
 {
     if (m_bTransformDirty) 
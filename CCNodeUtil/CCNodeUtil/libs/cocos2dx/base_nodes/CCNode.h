@@ -1217,6 +1217,24 @@ public:
      */
     virtual CCAffineTransform worldToNodeTransform(void);
 
+    /**
+     * Returns a counter which changes whenever the position, rotation, scale, skew, anchor point
+     * or content size of any node changes, or a node is added to or removed from a parent.
+     * If it didn't change, no world transform did either, so caches of world space data,
+     * like the touch index of CCTouchDispatcher, remain valid.
+     * Subclasses which override nodeToParentTransform() without calling the CCNode setters
+     * are not tracked.
+     * @since v2.1.x
+     */
+    static unsigned int getTransformEpoch(void);
+
+    /**
+     * Returns true if the transform or the parent of the node, or of one of its ancestors, changed
+     * after getTransformEpoch() returned uEpoch. Costs one comparison per ancestor, no matrix is computed.
+     * @since v2.1.x
+     */
+    bool isWorldTransformChangedSince(unsigned int uEpoch);
+
     /// @} end of Transformations
     
     
@@ -1321,6 +1339,7 @@ protected:
     
     bool m_bTransformDirty;             ///< transform dirty flag
     bool m_bInverseDirty;               ///< transform dirty flag
+    unsigned int m_uTransformEpoch;     ///< getTransformEpoch() right after the transform or the parent of this node last changed
     
     bool m_bVisible;                    ///< is this node visible
     
@@ -23,67 +23,50 @@ THE SOFTWARE.
 ****************************************************************************/
 #include "CCAutoreleasePool.h"
 #include "ccMacros.h"
+#include <stdlib.h>
 
 NS_CC_BEGIN
 
 static CCPoolManager* s_pPoolManager = NULL;
 
+#define kCCAutoreleaseChunkShift    10
+#define kCCAutoreleaseChunkSize     (1 << kCCAutoreleaseChunkShift)
+#define kCCAutoreleaseChunkMask     (kCCAutoreleaseChunkSize - 1)
+
+typedef struct _ccAutoreleaseEntry
+{
+    CCObject        *object;        // NULL once removed
+    unsigned int    previous;       // previous slot of the same object, or kCCAutoreleaseSlotNone
+} tCCAutoreleaseEntry;
+
 CCAutoreleasePool::CCAutoreleasePool(void)
+: m_uBegin(0)
 {
-    m_pManagedObjectArray = new CCArray();
-    m_pManagedObjectArray->init();
 }
 
 CCAutoreleasePool::~CCAutoreleasePool(void)
 {
-    CC_SAFE_DELETE(m_pManagedObjectArray);
 }
 
 void CCAutoreleasePool::addObject(CCObject* pObject)
 {
-    m_pManagedObjectArray->addObject(pObject);
+    CCAssert(CCPoolManager::sharedPoolManager()->m_pCurReleasePool == this, "objects can only be added to the current pool");
+    CCAssert(pObject->m_uReference > 0, "reference count should be greater than 0");
 
-    CCAssert(pObject->m_uReference > 1, "reference count should be greater than 1");
-    ++(pObject->m_uAutoReleaseCount);
-    pObject->release(); // no ref count, in this case autorelease pool added.
+    // the pool takes over the caller's reference
+    CCPoolManager::sharedPoolManager()->appendObject(pObject);
 }
 
 void CCAutoreleasePool::removeObject(CCObject* pObject)
 {
-    for (unsigned int i = 0; i < pObject->m_uAutoReleaseCount; ++i)
-    {
-        m_pManagedObjectArray->removeObject(pObject, false);
-    }
+    CCPoolManager::sharedPoolManager()->removeObjectSlots(pObject);
 }
 
 void CCAutoreleasePool::clear()
 {
-    if(m_pManagedObjectArray->count() > 0)
-    {
-        //CCAutoreleasePool* pReleasePool;
-#ifdef _DEBUG
-        int nIndex = m_pManagedObjectArray->count() - 1;
-#endif
-
-        CCObject* pObj = NULL;
-        CCARRAY_FOREACH_REVERSE(m_pManagedObjectArray, pObj)
-        {
-            if(!pObj)
-                break;
-
-            --(pObj->m_uAutoReleaseCount);
-            //(*it)->release();
-            //delete (*it);
-#ifdef _DEBUG
-            nIndex--;
-#endif
-        }
-
-        m_pManagedObjectArray->removeAllObjects();
-    }
+    CCPoolManager::sharedPoolManager()->releaseObjectsFrom(m_uBegin);
 }
 
-
 //--------------------------------------------------------------------
 //
 // CCPoolManager
@@ -105,6 +88,10 @@ void CCPoolManager::purgePoolManager()
 }
 
 CCPoolManager::CCPoolManager()
+: m_pChunks(NULL)
+, m_uChunkCount(0)
+, m_uChunkCapacity(0)
+, m_uCount(0)
 {
     m_pReleasePoolStack = new CCArray();    
     m_pReleasePoolStack->init();
@@ -121,6 +108,12 @@ CCPoolManager::~CCPoolManager()
      m_pReleasePoolStack->removeObjectAtIndex(0);
  
      CC_SAFE_DELETE(m_pReleasePoolStack);
+
+    for (unsigned int i = 0; i < m_uChunkCount; ++i)
+    {
+        free(m_pChunks[i]);
+    }
+    free(m_pChunks);
 }
 
 void CCPoolManager::finalize()
@@ -142,6 +135,7 @@ void CCPoolManager::finalize()
 void CCPoolManager::push()
 {
     CCAutoreleasePool* pPool = new CCAutoreleasePool();       //ref = 1
+    pPool->m_uBegin = m_uCount;
     m_pCurReleasePool = pPool;
 
     m_pReleasePoolStack->addObject(pPool);                   //ref = 2
@@ -179,7 +173,7 @@ void CCPoolManager::removeObject(CCObject* pObject)
 {
     CCAssert(m_pCurReleasePool, "current auto release pool should not be null");
 
-    m_pCurReleasePool->removeObject(pObject);
+    removeObjectSlots(pObject);
 }
 
 void CCPoolManager::addObject(CCObject* pObject)
@@ -200,4 +194,58 @@ CCAutoreleasePool* CCPoolManager::getCurReleasePool()
     return m_pCurReleasePool;
 }
 
+void CCPoolManager::appendObject(CCObject* pObject)
+{
+    if ((m_uCount >> kCCAutoreleaseChunkShift) == m_uChunkCount)
+    {
+        if (m_uChunkCount == m_uChunkCapacity)
+        {
+            m_uChunkCapacity = MAX(8, m_uChunkCapacity * 2);
+            m_pChunks = (tCCAutoreleaseEntry**)realloc(m_pChunks, m_uChunkCapacity * sizeof(tCCAutoreleaseEntry*));
+        }
+        m_pChunks[m_uChunkCount++] = (tCCAutoreleaseEntry*)malloc(kCCAutoreleaseChunkSize * sizeof(tCCAutoreleaseEntry));
+    }
+
+    unsigned int uSlot = m_uCount++;
+    tCCAutoreleaseEntry& entry = m_pChunks[uSlot >> kCCAutoreleaseChunkShift][uSlot & kCCAutoreleaseChunkMask];
+    entry.object = pObject;
+    entry.previous = pObject->m_uAutoReleaseSlot;
+
+    pObject->m_uAutoReleaseSlot = uSlot;
+    ++(pObject->m_uAutoReleaseCount);
+}
+
+void CCPoolManager::releaseObjectsFrom(unsigned int uBegin)
+{
+    // Released from the top: the slot of an object met here is always its latest one.
+    // Objects autoreleased by the destructors are appended and released by this same loop.
+    while (m_uCount > uBegin)
+    {
+        unsigned int uSlot = --m_uCount;
+        tCCAutoreleaseEntry& entry = m_pChunks[uSlot >> kCCAutoreleaseChunkShift][uSlot & kCCAutoreleaseChunkMask];
+        CCObject* pObject = entry.object;
+        if (pObject)
+        {
+            CCAssert(pObject->m_uAutoReleaseSlot == uSlot, "");
+            pObject->m_uAutoReleaseSlot = entry.previous;
+            --(pObject->m_uAutoReleaseCount);
+            pObject->release();
+        }
+    }
+}
+
+void CCPoolManager::removeObjectSlots(CCObject* pObject)
+{
+    unsigned int uSlot = pObject->m_uAutoReleaseSlot;
+    while (uSlot != kCCAutoreleaseSlotNone)
+    {
+        tCCAutoreleaseEntry& entry = m_pChunks[uSlot >> kCCAutoreleaseChunkShift][uSlot & kCCAutoreleaseChunkMask];
+        entry.object = NULL;
+        uSlot = entry.previous;
+    }
+
+    pObject->m_uAutoReleaseSlot = kCCAutoreleaseSlotNone;
+    pObject->m_uAutoReleaseCount = 0;
+}
+
 NS_CC_END
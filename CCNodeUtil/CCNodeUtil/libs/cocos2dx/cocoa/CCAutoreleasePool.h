@@ -34,9 +34,22 @@ NS_CC_BEGIN
  * @{
  */
 
+//! Slot of objects which are not in an autorelease pool
+#define kCCAutoreleaseSlotNone 0xffffffff
+
+struct _ccAutoreleaseEntry;
+
+/** @brief A level of the autorelease pool stack.
+
+ The objects themselves are stored by CCPoolManager in a chunked arena shared by every
+ pool; a pool only remembers where its objects begin. Adding an object is an append,
+ clear() releases the pool's range in one sweep, and every object knows its slot so it
+ can be taken out without searching.
+ */
 class CC_DLL CCAutoreleasePool : public CCObject
 {
-    CCArray*    m_pManagedObjectArray;    
+    // index of the first slot of this pool in the arena
+    unsigned int m_uBegin;
 public:
     CCAutoreleasePool(void);
     ~CCAutoreleasePool(void);
@@ -45,6 +58,8 @@ public:
     void removeObject(CCObject *pObject);
 
     void clear();
+
+    friend class CCPoolManager;
 };
 
 class CC_DLL CCPoolManager
@@ -52,7 +67,18 @@ class CC_DLL CCPoolManager
     CCArray*    m_pReleasePoolStack;    
     CCAutoreleasePool*                    m_pCurReleasePool;
 
+    // arena of autoreleased objects, kCCAutoreleaseChunkSize entries per chunk
+    struct _ccAutoreleaseEntry**    m_pChunks;
+    unsigned int                    m_uChunkCount;
+    unsigned int                    m_uChunkCapacity;
+    // number of used slots
+    unsigned int                    m_uCount;
+
     CCAutoreleasePool* getCurReleasePool();
+
+    void appendObject(CCObject* pObject);
+    void releaseObjectsFrom(unsigned int uBegin);
+    void removeObjectSlots(CCObject* pObject);
 public:
     CCPoolManager();
     ~CCPoolManager();
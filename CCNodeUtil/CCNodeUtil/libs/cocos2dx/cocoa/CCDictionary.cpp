@@ -25,44 +25,34 @@
 #include "CCDictionary.h"
 #include "CCString.h"
 #include "CCInteger.h"
+#include "support/data_support/ccStringIntern.h"
+#include "support/data_support/ccCArray.h"
+#include <stdlib.h>
+#include <string.h>
 
 using namespace std;
 
 NS_CC_BEGIN
 
-// -----------------------------------------------------------------------
-// CCDictElement
+// the bucket table holds at most 3/4 as many elements as buckets
+#define CC_DICT_MIN_BUCKETS 8
 
-CCDictElement::CCDictElement(const char* pszKey, CCObject* pObject)
+struct _ccDictBucket
 {
-    CCAssert(pszKey && strlen(pszKey) > 0, "Invalid key value.");
-    m_iKey = 0;
-    const char* pStart = pszKey;
-    
-    int len = strlen(pszKey);
-    if (len > MAX_KEY_LEN )
-    {
-        char* pEnd = (char*)&pszKey[len-1];
-        pStart = pEnd - (MAX_KEY_LEN-1);
-    }
-    
-    strcpy(m_szKey, pStart);
-    
-    m_pObject = pObject;
-    memset(&hh, 0, sizeof(hh));
-}
+    unsigned int hash;
+    unsigned int index;     // index of the element plus one, 0 for an empty bucket
+};
 
-CCDictElement::CCDictElement(intptr_t iKey, CCObject* pObject)
+static inline unsigned int hashOfInt(intptr_t iKey)
 {
-    m_szKey[0] = '\0';
-    m_iKey = iKey;
-    m_pObject = pObject;
-    memset(&hh, 0, sizeof(hh));
-}
-
-CCDictElement::~CCDictElement()
-{
-
+    // finalizer of MurmurHash3
+    unsigned int h = (unsigned int)iKey ^ (unsigned int)((unsigned long long)iKey >> 32);
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
 }
 
 // -----------------------------------------------------------------------
@@ -70,7 +60,12 @@ CCDictElement::~CCDictElement()
 
 CCDictionary::CCDictionary()
 : m_pElements(NULL)
+, m_uElementCount(0)
+, m_uElementCapacity(0)
+, m_pBuckets(NULL)
+, m_uBucketMask(0)
 , m_eDictType(kCCDictUnknown)
+, m_bInternKeys(false)
 {
 
 }
@@ -82,7 +77,7 @@ CCDictionary::~CCDictionary()
 
 unsigned int CCDictionary::count()
 {
-    return HASH_COUNT(m_pElements);
+    return m_uElementCount;
 }
 
 CCArray* CCDictionary::allKeys()
@@ -92,21 +87,20 @@ CCArray* CCDictionary::allKeys()
 
     CCArray* pArray = CCArray::createWithCapacity(iKeyCount);
 
-    CCDictElement *pElement, *tmp;
     if (m_eDictType == kCCDictStr)
     {
-        HASH_ITER(hh, m_pElements, pElement, tmp) 
+        for (unsigned int i = 0; i < m_uElementCount; ++i)
         {
-            CCString* pOneKey = new CCString(pElement->m_szKey);
+            CCString* pOneKey = new CCString(m_pElements[i].m_pszKey);
             pArray->addObject(pOneKey);
             CC_SAFE_RELEASE(pOneKey);
         }
     }
     else if (m_eDictType == kCCDictInt)
     {
-        HASH_ITER(hh, m_pElements, pElement, tmp) 
+        for (unsigned int i = 0; i < m_uElementCount; ++i)
         {
-            CCInteger* pOneKey = new CCInteger(pElement->m_iKey);
+            CCInteger* pOneKey = new CCInteger(m_pElements[i].m_iKey);
             pArray->addObject(pOneKey);
             CC_SAFE_RELEASE(pOneKey);
         }
@@ -121,15 +115,13 @@ CCArray* CCDictionary::allKeysForObject(CCObject* object)
     if (iKeyCount <= 0) return NULL;
     CCArray* pArray = CCArray::create();
 
-    CCDictElement *pElement, *tmp;
-
     if (m_eDictType == kCCDictStr)
     {
-        HASH_ITER(hh, m_pElements, pElement, tmp) 
+        for (unsigned int i = 0; i < m_uElementCount; ++i)
         {
-            if (object == pElement->m_pObject)
+            if (object == m_pElements[i].m_pObject)
             {
-                CCString* pOneKey = new CCString(pElement->m_szKey);
+                CCString* pOneKey = new CCString(m_pElements[i].m_pszKey);
                 pArray->addObject(pOneKey);
                 CC_SAFE_RELEASE(pOneKey);
             }
@@ -137,11 +129,11 @@ CCArray* CCDictionary::allKeysForObject(CCObject* object)
     }
     else if (m_eDictType == kCCDictInt)
     {
-        HASH_ITER(hh, m_pElements, pElement, tmp) 
+        for (unsigned int i = 0; i < m_uElementCount; ++i)
         {
-            if (object == pElement->m_pObject)
+            if (object == m_pElements[i].m_pObject)
             {
-                CCInteger* pOneKey = new CCInteger(pElement->m_iKey);
+                CCInteger* pOneKey = new CCInteger(m_pElements[i].m_iKey);
                 pArray->addObject(pOneKey);
                 CC_SAFE_RELEASE(pOneKey);
             }
@@ -150,6 +142,90 @@ CCArray* CCDictionary::allKeysForObject(CCObject* object)
     return pArray;
 }
 
+unsigned int CCDictionary::findElement(const char* pszKey, unsigned int uLength, unsigned int uHash)
+{
+    if (m_pBuckets == NULL)
+    {
+        return CC_INVALID_INDEX;
+    }
+
+    for (unsigned int b = uHash & m_uBucketMask; m_pBuckets[b].index != 0; b = (b + 1) & m_uBucketMask)
+    {
+        if (m_pBuckets[b].hash == uHash)
+        {
+            unsigned int uIndex = m_pBuckets[b].index - 1;
+            const CCDictElement& element = m_pElements[uIndex];
+            unsigned int uKeyLength = element.m_iKey ? ccStringInternLength((unsigned int)element.m_iKey) : (unsigned int)strlen(element.m_pszKey);
+            if (uKeyLength == uLength && memcmp(element.m_pszKey, pszKey, uLength) == 0)
+            {
+                return uIndex;
+            }
+        }
+    }
+    return CC_INVALID_INDEX;
+}
+
+unsigned int CCDictionary::findElement(intptr_t iKey, unsigned int uHash)
+{
+    if (m_pBuckets == NULL)
+    {
+        return CC_INVALID_INDEX;
+    }
+
+    for (unsigned int b = uHash & m_uBucketMask; m_pBuckets[b].index != 0; b = (b + 1) & m_uBucketMask)
+    {
+        if (m_pBuckets[b].hash == uHash && m_pElements[m_pBuckets[b].index - 1].m_iKey == iKey)
+        {
+            return m_pBuckets[b].index - 1;
+        }
+    }
+    return CC_INVALID_INDEX;
+}
+
+unsigned int CCDictionary::hashOfElement(const CCDictElement& element)
+{
+    if (element.m_pszKey == NULL)
+    {
+        return hashOfInt(element.m_iKey);
+    }
+    // the string keys which aren't interned have an id of 0
+    return element.m_iKey ? ccStringInternHash((unsigned int)element.m_iKey) : ccStringHash(element.m_pszKey, (unsigned int)strlen(element.m_pszKey));
+}
+
+unsigned int CCDictionary::bucketOfElement(unsigned int uIndex)
+{
+    unsigned int b = hashOfElement(m_pElements[uIndex]) & m_uBucketMask;
+    while (m_pBuckets[b].index != uIndex + 1)
+    {
+        b = (b + 1) & m_uBucketMask;
+    }
+    return b;
+}
+
+void CCDictionary::rehash(unsigned int uBucketCount)
+{
+    struct _ccDictBucket* pOldBuckets = m_pBuckets;
+    unsigned int uOldBucketCount = m_pBuckets ? m_uBucketMask + 1 : 0;
+
+    m_pBuckets = (struct _ccDictBucket*)calloc(uBucketCount, sizeof(struct _ccDictBucket));
+    m_uBucketMask = uBucketCount - 1;
+
+    // the buckets keep the hashes, so no key is hashed again
+    for (unsigned int i = 0; i < uOldBucketCount; ++i)
+    {
+        if (pOldBuckets[i].index != 0)
+        {
+            unsigned int b = pOldBuckets[i].hash & m_uBucketMask;
+            while (m_pBuckets[b].index != 0)
+            {
+                b = (b + 1) & m_uBucketMask;
+            }
+            m_pBuckets[b] = pOldBuckets[i];
+        }
+    }
+    free(pOldBuckets);
+}
+
 CCObject* CCDictionary::objectForKey(const std::string& key)
 {
     // if dictionary wasn't initialized, return NULL directly.
@@ -158,14 +234,9 @@ CCObject* CCDictionary::objectForKey(const std::string& key)
     // This method uses string as key, therefore we should make sure that the key type of this CCDictionary is string.
     CCAssert(m_eDictType == kCCDictStr, "this dictionary does not use string as key.");
 
-    CCObject* pRetObject = NULL;
-    CCDictElement *pElement = NULL;
-    HASH_FIND_STR(m_pElements, key.c_str(), pElement);
-    if (pElement != NULL)
-    {
-        pRetObject = pElement->m_pObject;
-    }
-    return pRetObject;
+    unsigned int uLength = (unsigned int)key.length();
+    unsigned int uIndex = findElement(key.c_str(), uLength, ccStringHash(key.c_str(), uLength));
+    return uIndex != CC_INVALID_INDEX ? m_pElements[uIndex].m_pObject : NULL;
 }
 
 CCObject* CCDictionary::objectForKey(int key)
@@ -176,14 +247,27 @@ CCObject* CCDictionary::objectForKey(int key)
     // This method uses integer as key, therefore we should make sure that the key type of this CCDictionary is integer.
     CCAssert(m_eDictType == kCCDictInt, "this dictionary does not use integer as key.");
 
-    CCObject* pRetObject = NULL;
-    CCDictElement *pElement = NULL;
-    HASH_FIND_INT(m_pElements, &key, pElement);
-    if (pElement != NULL)
+    unsigned int uIndex = findElement((intptr_t)key, hashOfInt(key));
+    return uIndex != CC_INVALID_INDEX ? m_pElements[uIndex].m_pObject : NULL;
+}
+
+CCObject* CCDictionary::objectForInternedKey(unsigned int uKeyId)
+{
+    // if dictionary wasn't initialized, return NULL directly.
+    if (m_eDictType == kCCDictUnknown) return NULL;
+    CCAssert(m_eDictType == kCCDictStr, "this dictionary does not use string as key.");
+
+    unsigned int uIndex;
+    if (m_bInternKeys)
     {
-        pRetObject = pElement->m_pObject;
+        // interned keys are equal when their ids are
+        uIndex = findElement((intptr_t)uKeyId, ccStringInternHash(uKeyId));
     }
-    return pRetObject;
+    else
+    {
+        uIndex = findElement(ccStringInternString(uKeyId), ccStringInternLength(uKeyId), ccStringInternHash(uKeyId));
+    }
+    return uIndex != CC_INVALID_INDEX ? m_pElements[uIndex].m_pObject : NULL;
 }
 
 const CCString* CCDictionary::valueForKey(const std::string& key)
@@ -216,18 +300,30 @@ void CCDictionary::setObject(CCObject* pObject, const std::string& key)
 
     CCAssert(m_eDictType == kCCDictStr, "this dictionary doesn't use string as key.");
 
-    CCDictElement *pElement = NULL;
-    HASH_FIND_STR(m_pElements, key.c_str(), pElement);
-    if (pElement == NULL)
+    unsigned int uLength = (unsigned int)key.length();
+    unsigned int uHash = ccStringHash(key.c_str(), uLength);
+    unsigned int uIndex = findElement(key.c_str(), uLength, uHash);
+    if (uIndex == CC_INVALID_INDEX)
     {
-        setObjectUnSafe(pObject, key);
+        if (m_bInternKeys)
+        {
+            unsigned int uKeyId = ccStringInternIdWithHash(key.c_str(), uLength, uHash);
+            setObjectUnSafe(pObject, ccStringInternString(uKeyId), uKeyId, uHash);
+        }
+        else
+        {
+            // the dictionary owns a copy of the key, freed with the element
+            char* pszKey = (char*)malloc(uLength + 1);
+            memcpy(pszKey, key.c_str(), uLength + 1);
+            setObjectUnSafe(pObject, pszKey, 0, uHash);
+        }
     }
-    else if (pElement->m_pObject != pObject)
+    else if (m_pElements[uIndex].m_pObject != pObject)
     {
-        CCObject* pTmpObj = pElement->m_pObject;
-        pTmpObj->retain();
-        removeObjectForElememt(pElement);
-        setObjectUnSafe(pObject, key);
+        // the old object is released last, its destructor may use the dictionary
+        CCObject* pTmpObj = m_pElements[uIndex].m_pObject;
+        pObject->retain();
+        m_pElements[uIndex].m_pObject = pObject;
         pTmpObj->release();
     }
 }
@@ -242,18 +338,17 @@ void CCDictionary::setObject(CCObject* pObject, int key)
 
     CCAssert(m_eDictType == kCCDictInt, "this dictionary doesn't use integer as key.");
 
-    CCDictElement *pElement = NULL;
-    HASH_FIND_INT(m_pElements, &key, pElement);
-    if (pElement == NULL)
+    unsigned int uHash = hashOfInt(key);
+    unsigned int uIndex = findElement((intptr_t)key, uHash);
+    if (uIndex == CC_INVALID_INDEX)
     {
-        setObjectUnSafe(pObject, key);
+        setObjectUnSafe(pObject, NULL, key, uHash);
     }
-    else if (pElement->m_pObject != pObject)
+    else if (m_pElements[uIndex].m_pObject != pObject)
     {
-        CCObject* pTmpObj = pElement->m_pObject;
-        pTmpObj->retain();
-        removeObjectForElememt(pElement);
-        setObjectUnSafe(pObject, key);
+        CCObject* pTmpObj = m_pElements[uIndex].m_pObject;
+        pObject->retain();
+        m_pElements[uIndex].m_pObject = pObject;
         pTmpObj->release();
     }
 
@@ -268,9 +363,12 @@ void CCDictionary::removeObjectForKey(const std::string& key)
     
     CCAssert(m_eDictType == kCCDictStr, "this dictionary doesn't use string as its key");
     CCAssert(key.length() > 0, "Invalid Argument!");
-    CCDictElement *pElement = NULL;
-    HASH_FIND_STR(m_pElements, key.c_str(), pElement);
-    removeObjectForElememt(pElement);
+    unsigned int uLength = (unsigned int)key.length();
+    unsigned int uIndex = findElement(key.c_str(), uLength, ccStringHash(key.c_str(), uLength));
+    if (uIndex != CC_INVALID_INDEX)
+    {
+        removeElementAtIndex(uIndex);
+    }
 }
 
 void CCDictionary::removeObjectForKey(int key)
@@ -281,23 +379,40 @@ void CCDictionary::removeObjectForKey(int key)
     }
     
     CCAssert(m_eDictType == kCCDictInt, "this dictionary doesn't use integer as its key");
-    CCDictElement *pElement = NULL;
-    HASH_FIND_INT(m_pElements, &key, pElement);
-    removeObjectForElememt(pElement);
+    unsigned int uIndex = findElement((intptr_t)key, hashOfInt(key));
+    if (uIndex != CC_INVALID_INDEX)
+    {
+        removeElementAtIndex(uIndex);
+    }
 }
 
-void CCDictionary::setObjectUnSafe(CCObject* pObject, const std::string& key)
+void CCDictionary::setObjectUnSafe(CCObject* pObject, const char* pszKey, intptr_t iKey, unsigned int uHash)
 {
-    pObject->retain();
-    CCDictElement* pElement = new CCDictElement(key.c_str(), pObject);
-    HASH_ADD_STR(m_pElements, m_szKey, pElement);
-}
+    if ((m_uElementCount + 1) * 4 > (m_pBuckets ? m_uBucketMask + 1 : 0) * 3)
+    {
+        rehash(m_pBuckets ? (m_uBucketMask + 1) * 2 : CC_DICT_MIN_BUCKETS);
+    }
+
+    if (m_uElementCount == m_uElementCapacity)
+    {
+        m_uElementCapacity = m_uElementCapacity ? m_uElementCapacity * 2 : CC_DICT_MIN_BUCKETS / 2;
+        m_pElements = (CCDictElement*)realloc(m_pElements, m_uElementCapacity * sizeof(CCDictElement));
+    }
 
-void CCDictionary::setObjectUnSafe(CCObject* pObject, const int key)
-{
     pObject->retain();
-    CCDictElement* pElement = new CCDictElement(key, pObject);
-    HASH_ADD_INT(m_pElements, m_iKey, pElement);
+
+    CCDictElement& element = m_pElements[m_uElementCount];
+    element.m_pszKey = pszKey;
+    element.m_iKey = iKey;
+    element.m_pObject = pObject;
+
+    unsigned int b = uHash & m_uBucketMask;
+    while (m_pBuckets[b].index != 0)
+    {
+        b = (b + 1) & m_uBucketMask;
+    }
+    m_pBuckets[b].hash = uHash;
+    m_pBuckets[b].index = ++m_uElementCount;
 }
 
 void CCDictionary::removeObjectsForKeys(CCArray* pKeyArray)
@@ -314,27 +429,76 @@ void CCDictionary::removeObjectForElememt(CCDictElement* pElement)
 {
     if (pElement != NULL)
     {
-        HASH_DEL(m_pElements, pElement);
-        pElement->m_pObject->release();
-        CC_SAFE_DELETE(pElement);
+        CCAssert(pElement >= m_pElements && pElement < m_pElements + m_uElementCount, "the element doesn't belong to this dictionary");
+        removeElementAtIndex((unsigned int)(pElement - m_pElements));
+    }
+}
+
+void CCDictionary::removeElementAtIndex(unsigned int uIndex)
+{
+    CCObject* pObject = m_pElements[uIndex].m_pObject;
+    const char* pszKey = m_pElements[uIndex].m_pszKey;
+    bool bOwnsKey = pszKey != NULL && m_pElements[uIndex].m_iKey == 0;
+
+    // empty the bucket, moving back the entries of its probe sequence so none of them is cut off
+    unsigned int b = bucketOfElement(uIndex);
+    for (unsigned int next = (b + 1) & m_uBucketMask; m_pBuckets[next].index != 0; next = (next + 1) & m_uBucketMask)
+    {
+        unsigned int home = m_pBuckets[next].hash & m_uBucketMask;
+        // the entry may move to b unless its home lies cyclically in (b, next]
+        bool bReachable = (b <= next) ? (b < home && home <= next) : (b < home || home <= next);
+        if (! bReachable)
+        {
+            m_pBuckets[b] = m_pBuckets[next];
+            b = next;
+        }
+    }
+    m_pBuckets[b].index = 0;
+
+    // fill the hole with the last element, so the elements stay packed; CCDICT_FOREACH runs
+    // backwards, so the moved element has already been visited
+    unsigned int uLast = --m_uElementCount;
+    if (uIndex != uLast)
+    {
+        m_pBuckets[bucketOfElement(uLast)].index = uIndex + 1;
+        m_pElements[uIndex] = m_pElements[uLast];
+    }
+
+    if (bOwnsKey)
+    {
+        free((void*)pszKey);
     }
+    pObject->release();
 }
 
 void CCDictionary::removeAllObjects()
 {
-    CCDictElement *pElement, *tmp;
-    HASH_ITER(hh, m_pElements, pElement, tmp) 
+    CCDictElement* pElements = m_pElements;
+    unsigned int uCount = m_uElementCount;
+
+    m_pElements = NULL;
+    m_uElementCount = 0;
+    m_uElementCapacity = 0;
+    free(m_pBuckets);
+    m_pBuckets = NULL;
+    m_uBucketMask = 0;
+
+    for (unsigned int i = 0; i < uCount; ++i)
     {
-        HASH_DEL(m_pElements, pElement);
-        pElement->m_pObject->release();
-        CC_SAFE_DELETE(pElement);
+        if (pElements[i].m_pszKey != NULL && pElements[i].m_iKey == 0)
+        {
+            free((void*)pElements[i].m_pszKey);
+        }
+        pElements[i].m_pObject->release();
     }
+    free(pElements);
 }
 
 CCObject* CCDictionary::copyWithZone(CCZone* pZone)
 {
     CCAssert(pZone == NULL, "CCDictionary should not be inherited.");
     CCDictionary* pNewDict = new CCDictionary();
+    pNewDict->m_bInternKeys = m_bInternKeys;
 
     CCDictElement* pElement = NULL;
     CCObject* pTmpObj = NULL;
@@ -361,6 +525,17 @@ CCObject* CCDictionary::copyWithZone(CCZone* pZone)
     return pNewDict;
 }
 
+void CCDictionary::setInternKeys(bool bInternKeys)
+{
+    CCAssert(m_uElementCount == 0, "the keys can't be interned once the dictionary has elements");
+    m_bInternKeys = bInternKeys;
+}
+
+bool CCDictionary::isInternKeys()
+{
+    return m_bInternKeys;
+}
+
 CCObject* CCDictionary::randomObject()
 {
     if (m_eDictType == kCCDictUnknown)
@@ -25,7 +25,6 @@ THE SOFTWARE.
 #ifndef __CCDICTIONARY_H__
 #define __CCDICTIONARY_H__
 
-#include "support/data_support/uthash.h"
 #include "CCObject.h"
 #include "CCArray.h"
 #include "CCString.h"
@@ -61,31 +60,9 @@ class CCDictionary;
  */
 class CC_DLL CCDictElement
 {
-private:
-    /**
-     *  Constructor of CCDictElement. It's only for internal usage. CCDictionary is its friend class.
-     *  
-     *  @param  pszKey    The string key of this element.
-     *  @param  pObject   The object of this element.
-     */
-    CCDictElement(const char* pszKey, CCObject* pObject);
-
-    /**
-     *  Constructor of CCDictElement. It's only for internal usage. CCDictionary is its friend class.
-     *
-     *  @param  iKey    The integer key of this element.
-     *  @param  pObject   The object of this element.
-     */
-    CCDictElement(intptr_t iKey, CCObject* pObject);
-    
 public:
-    /**
-     *  The destructor of CCDictElement.
-     */
-    ~CCDictElement();
-
     // Inline functions need to be implemented in header file on Android.
-    
+
     /**
      * Get the string key of this element.
      * @note    This method assumes you know the key type in the element. 
@@ -95,8 +72,24 @@ public:
      */
     inline const char* getStrKey() const
     {
-        CCAssert(m_szKey[0] != '\0', "Should not call this function for integer dictionary");
-        return m_szKey;
+        CCAssert(m_pszKey != NULL, "Should not call this function for integer dictionary");
+        return m_pszKey;
+    }
+
+    /**
+     * Get the interned id of the string key of this element.
+     * @note    This method assumes you know the key type in the element. 
+     *          If the element's key type is integer, invoking this method will cause an assert.
+     *
+     * @return  The id of the string key, as returned by ccStringInternId(),
+     *          or 0 if the dictionary doesn't intern its keys.
+     * @see CCDictionary::setInternKeys(bool)
+     * @since v2.1.x
+     */
+    inline unsigned int getStrKeyId() const
+    {
+        CCAssert(m_pszKey != NULL, "Should not call this function for integer dictionary");
+        return (unsigned int)m_iKey;
     }
 
     /**
@@ -106,12 +99,12 @@ public:
      *
      * @return  The integer key of this element.
      */
-    inline intptr_t getIntKey() const
+    inline intptr_t getIntKey() const 
     {
-        CCAssert(m_szKey[0] == '\0', "Should not call this function for string dictionary");
+        CCAssert(m_pszKey == NULL, "Should not call this function for string dictionary");
         return m_iKey;
     }
-    
+
     /**
      * Get the object of this element.
      *
@@ -120,32 +113,34 @@ public:
     inline CCObject* getObject() const { return m_pObject; }
 
 private:
-    // The max length of string key.
-    #define   MAX_KEY_LEN   256
-    // char array is needed for HASH_ADD_STR in UT_HASH.
-    // So it's a pain that all elements will allocate 256 bytes for this array.
-    char      m_szKey[MAX_KEY_LEN];     // hash key of string type
-    intptr_t  m_iKey;       // hash key of integer type
+    // The elements are stored by value in an array owned by CCDictionary, they don't
+    // need a constructor of their own.
+    const char* m_pszKey;   // interned string key, NULL for integer keys
+    intptr_t  m_iKey;       // integer key, or the interned id of the string key
     CCObject* m_pObject;    // hash value
-public:
-    UT_hash_handle hh;      // makes this class hashable
+
     friend class CCDictionary; // declare CCDictionary as friend class
 };
 
 /** The macro for traversing dictionary
  *  
  *  @note It's faster than getting all keys and traversing keys to get objects by objectForKey.
- *        It's also safe to remove elements while traversing.
+ *        It's also safe to remove the current element while traversing.
+ *        The elements are visited in no particular order.
  */
 #define CCDICT_FOREACH(__dict__, __el__) \
-    CCDictElement* pTmp##__dict__##__el__ = NULL; \
-    HASH_ITER(hh, (__dict__)->m_pElements, __el__, pTmp##__dict__##__el__)
+    for (unsigned int uIdx##__dict__##__el__ = (__dict__)->m_uElementCount; \
+         (uIdx##__dict__##__el__ > (__dict__)->m_uElementCount ? (uIdx##__dict__##__el__ = (__dict__)->m_uElementCount) : uIdx##__dict__##__el__) > 0 \
+         && ((__el__) = &(__dict__)->m_pElements[--uIdx##__dict__##__el__]) != NULL; )
 
 
 
 /**
  *  CCDictionary is a class like NSDictionary in Obj-C .
  *
+ *  The elements are stored in one array, indexed by an open addressing hash table.
+ *  Each dictionary owns a copy of its string keys, unless it interns them (see setInternKeys()).
+ *
  *  @note Only the pointer of CCObject or its subclass can be inserted to CCDictionary.
  *  @code
  *  // Create a dictionary, return an autorelease object.
@@ -231,6 +226,19 @@ public:
      *  @see objectForKey(const std::string&)
      */
     CCObject* objectForKey(int key);
+
+    /**
+     *  Get the object according to the interned id of a string key.
+     *
+     *  It's the fastest lookup in a dictionary which interns its keys: the key is neither hashed
+     *  nor compared character by character.
+     *  @note The dictionary needs to use string as key. If integer is passed, an assert will appear.
+     *  @param uKeyId  The id of the key, as returned by ccStringInternId() or CCDictElement::getStrKeyId().
+     *  @return The object matches the key.
+     *  @see objectForKey(const std::string&)
+     *  @since v2.1.x
+     */
+    CCObject* objectForInternedKey(unsigned int uKeyId);
     
     /** Get the value according to the specified string key.
      *
@@ -330,6 +338,20 @@ public:
     virtual CCObject* copyWithZone(CCZone* pZone);
     /// @}
     
+    /**
+     *  Set whether the string keys are interned with ccStringInternId().
+     *
+     *  An interned key is stored once however many dictionaries use it, and its hash is computed
+     *  only when it's interned, but it's never freed: only the dictionaries of the caches, whose
+     *  keys are a bounded set of names, should intern them. The keys aren't interned by default.
+     *  @note It can only be set while the dictionary is empty.
+     *  @since v2.1.x
+     */
+    void setInternKeys(bool bInternKeys);
+
+    /** Whether the string keys are interned. @since v2.1.x */
+    bool isInternKeys();
+
     /**
      *  Return a random object in the dictionary.
      *
@@ -379,17 +401,33 @@ private:
     /** 
      *  For internal usage, invoked by setObject.
      */
-    void setObjectUnSafe(CCObject* pObject, const std::string& key);
-    void setObjectUnSafe(CCObject* pObject, const int key);
+    void setObjectUnSafe(CCObject* pObject, const char* pszKey, intptr_t iKey, unsigned int uHash);
+
+    /** Returns the index of the element with the string key, or CC_INVALID_INDEX */
+    unsigned int findElement(const char* pszKey, unsigned int uLength, unsigned int uHash);
+    /** Returns the index of the element with the integer key, or the interned id of a string key */
+    unsigned int findElement(intptr_t iKey, unsigned int uHash);
+    /** Returns the hash of the key of an element */
+    unsigned int hashOfElement(const CCDictElement& element);
+    /** Returns the bucket which refers to an element */
+    unsigned int bucketOfElement(unsigned int uIndex);
+    void removeElementAtIndex(unsigned int uIndex);
+    void rehash(unsigned int uBucketCount);
     
 public:
     /**
      *  All the elements in dictionary.
      * 
-     *  @note For internal usage, we need to declare this member variable as public since it's used in UT_HASH.
+     *  @note For internal usage, we need to declare these member variables as public since they're used by CCDICT_FOREACH.
      */
     CCDictElement* m_pElements;
+    unsigned int m_uElementCount;
+
 private:
+    unsigned int m_uElementCapacity;
+    /** Open addressing table of element indices, with linear probing */
+    struct _ccDictBucket* m_pBuckets;
+    unsigned int m_uBucketMask;
     
     /** The support type of dictionary, it's confirmed when setObject is invoked. */
     enum CCDictType
@@ -403,6 +441,9 @@ private:
      *  The type of dictionary, it's assigned to kCCDictUnknown by default.
      */
     CCDictType m_eDictType;
+
+    /** Whether the string keys are interned, or copied by the dictionary */
+    bool m_bInternKeys;
 };
 
 // end of data_structure group
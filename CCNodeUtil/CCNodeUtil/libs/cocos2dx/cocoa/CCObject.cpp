@@ -39,6 +39,7 @@ CCObject* CCCopying::copyWithZone(CCZone *pZone)
 
 CCObject::CCObject(void)
 :m_uAutoReleaseCount(0)
+,m_uAutoReleaseSlot(kCCAutoreleaseSlotNone)
 ,m_uReference(1) // when the object is created, the reference count of it is 1
 ,m_nLuaID(0)
 {
@@ -57,6 +57,8 @@ protected:
     unsigned int        m_uReference;
     // count of autorelease
     unsigned int        m_uAutoReleaseCount;
+    // slot of the latest autorelease in the pool manager, the earlier ones are chained from it
+    unsigned int        m_uAutoReleaseSlot;
 public:
     CCObject(void);
     virtual ~CCObject(void);
@@ -72,6 +74,7 @@ public:
     virtual void update(float dt) {CC_UNUSED_PARAM(dt);};
     
     friend class CCAutoreleasePool;
+    friend class CCPoolManager;
 };
 
 
@@ -0,0 +1,206 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "CCObjectPool.h"
+#include "ccMacros.h"
+#include <stdlib.h>
+#include <string.h>
+
+NS_CC_BEGIN
+
+#define kCCObjectPoolSizeClasses (CC_OBJECT_POOL_MAX_BLOCK_SIZE / CC_OBJECT_POOL_GRANULARITY)
+
+CCObjectPool::CCObjectPool(const char *pszName)
+: m_pszName(pszName)
+, m_pFreeLists(NULL)
+, m_pFreeCounts(NULL)
+{
+    pthread_mutex_init(&m_mutex, NULL);
+    m_pFreeLists = (void**)calloc(kCCObjectPoolSizeClasses, sizeof(void*));
+    m_pFreeCounts = (unsigned int*)calloc(kCCObjectPoolSizeClasses, sizeof(unsigned int));
+    memset(&m_stats, 0, sizeof(m_stats));
+}
+
+CCObjectPool::~CCObjectPool()
+{
+    purge();
+    free(m_pFreeLists);
+    free(m_pFreeCounts);
+    pthread_mutex_destroy(&m_mutex);
+}
+
+void* CCObjectPool::allocate(size_t uSize)
+{
+    if (uSize == 0 || uSize > CC_OBJECT_POOL_MAX_BLOCK_SIZE)
+    {
+        return ::operator new(uSize);
+    }
+
+    unsigned int uClass = (unsigned int)((uSize - 1) / CC_OBJECT_POOL_GRANULARITY);
+    void *pBlock = NULL;
+
+    pthread_mutex_lock(&m_mutex);
+    pBlock = m_pFreeLists[uClass];
+    if (pBlock)
+    {
+        // the first word of a free block links to the next one
+        m_pFreeLists[uClass] = *(void**)pBlock;
+        m_pFreeCounts[uClass]--;
+        m_stats.cachedBlocks--;
+        m_stats.pooledAllocations++;
+    }
+    else
+    {
+        m_stats.heapAllocations++;
+    }
+    m_stats.liveBlocks++;
+    pthread_mutex_unlock(&m_mutex);
+
+    if (pBlock == NULL)
+    {
+        pBlock = ::operator new((uClass + 1) * CC_OBJECT_POOL_GRANULARITY);
+    }
+
+    return pBlock;
+}
+
+void CCObjectPool::deallocate(void *pBlock, size_t uSize)
+{
+    if (pBlock == NULL)
+    {
+        return;
+    }
+
+    if (uSize == 0 || uSize > CC_OBJECT_POOL_MAX_BLOCK_SIZE)
+    {
+        ::operator delete(pBlock);
+        return;
+    }
+
+    unsigned int uClass = (unsigned int)((uSize - 1) / CC_OBJECT_POOL_GRANULARITY);
+
+    pthread_mutex_lock(&m_mutex);
+    m_stats.deallocations++;
+    m_stats.liveBlocks--;
+    if (m_pFreeCounts[uClass] < CC_OBJECT_POOL_MAX_CACHED_BLOCKS)
+    {
+        *(void**)pBlock = m_pFreeLists[uClass];
+        m_pFreeLists[uClass] = pBlock;
+        m_pFreeCounts[uClass]++;
+        m_stats.cachedBlocks++;
+        pBlock = NULL;
+    }
+    pthread_mutex_unlock(&m_mutex);
+
+    if (pBlock)
+    {
+        ::operator delete(pBlock);
+    }
+}
+
+void CCObjectPool::getStats(ccObjectPoolStats *pStats)
+{
+    CCAssert(pStats, "");
+
+    pthread_mutex_lock(&m_mutex);
+    *pStats = m_stats;
+    pthread_mutex_unlock(&m_mutex);
+}
+
+void CCObjectPool::resetStats()
+{
+    pthread_mutex_lock(&m_mutex);
+    m_stats.heapAllocations = 0;
+    m_stats.pooledAllocations = 0;
+    m_stats.deallocations = 0;
+    pthread_mutex_unlock(&m_mutex);
+}
+
+void CCObjectPool::purge()
+{
+    pthread_mutex_lock(&m_mutex);
+    for (unsigned int i = 0; i < kCCObjectPoolSizeClasses; ++i)
+    {
+        void *pBlock = m_pFreeLists[i];
+        while (pBlock)
+        {
+            void *pNext = *(void**)pBlock;
+            ::operator delete(pBlock);
+            pBlock = pNext;
+        }
+        m_pFreeLists[i] = NULL;
+        m_pFreeCounts[i] = 0;
+    }
+    m_stats.cachedBlocks = 0;
+    pthread_mutex_unlock(&m_mutex);
+}
+
+// The shared pools are never deleted: pooled objects may still be released while static objects are destroyed at exit.
+
+CCObjectPool* CCObjectPool::actionPool()
+{
+    static CCObjectPool *s_pActionPool = new CCObjectPool("CCAction");
+    return s_pActionPool;
+}
+
+CCObjectPool* CCObjectPool::timerPool()
+{
+    static CCObjectPool *s_pTimerPool = new CCObjectPool("CCTimer");
+    return s_pTimerPool;
+}
+
+CCObjectPool* CCObjectPool::touchPool()
+{
+    static CCObjectPool *s_pTouchPool = new CCObjectPool("CCTouch");
+    return s_pTouchPool;
+}
+
+CCObjectPool* CCObjectPool::setPool()
+{
+    static CCObjectPool *s_pSetPool = new CCObjectPool("CCSet");
+    return s_pSetPool;
+}
+
+void CCObjectPool::purgeAllPools()
+{
+    actionPool()->purge();
+    timerPool()->purge();
+    touchPool()->purge();
+    setPool()->purge();
+}
+
+void CCObjectPool::dumpAllStats()
+{
+    CCObjectPool *pools[] = { actionPool(), timerPool(), touchPool(), setPool() };
+
+    for (unsigned int i = 0; i < sizeof(pools) / sizeof(pools[0]); ++i)
+    {
+        ccObjectPoolStats stats;
+        pools[i]->getStats(&stats);
+        CCLOG("cocos2d: %s pool: heap=%u pooled=%u freed=%u live=%u cached=%u", pools[i]->getName(),
+              stats.heapAllocations, stats.pooledAllocations, stats.deallocations, stats.liveBlocks, stats.cachedBlocks);
+    }
+}
+
+NS_CC_END
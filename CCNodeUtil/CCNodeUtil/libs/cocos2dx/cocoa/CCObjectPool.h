@@ -0,0 +1,124 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CCOBJECTPOOL_H__
+#define __CCOBJECTPOOL_H__
+
+#include "platform/CCPlatformMacros.h"
+#include <pthread.h>
+#include <stddef.h>
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup base_nodes
+ * @{
+ */
+
+/** Allocation counters of a CCObjectPool */
+typedef struct _ccObjectPoolStats
+{
+    /** blocks that had to be requested from the heap */
+    unsigned int heapAllocations;
+    /** blocks served from a free list */
+    unsigned int pooledAllocations;
+    /** blocks given back to the pool */
+    unsigned int deallocations;
+    /** blocks currently in use */
+    unsigned int liveBlocks;
+    /** blocks waiting in the free lists */
+    unsigned int cachedBlocks;
+} ccObjectPoolStats;
+
+/** @brief Free-list allocator for small, frequently created CCObjects.
+
+ Blocks are grouped in size classes of CC_OBJECT_POOL_GRANULARITY bytes, so a single pool
+ serves a whole class hierarchy (every CCAction subclass, for example). Freed blocks are
+ kept for reuse instead of being returned to the heap; once the game reaches a steady state
+ heapAllocations stops growing. Blocks larger than CC_OBJECT_POOL_MAX_BLOCK_SIZE bypass the pool.
+
+ Classes opt in with CC_POOLED_ALLOCATION. Pools are thread safe.
+ @since v2.1.x
+ */
+class CC_DLL CCObjectPool
+{
+public:
+    CCObjectPool(const char *pszName);
+    ~CCObjectPool();
+
+    void* allocate(size_t uSize);
+    void deallocate(void *pBlock, size_t uSize);
+
+    /** copies the counters of the pool */
+    void getStats(ccObjectPoolStats *pStats);
+    /** resets heapAllocations, pooledAllocations and deallocations */
+    void resetStats();
+    /** returns the cached blocks to the heap */
+    void purge();
+
+    inline const char* getName() const { return m_pszName; }
+
+    /** pool of CCAction and its subclasses */
+    static CCObjectPool* actionPool();
+    /** pool of CCTimer */
+    static CCObjectPool* timerPool();
+    /** pool of CCTouch */
+    static CCObjectPool* touchPool();
+    /** pool of CCSet */
+    static CCObjectPool* setPool();
+
+    /** purges every pool, called on memory warnings */
+    static void purgeAllPools();
+    /** logs the counters of every pool */
+    static void dumpAllStats();
+
+private:
+    const char *m_pszName;
+    pthread_mutex_t m_mutex;
+    // one singly linked free list per size class
+    void **m_pFreeLists;
+    unsigned int *m_pFreeCounts;
+    ccObjectPoolStats m_stats;
+};
+
+// end of base_nodes group
+/// @}
+
+NS_CC_END
+
+/** @def CC_POOLED_ALLOCATION
+ Routes operator new and delete of a class, and of its subclasses, through the given CCObjectPool accessor.
+ Put it in the class declaration: CC_POOLED_ALLOCATION(actionPool).
+ Expands to nothing when CC_ENABLE_OBJECT_POOLS is 0.
+ */
+#if CC_ENABLE_OBJECT_POOLS
+#define CC_POOLED_ALLOCATION(__POOL__) \
+public: \
+    static void* operator new(size_t uSize) { return cocos2d::CCObjectPool::__POOL__()->allocate(uSize); } \
+    static void operator delete(void *pBlock, size_t uSize) { cocos2d::CCObjectPool::__POOL__()->deallocate(pBlock, uSize); }
+#else
+#define CC_POOLED_ALLOCATION(__POOL__)
+#endif
+
+#endif // __CCOBJECTPOOL_H__
@@ -27,6 +27,7 @@ THE SOFTWARE.
 
 #include <set>
 #include "CCObject.h"
+#include "CCObjectPool.h"
 
 NS_CC_BEGIN
 
@@ -39,6 +40,7 @@ typedef std::set<CCObject *>::iterator CCSetIterator;
 
 class CC_DLL CCSet : public CCObject
 {
+    CC_POOLED_ALLOCATION(setPool)
 public:
     CCSet(void);
     CCSet(const CCSet &rSetObject);
@@ -246,6 +246,132 @@ To enable set it to a value different than 0. Disabled by default.
 #define CC_ENABLE_PROFILERS 0
 #endif
 
+/** @def CC_ACTION_MANAGER_BATCH_TWEENS
+ If enabled, CCActionManager steps the common interval actions (move, scale, rotate, fade and tint,
+ plain or eased) in packed per-easing batches instead of calling step() on every action.
+ 
+ To disable set it to 0. Enabled by default.
+ */
+#ifndef CC_ACTION_MANAGER_BATCH_TWEENS
+#define CC_ACTION_MANAGER_BATCH_TWEENS 1
+#endif
+
+/** @def CC_ENABLE_OBJECT_POOLS
+ If enabled, CCAction, CCTimer, CCTouch and CCSet objects are allocated from CCObjectPool free lists
+ instead of the heap, so that steady-state frames don't allocate memory for them.
+ 
+ To disable set it to 0. Enabled by default.
+ */
+#ifndef CC_ENABLE_OBJECT_POOLS
+#define CC_ENABLE_OBJECT_POOLS 1
+#endif
+
+/** @def CC_OBJECT_POOL_GRANULARITY
+ Size class step of CCObjectPool, in bytes. Must be a multiple of the pointer size. Default value is 16.
+ */
+#ifndef CC_OBJECT_POOL_GRANULARITY
+#define CC_OBJECT_POOL_GRANULARITY 16
+#endif
+
+/** @def CC_OBJECT_POOL_MAX_BLOCK_SIZE
+ Objects larger than this, in bytes, bypass CCObjectPool. Default value is 512.
+ */
+#ifndef CC_OBJECT_POOL_MAX_BLOCK_SIZE
+#define CC_OBJECT_POOL_MAX_BLOCK_SIZE 512
+#endif
+
+/** @def CC_OBJECT_POOL_MAX_CACHED_BLOCKS
+ Maximum number of free blocks CCObjectPool keeps per size class; further blocks go back to the heap.
+ Default value is 4096.
+ */
+#ifndef CC_OBJECT_POOL_MAX_CACHED_BLOCKS
+#define CC_OBJECT_POOL_MAX_CACHED_BLOCKS 4096
+#endif
+
+/** @def CC_TEXTURE_CACHE_MAX_DECODE_JOBS
+ Maximum number of images CCTextureCache::addImageAsync decodes at the same time, each one in a CCJobSystem job.
+ Default value is 4.
+ */
+#ifndef CC_TEXTURE_CACHE_MAX_DECODE_JOBS
+#define CC_TEXTURE_CACHE_MAX_DECODE_JOBS 4
+#endif
+
+/** @def CC_UPLOAD_SCHEDULER_FRAME_BYTES
+ Default number of bytes per frame CCUploadScheduler may spend on postponed uploads, such as the textures
+ loaded by CCTextureCache::addImageAsync. Uploads needed to draw the frame are deducted from it.
+ Default value is 4 MB.
+ */
+#ifndef CC_UPLOAD_SCHEDULER_FRAME_BYTES
+#define CC_UPLOAD_SCHEDULER_FRAME_BYTES (4 * 1024 * 1024)
+#endif
+
+/** @def CC_UPLOAD_SCHEDULER_FRAME_TIME
+ Default time, in seconds, CCUploadScheduler may spend per frame on postponed uploads.
+ At least one postponed upload is performed every frame regardless. Default value is 0.004f (4 ms).
+ */
+#ifndef CC_UPLOAD_SCHEDULER_FRAME_TIME
+#define CC_UPLOAD_SCHEDULER_FRAME_TIME (0.004f)
+#endif
+
+/** @def CC_PARTICLE_USE_SIMD
+ If enabled, CCParticleSystem steps its particles with SSE or NEON intrinsics when the
+ target supports them, 4 particles at a time.
+ Set it to 0 to always use the scalar loops. Enabled by default.
+ */
+#ifndef CC_PARTICLE_USE_SIMD
+#define CC_PARTICLE_USE_SIMD 1
+#endif
+
+/** @def CC_PARTICLE_PARALLEL_UPDATE
+ If enabled, particle systems step their particles and build their quads on the CCJobSystem
+ worker threads, see CCParticleSystem::setParallelUpdate().
+ 
+ To enable set it to a value different than 0. Disabled by default.
+ */
+#ifndef CC_PARTICLE_PARALLEL_UPDATE
+#define CC_PARTICLE_PARALLEL_UPDATE 0
+#endif
+
+/** @def CC_TEXTURE_ATLAS_FULL_UPLOAD_RATIO
+ CCTextureAtlas uploads all of its quads at once when at least 1/N of them are dirty,
+ and only the dirty ranges otherwise.
+ 
+ Default value is 2.
+ */
+#ifndef CC_TEXTURE_ATLAS_FULL_UPLOAD_RATIO
+#define CC_TEXTURE_ATLAS_FULL_UPLOAD_RATIO 2
+#endif
+
+/** @def CC_TMX_LAYER_CHUNK_SIZE
+ Number of tiles on every side of the chunks a CCTMXLayer is split into.
+ Every chunk has its own atlas which is only built once the chunk gets on screen,
+ and released again once it is far enough off screen.
+ 
+ Bigger chunks mean fewer draw calls, smaller ones less memory for large maps. Default value is 32.
+ */
+#ifndef CC_TMX_LAYER_CHUNK_SIZE
+#define CC_TMX_LAYER_CHUNK_SIZE 32
+#endif
+
+/** @def CC_TEXTURE_CONVERSION_USE_SIMD
+ If enabled, CCTexture2D repacks images into the 16 and 8 bit pixel formats with SSE2 or
+ NEON intrinsics when the target supports them. The results are identical to the scalar loops.
+ Set it to 0 to always use the scalar loops. Enabled by default.
+ */
+#ifndef CC_TEXTURE_CONVERSION_USE_SIMD
+#define CC_TEXTURE_CONVERSION_USE_SIMD 1
+#endif
+
+/** @def CC_JOB_SYSTEM_MAX_WORKERS
+ Upper bound on the number of worker threads created by CCJobSystem.
+ The job system uses one worker per additional CPU core, up to this limit.
+ 
+ To run every job inline on the calling thread set it to 0. Default value is 8.
+ */
+#ifndef CC_JOB_SYSTEM_MAX_WORKERS
+#define CC_JOB_SYSTEM_MAX_WORKERS 8
+#endif
+
 /** Enable Lua engine debug log */
 #ifndef CC_LUA_ENGINE_DEBUG
 #define CC_LUA_ENGINE_DEBUG 0
@@ -63,6 +63,7 @@ THE SOFTWARE.
 #include "cocoa/CCGeometry.h"
 #include "cocoa/CCSet.h"
 #include "cocoa/CCAutoreleasePool.h"
+#include "cocoa/CCObjectPool.h"
 #include "cocoa/CCInteger.h"
 #include "cocoa/CCFloat.h"
 #include "cocoa/CCDouble.h"
@@ -118,6 +119,7 @@ THE SOFTWARE.
 
 // particle_nodes
 #include "particle_nodes/CCParticleBatchNode.h"
+#include "particle_nodes/CCParticleData.h"
 #include "particle_nodes/CCParticleSystem.h"
 #include "particle_nodes/CCParticleExamples.h"
 #include "particle_nodes/CCParticleSystemQuad.h"
@@ -210,9 +212,12 @@ THE SOFTWARE.
 #include "sprite_nodes/CCSpriteFrameCache.h"
 
 // support
+#include "support/CCAssetPack.h"
+#include "support/CCJobSystem.h"
 #include "support/CCNotificationCenter.h"
 #include "support/CCPointExtension.h"
 #include "support/CCProfiling.h"
+#include "support/CCUploadScheduler.h"
 #include "support/CCUserDefault.h"
 #include "support/CCVertex.h"
 
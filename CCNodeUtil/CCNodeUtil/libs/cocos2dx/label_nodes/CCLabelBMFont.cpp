@@ -402,9 +402,6 @@ CCBMFontConfiguration * CCBMFontConfiguration::create(const char *FNTfile)
 
 bool CCBMFontConfiguration::initWithFNTfile(const char *FNTfile)
 {
-    m_pKerningDictionary = NULL;
-    m_pFontDefDictionary = NULL;
-    
     m_pCharacterSet = this->parseConfigFile(FNTfile);
     
     if (! m_pCharacterSet)
@@ -421,12 +418,13 @@ std::set<unsigned int>* CCBMFontConfiguration::getCharacterSet() const
 }
 
 CCBMFontConfiguration::CCBMFontConfiguration()
-: m_pFontDefDictionary(NULL)
-, m_nCommonHeight(0)
-, m_pKerningDictionary(NULL)
+: m_nCommonHeight(0)
+, m_pKernings(NULL)
+, m_uKerningMask(0)
+, m_uKerningCount(0)
 , m_pCharacterSet(NULL)
 {
-
+    memset(m_pFontDefPages, 0, sizeof(m_pFontDefPages));
 }
 
 CCBMFontConfiguration::~CCBMFontConfiguration()
@@ -443,30 +441,99 @@ const char* CCBMFontConfiguration::description(void)
     return CCString::createWithFormat(
         "<CCBMFontConfiguration = %08X | Glphys:%d Kernings:%d | Image = %s>",
         this,
-        HASH_COUNT(m_pFontDefDictionary),
-        HASH_COUNT(m_pKerningDictionary),
+        (int)m_fontDefs.size(),
+        (int)m_uKerningCount,
         m_sAtlasName.c_str()
     )->getCString();
 }
 
 void CCBMFontConfiguration::purgeKerningDictionary()
 {
-    tCCKerningHashElement *current;
-    while(m_pKerningDictionary) 
-    {
-        current = m_pKerningDictionary; 
-        HASH_DEL(m_pKerningDictionary,current);
-        free(current);
-    }
+    free(m_pKernings);
+    m_pKernings = NULL;
+    m_uKerningMask = 0;
+    m_uKerningCount = 0;
 }
 
 void CCBMFontConfiguration::purgeFontDefDictionary()
 {    
-    tCCFontDefHashElement *current, *tmp;
+    for (unsigned int i = 0; i < 256; i++)
+    {
+        free(m_pFontDefPages[i]);
+        m_pFontDefPages[i] = NULL;
+    }
+    m_fontDefs.clear();
+}
+
+// kerning keys can't be 0xffffffff, characters are 16-bit and U+FFFF isn't a character
+#define kCCBMFontEmptyKerning   0xffffffff
+
+static unsigned int hashOfKerning(unsigned int key)
+{
+    key = ((key >> 16) ^ key) * 0x45d9f3b;
+    return (key >> 16) ^ key;
+}
+
+void CCBMFontConfiguration::addKerning(unsigned int key, int amount)
+{
+    // keep the table at most half full, so the lookups stay short
+    unsigned int capacity = m_pKernings ? m_uKerningMask + 1 : 0;
+    if ((m_uKerningCount + 1) * 2 > capacity)
+    {
+        unsigned int newCapacity = capacity ? capacity * 2 : 64;
+        ccBMFontKerning *pKernings = (ccBMFontKerning*)malloc(newCapacity * sizeof(ccBMFontKerning));
+        memset(pKernings, 0xff, newCapacity * sizeof(ccBMFontKerning));
+
+        for (unsigned int i = 0; i < capacity; i++)
+        {
+            if (m_pKernings[i].key != kCCBMFontEmptyKerning)
+            {
+                unsigned int slot = hashOfKerning(m_pKernings[i].key) & (newCapacity - 1);
+                while (pKernings[slot].key != kCCBMFontEmptyKerning)
+                {
+                    slot = (slot + 1) & (newCapacity - 1);
+                }
+                pKernings[slot] = m_pKernings[i];
+            }
+        }
+
+        free(m_pKernings);
+        m_pKernings = pKernings;
+        m_uKerningMask = newCapacity - 1;
+    }
+
+    unsigned int slot = hashOfKerning(key) & m_uKerningMask;
+    while (m_pKernings[slot].key != kCCBMFontEmptyKerning && m_pKernings[slot].key != key)
+    {
+        slot = (slot + 1) & m_uKerningMask;
+    }
+    if (m_pKernings[slot].key == kCCBMFontEmptyKerning)
+    {
+        m_uKerningCount++;
+    }
+    m_pKernings[slot].key = key;
+    m_pKernings[slot].amount = amount;
+}
+
+int CCBMFontConfiguration::getKerningAmount(unsigned short first, unsigned short second) const
+{
+    if (! m_pKernings)
+    {
+        return 0;
+    }
 
-    HASH_ITER(hh, m_pFontDefDictionary, current, tmp) {
-        HASH_DEL(m_pFontDefDictionary, current);
-        free(current);
+    unsigned int key = ((unsigned int)first << 16) | second;
+    for (unsigned int slot = hashOfKerning(key) & m_uKerningMask; ; slot = (slot + 1) & m_uKerningMask)
+    {
+        const ccBMFontKerning& kerning = m_pKernings[slot];
+        if (kerning.key == key)
+        {
+            return kerning.amount;
+        }
+        if (kerning.key == kCCBMFontEmptyKerning)
+        {
+            return 0;
+        }
     }
 }
 
@@ -528,13 +595,23 @@ std::set<unsigned int>* CCBMFontConfiguration::parseConfigFile(const char *contr
         else if(line.substr(0,strlen("char")) == "char")
         {
             // Parse the current line and create a new CharDef
-            tCCFontDefHashElement* element = (tCCFontDefHashElement*)malloc( sizeof(*element) );
-            this->parseCharacterDefinition(line, &element->fontDef);
+            ccBMFontDef fontDef;
+            this->parseCharacterDefinition(line, &fontDef);
+            m_fontDefs.push_back(fontDef);
 
-            element->key = element->fontDef.charID;
-            HASH_ADD_INT(m_pFontDefDictionary, key, element);
+            // labels are UTF-16, the characters beyond can't be looked up
+            if (fontDef.charID <= 0xffff)
+            {
+                unsigned int *pPage = m_pFontDefPages[fontDef.charID >> 8];
+                if (! pPage)
+                {
+                    pPage = (unsigned int*)calloc(256, sizeof(unsigned int));
+                    m_pFontDefPages[fontDef.charID >> 8] = pPage;
+                }
+                pPage[fontDef.charID & 0xff] = m_fontDefs.size();
+            }
             
-            validCharsString->insert(element->fontDef.charID);
+            validCharsString->insert(fontDef.charID);
         }
 //        else if(line.substr(0,strlen("kernings count")) == "kernings count")
 //        {
@@ -694,10 +771,7 @@ void CCBMFontConfiguration::parseKerningEntry(std::string line)
     value = line.substr(index, index2-index);
     sscanf(value.c_str(), "amount=%d", &amount);
 
-    tCCKerningHashElement *element = (tCCKerningHashElement *)calloc( sizeof( *element ), 1 );
-    element->amount = amount;
-    element->key = (first<<16) | (second&0xffff);
-    HASH_ADD_INT(m_pKerningDictionary,key, element);
+    addKerning((first<<16) | (second&0xffff), amount);
 }
 //
 //CCLabelBMFont
@@ -801,10 +875,6 @@ bool CCLabelBMFont::initWithString(const char *theString, const char *fntFile, f
         m_bIsOpacityModifyRGB = m_pobTextureAtlas->getTexture()->hasPremultipliedAlpha();
         m_obAnchorPoint = ccp(0.5f, 0.5f);
         
-        m_pReusedChar = new CCSprite();
-        m_pReusedChar->initWithTexture(m_pobTextureAtlas->getTexture(), CCRectMake(0, 0, 0, 0), false);
-        m_pReusedChar->setBatchNode(this);
-        
         this->setString(theString);
         
         return true;
@@ -819,13 +889,15 @@ CCLabelBMFont::CCLabelBMFont()
 , m_sString(NULL)
 , m_bLineBreakWithoutSpaces(false)
 , m_tImageOffset(CCPointZero)
+, m_bKerningEnabled(false)
+, m_bGlyphSpritesEnabled(true)
+, m_bGlyphQuadsDirty(false)
 {
 
 }
 
 CCLabelBMFont::~CCLabelBMFont()
 {
-    CC_SAFE_RELEASE(m_pReusedChar);
     CC_SAFE_DELETE(m_sString);
     CC_SAFE_RELEASE(m_pConfiguration);
 }
@@ -833,23 +905,14 @@ CCLabelBMFont::~CCLabelBMFont()
 // LabelBMFont - Atlas generation
 int CCLabelBMFont::kerningAmountForFirst(unsigned short first, unsigned short second)
 {
-    int ret = 0;
-    unsigned int key = (first<<16) | (second & 0xffff);
-
-    if( m_pConfiguration->m_pKerningDictionary ) {
-        tCCKerningHashElement *element = NULL;
-        HASH_FIND_INT(m_pConfiguration->m_pKerningDictionary, &key, element);        
-        if(element)
-            ret = element->amount;
-    }
-    return ret;
+    return m_pConfiguration->getKerningAmount(first, second);
 }
 
 void CCLabelBMFont::createFontChars()
 {
     int nextFontPositionX = 0;
     int nextFontPositionY = 0;
-    //unsigned short prev = -1;
+    unsigned short prev = -1;
     int kerningAmount = 0;
 
     CCSize tmpSize = CCSizeZero;
@@ -859,13 +922,19 @@ void CCLabelBMFont::createFontChars()
 
     unsigned int quantityOfLines = 1;
     unsigned int stringLen = cc_wcslen(m_sString);
+
+    if (! m_bGlyphSpritesEnabled)
+    {
+        // the quads are written from the glyphs before the next draw
+        m_glyphs.resize(stringLen);
+        m_bGlyphQuadsDirty = true;
+    }
+
     if (stringLen == 0)
     {
         return;
     }
 
-    set<unsigned int> *charSet = m_pConfiguration->getCharacterSet();
-
     for (unsigned int i = 0; i < stringLen - 1; ++i)
     {
         unsigned short c = m_sString[i];
@@ -877,7 +946,7 @@ void CCLabelBMFont::createFontChars()
 
     totalHeight = m_pConfiguration->m_nCommonHeight * quantityOfLines;
     nextFontPositionY = 0-(m_pConfiguration->m_nCommonHeight - m_pConfiguration->m_nCommonHeight * quantityOfLines);
-    
+
     CCRect rect;
     ccBMFontDef fontDef;
 
@@ -885,103 +954,91 @@ void CCLabelBMFont::createFontChars()
     {
         unsigned short c = m_sString[i];
 
+        if (! m_bGlyphSpritesEnabled)
+        {
+            m_glyphs[i].pFontDef = NULL;
+        }
+
         if (c == '\n')
         {
             nextFontPositionX = 0;
             nextFontPositionY -= m_pConfiguration->m_nCommonHeight;
+            prev = -1;
             continue;
         }
-        
-        if (charSet->find(c) == charSet->end())
+
+        const ccBMFontDef *pFontDef = m_pConfiguration->getFontDef(c);
+        if (! pFontDef)
         {
             CCLOG("CCLabelBMFont: Attempted to use character not defined in this bitmap: %d", c);
-            continue;      
+            continue;
         }
 
-        tCCFontDefHashElement *element = NULL;
-
-        // unichar is a short, and an int is needed on HASH_FIND_INT
-        unsigned int key = c;
-        HASH_FIND_INT(m_pConfiguration->m_pFontDefDictionary, &key, element);
-        if (! element)
+        fontDef = *pFontDef;
+        if (m_bKerningEnabled)
         {
-            CCLOG("cocos2d: LabelBMFont: characer not found %d", c);
-            continue;
+            kerningAmount = this->kerningAmountForFirst(prev, c);
         }
 
-        fontDef = element->fontDef;
-
         rect = fontDef.rect;
         rect = CC_RECT_PIXELS_TO_POINTS(rect);
 
         rect.origin.x += m_tImageOffset.x;
         rect.origin.y += m_tImageOffset.y;
 
-        CCSprite *fontChar;
+        // See issue 1343. cast( signed short + unsigned integer ) == unsigned integer (sign is lost!)
+        int yOffset = m_pConfiguration->m_nCommonHeight - fontDef.yOffset;
+        CCPoint fontPos = ccp( (float)nextFontPositionX + fontDef.xOffset + fontDef.rect.size.width*0.5f + kerningAmount,
+            (float)nextFontPositionY + yOffset - rect.size.height*0.5f * CC_CONTENT_SCALE_FACTOR() );
 
-        bool hasSprite = true;
-        fontChar = (CCSprite*)(this->getChildByTag(i));
-        if( ! fontChar )
+        if (! m_bGlyphSpritesEnabled)
         {
-            if( 0 )
-            {
-				/* WIP: Doesn't support many features yet.
-				 But this code is super fast. It doesn't create any sprite.
-				 Ideal for big labels.
-				 */
-				fontChar = m_pReusedChar;
-				fontChar->setBatchNode(NULL);
-				hasSprite = false;
-			}
-            else
+            m_glyphs[i].pFontDef = pFontDef;
+            m_glyphs[i].position = CC_POINT_PIXELS_TO_POINTS(fontPos);
+        }
+        else
+        {
+            CCSprite *fontChar = (CCSprite*)(this->getChildByTag(i));
+            if( ! fontChar )
             {
                 fontChar = new CCSprite();
                 fontChar->initWithTexture(m_pobTextureAtlas->getTexture(), rect);
                 addChild(fontChar, i, i);
                 fontChar->release();
-			}
-        }
-        else
-        {
-            // updating previous sprite
-            fontChar->setTextureRect(rect, false, rect.size);
+            }
+            else
+            {
+                // updating previous sprite
+                fontChar->setTextureRect(rect, false, rect.size);
 
-            // restore to default in case they were modified
-            fontChar->setVisible(true);
-            fontChar->setOpacity(255);
-        }
+                // restore to default in case they were modified
+                fontChar->setVisible(true);
+                fontChar->setOpacity(255);
+            }
 
-        // See issue 1343. cast( signed short + unsigned integer ) == unsigned integer (sign is lost!)
-        int yOffset = m_pConfiguration->m_nCommonHeight - fontDef.yOffset;
-        CCPoint fontPos = ccp( (float)nextFontPositionX + fontDef.xOffset + fontDef.rect.size.width*0.5f + kerningAmount,
-            (float)nextFontPositionY + yOffset - rect.size.height*0.5f * CC_CONTENT_SCALE_FACTOR() );
-        fontChar->setPosition(CC_POINT_PIXELS_TO_POINTS(fontPos));
+            fontChar->setPosition(CC_POINT_PIXELS_TO_POINTS(fontPos));
 
-        // update kerning
-        nextFontPositionX += fontDef.xAdvance + kerningAmount;
-        //prev = c;
-
-        // Apply label properties
-        fontChar->setOpacityModifyRGB(m_bIsOpacityModifyRGB);
-        // Color MUST be set before opacity, since opacity might change color if OpacityModifyRGB is on
-        fontChar->setColor(m_tColor);
+            // Apply label properties
+            fontChar->setOpacityModifyRGB(m_bIsOpacityModifyRGB);
+            // Color MUST be set before opacity, since opacity might change color if OpacityModifyRGB is on
+            fontChar->setColor(m_tColor);
 
-        // only apply opacity if it is different than 255 )
-        // to prevent modifying the color too (issue #610)
-        if( m_cOpacity != 255 )
-        {
-            fontChar->setOpacity(m_cOpacity);
+            // only apply opacity if it is different than 255 )
+            // to prevent modifying the color too (issue #610)
+            if( m_cOpacity != 255 )
+            {
+                fontChar->setOpacity(m_cOpacity);
+            }
         }
 
+        // update kerning
+        nextFontPositionX += fontDef.xAdvance + kerningAmount;
+        prev = c;
+
         if (longestLine < nextFontPositionX)
         {
             longestLine = nextFontPositionX;
         }
-        
-        if (! hasSprite)
-        {
-            updateQuadFromSprite(fontChar, i);
-        }
     }
 
     // If the last character processed has an xAdvance which is less that the width of the characters image, then we need
@@ -1000,6 +1057,139 @@ void CCLabelBMFont::createFontChars()
     this->setContentSize(CC_SIZE_PIXELS_TO_POINTS(tmpSize));
 }
 
+void CCLabelBMFont::updateGlyphQuads()
+{
+    m_bGlyphQuadsDirty = false;
+
+    unsigned int quadCount = 0;
+    for (vector<ccBMFontGlyph>::const_iterator it = m_glyphs.begin(); it != m_glyphs.end(); ++it)
+    {
+        if (it->pFontDef)
+        {
+            quadCount++;
+        }
+    }
+
+    if (quadCount > m_pobTextureAtlas->getCapacity())
+    {
+        m_pobTextureAtlas->resizeCapacity(quadCount);
+    }
+
+    CCTexture2D *texture = m_pobTextureAtlas->getTexture();
+    float atlasWidth = (float)texture->getPixelsWide();
+    float atlasHeight = (float)texture->getPixelsHigh();
+    CCPoint imageOffset = CC_POINT_POINTS_TO_PIXELS(m_tImageOffset);
+
+    // the same colors as the sprites would have
+    ccColor4B color = { m_tColor.r, m_tColor.g, m_tColor.b, m_cOpacity };
+    if (m_bIsOpacityModifyRGB)
+    {
+        color.r = (GLubyte)(color.r * m_cOpacity / 255.0f);
+        color.g = (GLubyte)(color.g * m_cOpacity / 255.0f);
+        color.b = (GLubyte)(color.b * m_cOpacity / 255.0f);
+    }
+
+    ccV3F_C4B_T2F_Quad quad;
+    quad.bl.colors = color;
+    quad.br.colors = color;
+    quad.tl.colors = color;
+    quad.tr.colors = color;
+
+    // only the quads whose glyph changed are written again
+    unsigned int cachedCount = m_quadGlyphs.size();
+    m_quadGlyphs.resize(quadCount);
+
+    unsigned int index = 0;
+    for (vector<ccBMFontGlyph>::const_iterator it = m_glyphs.begin(); it != m_glyphs.end(); ++it)
+    {
+        if (! it->pFontDef)
+        {
+            continue;
+        }
+
+        ccBMFontGlyph& cached = m_quadGlyphs[index];
+        if (index < cachedCount && cached.pFontDef == it->pFontDef && cached.position.equals(it->position))
+        {
+            index++;
+            continue;
+        }
+        cached = *it;
+
+        // like CCSprite::setTextureCoords(), but the rect of the font definition is already in pixels
+        const CCRect& rect = it->pFontDef->rect;
+#if CC_FIX_ARTIFACTS_BY_STRECHING_TEXEL
+        float left      = (2*(rect.origin.x + imageOffset.x)+1)/(2*atlasWidth);
+        float right     = left + (rect.size.width*2-2)/(2*atlasWidth);
+        float top       = (2*(rect.origin.y + imageOffset.y)+1)/(2*atlasHeight);
+        float bottom    = top + (rect.size.height*2-2)/(2*atlasHeight);
+#else
+        float left      = (rect.origin.x + imageOffset.x)/atlasWidth;
+        float right     = (rect.origin.x + imageOffset.x + rect.size.width)/atlasWidth;
+        float top       = (rect.origin.y + imageOffset.y)/atlasHeight;
+        float bottom    = (rect.origin.y + imageOffset.y + rect.size.height)/atlasHeight;
+#endif // ! CC_FIX_ARTIFACTS_BY_STRECHING_TEXEL
+
+        quad.bl.texCoords.u = left;
+        quad.bl.texCoords.v = bottom;
+        quad.br.texCoords.u = right;
+        quad.br.texCoords.v = bottom;
+        quad.tl.texCoords.u = left;
+        quad.tl.texCoords.v = top;
+        quad.tr.texCoords.u = right;
+        quad.tr.texCoords.v = top;
+
+        // the glyph is centered on its position, like a sprite with an anchor point of (0.5, 0.5)
+        float width = rect.size.width / CC_CONTENT_SCALE_FACTOR();
+        float height = rect.size.height / CC_CONTENT_SCALE_FACTOR();
+        float x1 = it->position.x - width * 0.5f;
+        float y1 = it->position.y - height * 0.5f;
+
+        quad.bl.vertices = vertex3(x1, y1, 0);
+        quad.br.vertices = vertex3(x1 + width, y1, 0);
+        quad.tl.vertices = vertex3(x1, y1 + height, 0);
+        quad.tr.vertices = vertex3(x1 + width, y1 + height, 0);
+
+        m_pobTextureAtlas->updateQuad(&quad, index);
+        index++;
+    }
+
+    unsigned int totalQuads = m_pobTextureAtlas->getTotalQuads();
+    if (totalQuads > quadCount)
+    {
+        m_pobTextureAtlas->removeQuadsAtIndex(quadCount, totalQuads - quadCount);
+    }
+}
+
+void CCLabelBMFont::setGlyphSpritesEnabled(bool bEnabled)
+{
+    if (m_bGlyphSpritesEnabled == bEnabled)
+    {
+        return;
+    }
+
+    m_bGlyphSpritesEnabled = bEnabled;
+
+    // the quads of the sprites and those of the glyphs can't be mixed
+    removeAllChildrenWithCleanup(true);
+    m_pobTextureAtlas->removeAllQuads();
+    m_glyphs.clear();
+    m_quadGlyphs.clear();
+    m_bGlyphQuadsDirty = false;
+
+    updateLabel();
+}
+
+void CCLabelBMFont::setKerningEnabled(bool bEnabled)
+{
+    if (m_bKerningEnabled == bEnabled)
+    {
+        return;
+    }
+
+    m_bKerningEnabled = bEnabled;
+    updateLabel();
+}
+
 //LabelBMFont - CCLabelProtocol protocol
 void CCLabelBMFont::setString(const char *newString)
 {
@@ -1055,6 +1245,12 @@ void CCLabelBMFont::setCString(const char *label)
 void CCLabelBMFont::setColor(const ccColor3B& var)
 {
     m_tColor = var;
+    if (! m_bGlyphSpritesEnabled)
+    {
+        // every quad has to be written again
+        m_quadGlyphs.clear();
+        m_bGlyphQuadsDirty = true;
+    }
     if (m_pChildren && m_pChildren->count() != 0)
     {
         CCObject* child;
@@ -1077,6 +1273,11 @@ const ccColor3B& CCLabelBMFont::getColor()
 void CCLabelBMFont::setOpacity(GLubyte var)
 {
     m_cOpacity = var;
+    if (! m_bGlyphSpritesEnabled)
+    {
+        m_quadGlyphs.clear();
+        m_bGlyphQuadsDirty = true;
+    }
 
     if (m_pChildren && m_pChildren->count() != 0)
     {
@@ -1102,6 +1303,11 @@ GLubyte CCLabelBMFont::getOpacity()
 void CCLabelBMFont::setOpacityModifyRGB(bool var)
 {
     m_bIsOpacityModifyRGB = var;
+    if (! m_bGlyphSpritesEnabled)
+    {
+        m_quadGlyphs.clear();
+        m_bGlyphQuadsDirty = true;
+    }
     if (m_pChildren && m_pChildren->count() != 0)
     {
         CCObject* child;
@@ -1152,19 +1358,13 @@ void CCLabelBMFont::updateLabel()
         unsigned int line = 1, i = 0;
         bool start_line = false, start_word = false;
         float startOfLine = -1, startOfWord = -1;
-        int skip = 0;
 
-        CCArray* children = getChildren();
-        for (unsigned int j = 0; j < children->count(); j++)
-        {
-            CCSprite* characterSprite;
-
-            while (!(characterSprite = (CCSprite*)this->getChildByTag(j + skip)))
-                skip++;
-
-            if (!characterSprite->isVisible())
-                continue;
+        // horizontal edges of the visible letters, in the order of the string
+        vector<float> letterLefts, letterRights;
+        getLetterEdges(letterLefts, letterRights);
 
+        for (unsigned int j = 0; j < letterLefts.size(); j++)
+        {
             if (i >= stringLength)
                 break;
 
@@ -1172,7 +1372,7 @@ void CCLabelBMFont::updateLabel()
 
             if (!start_word)
             {
-                startOfWord = getLetterPosXLeft( characterSprite );
+                startOfWord = letterLefts[j];
                 start_word = true;
             }
             if (!start_line)
@@ -1203,7 +1403,7 @@ void CCLabelBMFont::updateLabel()
 
                 if (!startOfWord)
                 {
-                    startOfWord = getLetterPosXLeft( characterSprite );
+                    startOfWord = letterLefts[j];
                     start_word = true;
                 }
                 if (!startOfLine)
@@ -1226,7 +1426,7 @@ void CCLabelBMFont::updateLabel()
             }
 
             // Out of bounds.
-            if ( getLetterPosXRight( characterSprite ) - startOfLine > m_fWidth )
+            if ( letterRights[j] - startOfLine > m_fWidth )
             {
                 if (!m_bLineBreakWithoutSpaces)
                 {
@@ -1264,7 +1464,7 @@ void CCLabelBMFont::updateLabel()
 
                     if (!startOfWord)
                     {
-                        startOfWord = getLetterPosXLeft( characterSprite );
+                        startOfWord = letterLefts[j];
                         start_word = true;
                     }
                     if (!startOfLine)
@@ -1327,11 +1527,21 @@ void CCLabelBMFont::updateLabel()
                 int index = i + line_length - 1 + lineNumber;
                 if (index < 0) continue;
 
-                CCSprite* lastChar = (CCSprite*)getChildByTag(index);
-                if ( lastChar == NULL )
-                    continue;
+                if (m_bGlyphSpritesEnabled)
+                {
+                    CCSprite* lastChar = (CCSprite*)getChildByTag(index);
+                    if ( lastChar == NULL )
+                        continue;
+
+                    lineWidth = lastChar->getPosition().x + lastChar->getContentSize().width/2.0f;
+                }
+                else
+                {
+                    if (index >= (int)m_glyphs.size() || m_glyphs[index].pFontDef == NULL)
+                        continue;
 
-                lineWidth = lastChar->getPosition().x + lastChar->getContentSize().width/2.0f;
+                    lineWidth = m_glyphs[index].position.x + m_glyphs[index].pFontDef->rect.size.width/CC_CONTENT_SCALE_FACTOR()/2.0f;
+                }
 
                 float shift = 0;
                 switch (m_pAlignment)
@@ -1353,8 +1563,15 @@ void CCLabelBMFont::updateLabel()
                         index = i + j + lineNumber;
                         if (index < 0) continue;
 
-                        CCSprite* characterSprite = (CCSprite*)getChildByTag(index);
-                        characterSprite->setPosition(ccpAdd(characterSprite->getPosition(), ccp(shift, 0.0f)));
+                        if (m_bGlyphSpritesEnabled)
+                        {
+                            CCSprite* characterSprite = (CCSprite*)getChildByTag(index);
+                            characterSprite->setPosition(ccpAdd(characterSprite->getPosition(), ccp(shift, 0.0f)));
+                        }
+                        else if (index < (int)m_glyphs.size())
+                        {
+                            m_glyphs[index].position.x += shift;
+                        }
                     }
                 }
 
@@ -1407,14 +1624,44 @@ void CCLabelBMFont::setScaleY(float scaleY)
     updateLabel();
 }
 
-float CCLabelBMFont::getLetterPosXLeft( CCSprite* sp )
+void CCLabelBMFont::getLetterEdges(vector<float>& lefts, vector<float>& rights)
 {
-    return sp->getPosition().x * m_fScaleX - (sp->getContentSize().width * m_fScaleX * sp->getAnchorPoint().x);
-}
+    if (! m_bGlyphSpritesEnabled)
+    {
+        for (vector<ccBMFontGlyph>::const_iterator it = m_glyphs.begin(); it != m_glyphs.end(); ++it)
+        {
+            if (it->pFontDef)
+            {
+                float halfWidth = it->pFontDef->rect.size.width / CC_CONTENT_SCALE_FACTOR() * m_fScaleX * 0.5f;
+                lefts.push_back(it->position.x * m_fScaleX - halfWidth);
+                rights.push_back(it->position.x * m_fScaleX + halfWidth);
+            }
+        }
+        return;
+    }
 
-float CCLabelBMFont::getLetterPosXRight( CCSprite* sp )
-{
-    return sp->getPosition().x * m_fScaleX + (sp->getContentSize().width * m_fScaleX * sp->getAnchorPoint().x);
+    // the letters are tagged with their index in the string
+    unsigned int stringLen = cc_wcslen(m_sString);
+    vector<CCSprite*> letters(stringLen, (CCSprite*)NULL);
+    CCObject* child;
+    CCARRAY_FOREACH(m_pChildren, child)
+    {
+        CCSprite* sp = (CCSprite*)child;
+        if (sp->isVisible() && sp->getTag() >= 0 && (unsigned int)sp->getTag() < stringLen)
+        {
+            letters[sp->getTag()] = sp;
+        }
+    }
+
+    for (unsigned int i = 0; i < stringLen; i++)
+    {
+        CCSprite* sp = letters[i];
+        if (sp)
+        {
+            lefts.push_back(sp->getPosition().x * m_fScaleX - (sp->getContentSize().width * m_fScaleX * sp->getAnchorPoint().x));
+            rights.push_back(sp->getPosition().x * m_fScaleX + (sp->getContentSize().width * m_fScaleX * sp->getAnchorPoint().x));
+        }
+    }
 }
 
 // LabelBMFont - FntFile
@@ -1432,6 +1679,9 @@ void CCLabelBMFont::setFntFile(const char* fntFile)
         CC_SAFE_RELEASE(m_pConfiguration);
         m_pConfiguration = newConf;
 
+        // the cached glyphs point into the previous configuration
+        m_quadGlyphs.clear();
+
         this->setTexture(CCTextureCache::sharedTextureCache()->addImage(m_pConfiguration->getAtlasName()));
         this->createFontChars();
     }
@@ -1443,19 +1693,24 @@ const char* CCLabelBMFont::getFntFile()
 }
 
 
-//LabelBMFont - Debug draw
-#if CC_LABELBMFONT_DEBUG_DRAW
+//LabelBMFont - draw
 void CCLabelBMFont::draw()
 {
+    if (m_bGlyphQuadsDirty)
+    {
+        updateGlyphQuads();
+    }
+
     CCSpriteBatchNode::draw();
+
+#if CC_LABELBMFONT_DEBUG_DRAW
     const CCSize& s = this->getContentSize();
     CCPoint vertices[4]={
         ccp(0,0),ccp(s.width,0),
         ccp(s.width,s.height),ccp(0,s.height),
     };
     ccDrawPoly(vertices, 4, true);
-}
-
 #endif // CC_LABELBMFONT_DEBUG_DRAW
+}
 
 NS_CC_END
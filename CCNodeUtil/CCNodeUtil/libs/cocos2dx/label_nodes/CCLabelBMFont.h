@@ -34,7 +34,6 @@ Use any of these editors to generate BMFonts:
 #define __CCBITMAP_FONT_ATLAS_H__
 
 #include "sprite_nodes/CCSpriteBatchNode.h"
-#include "support/data_support/uthash.h"
 #include <map>
 #include <sstream>
 #include <iostream>
@@ -53,8 +52,6 @@ enum {
     kCCLabelAutomaticWidth = -1,
 };
 
-struct _FontDefHashElement;
-
 /**
 @struct ccBMFontDef
 BMFont definition
@@ -87,20 +84,27 @@ typedef struct _BMFontPadding {
     int bottom;
 } ccBMFontPadding;
 
-typedef struct _FontDefHashElement
-{
-	unsigned int	key;		// key. Font Unicode value
-	ccBMFontDef		fontDef;	// font definition
-	UT_hash_handle	hh;
-} tCCFontDefHashElement;
-
-// Equal function for targetSet.
-typedef struct _KerningHashElement
-{
-	int				key;		// key for the hash. 16-bit for 1st element, 16-bit for 2nd element
-	int				amount;
-	UT_hash_handle	hh;
-} tCCKerningHashElement;
+/** @struct ccBMFontKerning
+BMFont kerning between two characters
+@since v2.1.x
+*/
+typedef struct _BMFontKerning {
+    /// 16-bit for the 1st character, 16-bit for the 2nd one
+    unsigned int key;
+    /// amount added to the advance of the 1st character (in pixels)
+    int amount;
+} ccBMFontKerning;
+
+/** @struct ccBMFontGlyph
+Placement of a character of a CCLabelBMFont which renders without sprites
+@since v2.1.x
+*/
+typedef struct _BMFontGlyph {
+    /// definition of the character, NULL for line breaks and characters missing from the font
+    const ccBMFontDef *pFontDef;
+    /// position of the center of the character (in points)
+    CCPoint position;
+} ccBMFontGlyph;
 
 /** @brief CCBMFontConfiguration has parsed configuration of the the .fnt file
 @since v0.8
@@ -109,8 +113,10 @@ class CC_DLL CCBMFontConfiguration : public CCObject
 {
     // XXX: Creating a public interface so that the bitmapFontArray[] is accessible
 public://@public
-    // BMFont definitions
-    tCCFontDefHashElement *m_pFontDefDictionary;
+    // BMFont definitions, in the order of the file
+    std::vector<ccBMFontDef> m_fontDefs;
+    // 1 + index in m_fontDefs of the characters, by pages of 256 characters. NULL for the empty pages
+    unsigned int *m_pFontDefPages[256];
 
     //! FNTConfig: Common Height Should be signed (issue #1343)
     int m_nCommonHeight;
@@ -118,8 +124,10 @@ public://@public
     ccBMFontPadding    m_tPadding;
     //! atlas name
     std::string m_sAtlasName;
-    //! values for kerning
-    tCCKerningHashElement *m_pKerningDictionary;
+    //! values for kerning, open addressing on their key. NULL if the font has no kerning
+    ccBMFontKerning *m_pKernings;
+    unsigned int m_uKerningMask;
+    unsigned int m_uKerningCount;
     
     // Character Set defines the letters that actually exist in the font
     std::set<unsigned int> *m_pCharacterSet;
@@ -138,6 +146,21 @@ public:
     inline void setAtlasName(const char* atlasName) { m_sAtlasName = atlasName; }
     
     std::set<unsigned int>* getCharacterSet() const;
+
+    /** returns the definition of a character, or NULL if the font doesn't have it
+     @since v2.1.x
+     */
+    inline const ccBMFontDef* getFontDef(unsigned short c) const
+    {
+        const unsigned int *pPage = m_pFontDefPages[c >> 8];
+        unsigned int index = pPage ? pPage[c & 0xff] : 0;
+        return index ? &m_fontDefs[index - 1] : NULL;
+    }
+
+    /** returns the kerning amount between two characters (in pixels)
+     @since v2.1.x
+     */
+    int getKerningAmount(unsigned short first, unsigned short second) const;
 private:
     std::set<unsigned int>* parseConfigFile(const char *controlFile);
     void parseCharacterDefinition(std::string line, ccBMFontDef *characterDefinition);
@@ -145,6 +168,7 @@ private:
     void parseCommonArguments(std::string line);
     void parseImageFileName(std::string line, const char *fntFile);
     void parseKerningEntry(std::string line);
+    void addKerning(unsigned int key, int amount);
     void purgeKerningDictionary();
     void purgeFontDefDictionary();
 };
@@ -166,6 +190,10 @@ Limitations:
 - All inner characters are using an anchorPoint of (0.5f, 0.5f) and it is not recommend to change it
 because it might affect the rendering
 
+Labels whose text changes every frame (scores, timers...) can disable the character sprites with
+setGlyphSpritesEnabled(false). The characters are then written straight into the texture atlas, and
+only the ones which moved or changed are rewritten when the string is updated.
+
 CCLabelBMFont implements the protocol CCLabelProtocol, like CCLabel and CCLabelAtlas.
 CCLabelBMFont has the flexibility of CCLabel, the speed of CCLabelAtlas and all the features of CCSprite.
 If in doubt, use CCLabelBMFont instead of CCLabelAtlas / CCLabel.
@@ -207,9 +235,17 @@ protected:
     bool m_bLineBreakWithoutSpaces;
     // offset of the texture atlas
     CCPoint    m_tImageOffset;
-    
-    // reused char
-    CCSprite *m_pReusedChar;
+
+    // whether the kerning pairs of the .fnt file are applied
+    bool m_bKerningEnabled;
+    // whether every character is a CCSprite child
+    bool m_bGlyphSpritesEnabled;
+    // placement of every character of m_sString, when the sprites are disabled
+    std::vector<ccBMFontGlyph> m_glyphs;
+    // the glyph each quad of the texture atlas was written from
+    std::vector<ccBMFontGlyph> m_quadGlyphs;
+    // whether m_glyphs changed since the quads were written
+    bool m_bGlyphQuadsDirty;
     
 public:
     CCLabelBMFont();
@@ -260,14 +296,28 @@ public:
 
     void setFntFile(const char* fntFile);
     const char* getFntFile();
-#if CC_LABELBMFONT_DEBUG_DRAW
+
+    /** Enables or disables the CCSprite of every character. Enabled by default.
+     Without sprites, the characters can't be accessed with getChildByTag() nor animated one by one,
+     and the label must not have any other child. In exchange, updating the string doesn't touch any node.
+     @since v2.1.x
+     */
+    void setGlyphSpritesEnabled(bool bEnabled);
+    inline bool isGlyphSpritesEnabled() const { return m_bGlyphSpritesEnabled; }
+
+    /** Enables or disables the kerning pairs of the .fnt file. Disabled by default, so the layout
+     of the existing labels doesn't change.
+     @since v2.1.x
+     */
+    void setKerningEnabled(bool bEnabled);
+    inline bool isKerningEnabled() const { return m_bKerningEnabled; }
+
     virtual void draw();
-#endif // CC_LABELBMFONT_DEBUG_DRAW
 private:
     char * atlasNameFromFntFile(const char *fntFile);
     int kerningAmountForFirst(unsigned short first, unsigned short second);
-    float getLetterPosXLeft( CCSprite* characterSprite );
-    float getLetterPosXRight( CCSprite* characterSprite );
+    void getLetterEdges(std::vector<float>& lefts, std::vector<float>& rights);
+    void updateGlyphQuads();
 
 };
 
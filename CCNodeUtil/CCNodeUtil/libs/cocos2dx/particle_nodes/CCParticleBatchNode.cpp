@@ -436,7 +436,7 @@ void CCParticleBatchNode::increaseAtlasCapacityTo(unsigned int quantity)
 //sets a 0'd quad into the quads array
 void CCParticleBatchNode::disableParticle(unsigned int particleIndex)
 {
-    ccV3F_C4B_T2F_Quad* quad = &((m_pTextureAtlas->getQuads())[particleIndex]);
+    ccV3F_C4B_T2F_Quad* quad = &((m_pTextureAtlas->getQuadsForUpdate(particleIndex, 1))[particleIndex]);
     quad->br.vertices.x = quad->br.vertices.y = quad->tr.vertices.x = quad->tr.vertices.y = quad->tl.vertices.x = quad->tl.vertices.y = quad->bl.vertices.x = quad->bl.vertices.y = 0.0f;
 }
 
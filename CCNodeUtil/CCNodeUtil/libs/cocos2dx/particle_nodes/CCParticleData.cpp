@@ -0,0 +1,311 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "CCParticleData.h"
+#include "ccMacros.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if CC_PARTICLE_USE_SIMD && defined(__SSE__)
+#include <xmmintrin.h>
+#define CC_PARTICLE_SSE 1
+#elif CC_PARTICLE_USE_SIMD && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#include <arm_neon.h>
+#define CC_PARTICLE_NEON 1
+#endif
+
+NS_CC_BEGIN
+
+// number of float/unsigned int arrays, see init()
+#define kCCParticleDataArrays 26
+
+// value[i] += delta[i] * dt for every i of [uBegin, uEnd)
+static void stepArray(float *value, const float *delta, unsigned int uBegin, unsigned int uEnd, float dt)
+{
+    unsigned int i = uBegin;
+#if CC_PARTICLE_SSE
+    __m128 vdt = _mm_set1_ps(dt);
+    for (; i + 4 <= uEnd; i += 4)
+    {
+        _mm_storeu_ps(value + i, _mm_add_ps(_mm_loadu_ps(value + i), _mm_mul_ps(_mm_loadu_ps(delta + i), vdt)));
+    }
+#elif CC_PARTICLE_NEON
+    float32x4_t vdt = vdupq_n_f32(dt);
+    for (; i + 4 <= uEnd; i += 4)
+    {
+        vst1q_f32(value + i, vmlaq_f32(vld1q_f32(value + i), vld1q_f32(delta + i), vdt));
+    }
+#endif
+    for (; i < uEnd; i++)
+    {
+        value[i] += delta[i] * dt;
+    }
+}
+
+CCParticleData::CCParticleData()
+: posX(NULL)
+, posY(NULL)
+, startPosX(NULL)
+, startPosY(NULL)
+, colorR(NULL)
+, colorG(NULL)
+, colorB(NULL)
+, colorA(NULL)
+, deltaColorR(NULL)
+, deltaColorG(NULL)
+, deltaColorB(NULL)
+, deltaColorA(NULL)
+, size(NULL)
+, deltaSize(NULL)
+, rotation(NULL)
+, deltaRotation(NULL)
+, timeToLive(NULL)
+, atlasIndex(NULL)
+, m_pMemory(NULL)
+, m_uCapacity(0)
+{
+    memset(&modeA, 0, sizeof(modeA));
+    memset(&modeB, 0, sizeof(modeB));
+}
+
+CCParticleData::~CCParticleData()
+{
+    destroy();
+}
+
+bool CCParticleData::init(unsigned int uCount)
+{
+    // pad every array to a multiple of 4 elements so each one starts 16-byte aligned
+    unsigned int uStride = (uCount + 3) & ~3u;
+    void *pMemory = calloc(1, uStride * kCCParticleDataArrays * sizeof(float) + 15);
+    if (! pMemory)
+    {
+        return false;
+    }
+
+    destroy();
+    m_pMemory = pMemory;
+    m_uCapacity = uCount;
+
+    float *p = (float*)(((size_t)pMemory + 15) & ~(size_t)15);
+    posX = p;                       p += uStride;
+    posY = p;                       p += uStride;
+    startPosX = p;                  p += uStride;
+    startPosY = p;                  p += uStride;
+    colorR = p;                     p += uStride;
+    colorG = p;                     p += uStride;
+    colorB = p;                     p += uStride;
+    colorA = p;                     p += uStride;
+    deltaColorR = p;                p += uStride;
+    deltaColorG = p;                p += uStride;
+    deltaColorB = p;                p += uStride;
+    deltaColorA = p;                p += uStride;
+    size = p;                       p += uStride;
+    deltaSize = p;                  p += uStride;
+    rotation = p;                   p += uStride;
+    deltaRotation = p;              p += uStride;
+    timeToLive = p;                 p += uStride;
+    modeA.dirX = p;                 p += uStride;
+    modeA.dirY = p;                 p += uStride;
+    modeA.radialAccel = p;          p += uStride;
+    modeA.tangentialAccel = p;      p += uStride;
+    modeB.angle = p;                p += uStride;
+    modeB.degreesPerSecond = p;     p += uStride;
+    modeB.radius = p;               p += uStride;
+    modeB.deltaRadius = p;          p += uStride;
+    atlasIndex = (unsigned int*)p;
+
+    return true;
+}
+
+void CCParticleData::destroy()
+{
+    CC_SAFE_FREE(m_pMemory);
+    m_uCapacity = 0;
+    posX = posY = startPosX = startPosY = NULL;
+    colorR = colorG = colorB = colorA = NULL;
+    deltaColorR = deltaColorG = deltaColorB = deltaColorA = NULL;
+    size = deltaSize = rotation = deltaRotation = timeToLive = NULL;
+    atlasIndex = NULL;
+    memset(&modeA, 0, sizeof(modeA));
+    memset(&modeB, 0, sizeof(modeB));
+}
+
+void CCParticleData::copyParticle(unsigned int uDst, unsigned int uSrc)
+{
+    // the arrays are laid out back to back, atlasIndex being the last one
+    unsigned int uStride = (unsigned int)(modeA.dirY - modeA.dirX);
+    unsigned int *pWords = (unsigned int*)posX;
+    for (unsigned int i = 0; i < kCCParticleDataArrays; i++)
+    {
+        pWords[uDst] = pWords[uSrc];
+        pWords += uStride;
+    }
+}
+
+void CCParticleData::updateGravity(unsigned int uBegin, unsigned int uEnd, float dt, const CCPoint& gravity)
+{
+    float *px = posX;
+    float *py = posY;
+    float *dx = modeA.dirX;
+    float *dy = modeA.dirY;
+    const float *ra = modeA.radialAccel;
+    const float *ta = modeA.tangentialAccel;
+
+    unsigned int i = uBegin;
+#if CC_PARTICLE_SSE
+    __m128 vdt = _mm_set1_ps(dt);
+    __m128 vgx = _mm_set1_ps(gravity.x);
+    __m128 vgy = _mm_set1_ps(gravity.y);
+    __m128 vzero = _mm_setzero_ps();
+    __m128 vone = _mm_set1_ps(1.0f);
+    for (; i + 4 <= uEnd; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(px + i);
+        __m128 y = _mm_loadu_ps(py + i);
+
+        // radial direction, (0, 0) at the source position
+        __m128 len2 = _mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y));
+        __m128 inv = _mm_and_ps(_mm_cmpgt_ps(len2, vzero), _mm_div_ps(vone, _mm_sqrt_ps(len2)));
+        __m128 nx = _mm_mul_ps(x, inv);
+        __m128 ny = _mm_mul_ps(y, inv);
+
+        // radial * radialAccel + (-ny, nx) * tangentialAccel + gravity
+        __m128 r = _mm_loadu_ps(ra + i);
+        __m128 t = _mm_loadu_ps(ta + i);
+        __m128 ax = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(nx, r), _mm_mul_ps(ny, t)), vgx);
+        __m128 ay = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ny, r), _mm_mul_ps(nx, t)), vgy);
+
+        __m128 vx = _mm_add_ps(_mm_loadu_ps(dx + i), _mm_mul_ps(ax, vdt));
+        __m128 vy = _mm_add_ps(_mm_loadu_ps(dy + i), _mm_mul_ps(ay, vdt));
+        _mm_storeu_ps(dx + i, vx);
+        _mm_storeu_ps(dy + i, vy);
+        _mm_storeu_ps(px + i, _mm_add_ps(x, _mm_mul_ps(vx, vdt)));
+        _mm_storeu_ps(py + i, _mm_add_ps(y, _mm_mul_ps(vy, vdt)));
+    }
+#elif CC_PARTICLE_NEON
+    float32x4_t vdt = vdupq_n_f32(dt);
+    float32x4_t vgx = vdupq_n_f32(gravity.x);
+    float32x4_t vgy = vdupq_n_f32(gravity.y);
+    float32x4_t vzero = vdupq_n_f32(0.0f);
+    for (; i + 4 <= uEnd; i += 4)
+    {
+        float32x4_t x = vld1q_f32(px + i);
+        float32x4_t y = vld1q_f32(py + i);
+
+        // radial direction, (0, 0) at the source position.
+        // Two Newton-Raphson steps bring the reciprocal square root estimate to float precision.
+        float32x4_t len2 = vmlaq_f32(vmulq_f32(x, x), y, y);
+        float32x4_t e = vrsqrteq_f32(len2);
+        e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(len2, e), e));
+        e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(len2, e), e));
+        float32x4_t inv = vreinterpretq_f32_u32(vandq_u32(vcgtq_f32(len2, vzero), vreinterpretq_u32_f32(e)));
+        float32x4_t nx = vmulq_f32(x, inv);
+        float32x4_t ny = vmulq_f32(y, inv);
+
+        // radial * radialAccel + (-ny, nx) * tangentialAccel + gravity
+        float32x4_t r = vld1q_f32(ra + i);
+        float32x4_t t = vld1q_f32(ta + i);
+        float32x4_t ax = vmlsq_f32(vmlaq_f32(vgx, nx, r), ny, t);
+        float32x4_t ay = vmlaq_f32(vmlaq_f32(vgy, ny, r), nx, t);
+
+        float32x4_t vx = vmlaq_f32(vld1q_f32(dx + i), ax, vdt);
+        float32x4_t vy = vmlaq_f32(vld1q_f32(dy + i), ay, vdt);
+        vst1q_f32(dx + i, vx);
+        vst1q_f32(dy + i, vy);
+        vst1q_f32(px + i, vmlaq_f32(x, vx, vdt));
+        vst1q_f32(py + i, vmlaq_f32(y, vy, vdt));
+    }
+#endif
+    for (; i < uEnd; i++)
+    {
+        float x = px[i];
+        float y = py[i];
+
+        float nx = 0;
+        float ny = 0;
+        if (x || y)
+        {
+            float inv = 1.0f / sqrtf(x * x + y * y);
+            nx = x * inv;
+            ny = y * inv;
+        }
+
+        float ax = nx * ra[i] - ny * ta[i] + gravity.x;
+        float ay = ny * ra[i] + nx * ta[i] + gravity.y;
+
+        dx[i] += ax * dt;
+        dy[i] += ay * dt;
+        px[i] = x + dx[i] * dt;
+        py[i] = y + dy[i] * dt;
+    }
+}
+
+void CCParticleData::updateRadius(unsigned int uBegin, unsigned int uEnd, float dt)
+{
+    stepArray(modeB.angle, modeB.degreesPerSecond, uBegin, uEnd, dt);
+    stepArray(modeB.radius, modeB.deltaRadius, uBegin, uEnd, dt);
+
+    // there is no vector sine, this loop is left to the compiler
+    const float *angle = modeB.angle;
+    const float *radius = modeB.radius;
+    for (unsigned int i = uBegin; i < uEnd; i++)
+    {
+        posX[i] = - cosf(angle[i]) * radius[i];
+        posY[i] = - sinf(angle[i]) * radius[i];
+    }
+}
+
+void CCParticleData::updateAttributes(unsigned int uBegin, unsigned int uEnd, float dt)
+{
+    stepArray(colorR, deltaColorR, uBegin, uEnd, dt);
+    stepArray(colorG, deltaColorG, uBegin, uEnd, dt);
+    stepArray(colorB, deltaColorB, uBegin, uEnd, dt);
+    stepArray(colorA, deltaColorA, uBegin, uEnd, dt);
+    stepArray(rotation, deltaRotation, uBegin, uEnd, dt);
+
+    // size never goes below 0
+    stepArray(size, deltaSize, uBegin, uEnd, dt);
+    unsigned int i = uBegin;
+#if CC_PARTICLE_SSE
+    __m128 vzero = _mm_setzero_ps();
+    for (; i + 4 <= uEnd; i += 4)
+    {
+        _mm_storeu_ps(size + i, _mm_max_ps(_mm_loadu_ps(size + i), vzero));
+    }
+#elif CC_PARTICLE_NEON
+    float32x4_t vzero = vdupq_n_f32(0.0f);
+    for (; i + 4 <= uEnd; i += 4)
+    {
+        vst1q_f32(size + i, vmaxq_f32(vld1q_f32(size + i), vzero));
+    }
+#endif
+    for (; i < uEnd; i++)
+    {
+        size[i] = MAX(0, size[i]);
+    }
+}
+
+NS_CC_END
@@ -0,0 +1,132 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CCPARTICLE_DATA_H__
+#define __CCPARTICLE_DATA_H__
+
+#include "cocoa/CCGeometry.h"
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup particle_nodes
+ * @{
+ */
+
+/** @brief Structure of arrays holding the state of every particle of a CCParticleSystem.
+
+ Particle i is made of element i of every array. Each array is 16-byte aligned and
+ padded to a multiple of 4 elements, so the update kernels can process 4 particles
+ at a time with SSE or NEON, and fall back to plain loops the compiler can
+ auto-vectorize otherwise.
+ @since v2.1.x
+ */
+class CC_DLL CCParticleData
+{
+public:
+    CCParticleData();
+    ~CCParticleData();
+
+    /** (Re)allocates room for uCount particles. The previous contents are discarded and every
+     value is zeroed. Returns false and keeps the previous arrays if out of memory.
+     */
+    bool init(unsigned int uCount);
+
+    /** frees the arrays */
+    void destroy();
+
+    /** copies particle uSrc over particle uDst, atlasIndex included */
+    void copyParticle(unsigned int uDst, unsigned int uSrc);
+
+    /** Gravity mode: moves the particles of [uBegin, uEnd) along their direction, which is
+     accelerated by the gravity and by the radial and tangential accelerations.
+     */
+    void updateGravity(unsigned int uBegin, unsigned int uEnd, float dt, const CCPoint& gravity);
+
+    /** Radius mode: rotates the particles of [uBegin, uEnd) around the source position */
+    void updateRadius(unsigned int uBegin, unsigned int uEnd, float dt);
+
+    /** steps the color, size and rotation of the particles of [uBegin, uEnd) */
+    void updateAttributes(unsigned int uBegin, unsigned int uEnd, float dt);
+
+    /** number of particles the arrays can hold */
+    inline unsigned int getCapacity() const { return m_uCapacity; }
+
+    float *posX;
+    float *posY;
+    float *startPosX;
+    float *startPosY;
+
+    float *colorR;
+    float *colorG;
+    float *colorB;
+    float *colorA;
+
+    float *deltaColorR;
+    float *deltaColorG;
+    float *deltaColorB;
+    float *deltaColorA;
+
+    float *size;
+    float *deltaSize;
+
+    float *rotation;
+    float *deltaRotation;
+
+    float *timeToLive;
+
+    unsigned int *atlasIndex;
+
+    //! Mode A: gravity, direction, radial accel, tangential accel
+    struct {
+        float *dirX;
+        float *dirY;
+        float *radialAccel;
+        float *tangentialAccel;
+    } modeA;
+
+    //! Mode B: radius mode
+    struct {
+        float *angle;
+        float *degreesPerSecond;
+        float *radius;
+        float *deltaRadius;
+    } modeB;
+
+private:
+    // disallow copy, the arrays are owned
+    CCParticleData(const CCParticleData&);
+    CCParticleData& operator=(const CCParticleData&);
+
+    // every array lives in this single allocation
+    void *m_pMemory;
+    unsigned int m_uCapacity;
+};
+
+// end of particle_nodes group
+/// @}
+
+NS_CC_END
+
+#endif // __CCPARTICLE_DATA_H__
@@ -56,8 +56,10 @@ THE SOFTWARE.
 #include "support/CCProfiling.h"
 // opengl
 #include "CCGL.h"
+#include "support/CCJobSystem.h"
 
 #include <string>
+#include <vector>
 
 using namespace std;
 
@@ -84,7 +86,6 @@ NS_CC_BEGIN
 CCParticleSystem::CCParticleSystem()
     :m_sPlistFile("")
     ,m_fElapsed(0)
-    ,m_pParticles(NULL)
     ,m_fEmitCounter(0)
     ,m_uParticleIdx(0)
     ,m_bIsActive(true)
@@ -116,6 +117,9 @@ CCParticleSystem::CCParticleSystem()
     ,m_uAtlasIndex(0)
     ,m_bTransformSystemDirty(false)
     ,m_uAllocatedParticles(0)
+    ,m_bStepPending(false)
+    ,m_fPendingDelta(0)
+    ,m_tPendingPosition(CCPointZero)
 {
     modeA.gravity = CCPointZero;
     modeA.speed = 0;
@@ -389,11 +393,7 @@ bool CCParticleSystem::initWithTotalParticles(unsigned int numberOfParticles)
 {
     m_uTotalParticles = numberOfParticles;
 
-    CC_SAFE_FREE(m_pParticles);
-    
-    m_pParticles = (tCCParticle*)calloc(m_uTotalParticles, sizeof(tCCParticle));
-
-    if( ! m_pParticles )
+    if( ! m_tParticleData.init(m_uTotalParticles) )
     {
         CCLOG("Particle system: not enough memory");
         this->release();
@@ -405,7 +405,7 @@ bool CCParticleSystem::initWithTotalParticles(unsigned int numberOfParticles)
     {
         for (unsigned int i = 0; i < m_uTotalParticles; i++)
         {
-            m_pParticles[i].atlasIndex=i;
+            m_tParticleData.atlasIndex[i]=i;
         }
     }
     // default, active
@@ -441,7 +441,7 @@ bool CCParticleSystem::initWithTotalParticles(unsigned int numberOfParticles)
 CCParticleSystem::~CCParticleSystem()
 {
     unscheduleUpdate();
-    CC_SAFE_FREE(m_pParticles);
+    m_tParticleData.destroy();
     CC_SAFE_RELEASE(m_pTexture);
 }
 
@@ -452,24 +452,26 @@ bool CCParticleSystem::addParticle()
         return false;
     }
 
-    tCCParticle * particle = &m_pParticles[ m_uParticleCount ];
-    this->initParticle(particle);
+    this->initParticle(m_uParticleCount);
     ++m_uParticleCount;
 
     return true;
 }
 
-void CCParticleSystem::initParticle(tCCParticle* particle)
+void CCParticleSystem::initParticle(unsigned int uIndex)
 {
+    CCParticleData& d = m_tParticleData;
+
     // timeToLive
     // no negative life. prevent division by 0
-    particle->timeToLive = m_fLife + m_fLifeVar * CCRANDOM_MINUS1_1();
-    particle->timeToLive = MAX(0, particle->timeToLive);
+    float timeToLive = m_fLife + m_fLifeVar * CCRANDOM_MINUS1_1();
+    timeToLive = MAX(0, timeToLive);
+    d.timeToLive[uIndex] = timeToLive;
 
     // position
-    particle->pos.x = m_tSourcePosition.x + m_tPosVar.x * CCRANDOM_MINUS1_1();
+    d.posX[uIndex] = m_tSourcePosition.x + m_tPosVar.x * CCRANDOM_MINUS1_1();
 
-    particle->pos.y = m_tSourcePosition.y + m_tPosVar.y * CCRANDOM_MINUS1_1();
+    d.posY[uIndex] = m_tSourcePosition.y + m_tPosVar.y * CCRANDOM_MINUS1_1();
 
 
     // Color
@@ -485,43 +487,49 @@ void CCParticleSystem::initParticle(tCCParticle* particle)
     end.b = clampf(m_tEndColor.b + m_tEndColorVar.b * CCRANDOM_MINUS1_1(), 0, 1);
     end.a = clampf(m_tEndColor.a + m_tEndColorVar.a * CCRANDOM_MINUS1_1(), 0, 1);
 
-    particle->color = start;
-    particle->deltaColor.r = (end.r - start.r) / particle->timeToLive;
-    particle->deltaColor.g = (end.g - start.g) / particle->timeToLive;
-    particle->deltaColor.b = (end.b - start.b) / particle->timeToLive;
-    particle->deltaColor.a = (end.a - start.a) / particle->timeToLive;
+    d.colorR[uIndex] = start.r;
+    d.colorG[uIndex] = start.g;
+    d.colorB[uIndex] = start.b;
+    d.colorA[uIndex] = start.a;
+    d.deltaColorR[uIndex] = (end.r - start.r) / timeToLive;
+    d.deltaColorG[uIndex] = (end.g - start.g) / timeToLive;
+    d.deltaColorB[uIndex] = (end.b - start.b) / timeToLive;
+    d.deltaColorA[uIndex] = (end.a - start.a) / timeToLive;
 
     // size
     float startS = m_fStartSize + m_fStartSizeVar * CCRANDOM_MINUS1_1();
     startS = MAX(0, startS); // No negative value
 
-    particle->size = startS;
+    d.size[uIndex] = startS;
 
     if( m_fEndSize == kCCParticleStartSizeEqualToEndSize )
     {
-        particle->deltaSize = 0;
+        d.deltaSize[uIndex] = 0;
     }
     else
     {
         float endS = m_fEndSize + m_fEndSizeVar * CCRANDOM_MINUS1_1();
         endS = MAX(0, endS); // No negative values
-        particle->deltaSize = (endS - startS) / particle->timeToLive;
+        d.deltaSize[uIndex] = (endS - startS) / timeToLive;
     }
 
     // rotation
     float startA = m_fStartSpin + m_fStartSpinVar * CCRANDOM_MINUS1_1();
     float endA = m_fEndSpin + m_fEndSpinVar * CCRANDOM_MINUS1_1();
-    particle->rotation = startA;
-    particle->deltaRotation = (endA - startA) / particle->timeToLive;
+    d.rotation[uIndex] = startA;
+    d.deltaRotation[uIndex] = (endA - startA) / timeToLive;
 
     // position
     if( m_ePositionType == kCCPositionTypeFree )
     {
-        particle->startPos = this->convertToWorldSpace(CCPointZero);
+        CCPoint startPos = this->convertToWorldSpace(CCPointZero);
+        d.startPosX[uIndex] = startPos.x;
+        d.startPosY[uIndex] = startPos.y;
     }
     else if ( m_ePositionType == kCCPositionTypeRelative )
     {
-        particle->startPos = m_obPosition;
+        d.startPosX[uIndex] = m_obPosition.x;
+        d.startPosY[uIndex] = m_obPosition.y;
     }
 
     // direction
@@ -534,14 +542,16 @@ void CCParticleSystem::initParticle(tCCParticle* particle)
         float s = modeA.speed + modeA.speedVar * CCRANDOM_MINUS1_1();
 
         // direction
-        particle->modeA.dir = ccpMult( v, s );
+        CCPoint dir = ccpMult( v, s );
+        d.modeA.dirX[uIndex] = dir.x;
+        d.modeA.dirY[uIndex] = dir.y;
 
         // radial accel
-        particle->modeA.radialAccel = modeA.radialAccel + modeA.radialAccelVar * CCRANDOM_MINUS1_1();
+        d.modeA.radialAccel[uIndex] = modeA.radialAccel + modeA.radialAccelVar * CCRANDOM_MINUS1_1();
  
 
         // tangential accel
-        particle->modeA.tangentialAccel = modeA.tangentialAccel + modeA.tangentialAccelVar * CCRANDOM_MINUS1_1();
+        d.modeA.tangentialAccel[uIndex] = modeA.tangentialAccel + modeA.tangentialAccelVar * CCRANDOM_MINUS1_1();
 
     }
 
@@ -552,19 +562,19 @@ void CCParticleSystem::initParticle(tCCParticle* particle)
         float startRadius = modeB.startRadius + modeB.startRadiusVar * CCRANDOM_MINUS1_1();
         float endRadius = modeB.endRadius + modeB.endRadiusVar * CCRANDOM_MINUS1_1();
 
-        particle->modeB.radius = startRadius;
+        d.modeB.radius[uIndex] = startRadius;
 
         if(modeB.endRadius == kCCParticleStartRadiusEqualToEndRadius)
         {
-            particle->modeB.deltaRadius = 0;
+            d.modeB.deltaRadius[uIndex] = 0;
         }
         else
         {
-            particle->modeB.deltaRadius = (endRadius - startRadius) / particle->timeToLive;
+            d.modeB.deltaRadius[uIndex] = (endRadius - startRadius) / timeToLive;
         }
 
-        particle->modeB.angle = a;
-        particle->modeB.degreesPerSecond = CC_DEGREES_TO_RADIANS(modeB.rotatePerSecond + modeB.rotatePerSecondVar * CCRANDOM_MINUS1_1());
+        d.modeB.angle[uIndex] = a;
+        d.modeB.degreesPerSecond[uIndex] = CC_DEGREES_TO_RADIANS(modeB.rotatePerSecond + modeB.rotatePerSecondVar * CCRANDOM_MINUS1_1());
     }    
 }
 
@@ -581,8 +591,7 @@ void CCParticleSystem::resetSystem()
     m_fElapsed = 0;
     for (m_uParticleIdx = 0; m_uParticleIdx < m_uParticleCount; ++m_uParticleIdx)
     {
-        tCCParticle *p = &m_pParticles[m_uParticleIdx];
-        p->timeToLive = 0;
+        m_tParticleData.timeToLive[m_uParticleIdx] = 0;
     }
 }
 bool CCParticleSystem::isFull()
@@ -590,11 +599,31 @@ bool CCParticleSystem::isFull()
     return (m_uParticleCount == m_uTotalParticles);
 }
 
+// a range of the particles of one system, the unit of work of syncParallelUpdate()
+typedef struct _ccParticleBlock
+{
+    CCParticleSystem    *system;
+    unsigned int        begin;
+    unsigned int        end;
+} tCCParticleBlock;
+
+static bool s_bParallelUpdate = (CC_PARTICLE_PARALLEL_UPDATE != 0);
+// systems waiting for syncParallelUpdate(), retained, in update order
+static std::vector<CCParticleSystem*> s_pendingSystems;
+static std::vector<tCCParticleBlock> s_pendingBlocks;
+
 // ParticleSystem - MainLoop
 void CCParticleSystem::update(float dt)
 {
     CC_PROFILER_START_CATEGORY(kCCProfilerCategoryParticles , "CCParticleSystem - update");
 
+    if (m_bStepPending)
+    {
+        // updated twice in the same frame: finish the previous step first, the system stays queued
+        stepParticles(0, m_uParticleCount, m_fPendingDelta, m_tPendingPosition);
+        m_fPendingDelta = 0;
+    }
+
     if (m_bIsActive && m_fEmissionRate)
     {
         float rate = 1.0f / m_fEmissionRate;
@@ -631,144 +660,197 @@ void CCParticleSystem::update(float dt)
 
     if (m_bVisible)
     {
-        while (m_uParticleIdx < m_uParticleCount)
+        CCParticleData& d = m_tParticleData;
+
+        // life, dead particles are replaced by the last living one
+        unsigned int i = 0;
+        while (i < m_uParticleCount)
         {
-            tCCParticle *p = &m_pParticles[m_uParticleIdx];
+            d.timeToLive[i] -= dt;
 
-            // life
-            p->timeToLive -= dt;
+            if (d.timeToLive[i] > 0)
+            {
+                ++i;
+                continue;
+            }
 
-            if (p->timeToLive > 0) 
+            // life < 0
+            unsigned int last = m_uParticleCount - 1;
+            unsigned int currentIndex = d.atlasIndex[i];
+            if( i != last )
             {
-                // Mode A: gravity, direction, tangential accel & radial accel
-                if (m_nEmitterMode == kCCParticleModeGravity) 
-                {
-                    CCPoint tmp, radial, tangential;
+                // the moved particle hasn't aged yet, it is handled in the next iteration
+                d.copyParticle(i, last);
+            }
+            if (m_pBatchNode)
+            {
+                //disable the switched particle
+                m_pBatchNode->disableParticle(m_uAtlasIndex+currentIndex);
 
-                    radial = CCPointZero;
-                    // radial acceleration
-                    if (p->pos.x || p->pos.y)
-                    {
-                        radial = ccpNormalize(p->pos);
-                    }
-                    tangential = radial;
-                    radial = ccpMult(radial, p->modeA.radialAccel);
-
-                    // tangential acceleration
-                    float newy = tangential.x;
-                    tangential.x = -tangential.y;
-                    tangential.y = newy;
-                    tangential = ccpMult(tangential, p->modeA.tangentialAccel);
-
-                    // (gravity + radial + tangential) * dt
-                    tmp = ccpAdd( ccpAdd( radial, tangential), modeA.gravity);
-                    tmp = ccpMult( tmp, dt);
-                    p->modeA.dir = ccpAdd( p->modeA.dir, tmp);
-                    tmp = ccpMult(p->modeA.dir, dt);
-                    p->pos = ccpAdd( p->pos, tmp );
-                }
+                //switch indexes
+                d.atlasIndex[last] = currentIndex;
+            }
 
-                // Mode B: radius movement
-                else 
-                {                
-                    // Update the angle and radius of the particle.
-                    p->modeB.angle += p->modeB.degreesPerSecond * dt;
-                    p->modeB.radius += p->modeB.deltaRadius * dt;
+            --m_uParticleCount;
 
-                    p->pos.x = - cosf(p->modeB.angle) * p->modeB.radius;
-                    p->pos.y = - sinf(p->modeB.angle) * p->modeB.radius;
-                }
+            if( m_uParticleCount == 0 && m_bIsAutoRemoveOnFinish )
+            {
+                this->unscheduleUpdate();
+                m_pParent->removeChild(this, true);
+                return;
+            }
+        }
 
-                // color
-                p->color.r += (p->deltaColor.r * dt);
-                p->color.g += (p->deltaColor.g * dt);
-                p->color.b += (p->deltaColor.b * dt);
-                p->color.a += (p->deltaColor.a * dt);
+        if (m_pBatchNode)
+        {
+            // marked here because the quads may be written by several worker threads
+            m_pBatchNode->getTextureAtlas()->markDirty(m_uAtlasIndex, m_uTotalParticles);
+        }
 
-                // size
-                p->size += (p->deltaSize * dt);
-                p->size = MAX( 0, p->size );
+        if (s_bParallelUpdate)
+        {
+            if (! m_bStepPending)
+            {
+                m_bStepPending = true;
+                this->retain();
+                s_pendingSystems.push_back(this);
+            }
+            m_fPendingDelta = dt;
+            m_tPendingPosition = currentPosition;
+        }
+        else
+        {
+            stepParticles(0, m_uParticleCount, dt, currentPosition);
+            m_uParticleIdx = m_uParticleCount;
+        }
 
-                // angle
-                p->rotation += (p->deltaRotation * dt);
+        m_bTransformSystemDirty = false;
+    }
+    if (! m_pBatchNode && ! m_bStepPending)
+    {
+        postStep();
+    }
 
-                //
-                // update values in quad
-                //
+    CC_PROFILER_STOP_CATEGORY(kCCProfilerCategoryParticles , "CCParticleSystem - update");
+}
 
-                CCPoint    newPos;
+void CCParticleSystem::updateWithNoTime(void)
+{
+    this->update(0.0f);
+}
 
-                if (m_ePositionType == kCCPositionTypeFree || m_ePositionType == kCCPositionTypeRelative) 
-                {
-                    CCPoint diff = ccpSub( currentPosition, p->startPos );
-                    newPos = ccpSub(p->pos, diff);
-                } 
-                else
-                {
-                    newPos = p->pos;
-                }
+void CCParticleSystem::stepParticles(unsigned int uBegin, unsigned int uEnd, float dt, const CCPoint& currentPosition)
+{
+    CCParticleData& d = m_tParticleData;
 
-                // translate newPos to correct position, since matrix transform isn't performed in batchnode
-                // don't update the particle with the new position information, it will interfere with the radius and tangential calculations
-                if (m_pBatchNode)
-                {
-                    newPos.x+=m_obPosition.x;
-                    newPos.y+=m_obPosition.y;
-                }
+    // a block at a time, each block is turned into quads while it is still in the cache
+    for (unsigned int uBlock = uBegin; uBlock < uEnd; uBlock += kCCParticleUpdateBlockSize)
+    {
+        unsigned int uBlockEnd = MIN(uBlock + kCCParticleUpdateBlockSize, uEnd);
 
-                updateQuadWithParticle(p, newPos);
-                //updateParticleImp(self, updateParticleSel, p, newPos);
+        if (m_nEmitterMode == kCCParticleModeGravity)
+        {
+            // Mode A: gravity, direction, tangential accel & radial accel
+            d.updateGravity(uBlock, uBlockEnd, dt, modeA.gravity);
+        }
+        else
+        {
+            // Mode B: radius movement
+            d.updateRadius(uBlock, uBlockEnd, dt);
+        }
+        d.updateAttributes(uBlock, uBlockEnd, dt);
 
-                // update particle counter
-                ++m_uParticleIdx;
-            } 
-            else 
-            {
-                // life < 0
-                int currentIndex = p->atlasIndex;
-                if( m_uParticleIdx != m_uParticleCount-1 )
-                {
-                    m_pParticles[m_uParticleIdx] = m_pParticles[m_uParticleCount-1];
-                }
-                if (m_pBatchNode)
-                {
-                    //disable the switched particle
-                    m_pBatchNode->disableParticle(m_uAtlasIndex+currentIndex);
+        updateParticleQuads(uBlock, uBlockEnd, currentPosition);
+    }
+}
 
-                    //switch indexes
-                    m_pParticles[m_uParticleCount-1].atlasIndex = currentIndex;
-                }
+// ParticleSystem - parallel update
 
+void CCParticleSystem::setParallelUpdate(bool bParallel)
+{
+    s_bParallelUpdate = bParallel;
+}
 
-                --m_uParticleCount;
+bool CCParticleSystem::isParallelUpdate()
+{
+    return s_bParallelUpdate;
+}
 
-                if( m_uParticleCount == 0 && m_bIsAutoRemoveOnFinish )
-                {
-                    this->unscheduleUpdate();
-                    m_pParent->removeChild(this, true);
-                    return;
-                }
-            }
-        } //while
-        m_bTransformSystemDirty = false;
+void CCParticleSystem::stepPendingBlocks(unsigned int uBegin, unsigned int uEnd, void *pUserData)
+{
+    CC_UNUSED_PARAM(pUserData);
+
+    for (unsigned int i = uBegin; i < uEnd; i++)
+    {
+        const tCCParticleBlock& block = s_pendingBlocks[i];
+        CCParticleSystem *pSystem = block.system;
+        pSystem->stepParticles(block.begin, block.end, pSystem->m_fPendingDelta, pSystem->m_tPendingPosition);
     }
-    if (! m_pBatchNode)
+}
+
+void CCParticleSystem::syncParallelUpdate()
+{
+    if (s_pendingSystems.empty())
     {
-        postStep();
+        return;
     }
 
-    CC_PROFILER_STOP_CATEGORY(kCCProfilerCategoryParticles , "CCParticleSystem - update");
+    CC_PROFILER_START_CATEGORY(kCCProfilerCategoryParticles , "CCParticleSystem - syncParallelUpdate");
+
+    // Large systems are split in several blocks and small ones are spread over the workers.
+    // Dead particles were already removed on the main thread, so the result doesn't depend on the scheduling.
+    s_pendingBlocks.clear();
+    for (unsigned int i = 0; i < s_pendingSystems.size(); i++)
+    {
+        CCParticleSystem *pSystem = s_pendingSystems[i];
+        for (unsigned int uBegin = 0; uBegin < pSystem->m_uParticleCount; uBegin += kCCParticleUpdateBlockSize)
+        {
+            tCCParticleBlock block;
+            block.system = pSystem;
+            block.begin = uBegin;
+            block.end = MIN(uBegin + kCCParticleUpdateBlockSize, pSystem->m_uParticleCount);
+            s_pendingBlocks.push_back(block);
+        }
+    }
+
+    CCJobSystem::sharedJobSystem()->parallelFor((unsigned int)s_pendingBlocks.size(), 1, &CCParticleSystem::stepPendingBlocks, NULL);
+
+    // the VBO uploads stay on the main thread
+    for (unsigned int i = 0; i < s_pendingSystems.size(); i++)
+    {
+        CCParticleSystem *pSystem = s_pendingSystems[i];
+        pSystem->m_bStepPending = false;
+        pSystem->m_uParticleIdx = pSystem->m_uParticleCount;
+        if (! pSystem->m_pBatchNode)
+        {
+            pSystem->postStep();
+        }
+        pSystem->release();
+    }
+    s_pendingSystems.clear();
+
+    CC_PROFILER_STOP_CATEGORY(kCCProfilerCategoryParticles , "CCParticleSystem - syncParallelUpdate");
 }
 
-void CCParticleSystem::updateWithNoTime(void)
+void CCParticleSystem::purgePendingUpdates()
 {
-    this->update(0.0f);
+    // swapped out first, releasing a system may run its destructor
+    std::vector<CCParticleSystem*> pendingSystems;
+    pendingSystems.swap(s_pendingSystems);
+    s_pendingBlocks.clear();
+
+    for (unsigned int i = 0; i < pendingSystems.size(); i++)
+    {
+        pendingSystems[i]->m_bStepPending = false;
+        pendingSystems[i]->release();
+    }
 }
 
-void CCParticleSystem::updateQuadWithParticle(tCCParticle* particle, const CCPoint& newPosition)
+void CCParticleSystem::updateParticleQuads(unsigned int uBegin, unsigned int uEnd, const CCPoint& currentPosition)
 {
-    CC_UNUSED_PARAM(particle);
-    CC_UNUSED_PARAM(newPosition);
+    CC_UNUSED_PARAM(uBegin);
+    CC_UNUSED_PARAM(uEnd);
+    CC_UNUSED_PARAM(currentPosition);
     // should be overridden
 }
 
@@ -1296,7 +1378,7 @@ void CCParticleSystem::setBatchNode(CCParticleBatchNode* batchNode)
             //each particle needs a unique index
             for (unsigned int i = 0; i < m_uTotalParticles; i++)
             {
-                m_pParticles[i].atlasIndex=i;
+                m_tParticleData.atlasIndex[i]=i;
             }
         }
     }
@@ -30,6 +30,7 @@ THE SOFTWARE.
 #include "base_nodes/CCNode.h"
 #include "cocoa/CCDictionary.h"
 #include "cocoa/CCString.h"
+#include "CCParticleData.h"
 
 NS_CC_BEGIN
 
@@ -88,44 +89,8 @@ enum {
     kPositionTypeGrouped = kCCPositionTypeGrouped,
 }; 
 
-/**
-Structure that contains the values of each particle
-*/
-typedef struct sCCParticle {
-    CCPoint     pos;
-    CCPoint     startPos;
-
-    ccColor4F    color;
-    ccColor4F    deltaColor;
-
-    float        size;
-    float        deltaSize;
-
-    float        rotation;
-    float        deltaRotation;
-
-    float        timeToLive;
-
-    unsigned int    atlasIndex;
-
-    //! Mode A: gravity, direction, radial accel, tangential accel
-    struct {
-        CCPoint        dir;
-        float        radialAccel;
-        float        tangentialAccel;
-    } modeA;
-
-    //! Mode B: radius mode
-    struct {
-        float        angle;
-        float        degreesPerSecond;
-        float        radius;
-        float        deltaRadius;
-    } modeB;
-
-}tCCParticle;
-
-//typedef void (*CC_UPDATE_PARTICLE_IMP)(id, SEL, tCCParticle*, CCPoint);
+//! Number of particles CCParticleSystem simulates and turns into quads in one go
+#define kCCParticleUpdateBlockSize 256
 
 class CCTexture2D;
 
@@ -214,8 +179,8 @@ protected:
         float rotatePerSecondVar;
     } modeB;
 
-    //! Array of particles
-    tCCParticle *m_pParticles;
+    //! State of every particle, one array per attribute
+    CCParticleData m_tParticleData;
 
     // color modulate
     //    BOOL colorModulate;
@@ -241,6 +206,11 @@ protected:
     // Number of allocated particles
     unsigned int m_uAllocatedParticles;
 
+    // step left for syncParallelUpdate(), see setParallelUpdate()
+    bool m_bStepPending;
+    float m_fPendingDelta;
+    CCPoint m_tPendingPosition;
+
     /** Is the emitter active */
     bool m_bIsActive;
     /** Quantity of particles that are being simulated at the moment */
@@ -401,8 +371,8 @@ public:
     virtual bool initWithTotalParticles(unsigned int numberOfParticles);
     //! Add a particle to the emitter
     bool addParticle();
-    //! Initializes a particle
-    void initParticle(tCCParticle* particle);
+    //! Initializes the particle at uIndex
+    void initParticle(unsigned int uIndex);
     //! stop emitting particles. Running particles will continue to run until they die
     void stopSystem();
     //! Kill all living particles.
@@ -410,14 +380,52 @@ public:
     //! whether or not the system is full
     bool isFull();
 
-    //! should be overridden by subclasses
-    virtual void updateQuadWithParticle(tCCParticle* particle, const CCPoint& newPosition);
+    /** Updates the quads of the particles of [uBegin, uEnd) after they have been stepped.
+    currentPosition is the emitter position the particles' startPos is compared with.
+    Should be overridden by subclasses.
+    @since v2.1.x
+    */
+    virtual void updateParticleQuads(unsigned int uBegin, unsigned int uEnd, const CCPoint& currentPosition);
     //! should be overridden by subclasses
     virtual void postStep();
 
     virtual void update(float dt);
     virtual void updateWithNoTime(void);
 
+    /** Enables or disables the parallel update of every particle system.
+    When enabled, update() only emits and removes particles. Stepping the remaining ones and
+    building their quads is left to syncParallelUpdate(), which splits the work of all the
+    systems updated during the frame into blocks of kCCParticleUpdateBlockSize particles and
+    runs them on the CCJobSystem workers.
+    updateParticleQuads() must then be thread safe. The default is CC_PARTICLE_PARALLEL_UPDATE.
+    @since v2.1.x
+    */
+    static void setParallelUpdate(bool bParallel);
+    /** returns true if the particle systems are updated on the CCJobSystem workers
+    @since v2.1.x
+    */
+    static bool isParallelUpdate();
+
+    /** Waits until every particle system updated since the last call has been stepped.
+    You should NEVER call this method, unless you know what you are doing; CCDirector calls it
+    every frame, after the scheduler and before the scene is drawn.
+    @since v2.1.x
+    */
+    static void syncParallelUpdate();
+
+    /** Releases the particle systems waiting for syncParallelUpdate(), without stepping them.
+    CCDirector calls it when it is purged.
+    @since v2.1.x
+    */
+    static void purgePendingUpdates();
+
+protected:
+    //! steps the particles of [uBegin, uEnd) and updates their quads
+    void stepParticles(unsigned int uBegin, unsigned int uEnd, float dt, const CCPoint& currentPosition);
+
+private:
+    static void stepPendingBlocks(unsigned int uBegin, unsigned int uEnd, void *pUserData);
+
 protected:
     virtual void updateBlendFunc();
 };
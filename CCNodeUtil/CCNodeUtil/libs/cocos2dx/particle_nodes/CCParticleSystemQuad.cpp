@@ -37,6 +37,7 @@ THE SOFTWARE.
 #include "support/TransformUtils.h"
 #include "support/CCNotificationCenter.h"
 #include "CCEventType.h"
+#include "support/CCUploadScheduler.h"
 
 // extern
 #include "kazmath/GL/matrix.h"
@@ -167,7 +168,7 @@ void CCParticleSystemQuad::initTexCoordsWithRect(const CCRect& pointRect)
     unsigned int start = 0, end = 0;
     if (m_pBatchNode)
     {
-        quads = m_pBatchNode->getTextureAtlas()->getQuads();
+        quads = m_pBatchNode->getTextureAtlas()->getQuadsForUpdate(m_uAtlasIndex, m_uTotalParticles);
         start = m_uAtlasIndex;
         end = m_uAtlasIndex + m_uTotalParticles;
     }
@@ -237,93 +238,119 @@ void CCParticleSystemQuad::setupIndices()
     }
 }
 
-void CCParticleSystemQuad::updateQuadWithParticle(tCCParticle* particle, const CCPoint& newPosition)
+void CCParticleSystemQuad::updateParticleQuads(unsigned int uBegin, unsigned int uEnd, const CCPoint& currentPosition)
 {
-    ccV3F_C4B_T2F_Quad *quad;
+    const CCParticleData& d = m_tParticleData;
 
+    // Free and Relative particles are drawn where they were emitted from
+    bool bFollowStart = (m_ePositionType == kCCPositionTypeFree || m_ePositionType == kCCPositionTypeRelative);
+
+    ccV3F_C4B_T2F_Quad *quads;
+    GLfloat offsetX = 0;
+    GLfloat offsetY = 0;
     if (m_pBatchNode)
     {
-        ccV3F_C4B_T2F_Quad *batchQuads = m_pBatchNode->getTextureAtlas()->getQuads();
-        quad = &(batchQuads[m_uAtlasIndex+particle->atlasIndex]);
+        // update() has already marked the quads of the system, this may run on a worker thread
+        quads = m_pBatchNode->getTextureAtlas()->getQuadsForUpdate(m_uAtlasIndex, 0) + m_uAtlasIndex;
+
+        // translate newPos to correct position, since matrix transform isn't performed in batchnode
+        offsetX = m_obPosition.x;
+        offsetY = m_obPosition.y;
     }
     else
     {
-        quad = &(m_pQuads[m_uParticleIdx]);
+        quads = m_pQuads;
+    }
+    if (bFollowStart)
+    {
+        offsetX -= currentPosition.x;
+        offsetY -= currentPosition.y;
     }
-    ccColor4B color = (m_bOpacityModifyRGB)
-        ? ccc4( particle->color.r*particle->color.a*255, particle->color.g*particle->color.a*255, particle->color.b*particle->color.a*255, particle->color.a*255)
-        : ccc4( particle->color.r*255, particle->color.g*255, particle->color.b*255, particle->color.a*255);
-
-    quad->bl.colors = color;
-    quad->br.colors = color;
-    quad->tl.colors = color;
-    quad->tr.colors = color;
 
-    // vertices
-    GLfloat size_2 = particle->size/2;
-    if (particle->rotation) 
+    for (unsigned int i = uBegin; i < uEnd; i++)
     {
-        GLfloat x1 = -size_2;
-        GLfloat y1 = -size_2;
-
-        GLfloat x2 = size_2;
-        GLfloat y2 = size_2;
-        GLfloat x = newPosition.x;
-        GLfloat y = newPosition.y;
-
-        GLfloat r = (GLfloat)-CC_DEGREES_TO_RADIANS(particle->rotation);
-        GLfloat cr = cosf(r);
-        GLfloat sr = sinf(r);
-        GLfloat ax = x1 * cr - y1 * sr + x;
-        GLfloat ay = x1 * sr + y1 * cr + y;
-        GLfloat bx = x2 * cr - y1 * sr + x;
-        GLfloat by = x2 * sr + y1 * cr + y;
-        GLfloat cx = x2 * cr - y2 * sr + x;
-        GLfloat cy = x2 * sr + y2 * cr + y;
-        GLfloat dx = x1 * cr - y2 * sr + x;
-        GLfloat dy = x1 * sr + y2 * cr + y;
-
-        // bottom-left
-        quad->bl.vertices.x = ax;
-        quad->bl.vertices.y = ay;
+        ccV3F_C4B_T2F_Quad *quad = &quads[m_pBatchNode ? d.atlasIndex[i] : i];
 
-        // bottom-right vertex:
-        quad->br.vertices.x = bx;
-        quad->br.vertices.y = by;
+        GLfloat x = d.posX[i] + offsetX;
+        GLfloat y = d.posY[i] + offsetY;
+        if (bFollowStart)
+        {
+            x += d.startPosX[i];
+            y += d.startPosY[i];
+        }
 
-        // top-left vertex:
-        quad->tl.vertices.x = dx;
-        quad->tl.vertices.y = dy;
+        float a = d.colorA[i];
+        ccColor4B color = (m_bOpacityModifyRGB)
+            ? ccc4( d.colorR[i]*a*255, d.colorG[i]*a*255, d.colorB[i]*a*255, a*255)
+            : ccc4( d.colorR[i]*255, d.colorG[i]*255, d.colorB[i]*255, a*255);
 
-        // top-right vertex:
-        quad->tr.vertices.x = cx;
-        quad->tr.vertices.y = cy;
-    } 
-    else 
-    {
-        // bottom-left vertex:
-        quad->bl.vertices.x = newPosition.x - size_2;
-        quad->bl.vertices.y = newPosition.y - size_2;
+        quad->bl.colors = color;
+        quad->br.colors = color;
+        quad->tl.colors = color;
+        quad->tr.colors = color;
 
-        // bottom-right vertex:
-        quad->br.vertices.x = newPosition.x + size_2;
-        quad->br.vertices.y = newPosition.y - size_2;
+        // vertices
+        GLfloat size_2 = d.size[i]/2;
+        if (d.rotation[i]) 
+        {
+            GLfloat x1 = -size_2;
+            GLfloat y1 = -size_2;
 
-        // top-left vertex:
-        quad->tl.vertices.x = newPosition.x - size_2;
-        quad->tl.vertices.y = newPosition.y + size_2;
+            GLfloat x2 = size_2;
+            GLfloat y2 = size_2;
 
-        // top-right vertex:
-        quad->tr.vertices.x = newPosition.x + size_2;
-        quad->tr.vertices.y = newPosition.y + size_2;                
+            GLfloat r = (GLfloat)-CC_DEGREES_TO_RADIANS(d.rotation[i]);
+            GLfloat cr = cosf(r);
+            GLfloat sr = sinf(r);
+
+            // bottom-left
+            quad->bl.vertices.x = x1 * cr - y1 * sr + x;
+            quad->bl.vertices.y = x1 * sr + y1 * cr + y;
+
+            // bottom-right vertex:
+            quad->br.vertices.x = x2 * cr - y1 * sr + x;
+            quad->br.vertices.y = x2 * sr + y1 * cr + y;
+
+            // top-left vertex:
+            quad->tl.vertices.x = x1 * cr - y2 * sr + x;
+            quad->tl.vertices.y = x1 * sr + y2 * cr + y;
+
+            // top-right vertex:
+            quad->tr.vertices.x = x2 * cr - y2 * sr + x;
+            quad->tr.vertices.y = x2 * sr + y2 * cr + y;
+        } 
+        else 
+        {
+            // bottom-left vertex:
+            quad->bl.vertices.x = x - size_2;
+            quad->bl.vertices.y = y - size_2;
+
+            // bottom-right vertex:
+            quad->br.vertices.x = x + size_2;
+            quad->br.vertices.y = y - size_2;
+
+            // top-left vertex:
+            quad->tl.vertices.x = x - size_2;
+            quad->tl.vertices.y = y + size_2;
+
+            // top-right vertex:
+            quad->tr.vertices.x = x + size_2;
+            quad->tr.vertices.y = y + size_2;                
+        }
     }
 }
 void CCParticleSystemQuad::postStep()
 {
+    // only the live particles are drawn, so only their quads need to reach the VBO
+    if (m_uParticleIdx == 0)
+    {
+        return;
+    }
+
     glBindBuffer(GL_ARRAY_BUFFER, m_pBuffersVBO[0]);
 	
 	// Option 1: Sub Data
-    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(m_pQuads[0])*m_uTotalParticles, m_pQuads);
+    CCUploadScheduler::sharedUploadScheduler()->bufferSubData(GL_ARRAY_BUFFER, 0, sizeof(m_pQuads[0])*m_uParticleIdx, m_pQuads);
 	
 	// Option 2: Data
     //	glBufferData(GL_ARRAY_BUFFER, sizeof(quads_[0]) * particleCount, quads_, GL_DYNAMIC_DRAW);
@@ -404,23 +431,20 @@ void CCParticleSystemQuad::setTotalParticles(unsigned int tp)
     if( tp > m_uAllocatedParticles )
     {
         // Allocate new memory
-        size_t particlesSize = tp * sizeof(tCCParticle);
         size_t quadsSize = sizeof(m_pQuads[0]) * tp * 1;
         size_t indicesSize = sizeof(m_pIndices[0]) * tp * 6 * 1;
 
-        tCCParticle* particlesNew = (tCCParticle*)realloc(m_pParticles, particlesSize);
+        bool particlesNew = m_tParticleData.init(tp);
         ccV3F_C4B_T2F_Quad* quadsNew = (ccV3F_C4B_T2F_Quad*)realloc(m_pQuads, quadsSize);
         GLushort* indicesNew = (GLushort*)realloc(m_pIndices, indicesSize);
 
         if (particlesNew && quadsNew && indicesNew)
         {
             // Assign pointers
-            m_pParticles = particlesNew;
             m_pQuads = quadsNew;
             m_pIndices = indicesNew;
 
             // Clear the memory
-            memset(m_pParticles, 0, particlesSize);
             memset(m_pQuads, 0, quadsSize);
             memset(m_pIndices, 0, indicesSize);
 
@@ -429,7 +453,6 @@ void CCParticleSystemQuad::setTotalParticles(unsigned int tp)
         else
         {
             // Out of memory, failed to resize some array
-            if (particlesNew) m_pParticles = particlesNew;
             if (quadsNew) m_pQuads = quadsNew;
             if (indicesNew) m_pIndices = indicesNew;
 
@@ -444,7 +467,7 @@ void CCParticleSystemQuad::setTotalParticles(unsigned int tp)
         {
             for (unsigned int i = 0; i < m_uTotalParticles; i++)
             {
-                m_pParticles[i].atlasIndex=i;
+                m_tParticleData.atlasIndex[i]=i;
             }
         }
 
@@ -472,7 +495,7 @@ void CCParticleSystemQuad::setupVBOandVAO()
     glGenBuffers(2, &m_pBuffersVBO[0]);
 
     glBindBuffer(GL_ARRAY_BUFFER, m_pBuffersVBO[0]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(m_pQuads[0]) * m_uTotalParticles, m_pQuads, GL_DYNAMIC_DRAW);
+    CCUploadScheduler::sharedUploadScheduler()->bufferData(GL_ARRAY_BUFFER, sizeof(m_pQuads[0]) * m_uTotalParticles, m_pQuads, GL_DYNAMIC_DRAW);
 
     // vertices
     glEnableVertexAttribArray(kCCVertexAttrib_Position);
@@ -487,7 +510,7 @@ void CCParticleSystemQuad::setupVBOandVAO()
     glVertexAttribPointer(kCCVertexAttrib_TexCoords, 2, GL_FLOAT, GL_FALSE, kQuadSize, (GLvoid*) offsetof( ccV3F_C4B_T2F, texCoords));
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_pBuffersVBO[1]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(m_pIndices[0]) * m_uTotalParticles * 6, m_pIndices, GL_STATIC_DRAW);
+    CCUploadScheduler::sharedUploadScheduler()->bufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(m_pIndices[0]) * m_uTotalParticles * 6, m_pIndices, GL_STATIC_DRAW);
 
     // Must unbind the VAO before changing the element buffer.
     ccGLBindVAO(0);
@@ -503,11 +526,11 @@ void CCParticleSystemQuad::setupVBO()
     glGenBuffers(2, &m_pBuffersVBO[0]);
 
     glBindBuffer(GL_ARRAY_BUFFER, m_pBuffersVBO[0]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(m_pQuads[0]) * m_uTotalParticles, m_pQuads, GL_DYNAMIC_DRAW);
+    CCUploadScheduler::sharedUploadScheduler()->bufferData(GL_ARRAY_BUFFER, sizeof(m_pQuads[0]) * m_uTotalParticles, m_pQuads, GL_DYNAMIC_DRAW);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_pBuffersVBO[1]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(m_pIndices[0]) * m_uTotalParticles * 6, m_pIndices, GL_STATIC_DRAW);
+    CCUploadScheduler::sharedUploadScheduler()->bufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(m_pIndices[0]) * m_uTotalParticles * 6, m_pIndices, GL_STATIC_DRAW);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
     CHECK_GL_ERROR_DEBUG();
@@ -574,7 +597,7 @@ void CCParticleSystemQuad::setBatchNode(CCParticleBatchNode * batchNode)
         else if( !oldBatch )
         {
             // copy current state to batch
-            ccV3F_C4B_T2F_Quad *batchQuads = m_pBatchNode->getTextureAtlas()->getQuads();
+            ccV3F_C4B_T2F_Quad *batchQuads = m_pBatchNode->getTextureAtlas()->getQuadsForUpdate(m_uAtlasIndex, m_uTotalParticles);
             ccV3F_C4B_T2F_Quad *quad = &(batchQuads[m_uAtlasIndex] );
             memcpy( quad, m_pQuads, m_uTotalParticles * sizeof(m_pQuads[0]) );
 
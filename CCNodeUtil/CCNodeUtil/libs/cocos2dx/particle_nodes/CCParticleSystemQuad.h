@@ -90,7 +90,7 @@ public:
     // super methods
     virtual bool initWithTotalParticles(unsigned int numberOfParticles);
     virtual void setTexture(CCTexture2D* texture);
-    virtual void updateQuadWithParticle(tCCParticle* particle, const CCPoint& newPosition);
+    virtual void updateParticleQuads(unsigned int uBegin, unsigned int uEnd, const CCPoint& currentPosition);
     virtual void postStep();
     virtual void draw();
     virtual void setBatchNode(CCParticleBatchNode* batchNode);
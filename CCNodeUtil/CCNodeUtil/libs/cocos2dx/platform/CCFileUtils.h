@@ -34,6 +34,7 @@ NS_CC_BEGIN
 
 class CCDictionary;
 class CCArray;
+class CCAssetPack;
 /**
  * @addtogroup platform
  * @{
@@ -66,6 +67,9 @@ public:
     /**
      *  Purges the file searching cache.
      *
+     *  It is invoked whenever the search paths, the resolutions order or the filename lookup dictionary change.
+     *  Interned path handles stay valid.
+     *
      *  @note It should be invoked after the resources were updated.
      *        For instance, in the CocosPlayer sample, every time you run application from CocosBuilder,
      *        All the resources will be downloaded to the writable folder, before new js app launchs,
@@ -92,6 +96,43 @@ public:
     */
     unsigned char* getFileDataFromZip(const char* pszZipFilePath, const char* pszFileName, unsigned long * pSize);
 
+    /**
+    @brief Get resource file data without copying it, if the file is stored as is in an asset pack.
+    @param[in]  pszFileName The resource file name which contains the path.
+    @param[out] pSize If the file is found, it will be the data size, otherwise 0.
+    @return A pointer into the mapped pack, valid until the pack is removed, or NULL if the file
+            isn't an uncompressed pack entry. Use getFileData() in that case.
+    @since v2.1.x
+    */
+    const unsigned char* getFileDataView(const char* pszFileName, unsigned long * pSize);
+
+    /**
+     *  Mounts an asset pack (see CCAssetPack).
+     *
+     *  The pack acts as a directory named like the pack file: its entries are found by fullPathForFilename
+     *  for every relative search path, before the files of the bundle, and read by getFileData
+     *  from the mapped pack. Packs mounted last are searched first.
+     *
+     *  @note Mount the packs before loading any resource in the background.
+     *  @param pszPackFile The pack file name, resolved with fullPathForFilename.
+     *  @return false if the pack can't be mapped.
+     *  @since v2.1.x
+     */
+    bool addAssetPack(const char* pszPackFile);
+
+    /**
+     *  Unmounts every asset pack. Views returned by getFileDataView become invalid.
+     *  @since v2.1.x
+     */
+    void removeAllAssetPacks();
+
+    /**
+     *  Returns the mounted asset pack a full path returned by fullPathForFilename points into, or NULL.
+     *  @param[out] entry The path of the entry inside of the pack.
+     *  @since v2.1.x
+     */
+    CCAssetPack* getAssetPackForPath(const std::string& fullPath, std::string& entry);
+
     /**
      *  @brief   Generate the absolute path of the file.
      *  @param   pszRelativePath     The relative path of the file.
@@ -148,6 +189,32 @@ public:
      @since v2.1
      */
     std::string fullPathForFilename(const char* pszFileName);
+
+    /** Returns the handle of the full path of a file name, resolved like fullPathForFilename().
+
+     Full paths are interned: a handle is a small non-zero integer which stays valid and keeps
+     pointing to the same path for the lifetime of the application, even after purgeCachedEntries().
+     File names which have already been resolved cost one hash lookup.
+     Only paths of existing files are interned: a file name which can't be found gets the handle
+     of the name itself if it was interned with handleForPath(), 0 otherwise.
+     @since v2.1.x
+     */
+    unsigned int fullPathHandleForFilename(const char* pszFileName);
+
+    /** Interns a path as is, without resolving it, and returns its handle.
+     @since v2.1.x
+     */
+    unsigned int handleForPath(const char* pszPath);
+
+    /** Returns the handle of a path interned already, or 0. Unlike handleForPath() it never interns.
+     @since v2.1.x
+     */
+    unsigned int findHandleForPath(const char* pszPath);
+
+    /** Returns the path interned for a handle, or an empty string for an unknown handle.
+     @since v2.1.x
+     */
+    std::string pathForHandle(unsigned int uHandle);
     
     /**
      * Loads the filenameLookup dictionary from the contents of a filename.
@@ -277,6 +344,7 @@ protected:
     
     std::string getNewFilename(const char* pszFileName);
     std::string getPathForFilename(const std::string& filename, const std::string& resourceDirectory, const std::string& searchPath);
+    std::string resolveFullPath(const char* pszFileName, unsigned int* pHandle);
     
     std::string m_obDirectory;
     
@@ -292,6 +360,9 @@ protected:
     std::vector<std::string> m_searchResolutionsOrderArray;
     std::vector<std::string> m_searchPathArray;
     std::string m_strDefaultResRootPath;
+
+    //! mounted asset packs, retained, the last one is searched first
+    std::vector<CCAssetPack*> m_assetPacks;
 };
 
 // end of platform group
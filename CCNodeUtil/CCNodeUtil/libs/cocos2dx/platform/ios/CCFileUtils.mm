@@ -36,6 +36,9 @@ THE SOFTWARE.
 #include "CCSAXParser.h"
 #include "CCDictionary.h"
 #include "support/zip_support/unzip.h"
+#include "support/CCAssetPack.h"
+#include "support/data_support/uthash.h"
+#include <pthread.h>
 
 #define MAX_PATH 260
 
@@ -142,7 +145,56 @@ static void static_addValueToCCDict(id key, id value, CCDictionary* pDict)
 
 NS_CC_BEGIN
 
-static std::map<std::string, std::string> s_fullPathCache;
+// interned full paths, a handle is the index of its path in s_internedPathArray plus one
+typedef struct _ccInternedPath
+{
+    std::string path;
+    unsigned int handle;
+    UT_hash_handle hh;
+} ccInternedPath;
+
+// file names already resolved, dropped when the search rules change
+typedef struct _ccResolvedPath
+{
+    std::string name;
+    unsigned int handle;
+    UT_hash_handle hh;
+} ccResolvedPath;
+
+static ccInternedPath *s_pInternedPaths = NULL;
+static std::vector<ccInternedPath*> s_internedPathArray;
+static ccResolvedPath *s_pResolvedPaths = NULL;
+// the loading threads resolve paths as well
+static pthread_mutex_t s_pathCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static unsigned int static_findPath(const char* pszPath, size_t uLength)
+{
+    ccInternedPath *pEntry = NULL;
+    HASH_FIND(hh, s_pInternedPaths, pszPath, uLength, pEntry);
+    return pEntry ? pEntry->handle : 0;
+}
+
+// interned paths are never freed, only those of existing files should be interned
+static unsigned int static_internPath(const char* pszPath, size_t uLength)
+{
+    ccInternedPath *pEntry = NULL;
+    HASH_FIND(hh, s_pInternedPaths, pszPath, uLength, pEntry);
+    if (! pEntry)
+    {
+        pEntry = new ccInternedPath();
+        pEntry->path.assign(pszPath, uLength);
+        s_internedPathArray.push_back(pEntry);
+        pEntry->handle = (unsigned int)s_internedPathArray.size();
+        HASH_ADD_KEYPTR(hh, s_pInternedPaths, pEntry->path.c_str(), pEntry->path.length(), pEntry);
+    }
+    return pEntry->handle;
+}
+
+static bool static_isAbsolutePath(const char* pszPath)
+{
+    // same as -[NSString isAbsolutePath], without creating a NSString
+    return pszPath[0] == '/' || pszPath[0] == '~';
+}
 
 static CCFileUtils* s_pFileUtils = NULL;
 static NSFileManager* s_fileManager = [NSFileManager defaultManager];
@@ -161,6 +213,7 @@ void CCFileUtils::purgeFileUtils()
 {
     if (s_pFileUtils != NULL)
     {
+        s_pFileUtils->removeAllAssetPacks();
         s_pFileUtils->purgeCachedEntries();
         CC_SAFE_RELEASE(s_pFileUtils->m_pFilenameLookupDict);
     }
@@ -170,7 +223,14 @@ void CCFileUtils::purgeFileUtils()
 
 void CCFileUtils::purgeCachedEntries()
 {
-    s_fullPathCache.clear();
+    pthread_mutex_lock(&s_pathCacheMutex);
+    ccResolvedPath *pEntry, *pTmp;
+    HASH_ITER(hh, s_pResolvedPaths, pEntry, pTmp)
+    {
+        HASH_DEL(s_pResolvedPaths, pEntry);
+        delete pEntry;
+    }
+    pthread_mutex_unlock(&s_pathCacheMutex);
 }
 
 bool CCFileUtils::init()
@@ -198,6 +258,7 @@ void CCFileUtils::setSearchResolutionsOrder(const std::vector<std::string>& sear
     {
         m_searchResolutionsOrderArray.push_back("");
     }
+    purgeCachedEntries();
 }
 
 const std::vector<std::string>& CCFileUtils::getSearchResolutionsOrder()
@@ -221,6 +282,7 @@ void CCFileUtils::setSearchPaths(const std::vector<std::string>& searchPaths)
     {
         m_searchPathArray.push_back(m_strDefaultResRootPath);
     }
+    purgeCachedEntries();
 }
 
 const std::vector<std::string>& CCFileUtils::getSearchPaths()
@@ -236,6 +298,7 @@ void CCFileUtils::setResourceDirectory(const char *pszDirectoryName)
         m_obDirectory.append("/");
     }
     m_searchPathArray.insert(m_searchPathArray.begin(), m_obDirectory);
+    purgeCachedEntries();
 }
 
 const char* CCFileUtils::getResourceDirectory()
@@ -284,6 +347,25 @@ std::string CCFileUtils::getPathForFilename(const std::string& filename, const s
     
     if (searchPath[0] != '/')
     {
+        // asset packs first, their entries are relative to the resources root
+        if (! m_assetPacks.empty())
+        {
+            std::string entry = path + file;
+            size_t start = entry.find_first_not_of('/');
+            if (start != std::string::npos && entry.compare(start, 2, "./") == 0)
+            {
+                start += 2;
+            }
+            entry.erase(0, start);
+
+            for (std::vector<CCAssetPack*>::reverse_iterator packIter = m_assetPacks.rbegin();
+                 packIter != m_assetPacks.rend(); ++packIter) {
+                if ((*packIter)->fileExists(entry.c_str())) {
+                    return (*packIter)->getPath() + "/" + entry;
+                }
+            }
+        }
+
         NSString* fullpath = [[NSBundle mainBundle] pathForResource:[NSString stringWithUTF8String:file.c_str()]
                                                ofType:nil
                                           inDirectory:[NSString stringWithUTF8String:path.c_str()]];
@@ -303,23 +385,41 @@ std::string CCFileUtils::getPathForFilename(const std::string& filename, const s
 	return "";
 }
 
-std::string CCFileUtils::fullPathForFilename(const char* pszFileName)
+std::string CCFileUtils::resolveFullPath(const char* pszFileName, unsigned int* pHandle)
 {
     CCAssert(pszFileName != NULL, "CCFileUtils: Invalid path");
 
-    NSString *relPath = [NSString stringWithUTF8String:pszFileName];
-    
     // Return directly if it's an absolute path.
-    if ([relPath isAbsolutePath]) {
+    if (static_isAbsolutePath(pszFileName)) {
+        if (pHandle) {
+            *pHandle = findHandleForPath(pszFileName);
+            if (*pHandle == 0) {
+                // entries of the asset packs exist, although not on disk
+                std::string entry;
+                CCAssetPack* pPack = getAssetPackForPath(pszFileName, entry);
+                if (pPack ? pPack->fileExists(entry.c_str()) : [s_fileManager fileExistsAtPath:[NSString stringWithUTF8String:pszFileName]]) {
+                    *pHandle = handleForPath(pszFileName);
+                }
+            }
+        }
         return pszFileName;
     }
     
     // Already Cached ?
-    std::map<std::string, std::string>::iterator cacheIter = s_fullPathCache.find(pszFileName);
-    if (cacheIter != s_fullPathCache.end()) {
-        //CCLOG("Return full path from cache: %s", cacheIter->second.c_str());
-        return cacheIter->second;
+    size_t uLength = strlen(pszFileName);
+    pthread_mutex_lock(&s_pathCacheMutex);
+    ccResolvedPath *pResolved = NULL;
+    HASH_FIND(hh, s_pResolvedPaths, pszFileName, uLength, pResolved);
+    if (pResolved) {
+        unsigned int uHandle = pResolved->handle;
+        std::string fullpath = pHandle ? std::string() : s_internedPathArray[uHandle - 1]->path;
+        pthread_mutex_unlock(&s_pathCacheMutex);
+        if (pHandle) {
+            *pHandle = uHandle;
+        }
+        return fullpath;
     }
+    pthread_mutex_unlock(&s_pathCacheMutex);
     
     std::string fullpath = "";
     
@@ -336,16 +436,77 @@ std::string CCFileUtils::fullPathForFilename(const char* pszFileName)
             if (fullpath.length() > 0)
             {
                 // Adding the full path to cache if the file was found.
-                s_fullPathCache.insert(std::pair<std::string, std::string>(pszFileName, fullpath));
+                pthread_mutex_lock(&s_pathCacheMutex);
+                unsigned int uHandle = static_internPath(fullpath.c_str(), fullpath.length());
+                HASH_FIND(hh, s_pResolvedPaths, pszFileName, uLength, pResolved);
+                if (! pResolved) {
+                    pResolved = new ccResolvedPath();
+                    pResolved->name.assign(pszFileName, uLength);
+                    pResolved->handle = uHandle;
+                    HASH_ADD_KEYPTR(hh, s_pResolvedPaths, pResolved->name.c_str(), pResolved->name.length(), pResolved);
+                }
+                pthread_mutex_unlock(&s_pathCacheMutex);
+
+                if (pHandle) {
+                    *pHandle = uHandle;
+                }
                 return fullpath;
             }
         }
     }
 
     // The file wasn't found, return the file name passed in.
+    // It isn't cached nor interned, the file may be created later on.
+    if (pHandle) {
+        *pHandle = findHandleForPath(pszFileName);
+    }
     return pszFileName;
 }
 
+std::string CCFileUtils::fullPathForFilename(const char* pszFileName)
+{
+    return resolveFullPath(pszFileName, NULL);
+}
+
+unsigned int CCFileUtils::fullPathHandleForFilename(const char* pszFileName)
+{
+    unsigned int uHandle = 0;
+    resolveFullPath(pszFileName, &uHandle);
+    return uHandle;
+}
+
+unsigned int CCFileUtils::handleForPath(const char* pszPath)
+{
+    CCAssert(pszPath != NULL, "CCFileUtils: Invalid path");
+
+    pthread_mutex_lock(&s_pathCacheMutex);
+    unsigned int uHandle = static_internPath(pszPath, strlen(pszPath));
+    pthread_mutex_unlock(&s_pathCacheMutex);
+    return uHandle;
+}
+
+unsigned int CCFileUtils::findHandleForPath(const char* pszPath)
+{
+    CCAssert(pszPath != NULL, "CCFileUtils: Invalid path");
+
+    pthread_mutex_lock(&s_pathCacheMutex);
+    unsigned int uHandle = static_findPath(pszPath, strlen(pszPath));
+    pthread_mutex_unlock(&s_pathCacheMutex);
+    return uHandle;
+}
+
+std::string CCFileUtils::pathForHandle(unsigned int uHandle)
+{
+    std::string path;
+    pthread_mutex_lock(&s_pathCacheMutex);
+    if (uHandle > 0 && uHandle <= s_internedPathArray.size())
+    {
+        path = s_internedPathArray[uHandle - 1]->path;
+    }
+    pthread_mutex_unlock(&s_pathCacheMutex);
+    return path;
+}
+
 void CCFileUtils::loadFilenameLookupDictionaryFromFile(const char* filename)
 {
     std::string pFullPath = this->fullPathForFilename(filename);
@@ -372,6 +533,7 @@ void CCFileUtils::setFilenameLookupDictionary(CCDictionary* pFilenameLookupDict)
     CC_SAFE_RELEASE(m_pFilenameLookupDict);
     m_pFilenameLookupDict = pFilenameLookupDict;
     CC_SAFE_RETAIN(m_pFilenameLookupDict);
+    purgeCachedEntries();
 }
 
 const char* CCFileUtils::fullPathFromRelativeFile(const char *pszFilename, const char *pszRelativeFile)
@@ -383,11 +545,44 @@ const char* CCFileUtils::fullPathFromRelativeFile(const char *pszFilename, const
     return pRet->m_sString.c_str();
 }
 
+// plists stored in an asset pack are parsed from the mapped data
+static id static_propertyListWithContentsOfFile(const std::string& fullPath)
+{
+    unsigned long nSize = 0;
+    const unsigned char* pView = CCFileUtils::sharedFileUtils()->getFileDataView(fullPath.c_str(), &nSize);
+    NSData* pData = nil;
+    if (pView)
+    {
+        pData = [NSData dataWithBytesNoCopy:(void*)pView length:nSize freeWhenDone:NO];
+    }
+    else
+    {
+        std::string entry;
+        CCAssetPack* pPack = CCFileUtils::sharedFileUtils()->getAssetPackForPath(fullPath, entry);
+        if (! pPack)
+        {
+            return nil;
+        }
+        unsigned char* pBuffer = pPack->getFileData(entry.c_str(), &nSize);
+        if (! pBuffer)
+        {
+            return nil;
+        }
+        pData = [NSData dataWithBytes:pBuffer length:nSize];
+        delete [] pBuffer;
+    }
+    return [NSPropertyListSerialization propertyListWithData:pData options:NSPropertyListImmutable format:NULL error:NULL];
+}
+
 CCDictionary* ccFileUtils_dictionaryWithContentsOfFileThreadSafe(const char *pFileName)
 {
     std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(pFileName);
-    NSString* pPath = [NSString stringWithUTF8String:fullPath.c_str()];
-    NSDictionary* pDict = [NSDictionary dictionaryWithContentsOfFile:pPath];
+    NSDictionary* pDict = static_propertyListWithContentsOfFile(fullPath);
+    if (! pDict)
+    {
+        NSString* pPath = [NSString stringWithUTF8String:fullPath.c_str()];
+        pDict = [NSDictionary dictionaryWithContentsOfFile:pPath];
+    }
     
     CCDictionary* pRet = new CCDictionary();
     for (id key in [pDict allKeys]) {
@@ -406,8 +601,12 @@ CCArray* ccFileUtils_arrayWithContentsOfFileThreadSafe(const char* pFileName)
 //    pPath = [[NSBundle mainBundle] pathForResource:pPath ofType:pathExtension];
 //    fixing cannot read data using CCArray::createWithContentsOfFile
     std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(pFileName);
-    NSString* pPath = [NSString stringWithUTF8String:fullPath.c_str()];
-    NSArray* pArray = [NSArray arrayWithContentsOfFile:pPath];
+    NSArray* pArray = static_propertyListWithContentsOfFile(fullPath);
+    if (! pArray)
+    {
+        NSString* pPath = [NSString stringWithUTF8String:fullPath.c_str()];
+        pArray = [NSArray arrayWithContentsOfFile:pPath];
+    }
     
     CCArray* pRet = new CCArray();
     for (id value in pArray) {
@@ -424,8 +623,18 @@ unsigned char* CCFileUtils::getFileData(const char* pszFileName, const char* psz
     *pSize = 0;
     do 
     {
-        // read the file from hardware
         std::string fullPath = fullPathForFilename(pszFileName);
+
+        // read the file from a mapped asset pack
+        std::string entry;
+        CCAssetPack* pPack = getAssetPackForPath(fullPath, entry);
+        if (pPack)
+        {
+            pBuffer = pPack->getFileData(entry.c_str(), pSize);
+            break;
+        }
+
+        // read the file from hardware
         FILE *fp = fopen(fullPath.c_str(), pszMode);
         CC_BREAK_IF(!fp);
 
@@ -448,6 +657,62 @@ unsigned char* CCFileUtils::getFileData(const char* pszFileName, const char* psz
     return pBuffer;
 }
 
+const unsigned char* CCFileUtils::getFileDataView(const char* pszFileName, unsigned long * pSize)
+{
+    CCAssert(pszFileName != NULL && pSize != NULL, "Invalid parameters.");
+    *pSize = 0;
+
+    if (m_assetPacks.empty())
+    {
+        return NULL;
+    }
+
+    std::string entry;
+    CCAssetPack* pPack = getAssetPackForPath(fullPathForFilename(pszFileName), entry);
+    return pPack ? pPack->getFileView(entry.c_str(), pSize) : NULL;
+}
+
+bool CCFileUtils::addAssetPack(const char* pszPackFile)
+{
+    std::string fullPath = fullPathForFilename(pszPackFile);
+    CCAssetPack* pPack = CCAssetPack::create(fullPath.c_str());
+    if (! pPack)
+    {
+        return false;
+    }
+
+    pPack->retain();
+    m_assetPacks.push_back(pPack);
+
+    // cached paths may now resolve into the pack
+    purgeCachedEntries();
+    return true;
+}
+
+void CCFileUtils::removeAllAssetPacks()
+{
+    for (std::vector<CCAssetPack*>::iterator packIter = m_assetPacks.begin(); packIter != m_assetPacks.end(); ++packIter) {
+        (*packIter)->release();
+    }
+    m_assetPacks.clear();
+    purgeCachedEntries();
+}
+
+CCAssetPack* CCFileUtils::getAssetPackForPath(const std::string& fullPath, std::string& entry)
+{
+    for (std::vector<CCAssetPack*>::reverse_iterator packIter = m_assetPacks.rbegin();
+         packIter != m_assetPacks.rend(); ++packIter) {
+        const std::string& packPath = (*packIter)->getPath();
+        if (fullPath.length() > packPath.length() + 1
+            && fullPath.compare(0, packPath.length(), packPath) == 0
+            && fullPath[packPath.length()] == '/') {
+            entry = fullPath.substr(packPath.length() + 1);
+            return *packIter;
+        }
+    }
+    return NULL;
+}
+
 // notification support when getFileData from a invalid file
 static bool s_bPopupNotify = true;
 
@@ -343,10 +343,16 @@ bool CCImage::initWithImageFile(const char * strPath, EImageFormat eImgFmt/* = e
 {
 	bool bRet = false;
     unsigned long nSize = 0;
-    unsigned char* pBuffer = CCFileUtils::sharedFileUtils()->getFileData(
-				CCFileUtils::sharedFileUtils()->fullPathForFilename(strPath).c_str(),
-				"rb",
-				&nSize);
+    std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(strPath);
+
+    // decode straight from a mapped asset pack
+    const unsigned char* pView = CCFileUtils::sharedFileUtils()->getFileDataView(fullPath.c_str(), &nSize);
+    if (pView != NULL && nSize > 0)
+    {
+        return initWithImageData((void*)pView, nSize, eImgFmt);
+    }
+
+    unsigned char* pBuffer = CCFileUtils::sharedFileUtils()->getFileData(fullPath.c_str(), "rb", &nSize);
 				
     if (pBuffer != NULL && nSize > 0)
     {
@@ -363,6 +369,12 @@ bool CCImage::initWithImageFileThreadSafe(const char *fullpath, EImageFormat ima
      */
     bool bRet = false;
     unsigned long nSize = 0;
+    const unsigned char* pView = CCFileUtils::sharedFileUtils()->getFileDataView(fullpath, &nSize);
+    if (pView != NULL && nSize > 0)
+    {
+        return initWithImageData((void*)pView, nSize, imageType);
+    }
+
     unsigned char* pBuffer = CCFileUtils::sharedFileUtils()->getFileData(fullpath, "rb", &nSize);
     if (pBuffer != NULL && nSize > 0)
     {
@@ -78,6 +78,7 @@ CCShaderCache::~CCShaderCache()
 bool CCShaderCache::init()
 {
     m_pPrograms = new CCDictionary();
+    m_pPrograms->setInternKeys(true);
     loadDefaultShaders();
     return true;
 }
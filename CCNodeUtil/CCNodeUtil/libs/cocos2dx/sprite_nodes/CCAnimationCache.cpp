@@ -56,6 +56,7 @@ void CCAnimationCache::purgeSharedAnimationCache(void)
 bool CCAnimationCache::init()
 {
     m_pAnimations = new CCDictionary();
+    m_pAnimations->setInternKeys(true);
     return true;
 }
 
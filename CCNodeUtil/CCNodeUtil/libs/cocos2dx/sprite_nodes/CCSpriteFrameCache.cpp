@@ -37,12 +37,238 @@ THE SOFTWARE.
 #include "cocoa/CCString.h"
 #include "cocoa/CCArray.h"
 #include "cocoa/CCDictionary.h"
+#include "support/data_support/ccStringIntern.h"
+#include <string.h>
 #include <vector>
 
 using namespace std;
 
 NS_CC_BEGIN
 
+/*
+ Layout of a .ccframes index, written by tools/ccframes.py. All integers are little endian:
+
+ - a 32 bytes header: "CCSF", version (1), frame count, alias count, slot count (a power of two),
+   offset and length of the texture file name (empty if the plist had none) and 4 reserved bytes.
+ - one 32 bytes record per frame: the FNV-1a hash, offset and length of its name, flags, the rect
+   and the source size as 16 bits integers, and the offset as two floats.
+ - one 16 bytes record per alias: the hash, offset and length of its name and the frame it stands for.
+ - the slots, one 32 bits integer each: 0 for an empty slot, otherwise 1 + the frame number,
+   or 1 + frame count + the alias number. Names are found by linear probing from hash & (slot count - 1).
+ - the names, each followed by a '\0'.
+ */
+#define kCCSpriteFrameIndexVersion      1
+#define kCCSpriteFrameIndexRotated      0x1
+
+typedef struct _ccSpriteFrameIndexHeader
+{
+    char            magic[4];
+    unsigned int    version;
+    unsigned int    frameCount;
+    unsigned int    aliasCount;
+    unsigned int    slotCount;
+    unsigned int    textureNameOffset;
+    unsigned int    textureNameLength;
+    unsigned int    reserved;
+} ccSpriteFrameIndexHeader;
+
+typedef struct _ccSpriteFrameIndexFrame
+{
+    unsigned int    hash;
+    unsigned int    nameOffset;
+    unsigned short  nameLength;
+    unsigned short  flags;
+    unsigned short  x, y, width, height;
+    unsigned short  sourceWidth, sourceHeight;
+    float           offsetX, offsetY;
+} ccSpriteFrameIndexFrame;
+
+typedef struct _ccSpriteFrameIndexAlias
+{
+    unsigned int    hash;
+    unsigned int    nameOffset;
+    unsigned int    nameLength;
+    unsigned int    frame;
+} ccSpriteFrameIndexAlias;
+
+struct _ccSpriteFrameIndex
+{
+    std::string                     path;       // full path of the .ccframes file
+    unsigned char                   *pData;
+    unsigned long                   uSize;
+    const ccSpriteFrameIndexHeader  *pHeader;
+    const ccSpriteFrameIndexFrame   *pFrames;
+    const ccSpriteFrameIndexAlias   *pAliases;
+    const unsigned int              *pSlots;
+    unsigned char                   *pRemoved;  // one flag per frame, set by removeSpriteFrameByName
+    CCTexture2D                     *pTexture;  // retained
+};
+
+static bool isSpriteFrameIndexFile(const char *pszPath)
+{
+    size_t length = strlen(pszPath);
+    return length > 9 && strcmp(pszPath + length - 9, ".ccframes") == 0;
+}
+
+static void freeSpriteFrameIndex(_ccSpriteFrameIndex *pIndex)
+{
+    CC_SAFE_RELEASE(pIndex->pTexture);
+    CC_SAFE_DELETE_ARRAY(pIndex->pRemoved);
+    CC_SAFE_DELETE_ARRAY(pIndex->pData);
+    delete pIndex;
+}
+
+static bool isValidName(const _ccSpriteFrameIndex *pIndex, unsigned int uOffset, unsigned int uLength)
+{
+    return (unsigned long long)uOffset + uLength < pIndex->uSize && pIndex->pData[uOffset + uLength] == '\0';
+}
+
+// checked once here, so lookups can trust the offsets
+static bool validateSpriteFrameIndex(_ccSpriteFrameIndex *pIndex)
+{
+    if (pIndex->uSize < sizeof(ccSpriteFrameIndexHeader))
+    {
+        return false;
+    }
+
+    const ccSpriteFrameIndexHeader *pHeader = (const ccSpriteFrameIndexHeader*)pIndex->pData;
+    if (memcmp(pHeader->magic, "CCSF", 4) != 0 || pHeader->version != kCCSpriteFrameIndexVersion)
+    {
+        return false;
+    }
+
+    unsigned int slotCount = pHeader->slotCount;
+    unsigned long long entryCount = (unsigned long long)pHeader->frameCount + pHeader->aliasCount;
+    if (slotCount == 0 || (slotCount & (slotCount - 1)) != 0 || entryCount > slotCount)
+    {
+        return false;
+    }
+
+    unsigned long long aliasesOffset = sizeof(ccSpriteFrameIndexHeader) + (unsigned long long)pHeader->frameCount * sizeof(ccSpriteFrameIndexFrame);
+    unsigned long long slotsOffset = aliasesOffset + (unsigned long long)pHeader->aliasCount * sizeof(ccSpriteFrameIndexAlias);
+    if (slotsOffset + (unsigned long long)slotCount * sizeof(unsigned int) > pIndex->uSize
+        || ! isValidName(pIndex, pHeader->textureNameOffset, pHeader->textureNameLength))
+    {
+        return false;
+    }
+
+    pIndex->pHeader = pHeader;
+    pIndex->pFrames = (const ccSpriteFrameIndexFrame*)(pIndex->pData + sizeof(ccSpriteFrameIndexHeader));
+    pIndex->pAliases = (const ccSpriteFrameIndexAlias*)(pIndex->pData + aliasesOffset);
+    pIndex->pSlots = (const unsigned int*)(pIndex->pData + slotsOffset);
+
+    for (unsigned int i = 0; i < pHeader->frameCount; i++)
+    {
+        if (! isValidName(pIndex, pIndex->pFrames[i].nameOffset, pIndex->pFrames[i].nameLength))
+        {
+            return false;
+        }
+    }
+    for (unsigned int i = 0; i < pHeader->aliasCount; i++)
+    {
+        const ccSpriteFrameIndexAlias *pAlias = &pIndex->pAliases[i];
+        if (! isValidName(pIndex, pAlias->nameOffset, pAlias->nameLength) || pAlias->frame >= pHeader->frameCount)
+        {
+            return false;
+        }
+    }
+    for (unsigned int i = 0; i < slotCount; i++)
+    {
+        if (pIndex->pSlots[i] > entryCount)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static _ccSpriteFrameIndex* loadSpriteFrameIndex(const std::string& fullPath)
+{
+    _ccSpriteFrameIndex *pIndex = new _ccSpriteFrameIndex();
+    pIndex->path = fullPath;
+    pIndex->uSize = 0;
+    pIndex->pData = CCFileUtils::sharedFileUtils()->getFileData(fullPath.c_str(), "rb", &pIndex->uSize);
+    pIndex->pHeader = NULL;
+    pIndex->pRemoved = NULL;
+    pIndex->pTexture = NULL;
+
+    if (pIndex->pData == NULL || ! validateSpriteFrameIndex(pIndex))
+    {
+        CCLOG("cocos2d: CCSpriteFrameCache: %s is not a valid sprite frame index", fullPath.c_str());
+        freeSpriteFrameIndex(pIndex);
+        return NULL;
+    }
+
+    pIndex->pRemoved = new unsigned char[pIndex->pHeader->frameCount + 1];
+    memset(pIndex->pRemoved, 0, pIndex->pHeader->frameCount + 1);
+    return pIndex;
+}
+
+// returns the number of the frame named or aliased pszName, or -1
+static int findSpriteFrameInIndex(const _ccSpriteFrameIndex *pIndex, const char *pszName, unsigned int uLength, unsigned int uHash)
+{
+    const unsigned char *pData = pIndex->pData;
+    unsigned int frameCount = pIndex->pHeader->frameCount;
+    unsigned int mask = pIndex->pHeader->slotCount - 1;
+
+    for (unsigned int i = 0; i <= mask; i++)
+    {
+        unsigned int slot = pIndex->pSlots[(uHash + i) & mask];
+        if (slot == 0)
+        {
+            return -1;
+        }
+
+        unsigned int entry = slot - 1;
+        if (entry < frameCount)
+        {
+            const ccSpriteFrameIndexFrame *pFrame = &pIndex->pFrames[entry];
+            if (pFrame->hash == uHash && pFrame->nameLength == uLength
+                && memcmp(pData + pFrame->nameOffset, pszName, uLength) == 0)
+            {
+                return (int)entry;
+            }
+        }
+        else
+        {
+            const ccSpriteFrameIndexAlias *pAlias = &pIndex->pAliases[entry - frameCount];
+            if (pAlias->hash == uHash && pAlias->nameLength == uLength
+                && memcmp(pData + pAlias->nameOffset, pszName, uLength) == 0)
+            {
+                return (int)pAlias->frame;
+            }
+        }
+    }
+    return -1;
+}
+
+// the texture file is found like in the plist case: metadata first, then the index name with a .png suffix
+static std::string texturePathForFile(const char *pszFile, const char *pszTextureFileName)
+{
+    string texturePath(pszTextureFileName ? pszTextureFileName : "");
+
+    if (! texturePath.empty())
+    {
+        // build texture path relative to plist file
+        texturePath = CCFileUtils::sharedFileUtils()->fullPathFromRelativeFile(texturePath.c_str(), pszFile);
+    }
+    else
+    {
+        // build texture path by replacing file extension
+        texturePath = pszFile;
+
+        // remove .xxx
+        size_t startPos = texturePath.find_last_of("."); 
+        texturePath = texturePath.erase(startPos);
+
+        // append .png
+        texturePath = texturePath.append(".png");
+
+        CCLOG("cocos2d: CCSpriteFrameCache: Trying to use file %s as texture", texturePath.c_str());
+    }
+    return texturePath;
+}
+
 static CCSpriteFrameCache *pSharedSpriteFrameCache = NULL;
 
 CCSpriteFrameCache* CCSpriteFrameCache::sharedSpriteFrameCache(void)
@@ -64,16 +290,24 @@ void CCSpriteFrameCache::purgeSharedSpriteFrameCache(void)
 bool CCSpriteFrameCache::init(void)
 {
     m_pSpriteFrames= new CCDictionary();
+    m_pSpriteFrames->setInternKeys(true);
     m_pSpriteFramesAliases = new CCDictionary();
+    m_pSpriteFramesAliases->setInternKeys(true);
     m_pLoadedFileNames = new std::set<std::string>();
+    m_pFrameIndices = new std::vector<_ccSpriteFrameIndex*>();
     return true;
 }
 
 CCSpriteFrameCache::~CCSpriteFrameCache(void)
 {
+    if (m_pFrameIndices)
+    {
+        removeFrameIndices(NULL);
+    }
     CC_SAFE_RELEASE(m_pSpriteFrames);
     CC_SAFE_RELEASE(m_pSpriteFramesAliases);
     CC_SAFE_DELETE(m_pLoadedFileNames);
+    CC_SAFE_DELETE(m_pFrameIndices);
 }
 
 void CCSpriteFrameCache::addSpriteFramesWithDictionary(CCDictionary* dictionary, CCTexture2D *pobTexture)
@@ -201,9 +435,91 @@ void CCSpriteFrameCache::addSpriteFramesWithDictionary(CCDictionary* dictionary,
     }
 }
 
+void CCSpriteFrameCache::addSpriteFramesWithIndex(_ccSpriteFrameIndex *pIndex, CCTexture2D *pobTexture)
+{
+    // adding a file again brings back the frames removed by name
+    for (std::vector<_ccSpriteFrameIndex*>::iterator it = m_pFrameIndices->begin(); it != m_pFrameIndices->end(); ++it)
+    {
+        if ((*it)->path == pIndex->path)
+        {
+            freeSpriteFrameIndex(*it);
+            m_pFrameIndices->erase(it);
+            break;
+        }
+    }
+
+    pIndex->pTexture = pobTexture;
+    pobTexture->retain();
+    m_pFrameIndices->push_back(pIndex);
+}
+
+CCSpriteFrame* CCSpriteFrameCache::spriteFrameFromIndices(const char *pszName)
+{
+    unsigned int length = (unsigned int)strlen(pszName);
+    unsigned int hash = ccStringHash(pszName, length);
+
+    for (std::vector<_ccSpriteFrameIndex*>::iterator it = m_pFrameIndices->begin(); it != m_pFrameIndices->end(); ++it)
+    {
+        _ccSpriteFrameIndex *pIndex = *it;
+        int number = findSpriteFrameInIndex(pIndex, pszName, length, hash);
+        if (number < 0 || pIndex->pRemoved[number])
+        {
+            continue;
+        }
+
+        const ccSpriteFrameIndexFrame *pRecord = &pIndex->pFrames[number];
+        const char *pszFrameName = (const char*)pIndex->pData + pRecord->nameOffset;
+
+        // pszName may be an alias of a frame which has already been created
+        CCSpriteFrame *pFrame = (CCSpriteFrame*)m_pSpriteFrames->objectForKey(pszFrameName);
+        if (pFrame)
+        {
+            return pFrame;
+        }
+
+        pFrame = new CCSpriteFrame();
+        pFrame->initWithTexture(pIndex->pTexture,
+                                CCRectMake(pRecord->x, pRecord->y, pRecord->width, pRecord->height),
+                                (pRecord->flags & kCCSpriteFrameIndexRotated) != 0,
+                                CCPointMake(pRecord->offsetX, pRecord->offsetY),
+                                CCSizeMake(pRecord->sourceWidth, pRecord->sourceHeight));
+        m_pSpriteFrames->setObject(pFrame, pszFrameName);
+        pFrame->release();
+        return pFrame;
+    }
+    return NULL;
+}
+
+void CCSpriteFrameCache::removeFrameIndices(CCTexture2D *pobTexture)
+{
+    std::vector<_ccSpriteFrameIndex*>::iterator it = m_pFrameIndices->begin();
+    while (it != m_pFrameIndices->end())
+    {
+        if (pobTexture == NULL || (*it)->pTexture == pobTexture)
+        {
+            freeSpriteFrameIndex(*it);
+            it = m_pFrameIndices->erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
 void CCSpriteFrameCache::addSpriteFramesWithFile(const char *pszPlist, CCTexture2D *pobTexture)
 {
     std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(pszPlist);
+    if (isSpriteFrameIndexFile(pszPlist))
+    {
+        _ccSpriteFrameIndex *pIndex = loadSpriteFrameIndex(fullPath);
+        if (pIndex)
+        {
+            addSpriteFramesWithIndex(pIndex, pobTexture);
+        }
+        return;
+    }
+
     CCDictionary *dict = CCDictionary::createWithContentsOfFileThreadSafe(fullPath.c_str());
 
     addSpriteFramesWithDictionary(dict, pobTexture);
@@ -233,37 +549,43 @@ void CCSpriteFrameCache::addSpriteFramesWithFile(const char *pszPlist)
     if (m_pLoadedFileNames->find(pszPlist) == m_pLoadedFileNames->end())
     {
         std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(pszPlist);
-        CCDictionary *dict = CCDictionary::createWithContentsOfFileThreadSafe(fullPath.c_str());
-
-        string texturePath("");
 
-        CCDictionary* metadataDict = (CCDictionary*)dict->objectForKey("metadata");
-        if (metadataDict)
+        if (isSpriteFrameIndexFile(pszPlist))
         {
-            // try to read  texture file name from meta data
-            texturePath = metadataDict->valueForKey("textureFileName")->getCString();
-        }
+            _ccSpriteFrameIndex *pIndex = loadSpriteFrameIndex(fullPath);
+            if (! pIndex)
+            {
+                return;
+            }
 
-        if (! texturePath.empty())
-        {
-            // build texture path relative to plist file
-            texturePath = CCFileUtils::sharedFileUtils()->fullPathFromRelativeFile(texturePath.c_str(), pszPlist);
+            const char *pszTextureFileName = (const char*)pIndex->pData + pIndex->pHeader->textureNameOffset;
+            std::string texturePath = texturePathForFile(pszPlist, pszTextureFileName);
+            CCTexture2D *pTexture = CCTextureCache::sharedTextureCache()->addImage(texturePath.c_str());
+            if (pTexture)
+            {
+                addSpriteFramesWithIndex(pIndex, pTexture);
+                m_pLoadedFileNames->insert(pszPlist);
+            }
+            else
+            {
+                CCLOG("cocos2d: CCSpriteFrameCache: Couldn't load texture");
+                freeSpriteFrameIndex(pIndex);
+            }
+            return;
         }
-        else
-        {
-            // build texture path by replacing file extension
-            texturePath = pszPlist;
 
-            // remove .xxx
-            size_t startPos = texturePath.find_last_of("."); 
-            texturePath = texturePath.erase(startPos);
+        CCDictionary *dict = CCDictionary::createWithContentsOfFileThreadSafe(fullPath.c_str());
 
-            // append .png
-            texturePath = texturePath.append(".png");
+        const char *pszTextureFileName = NULL;
 
-            CCLOG("cocos2d: CCSpriteFrameCache: Trying to use file %s as texture", texturePath.c_str());
+        CCDictionary* metadataDict = (CCDictionary*)dict->objectForKey("metadata");
+        if (metadataDict)
+        {
+            // try to read  texture file name from meta data
+            pszTextureFileName = metadataDict->valueForKey("textureFileName")->getCString();
         }
 
+        std::string texturePath = texturePathForFile(pszPlist, pszTextureFileName);
         CCTexture2D *pTexture = CCTextureCache::sharedTextureCache()->addImage(texturePath.c_str());
 
         if (pTexture)
@@ -291,6 +613,7 @@ void CCSpriteFrameCache::removeSpriteFrames(void)
     m_pSpriteFrames->removeAllObjects();
     m_pSpriteFramesAliases->removeAllObjects();
     m_pLoadedFileNames->clear();
+    removeFrameIndices(NULL);
 }
 
 void CCSpriteFrameCache::removeUnusedSpriteFrames(void)
@@ -308,6 +631,13 @@ void CCSpriteFrameCache::removeUnusedSpriteFrames(void)
         }
     }
 
+    // the indices would keep their textures alive, the frames still in use don't need them
+    if (! m_pFrameIndices->empty())
+    {
+        removeFrameIndices(NULL);
+        bRemoved = true;
+    }
+
     // XXX. Since we don't know the .plist file that originated the frame, we must remove all .plist from the cache
     if( bRemoved )
     {
@@ -337,6 +667,21 @@ void CCSpriteFrameCache::removeSpriteFrameByName(const char *pszName)
         m_pSpriteFrames->removeObjectForKey(pszName);
     }
 
+    // don't let the indices create it again
+    unsigned int length = (unsigned int)strlen(pszName);
+    unsigned int hash = ccStringHash(pszName, length);
+    for (std::vector<_ccSpriteFrameIndex*>::iterator it = m_pFrameIndices->begin(); it != m_pFrameIndices->end(); ++it)
+    {
+        _ccSpriteFrameIndex *pIndex = *it;
+        int number = findSpriteFrameInIndex(pIndex, pszName, length, hash);
+        if (number >= 0)
+        {
+            pIndex->pRemoved[number] = 1;
+            // pszName may be an alias: the frame is cached under its own name
+            m_pSpriteFrames->removeObjectForKey((const char*)pIndex->pData + pIndex->pFrames[number].nameOffset);
+        }
+    }
+
     // XXX. Since we don't know the .plist file that originated the frame, we must remove all .plist from the cache
     m_pLoadedFileNames->clear();
 }
@@ -344,6 +689,39 @@ void CCSpriteFrameCache::removeSpriteFrameByName(const char *pszName)
 void CCSpriteFrameCache::removeSpriteFramesFromFile(const char* plist)
 {
     std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(plist);
+
+    if (isSpriteFrameIndexFile(plist))
+    {
+        _ccSpriteFrameIndex *pIndex = NULL;
+        for (std::vector<_ccSpriteFrameIndex*>::iterator it = m_pFrameIndices->begin(); it != m_pFrameIndices->end(); ++it)
+        {
+            if ((*it)->path == fullPath)
+            {
+                pIndex = *it;
+                m_pFrameIndices->erase(it);
+                break;
+            }
+        }
+
+        // the index may have been released while some of its frames are still cached
+        if (! pIndex)
+        {
+            pIndex = loadSpriteFrameIndex(fullPath);
+        }
+
+        if (pIndex)
+        {
+            for (unsigned int i = 0; i < pIndex->pHeader->frameCount; i++)
+            {
+                m_pSpriteFrames->removeObjectForKey((const char*)pIndex->pData + pIndex->pFrames[i].nameOffset);
+            }
+            freeSpriteFrameIndex(pIndex);
+        }
+
+        m_pLoadedFileNames->erase(plist);
+        return;
+    }
+
     CCDictionary* dict = CCDictionary::createWithContentsOfFileThreadSafe(fullPath.c_str());
 
     removeSpriteFramesFromDictionary((CCDictionary*)dict);
@@ -391,6 +769,7 @@ void CCSpriteFrameCache::removeSpriteFramesFromTexture(CCTexture2D* texture)
     }
 
     m_pSpriteFrames->removeObjectsForKeys(keysToRemove);
+    removeFrameIndices(texture);
 }
 
 CCSpriteFrame* CCSpriteFrameCache::spriteFrameByName(const char *pszName)
@@ -408,6 +787,10 @@ CCSpriteFrame* CCSpriteFrameCache::spriteFrameByName(const char *pszName)
                 CCLOG("cocos2d: CCSpriteFrameCache: Frame '%s' not found", pszName);
             }
         }
+        else if (! m_pFrameIndices->empty())
+        {
+            frame = spriteFrameFromIndices(pszName);
+        }
     }
     return frame;
 }
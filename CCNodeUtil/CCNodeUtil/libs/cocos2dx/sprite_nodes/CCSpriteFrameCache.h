@@ -39,12 +39,14 @@ THE SOFTWARE.
 #include "cocoa/CCObject.h"
 #include <set>
 #include <string>
+#include <vector>
 
 NS_CC_BEGIN
 
 class CCDictionary;
 class CCArray;
 class CCSprite;
+struct _ccSpriteFrameIndex;
 
 /**
  * @addtogroup sprite_nodes
@@ -53,13 +55,17 @@ class CCSprite;
 
 /** @brief Singleton that handles the loading of the sprite frames.
  It saves in a cache the sprite frames.
+
+ Besides plists, the addSpriteFramesWithFile methods accept binary frame indices (.ccframes files)
+ built off-line from the plists with tools/ccframes.py. An index is read with a single file read
+ and its frames are only created the first time spriteFrameByName asks for them.
  @since v0.9
  */
 class CC_DLL CCSpriteFrameCache : public CCObject
 {
 protected:
     // MARMALADE: Made this protected not private, as deriving from this class is pretty useful
-    CCSpriteFrameCache(void) : m_pSpriteFrames(NULL), m_pSpriteFramesAliases(NULL){}
+    CCSpriteFrameCache(void) : m_pSpriteFrames(NULL), m_pSpriteFramesAliases(NULL), m_pFrameIndices(NULL){}
 public:
     bool init(void);
     ~CCSpriteFrameCache(void);
@@ -68,8 +74,17 @@ private:
     /*Adds multiple Sprite Frames with a dictionary. The texture will be associated with the created sprite frames.
      */
     void addSpriteFramesWithDictionary(CCDictionary* pobDictionary, CCTexture2D *pobTexture);
+
+    /* Adds the frames of a binary index. The frames are created lazily, with the given texture. */
+    void addSpriteFramesWithIndex(_ccSpriteFrameIndex *pIndex, CCTexture2D *pobTexture);
+
+    /* Creates the frame named pszName from the loaded indices, or returns NULL. */
+    CCSpriteFrame* spriteFrameFromIndices(const char *pszName);
+
+    /* Releases the indices whose texture is pobTexture, or every index if pobTexture is NULL. */
+    void removeFrameIndices(CCTexture2D *pobTexture);
 public:
-    /** Adds multiple Sprite Frames from a plist file.
+    /** Adds multiple Sprite Frames from a plist file, or from a .ccframes index.
      * A texture will be loaded automatically. The texture name will composed by replacing the .plist suffix with .png
      * If you want to use another texture, you should use the addSpriteFramesWithFile:texture method.
      */
@@ -98,6 +113,7 @@ public:
 
     /** Removes unused sprite frames.
      * Sprite Frames that have a retain count of 1 will be deleted.
+     * The .ccframes indices are released too, so they don't keep their textures alive.
      * It is convenient to call this method after when starting a new Scene.
      */
     void removeUnusedSpriteFrames(void);
@@ -144,6 +160,8 @@ protected:
     CCDictionary* m_pSpriteFrames;
     CCDictionary* m_pSpriteFramesAliases;
     std::set<std::string>*  m_pLoadedFileNames;
+    // loaded .ccframes indices, searched in loading order when a frame isn't in m_pSpriteFrames
+    std::vector<_ccSpriteFrameIndex*>* m_pFrameIndices;
 };
 
 // end of sprite_nodes group
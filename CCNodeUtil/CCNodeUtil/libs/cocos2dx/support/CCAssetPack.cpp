@@ -0,0 +1,274 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "CCAssetPack.h"
+#include "ccMacros.h"
+#include "support/zip_support/ZipUtils.h"
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+NS_CC_BEGIN
+
+#define kCCAssetPackVersion         1
+#define kCCAssetPackFlagDeflated    0x1
+
+typedef struct _ccAssetPackHeader
+{
+    char            magic[4];
+    unsigned int    version;
+    unsigned int    slotCount;
+    unsigned int    entryCount;
+    unsigned int    reserved[4];
+} ccAssetPackHeader;
+
+typedef struct _ccAssetPackEntry
+{
+    unsigned int    hash;
+    unsigned int    nameOffset;
+    unsigned int    nameLength;
+    unsigned int    flags;
+    unsigned int    dataOffset;
+    unsigned int    storedSize;
+    unsigned int    originalSize;
+    unsigned int    reserved;
+} ccAssetPackEntry;
+
+// FNV-1a, the host tool must use the same hash
+static unsigned int ccAssetPackHash(const char *str, unsigned int length)
+{
+    unsigned int hash = 2166136261u;
+    for (unsigned int i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char)str[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+CCAssetPack::CCAssetPack()
+: m_pMapping(NULL)
+, m_uMappingSize(0)
+, m_pHeader(NULL)
+, m_pSlots(NULL)
+{
+}
+
+CCAssetPack::~CCAssetPack()
+{
+    if (m_pMapping)
+    {
+        munmap(m_pMapping, m_uMappingSize);
+        m_pMapping = NULL;
+    }
+}
+
+CCAssetPack* CCAssetPack::create(const char *pszPath)
+{
+    CCAssetPack *pRet = new CCAssetPack();
+    if (pRet->initWithFile(pszPath))
+    {
+        pRet->autorelease();
+        return pRet;
+    }
+    CC_SAFE_DELETE(pRet);
+    return NULL;
+}
+
+bool CCAssetPack::initWithFile(const char *pszPath)
+{
+    CCAssert(pszPath != NULL, "CCAssetPack: Invalid path");
+    CCAssert(m_pMapping == NULL, "CCAssetPack: already initialized");
+
+    int fd = open(pszPath, O_RDONLY);
+    if (fd < 0)
+    {
+        CCLOG("cocos2d: CCAssetPack: can't open %s", pszPath);
+        return false;
+    }
+
+    struct stat st;
+    void *pMapping = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(ccAssetPackHeader))
+    {
+        pMapping = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    // the mapping keeps the file alive
+    close(fd);
+
+    if (pMapping == MAP_FAILED)
+    {
+        CCLOG("cocos2d: CCAssetPack: can't map %s", pszPath);
+        return false;
+    }
+
+    m_pMapping = (unsigned char*)pMapping;
+    m_uMappingSize = (unsigned long)st.st_size;
+    m_pHeader = (const ccAssetPackHeader*)m_pMapping;
+    m_pSlots = (const ccAssetPackEntry*)(m_pMapping + sizeof(ccAssetPackHeader));
+
+    if (! validate())
+    {
+        CCLOG("cocos2d: CCAssetPack: %s is not a valid pack", pszPath);
+        munmap(m_pMapping, m_uMappingSize);
+        m_pMapping = NULL;
+        m_uMappingSize = 0;
+        m_pHeader = NULL;
+        m_pSlots = NULL;
+        return false;
+    }
+
+    m_sPath = pszPath;
+    return true;
+}
+
+bool CCAssetPack::validate()
+{
+    if (memcmp(m_pHeader->magic, "CCPK", 4) != 0 || m_pHeader->version != kCCAssetPackVersion)
+    {
+        return false;
+    }
+
+    unsigned int slotCount = m_pHeader->slotCount;
+    if (slotCount == 0 || (slotCount & (slotCount - 1)) != 0 || m_pHeader->entryCount > slotCount)
+    {
+        return false;
+    }
+
+    unsigned long long indexEnd = sizeof(ccAssetPackHeader) + (unsigned long long)slotCount * sizeof(ccAssetPackEntry);
+    if (indexEnd > m_uMappingSize)
+    {
+        return false;
+    }
+
+    // checked once here, so lookups can trust the offsets
+    for (unsigned int i = 0; i < slotCount; i++)
+    {
+        const ccAssetPackEntry *pEntry = &m_pSlots[i];
+        if (pEntry->nameLength == 0)
+        {
+            continue;
+        }
+        if ((unsigned long long)pEntry->nameOffset + pEntry->nameLength > m_uMappingSize
+            || (unsigned long long)pEntry->dataOffset + pEntry->storedSize > m_uMappingSize)
+        {
+            return false;
+        }
+        if (! (pEntry->flags & kCCAssetPackFlagDeflated) && pEntry->storedSize != pEntry->originalSize)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+unsigned int CCAssetPack::getEntryCount() const
+{
+    return m_pHeader ? m_pHeader->entryCount : 0;
+}
+
+const ccAssetPackEntry* CCAssetPack::findEntry(const char *pszEntry) const
+{
+    if (! m_pHeader || ! pszEntry)
+    {
+        return NULL;
+    }
+
+    unsigned int length = (unsigned int)strlen(pszEntry);
+    unsigned int hash = ccAssetPackHash(pszEntry, length);
+    unsigned int mask = m_pHeader->slotCount - 1;
+
+    for (unsigned int i = 0; i <= mask; i++)
+    {
+        const ccAssetPackEntry *pEntry = &m_pSlots[(hash + i) & mask];
+        if (pEntry->nameLength == 0)
+        {
+            return NULL;
+        }
+        if (pEntry->hash == hash && pEntry->nameLength == length
+            && memcmp(m_pMapping + pEntry->nameOffset, pszEntry, length) == 0)
+        {
+            return pEntry;
+        }
+    }
+    return NULL;
+}
+
+bool CCAssetPack::fileExists(const char *pszEntry) const
+{
+    return findEntry(pszEntry) != NULL;
+}
+
+const unsigned char* CCAssetPack::getFileView(const char *pszEntry, unsigned long *pSize) const
+{
+    CCAssert(pSize != NULL, "Invalid parameters.");
+    *pSize = 0;
+
+    const ccAssetPackEntry *pEntry = findEntry(pszEntry);
+    if (! pEntry || (pEntry->flags & kCCAssetPackFlagDeflated))
+    {
+        return NULL;
+    }
+
+    *pSize = pEntry->originalSize;
+    return m_pMapping + pEntry->dataOffset;
+}
+
+unsigned char* CCAssetPack::getFileData(const char *pszEntry, unsigned long *pSize) const
+{
+    CCAssert(pSize != NULL, "Invalid parameters.");
+    *pSize = 0;
+
+    const ccAssetPackEntry *pEntry = findEntry(pszEntry);
+    if (! pEntry)
+    {
+        return NULL;
+    }
+
+    unsigned char *pBuffer = new unsigned char[pEntry->originalSize];
+    if (pEntry->flags & kCCAssetPackFlagDeflated)
+    {
+        // the original size is known, inflate straight into the final buffer
+        ZipInflateStream inflater;
+        if (! inflater.begin(pBuffer, pEntry->originalSize)
+            || ! inflater.feed(m_pMapping + pEntry->dataOffset, pEntry->storedSize)
+            || ! inflater.isFinished() || inflater.getOutLength() != pEntry->originalSize)
+        {
+            CCLOG("cocos2d: CCAssetPack: can't inflate %s", pszEntry);
+            delete [] pBuffer;
+            return NULL;
+        }
+    }
+    else
+    {
+        memcpy(pBuffer, m_pMapping + pEntry->dataOffset, pEntry->originalSize);
+    }
+
+    *pSize = pEntry->originalSize;
+    return pBuffer;
+}
+
+NS_CC_END
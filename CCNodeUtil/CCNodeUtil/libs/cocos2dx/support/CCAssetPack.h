@@ -0,0 +1,105 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CCASSETPACK_H__
+#define __CCASSETPACK_H__
+
+#include "cocoa/CCObject.h"
+#include <string>
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup platform
+ * @{
+ */
+
+struct _ccAssetPackHeader;
+struct _ccAssetPackEntry;
+
+/** @brief A read-only archive of resources, memory mapped as a whole.
+
+ The pack is built off-line (see tools/ccpack.py). All integers are little endian:
+
+ - a 32 bytes header: "CCPK", version (1), slot count (a power of two), entry count and 16 reserved bytes.
+ - the index: one 32 bytes slot per slot count, each holding the FNV-1a hash of the entry's path,
+   the offset and length of the path, flags, the offset, stored and original size of the data and 4 reserved bytes.
+   Entries are found by linear probing from hash & (slot count - 1); a slot with an empty path ends the probe.
+ - the paths, then the data of every entry, each starting on a 4096 bytes boundary.
+
+ An entry is either stored as is and can be read in place, or deflated with zlib (flag 1).
+ Paths are relative to the resources root and use '/' as separator.
+ @since v2.1.x
+ */
+class CC_DLL CCAssetPack : public CCObject
+{
+public:
+    CCAssetPack();
+    virtual ~CCAssetPack();
+
+    /** Maps the pack at the given full path.
+     Returns NULL if the file can't be mapped or isn't a valid pack.
+     */
+    static CCAssetPack* create(const char *pszPath);
+
+    /** Maps the pack at the given full path. */
+    bool initWithFile(const char *pszPath);
+
+    /** the full path the pack was mapped from */
+    inline const std::string& getPath() const { return m_sPath; }
+
+    /** number of entries in the pack */
+    unsigned int getEntryCount() const;
+
+    /** returns true if the pack holds the given path */
+    bool fileExists(const char *pszEntry) const;
+
+    /** Returns the data of a stored entry in place, without any copy.
+     The pointer stays valid as long as the pack is alive.
+     Returns NULL if the entry doesn't exist or is compressed.
+     */
+    const unsigned char* getFileView(const char *pszEntry, unsigned long *pSize) const;
+
+    /** Returns a copy of the entry's data, inflated if needed.
+     @warning Recall: you are responsible for calling delete[] on any Non-NULL pointer returned.
+     */
+    unsigned char* getFileData(const char *pszEntry, unsigned long *pSize) const;
+
+private:
+    const _ccAssetPackEntry* findEntry(const char *pszEntry) const;
+    bool validate();
+
+    std::string m_sPath;
+    unsigned char *m_pMapping;
+    unsigned long m_uMappingSize;
+    const _ccAssetPackHeader *m_pHeader;
+    const _ccAssetPackEntry *m_pSlots;
+};
+
+// end of platform group
+/// @}
+
+NS_CC_END
+
+#endif // __CCASSETPACK_H__
@@ -0,0 +1,547 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "CCJobSystem.h"
+#include "ccMacros.h"
+#include "platform/CCThread.h"
+#include <deque>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+using namespace std;
+
+NS_CC_BEGIN
+
+// data structures
+
+// An entry of a worker queue: either a scheduled job or one range of a parallelFor call
+typedef struct _ccJobTask
+{
+    CCJob                   *job;           // NULL for parallelFor ranges
+    CC_PARALLEL_FOR_FUNC    func;
+    unsigned int            begin;
+    unsigned int            end;
+    void                    *userData;
+    volatile int            *remaining;     // ranges left in the owning parallelFor call
+} tCCJobTask;
+
+typedef struct _ccJobWorker
+{
+    pthread_t               thread;
+    pthread_mutex_t         mutex;          // guards tasks
+    std::deque<tCCJobTask>  tasks;          // the owner pops from the back, thieves from the front
+    unsigned int            index;
+} tCCJobWorker;
+
+static CCJobSystem *s_pSharedJobSystem = NULL;
+
+static tCCJobWorker *s_pWorkers = NULL;
+static unsigned int s_uWorkerCount = 0;
+static unsigned int s_uNextWorker = 0;
+
+static pthread_key_t s_workerKey;
+
+// workers sleep on s_wakeCondition while s_nQueuedTasks is 0
+static pthread_mutex_t s_sleepMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_wakeCondition = PTHREAD_COND_INITIALIZER;
+static volatile int s_nQueuedTasks = 0;
+static volatile bool s_bNeedQuit = false;
+
+// guards CCJob::m_dependents, m_uPendingDependencies and m_bScheduled
+static pthread_mutex_t s_dependencyMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// jobs whose execute() returned, waiting for onComplete() on the main thread
+static pthread_mutex_t s_completedMutex = PTHREAD_MUTEX_INITIALIZER;
+static std::vector<CCJob*> s_completedJobs;
+
+static tCCJobWorker* currentWorker()
+{
+    if (s_pWorkers == NULL)
+    {
+        return NULL;
+    }
+    return (tCCJobWorker*)pthread_getspecific(s_workerKey);
+}
+
+static void pushTask(tCCJobWorker *pWorker, const tCCJobTask& task)
+{
+    pthread_mutex_lock(&pWorker->mutex);
+    pWorker->tasks.push_back(task);
+    pthread_mutex_unlock(&pWorker->mutex);
+
+    __sync_add_and_fetch(&s_nQueuedTasks, 1);
+
+    pthread_mutex_lock(&s_sleepMutex);
+    pthread_cond_signal(&s_wakeCondition);
+    pthread_mutex_unlock(&s_sleepMutex);
+}
+
+static tCCJobWorker* pickWorker()
+{
+    // tasks spawned by a worker stay local, the others are spread round robin
+    tCCJobWorker *pWorker = currentWorker();
+    if (pWorker == NULL)
+    {
+        pWorker = &s_pWorkers[__sync_fetch_and_add(&s_uNextWorker, 1) % s_uWorkerCount];
+    }
+    return pWorker;
+}
+
+static bool popTask(tCCJobWorker *pSelf, tCCJobTask& task)
+{
+    if (s_nQueuedTasks <= 0)
+    {
+        return false;
+    }
+
+    if (pSelf)
+    {
+        pthread_mutex_lock(&pSelf->mutex);
+        if (! pSelf->tasks.empty())
+        {
+            task = pSelf->tasks.back();
+            pSelf->tasks.pop_back();
+            pthread_mutex_unlock(&pSelf->mutex);
+            __sync_sub_and_fetch(&s_nQueuedTasks, 1);
+            return true;
+        }
+        pthread_mutex_unlock(&pSelf->mutex);
+    }
+
+    // steal the oldest task of somebody else
+    unsigned int uStart = pSelf ? pSelf->index + 1 : 0;
+    for (unsigned int i = 0; i < s_uWorkerCount; ++i)
+    {
+        tCCJobWorker *pVictim = &s_pWorkers[(uStart + i) % s_uWorkerCount];
+        if (pVictim == pSelf)
+        {
+            continue;
+        }
+
+        pthread_mutex_lock(&pVictim->mutex);
+        if (! pVictim->tasks.empty())
+        {
+            task = pVictim->tasks.front();
+            pVictim->tasks.pop_front();
+            pthread_mutex_unlock(&pVictim->mutex);
+            __sync_sub_and_fetch(&s_nQueuedTasks, 1);
+            return true;
+        }
+        pthread_mutex_unlock(&pVictim->mutex);
+    }
+
+    return false;
+}
+
+// removes a queued range of the parallelFor call whose counter is pRemaining, wherever it is queued
+static bool popRangeTask(volatile int *pRemaining, tCCJobTask& task)
+{
+    if (s_nQueuedTasks <= 0)
+    {
+        return false;
+    }
+
+    for (unsigned int i = 0; i < s_uWorkerCount; ++i)
+    {
+        tCCJobWorker *pWorker = &s_pWorkers[i];
+        std::deque<tCCJobTask>& tasks = pWorker->tasks;
+
+        pthread_mutex_lock(&pWorker->mutex);
+        // the ranges were pushed last, look from the back
+        for (size_t j = tasks.size(); j-- > 0; )
+        {
+            if (tasks[j].remaining == pRemaining)
+            {
+                task = tasks[j];
+                tasks.erase(tasks.begin() + j);
+                pthread_mutex_unlock(&pWorker->mutex);
+                __sync_sub_and_fetch(&s_nQueuedTasks, 1);
+                return true;
+            }
+        }
+        pthread_mutex_unlock(&pWorker->mutex);
+    }
+
+    return false;
+}
+
+// releases the dependents of a job which will never run, and theirs in turn
+void CCJobSystem::dropDependents(CCJob *pJob)
+{
+    std::vector<CCJob*> dependents;
+    dependents.swap(pJob->m_dependents);
+
+    for (std::vector<CCJob*>::iterator it = dependents.begin(); it != dependents.end(); ++it)
+    {
+        CCJob *pDependent = *it;
+        if (pDependent->m_bScheduled)
+        {
+            // still waiting for pJob, so never queued: drop the reference taken by scheduleJob() too
+            pDependent->m_bScheduled = false;
+            dropDependents(pDependent);
+            pDependent->release();
+        }
+        pDependent->release();
+    }
+}
+
+// Must be called without s_dependencyMutex held, the job runs right away when there is no worker
+void CCJobSystem::enqueueJob(CCJob *pJob)
+{
+    tCCJobTask task;
+    task.job = pJob;
+    task.func = NULL;
+    task.begin = task.end = 0;
+    task.userData = NULL;
+    task.remaining = NULL;
+
+    if (s_pWorkers == NULL)
+    {
+        runTask(task);
+        return;
+    }
+
+    pushTask(pickWorker(), task);
+}
+
+void CCJobSystem::finishJob(CCJob *pJob)
+{
+    std::vector<CCJob*> ready;
+
+    pthread_mutex_lock(&s_dependencyMutex);
+    pJob->m_bFinished = true;
+    for (std::vector<CCJob*>::iterator it = pJob->m_dependents.begin(); it != pJob->m_dependents.end(); ++it)
+    {
+        CCJob *pDependent = *it;
+        if (--pDependent->m_uPendingDependencies == 0 && pDependent->m_bScheduled)
+        {
+            ready.push_back(pDependent);
+        }
+    }
+    pthread_mutex_unlock(&s_dependencyMutex);
+
+    // queued before the job is completed, so the dependents are still retained by it
+    for (std::vector<CCJob*>::iterator it = ready.begin(); it != ready.end(); ++it)
+    {
+        enqueueJob(*it);
+    }
+
+    pthread_mutex_lock(&s_completedMutex);
+    s_completedJobs.push_back(pJob);
+    pthread_mutex_unlock(&s_completedMutex);
+}
+
+void CCJobSystem::runTask(const tCCJobTask& task)
+{
+    // create autorelease pool for iOS, drained once the task is done
+    CCThread thread;
+    thread.createAutoreleasePool();
+
+    if (task.job)
+    {
+        task.job->execute();
+        finishJob(task.job);
+    }
+    else
+    {
+        task.func(task.begin, task.end, task.userData);
+        __sync_sub_and_fetch(task.remaining, 1);
+    }
+}
+
+void* CCJobSystem::workerLoop(void *data)
+{
+    tCCJobWorker *pSelf = (tCCJobWorker*)data;
+    pthread_setspecific(s_workerKey, pSelf);
+
+    while (true)
+    {
+        tCCJobTask task;
+        if (popTask(pSelf, task))
+        {
+            runTask(task);
+            continue;
+        }
+
+        pthread_mutex_lock(&s_sleepMutex);
+        while (s_nQueuedTasks <= 0 && !s_bNeedQuit)
+        {
+            pthread_cond_wait(&s_wakeCondition, &s_sleepMutex);
+        }
+        bool bQuit = s_bNeedQuit;
+        pthread_mutex_unlock(&s_sleepMutex);
+
+        if (bQuit)
+        {
+            break;
+        }
+    }
+
+    return 0;
+}
+
+// implementation CCJob
+
+CCJob::CCJob()
+: m_uPendingDependencies(0)
+, m_bFinished(false)
+, m_bScheduled(false)
+{
+}
+
+CCJob::~CCJob()
+{
+}
+
+void CCJob::addDependency(CCJob *pJob)
+{
+    CCAssert(pJob != NULL && pJob != this, "Invalid dependency");
+    CCAssert(! m_bScheduled, "Dependencies must be added before the job is scheduled");
+
+    pthread_mutex_lock(&s_dependencyMutex);
+    if (! pJob->m_bFinished)
+    {
+        this->retain();
+        pJob->m_dependents.push_back(this);
+        ++m_uPendingDependencies;
+    }
+    pthread_mutex_unlock(&s_dependencyMutex);
+}
+
+// implementation CCJobSystem
+
+CCJobSystem* CCJobSystem::sharedJobSystem()
+{
+    if (! s_pSharedJobSystem)
+    {
+        s_pSharedJobSystem = new CCJobSystem();
+    }
+    return s_pSharedJobSystem;
+}
+
+void CCJobSystem::purgeSharedJobSystem()
+{
+    CC_SAFE_RELEASE_NULL(s_pSharedJobSystem);
+}
+
+CCJobSystem::CCJobSystem()
+: m_uWorkerCount(0)
+{
+    CCAssert(s_pSharedJobSystem == NULL, "Attempted to allocate a second instance of a singleton.");
+
+    long nCores = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned int uWorkers = nCores > 1 ? (unsigned int)(nCores - 1) : 1;
+    m_uWorkerCount = MIN(uWorkers, (unsigned int)CC_JOB_SYSTEM_MAX_WORKERS);
+
+    if (m_uWorkerCount == 0)
+    {
+        return;
+    }
+
+    s_bNeedQuit = false;
+    s_nQueuedTasks = 0;
+    s_uNextWorker = 0;
+    s_uWorkerCount = m_uWorkerCount;
+    pthread_key_create(&s_workerKey, NULL);
+
+    s_pWorkers = new tCCJobWorker[m_uWorkerCount];
+    for (unsigned int i = 0; i < m_uWorkerCount; ++i)
+    {
+        s_pWorkers[i].index = i;
+        pthread_mutex_init(&s_pWorkers[i].mutex, NULL);
+    }
+    for (unsigned int i = 0; i < m_uWorkerCount; ++i)
+    {
+        pthread_create(&s_pWorkers[i].thread, NULL, workerLoop, &s_pWorkers[i]);
+    }
+
+    CCLOG("cocos2d: CCJobSystem started %u worker threads", m_uWorkerCount);
+}
+
+CCJobSystem::~CCJobSystem()
+{
+    CCLOGINFO("cocos2d: deallocing CCJobSystem.");
+
+    if (s_pWorkers)
+    {
+        pthread_mutex_lock(&s_sleepMutex);
+        s_bNeedQuit = true;
+        pthread_cond_broadcast(&s_wakeCondition);
+        pthread_mutex_unlock(&s_sleepMutex);
+
+        for (unsigned int i = 0; i < m_uWorkerCount; ++i)
+        {
+            pthread_join(s_pWorkers[i].thread, NULL);
+        }
+
+        // jobs that never ran are dropped together with the jobs waiting for them
+        for (unsigned int i = 0; i < m_uWorkerCount; ++i)
+        {
+            std::deque<tCCJobTask>& tasks = s_pWorkers[i].tasks;
+            for (std::deque<tCCJobTask>::iterator it = tasks.begin(); it != tasks.end(); ++it)
+            {
+                if (it->job)
+                {
+                    dropDependents(it->job);
+                    it->job->release();
+                }
+            }
+            pthread_mutex_destroy(&s_pWorkers[i].mutex);
+        }
+
+        CC_SAFE_DELETE_ARRAY(s_pWorkers);
+        s_uWorkerCount = 0;
+        pthread_key_delete(s_workerKey);
+    }
+
+    // finished jobs are released without calling onComplete(), the scene is being torn down
+    pthread_mutex_lock(&s_completedMutex);
+    std::vector<CCJob*> completed;
+    completed.swap(s_completedJobs);
+    pthread_mutex_unlock(&s_completedMutex);
+
+    for (std::vector<CCJob*>::iterator it = completed.begin(); it != completed.end(); ++it)
+    {
+        for (unsigned int j = 0; j < (*it)->m_dependents.size(); ++j)
+        {
+            (*it)->m_dependents[j]->release();
+        }
+        (*it)->m_dependents.clear();
+        (*it)->release();
+    }
+}
+
+void CCJobSystem::dispatchCompletedJobs()
+{
+    if (s_pSharedJobSystem == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&s_completedMutex);
+    if (s_completedJobs.empty())
+    {
+        pthread_mutex_unlock(&s_completedMutex);
+        return;
+    }
+    std::vector<CCJob*> completed;
+    completed.swap(s_completedJobs);
+    pthread_mutex_unlock(&s_completedMutex);
+
+    for (std::vector<CCJob*>::iterator it = completed.begin(); it != completed.end(); ++it)
+    {
+        CCJob *pJob = *it;
+        pJob->onComplete();
+
+        // dependents are queued by now (or already done), the job no longer needs to keep them alive
+        pthread_mutex_lock(&s_dependencyMutex);
+        std::vector<CCJob*> dependents;
+        dependents.swap(pJob->m_dependents);
+        pthread_mutex_unlock(&s_dependencyMutex);
+
+        for (std::vector<CCJob*>::iterator dep = dependents.begin(); dep != dependents.end(); ++dep)
+        {
+            (*dep)->release();
+        }
+        pJob->release();
+    }
+}
+
+void CCJobSystem::scheduleJob(CCJob *pJob)
+{
+    CCAssert(pJob != NULL, "Invalid job");
+    CCAssert(! pJob->m_bScheduled, "Job already scheduled");
+
+    pJob->retain();
+
+    // otherwise the last dependency to finish queues it
+    pthread_mutex_lock(&s_dependencyMutex);
+    pJob->m_bScheduled = true;
+    bool bReady = (pJob->m_uPendingDependencies == 0);
+    pthread_mutex_unlock(&s_dependencyMutex);
+
+    if (bReady)
+    {
+        enqueueJob(pJob);
+    }
+}
+
+void CCJobSystem::parallelFor(unsigned int uCount, unsigned int uGrainSize, CC_PARALLEL_FOR_FUNC pfnFunc, void *pUserData)
+{
+    CCAssert(pfnFunc != NULL, "Invalid function");
+
+    if (uCount == 0)
+    {
+        return;
+    }
+    if (uGrainSize == 0)
+    {
+        uGrainSize = 1;
+    }
+
+    if (m_uWorkerCount == 0 || uCount <= uGrainSize)
+    {
+        pfnFunc(0, uCount, pUserData);
+        return;
+    }
+
+    unsigned int uRanges = (uCount + uGrainSize - 1) / uGrainSize;
+    volatile int nRemaining = (int)uRanges;
+
+    // the caller keeps the first range for itself
+    for (unsigned int i = 1; i < uRanges; ++i)
+    {
+        tCCJobTask task;
+        task.job = NULL;
+        task.func = pfnFunc;
+        task.begin = i * uGrainSize;
+        task.end = MIN(uCount, task.begin + uGrainSize);
+        task.userData = pUserData;
+        task.remaining = &nRemaining;
+
+        pushTask(pickWorker(), task);
+    }
+
+    pfnFunc(0, MIN(uCount, uGrainSize), pUserData);
+    __sync_sub_and_fetch(&nRemaining, 1);
+
+    // Help out until every range is done, with the ranges of this call only: any other task
+    // could keep the caller, which may be the main thread, busy for much longer, and jobs
+    // must run on the workers.
+    while (nRemaining > 0)
+    {
+        tCCJobTask task;
+        if (popRangeTask(&nRemaining, task))
+        {
+            runTask(task);
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+}
+
+NS_CC_END
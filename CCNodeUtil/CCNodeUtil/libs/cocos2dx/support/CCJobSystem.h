@@ -0,0 +1,136 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CCJOBSYSTEM_H__
+#define __CCJOBSYSTEM_H__
+
+#include "cocoa/CCObject.h"
+#include <vector>
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup global
+ * @{
+ */
+
+/** Function called by CCJobSystem::parallelFor for every range [uBegin, uEnd). */
+typedef void (*CC_PARALLEL_FOR_FUNC)(unsigned int uBegin, unsigned int uEnd, void *pUserData);
+
+struct _ccJobTask;
+
+/** @brief A unit of work run by CCJobSystem.
+
+ Subclass it and override execute(), which is called on a worker thread, and
+ optionally onComplete(), which is called on the main thread by CCScheduler
+ once execute() has returned. execute() must not touch CCNodes nor retain or
+ release CCObjects; hand the results to onComplete() instead.
+ @since v2.1.x
+ */
+class CC_DLL CCJob : public CCObject
+{
+public:
+    CCJob();
+    virtual ~CCJob();
+
+    /** the work itself, called on a worker thread */
+    virtual void execute() = 0;
+
+    /** called on the main thread after execute() has returned */
+    virtual void onComplete() {}
+
+    /** The job won't be executed before pJob has finished.
+     Must be called from the main thread, before the job is scheduled.
+     */
+    void addDependency(CCJob *pJob);
+
+    /** returns true once execute() has returned */
+    inline bool isFinished() const { return m_bFinished; }
+
+private:
+    friend class CCJobSystem;
+
+    // jobs waiting for this one, retained until this job is completed on the main thread
+    std::vector<CCJob*> m_dependents;
+    unsigned int m_uPendingDependencies;
+    volatile bool m_bFinished;
+    bool m_bScheduled;
+};
+
+/** @brief Work-stealing job system.
+
+ Owns one worker thread per additional CPU core (up to CC_JOB_SYSTEM_MAX_WORKERS).
+ Every worker has its own task queue and steals from the others when it runs dry.
+ Finished jobs are handed back to the main thread through a completion queue
+ which CCScheduler drains at the beginning of every frame, so onComplete() may
+ safely modify the scene graph.
+ @since v2.1.x
+ */
+class CC_DLL CCJobSystem : public CCObject
+{
+public:
+    CCJobSystem();
+    ~CCJobSystem();
+
+    /** returns the shared job system, creating the worker threads on first use */
+    static CCJobSystem* sharedJobSystem();
+
+    /** stops the worker threads and releases the shared job system */
+    static void purgeSharedJobSystem();
+
+    /** Calls onComplete() on every job that finished since the last call.
+     You should NEVER call this method, unless you know what you are doing; CCScheduler calls it every frame.
+     It is a no-op if the shared job system was never created.
+     */
+    static void dispatchCompletedJobs();
+
+    /** Queues a job. The job is retained until its onComplete() has been called. Main thread only. */
+    void scheduleJob(CCJob *pJob);
+
+    /** Splits [0, uCount) into ranges of at most uGrainSize elements, runs pfnFunc on them in
+     parallel and returns once every range is done. While it waits, the calling thread runs
+     ranges of this call, never other tasks.
+     Safe to call from the main thread as well as from inside CCJob::execute().
+     */
+    void parallelFor(unsigned int uCount, unsigned int uGrainSize, CC_PARALLEL_FOR_FUNC pfnFunc, void *pUserData);
+
+    /** number of worker threads, 0 means every job runs inline on the calling thread */
+    inline unsigned int getWorkerCount() const { return m_uWorkerCount; }
+
+private:
+    static void* workerLoop(void *data);
+    static void runTask(const struct _ccJobTask& task);
+    static void enqueueJob(CCJob *pJob);
+    static void finishJob(CCJob *pJob);
+    static void dropDependents(CCJob *pJob);
+
+    unsigned int m_uWorkerCount;
+};
+
+// end of global group
+/// @}
+
+NS_CC_END
+
+#endif // __CCJOBSYSTEM_H__
@@ -25,25 +25,51 @@ THE SOFTWARE.
 #include "CCNotificationCenter.h"
 #include "cocoa/CCArray.h"
 #include "script_support/CCScriptSupport.h"
+#include "support/data_support/uthash.h"
+#include "CCDirector.h"
+#include "CCScheduler.h"
 #include <string>
 
 using namespace std;
 
 NS_CC_BEGIN
 
+// Observers of one notification name. The observer list is copy-on-write: a post retains
+// the array it walks, and adding or removing an observer while the array is retained
+// replaces it with a copy instead of changing it, so posting never copies it.
+typedef struct _hashNotificationEntry
+{
+    char            *name;
+    CCArray         *observers;
+    UT_hash_handle  hh;
+} tHashNotificationEntry;
+
 static CCNotificationCenter *s_sharedNotifCenter = NULL;
 
 CCNotificationCenter::CCNotificationCenter()
-: m_scriptHandler(0)
+: m_pObserversByName(NULL)
+, m_scriptHandler(0)
 {
-    m_observers = CCArray::createWithCapacity(3);
-    m_observers->retain();
 }
 
 CCNotificationCenter::~CCNotificationCenter()
 {
     unregisterScriptObserver();
-    m_observers->release();
+
+    for (unsigned int i = 0; i < m_deferredNotifications.size(); ++i)
+    {
+        CC_SAFE_RELEASE(m_deferredNotifications[i].second);
+    }
+
+    for (tHashNotificationEntry *pEntry = m_pObserversByName; pEntry != NULL; )
+    {
+        tHashNotificationEntry *pNext = (tHashNotificationEntry*)pEntry->hh.next;
+        HASH_DEL(m_pObserversByName, pEntry);
+        pEntry->observers->release();
+        free(pEntry->name);
+        free(pEntry);
+        pEntry = pNext;
+    }
 }
 
 CCNotificationCenter *CCNotificationCenter::sharedNotificationCenter(void)
@@ -57,22 +83,57 @@ CCNotificationCenter *CCNotificationCenter::sharedNotificationCenter(void)
 
 void CCNotificationCenter::purgeNotificationCenter(void)
 {
+    if (s_sharedNotifCenter && !s_sharedNotifCenter->m_deferredNotifications.empty())
+    {
+        // the scheduler retains the center while deferred notifications are pending
+        CCDirector::sharedDirector()->getScheduler()->unscheduleSelector(schedule_selector(CCNotificationCenter::postDeferredNotifications), s_sharedNotifCenter);
+    }
     CC_SAFE_RELEASE_NULL(s_sharedNotifCenter);
 }
 
 //
 // internal functions
 //
+tHashNotificationEntry* CCNotificationCenter::entryForName(const char *name, bool bCreate)
+{
+    tHashNotificationEntry *pEntry = NULL;
+    HASH_FIND_STR(m_pObserversByName, name, pEntry);
+    if (!pEntry && bCreate)
+    {
+        pEntry = (tHashNotificationEntry*)calloc(1, sizeof(*pEntry));
+        pEntry->name = strdup(name);
+        pEntry->observers = new CCArray();
+        pEntry->observers->init();
+        HASH_ADD_KEYPTR(hh, m_pObserversByName, pEntry->name, strlen(pEntry->name), pEntry);
+    }
+    return pEntry;
+}
+
+// Returns the observer list of pEntry, copied first if a post is walking it.
+static CCArray* mutableObservers(tHashNotificationEntry *pEntry)
+{
+    if (pEntry->observers->retainCount() > 1)
+    {
+        CCArray *pCopy = new CCArray();
+        pCopy->initWithCapacity(pEntry->observers->count() + 1);
+        pCopy->addObjectsFromArray(pEntry->observers);
+        pEntry->observers->release();
+        pEntry->observers = pCopy;
+    }
+    return pEntry->observers;
+}
+
 bool CCNotificationCenter::observerExisted(CCObject *target,const char *name)
 {
+    tHashNotificationEntry *pEntry = entryForName(name, false);
+    if (!pEntry)
+        return false;
+
     CCObject* obj = NULL;
-    CCARRAY_FOREACH(m_observers, obj)
+    CCARRAY_FOREACH(pEntry->observers, obj)
     {
         CCNotificationObserver* observer = (CCNotificationObserver*) obj;
-        if (!observer)
-            continue;
-        
-        if (!strcmp(observer->getName(),name) && observer->getTarget() == target)
+        if (observer->getTarget() == target)
             return true;
     }
     return false;
@@ -94,21 +155,22 @@ void CCNotificationCenter::addObserver(CCObject *target,
         return;
     
     observer->autorelease();
-    m_observers->addObject(observer);
+    mutableObservers(entryForName(name, true))->addObject(observer);
 }
 
 void CCNotificationCenter::removeObserver(CCObject *target,const char *name)
 {
+    tHashNotificationEntry *pEntry = entryForName(name, false);
+    if (!pEntry)
+        return;
+
     CCObject* obj = NULL;
-    CCARRAY_FOREACH(m_observers, obj)
+    CCARRAY_FOREACH(pEntry->observers, obj)
     {
         CCNotificationObserver* observer = (CCNotificationObserver*) obj;
-        if (!observer)
-            continue;
-        
-        if (!strcmp(observer->getName(),name) && observer->getTarget() == target)
+        if (observer->getTarget() == target)
         {
-            m_observers->removeObject(observer);
+            mutableObservers(pEntry)->removeObject(observer);
             return;
         }
     }
@@ -131,17 +193,22 @@ void CCNotificationCenter::unregisterScriptObserver(void)
 
 void CCNotificationCenter::postNotification(const char *name, CCObject *object)
 {
-    CCArray* ObserversCopy = CCArray::createWithCapacity(m_observers->count());
-    ObserversCopy->addObjectsFromArray(m_observers);
-    CCObject* obj = NULL;
-    CCARRAY_FOREACH(ObserversCopy, obj)
+    tHashNotificationEntry *pEntry = entryForName(name, false);
+    if (pEntry)
     {
-        CCNotificationObserver* observer = (CCNotificationObserver*) obj;
-        if (!observer)
-            continue;
-        
-        if (!strcmp(name,observer->getName()) && (observer->getObject() == object || observer->getObject() == NULL || object == NULL))
-            observer->performSelector(object);
+        // observers added or removed by the callbacks don't change the list being walked
+        CCArray *pObservers = pEntry->observers;
+        pObservers->retain();
+
+        CCObject* obj = NULL;
+        CCARRAY_FOREACH(pObservers, obj)
+        {
+            CCNotificationObserver* observer = (CCNotificationObserver*) obj;
+            if (observer->getObject() == object || observer->getObject() == NULL || object == NULL)
+                observer->performSelector(object);
+        }
+
+        pObservers->release();
     }
 
     if (m_scriptHandler)
@@ -156,6 +223,47 @@ void CCNotificationCenter::postNotification(const char *name)
     this->postNotification(name,NULL);
 }
 
+void CCNotificationCenter::postNotificationDeferred(const char *name, CCObject *object)
+{
+    tHashNotificationEntry *pEntry = entryForName(name, true);
+
+    // coalesce with the same notification posted earlier in this frame
+    for (unsigned int i = 0; i < m_deferredNotifications.size(); ++i)
+    {
+        if (m_deferredNotifications[i].first == pEntry && m_deferredNotifications[i].second == object)
+            return;
+    }
+
+    if (m_deferredNotifications.empty())
+    {
+        CCDirector::sharedDirector()->getScheduler()->scheduleSelector(schedule_selector(CCNotificationCenter::postDeferredNotifications), this, 0, false);
+    }
+
+    CC_SAFE_RETAIN(object);
+    m_deferredNotifications.push_back(std::make_pair(pEntry, object));
+}
+
+void CCNotificationCenter::postNotificationDeferred(const char *name)
+{
+    this->postNotificationDeferred(name, NULL);
+}
+
+void CCNotificationCenter::postDeferredNotifications(float dt)
+{
+    CC_UNUSED_PARAM(dt);
+
+    // notifications deferred by the observers are posted next frame
+    std::vector<std::pair<tHashNotificationEntry*, CCObject*> > notifications;
+    notifications.swap(m_deferredNotifications);
+    CCDirector::sharedDirector()->getScheduler()->unscheduleSelector(schedule_selector(CCNotificationCenter::postDeferredNotifications), this);
+
+    for (unsigned int i = 0; i < notifications.size(); ++i)
+    {
+        this->postNotification(notifications[i].first->name, notifications[i].second);
+        CC_SAFE_RELEASE(notifications[i].second);
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 ///
 /// CCNotificationObserver
@@ -27,9 +27,12 @@ THE SOFTWARE.
 
 #include "cocoa/CCObject.h"
 #include "cocoa/CCArray.h"
+#include <vector>
 
 NS_CC_BEGIN
 
+struct _hashNotificationEntry;
+
 class CC_DLL CCNotificationCenter : public CCObject
 {
 public:
@@ -81,6 +84,21 @@ public:
      *  @param object The extra parameter.
      */
     void postNotification(const char *name, CCObject *object);
+
+    /** @brief Posts one notification event by name at the beginning of the next frame.
+     *  Posting the same name again before that is a no-op, so the observers are called once per frame.
+     *  @param name The name of this notification.
+     *  @since v2.1.x
+     */
+    void postNotificationDeferred(const char *name);
+
+    /** @brief Posts one notification event by name at the beginning of the next frame.
+     *  Posting the same name and object again before that is a no-op.
+     *  @param name The name of this notification.
+     *  @param object The extra parameter, retained until the notification is posted.
+     *  @since v2.1.x
+     */
+    void postNotificationDeferred(const char *name, CCObject *object);
     
     /** @brief Gets script handler.
      *  @note Only supports Lua Binding now.
@@ -92,10 +110,17 @@ private:
 
     // Check whether the observer exists by the specified target and name.
     bool observerExisted(CCObject *target,const char *name);
+
+    // Returns the observers of the notification name, creating the entry if bCreate is true.
+    struct _hashNotificationEntry* entryForName(const char *name, bool bCreate);
+
+    // Posts the notifications queued by postNotificationDeferred(), scheduled while there are some.
+    void postDeferredNotifications(float dt);
     
     // variables
     //
-    CCArray *m_observers;
+    struct _hashNotificationEntry *m_pObserversByName;
+    std::vector<std::pair<struct _hashNotificationEntry*, CCObject*> > m_deferredNotifications;
     int     m_scriptHandler;
 };
 
@@ -0,0 +1,158 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "CCUploadScheduler.h"
+#include "ccMacros.h"
+#include "platform/platform.h"
+#include <algorithm>
+
+NS_CC_BEGIN
+
+static CCUploadScheduler *s_pSharedUploadScheduler = NULL;
+
+CCUploadScheduler* CCUploadScheduler::sharedUploadScheduler()
+{
+    if (! s_pSharedUploadScheduler)
+    {
+        s_pSharedUploadScheduler = new CCUploadScheduler();
+    }
+    return s_pSharedUploadScheduler;
+}
+
+void CCUploadScheduler::purgeSharedUploadScheduler()
+{
+    CC_SAFE_RELEASE_NULL(s_pSharedUploadScheduler);
+}
+
+CCUploadScheduler::CCUploadScheduler()
+: m_uFrameBytes(0)
+, m_uLastFrameBytes(0)
+, m_uFrameScheduledBytes(0)
+, m_uFrameByteBudget(CC_UPLOAD_SCHEDULER_FRAME_BYTES)
+, m_fFrameTimeBudget(CC_UPLOAD_SCHEDULER_FRAME_TIME)
+{
+    CCAssert(s_pSharedUploadScheduler == NULL, "Attempted to allocate a second instance of a singleton.");
+}
+
+CCUploadScheduler::~CCUploadScheduler()
+{
+    CCLOGINFO("cocos2d: deallocing CCUploadScheduler.");
+
+    for (std::deque<CCUploadTask*>::iterator it = m_pendingTasks.begin(); it != m_pendingTasks.end(); ++it)
+    {
+        (*it)->release();
+    }
+}
+
+void CCUploadScheduler::bufferData(GLenum target, GLsizeiptr size, const GLvoid *data, GLenum usage)
+{
+    glBufferData(target, size, data, usage);
+
+    // orphaning a buffer transfers nothing
+    if (data)
+    {
+        m_uFrameBytes += (unsigned int)size;
+    }
+}
+
+void CCUploadScheduler::bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid *data)
+{
+    glBufferSubData(target, offset, size, data);
+    m_uFrameBytes += (unsigned int)size;
+}
+
+void CCUploadScheduler::reportUpload(unsigned int uBytes)
+{
+    m_uFrameBytes += uBytes;
+}
+
+void CCUploadScheduler::scheduleUpload(CCUploadTask *pTask)
+{
+    CCAssert(pTask != NULL, "Invalid upload task");
+
+    pTask->retain();
+    m_pendingTasks.push_back(pTask);
+}
+
+void CCUploadScheduler::cancelUpload(CCUploadTask *pTask)
+{
+    std::deque<CCUploadTask*>::iterator it = std::find(m_pendingTasks.begin(), m_pendingTasks.end(), pTask);
+    if (it != m_pendingTasks.end())
+    {
+        m_pendingTasks.erase(it);
+        pTask->release();
+    }
+}
+
+void CCUploadScheduler::processUploads()
+{
+    // the immediate uploads of the last frame predict those of this one
+    unsigned int uImmediateBytes = m_uFrameBytes - m_uFrameScheduledBytes;
+    unsigned int uBudget = m_uFrameByteBudget > uImmediateBytes ? m_uFrameByteBudget - uImmediateBytes : 0;
+
+    m_uLastFrameBytes = m_uFrameBytes;
+    m_uFrameBytes = 0;
+    m_uFrameScheduledBytes = 0;
+
+    if (m_pendingTasks.empty())
+    {
+        return;
+    }
+
+    struct cc_timeval start;
+    CCTime::gettimeofdayCocos2d(&start, NULL);
+
+    unsigned int uPerformed = 0;
+    while (! m_pendingTasks.empty())
+    {
+        CCUploadTask *pTask = m_pendingTasks.front();
+
+        if (uPerformed > 0)
+        {
+            if (m_uFrameScheduledBytes + pTask->getUploadSize() > uBudget)
+            {
+                break;
+            }
+
+            struct cc_timeval now;
+            CCTime::gettimeofdayCocos2d(&now, NULL);
+            if (CCTime::timersubCocos2d(&start, &now) >= m_fFrameTimeBudget * 1000.0)
+            {
+                break;
+            }
+        }
+
+        m_pendingTasks.pop_front();
+
+        // the task may schedule or cancel other uploads, its bytes are counted as they are sent
+        unsigned int uFrameBytes = m_uFrameBytes;
+        pTask->upload();
+        m_uFrameScheduledBytes += m_uFrameBytes - uFrameBytes;
+        ++uPerformed;
+
+        pTask->release();
+    }
+}
+
+NS_CC_END
@@ -0,0 +1,135 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CCUPLOADSCHEDULER_H__
+#define __CCUPLOADSCHEDULER_H__
+
+#include "cocoa/CCObject.h"
+#include "CCGL.h"
+#include <deque>
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup global
+ * @{
+ */
+
+/** @brief A GPU upload which may be postponed to a later frame.
+
+ Subclass it and override upload(), which is called on the main thread with the GL context current.
+ @since v2.1.x
+ */
+class CC_DLL CCUploadTask : public CCObject
+{
+public:
+    CCUploadTask() {}
+    virtual ~CCUploadTask() {}
+
+    /** Performs the upload. The data must be sent with CCUploadScheduler::bufferData(), bufferSubData()
+     or counted with reportUpload(), as CCTexture2D does, to be deducted from the frame budget.
+     */
+    virtual void upload() = 0;
+
+    /** bytes the upload is expected to send, used to fit it in the frame budget */
+    virtual unsigned int getUploadSize() = 0;
+};
+
+/** @brief Singleton that meters the data sent to the GPU every frame.
+
+ Vertex buffer and texture uploads that are needed to draw the current frame go through
+ bufferData(), bufferSubData() or reportUpload(): they happen immediately and are counted.
+ Uploads that can wait, such as textures loaded by CCTextureCache::addImageAsync, are queued
+ with scheduleUpload() and performed by CCDirector at the beginning of each frame, as long as
+ the frame's byte and time budgets last. At least one queued upload is performed every frame.
+
+ The immediate uploads of the previous frame are deducted from the byte budget, so queued
+ uploads back off while the scene itself is streaming a lot of vertex data.
+ @since v2.1.x
+ */
+class CC_DLL CCUploadScheduler : public CCObject
+{
+public:
+    CCUploadScheduler();
+    ~CCUploadScheduler();
+
+    /** returns the shared upload scheduler */
+    static CCUploadScheduler* sharedUploadScheduler();
+
+    /** releases the shared upload scheduler, queued uploads are dropped */
+    static void purgeSharedUploadScheduler();
+
+    /** glBufferData, counted in the frame's upload bytes */
+    void bufferData(GLenum target, GLsizeiptr size, const GLvoid *data, GLenum usage);
+
+    /** glBufferSubData, counted in the frame's upload bytes */
+    void bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid *data);
+
+    /** counts an upload made directly with GL, e.g. glTexImage2D or a mapped buffer */
+    void reportUpload(unsigned int uBytes);
+
+    /** Queues an upload for one of the next frames. The task is retained until it has been performed or cancelled. */
+    void scheduleUpload(CCUploadTask *pTask);
+
+    /** removes a queued upload without performing it */
+    void cancelUpload(CCUploadTask *pTask);
+
+    /** Starts a new frame and performs queued uploads within the budgets.
+     You should NEVER call this method, unless you know what you are doing; CCDirector calls it every frame.
+     */
+    void processUploads();
+
+    /** bytes uploaded during the last complete frame */
+    inline unsigned int getUploadedBytesLastFrame() const { return m_uLastFrameBytes; }
+
+    /** bytes uploaded so far in the current frame */
+    inline unsigned int getUploadedBytes() const { return m_uFrameBytes; }
+
+    /** number of queued uploads */
+    inline unsigned int getPendingUploadCount() const { return (unsigned int)m_pendingTasks.size(); }
+
+    /** Bytes per frame that queued uploads may use. Defaults to CC_UPLOAD_SCHEDULER_FRAME_BYTES. */
+    inline void setFrameByteBudget(unsigned int uBytes) { m_uFrameByteBudget = uBytes; }
+    inline unsigned int getFrameByteBudget() const { return m_uFrameByteBudget; }
+
+    /** Seconds per frame that queued uploads may use. Defaults to CC_UPLOAD_SCHEDULER_FRAME_TIME. */
+    inline void setFrameTimeBudget(float fSeconds) { m_fFrameTimeBudget = fSeconds; }
+    inline float getFrameTimeBudget() const { return m_fFrameTimeBudget; }
+
+private:
+    std::deque<CCUploadTask*> m_pendingTasks;
+    unsigned int m_uFrameBytes;
+    unsigned int m_uLastFrameBytes;
+    // bytes of the current frame which were uploaded by processUploads
+    unsigned int m_uFrameScheduledBytes;
+    unsigned int m_uFrameByteBudget;
+    float m_fFrameTimeBudget;
+};
+
+// end of global group
+/// @}
+
+NS_CC_END
+
+#endif // __CCUPLOADSCHEDULER_H__
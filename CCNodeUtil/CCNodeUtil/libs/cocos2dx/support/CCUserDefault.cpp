@@ -24,107 +24,468 @@ THE SOFTWARE.
 #include "CCUserDefault.h"
 #include "platform/CCCommon.h"
 #include "platform/CCFileUtils.h"
+#include "ccMacros.h"
+#include "support/data_support/uthash.h"
 #include <libxml/parser.h>
 #include <libxml/tree.h>
+#include <zlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <vector>
 
-// root name of xml
-#define USERDEFAULT_ROOT_NAME    "userDefaultRoot"
-
+// file of the former XML backend, migrated on first load
 #define XML_FILE_NAME "UserDefault.xml"
 
+#define BINARY_FILE_NAME "UserDefault.bin"
+
+/* The binary file is a header followed by a log of records. Each record sets one key,
+ * the last record of a key wins. Records are appended by flush(), and the log is
+ * compacted into a snapshot of the current values once it holds too many stale ones.
+ *
+ * header: u32 magic, u32 version
+ * record: u8 type, u16 key length, u32 value length, key, value, u32 crc32 of all of the above
+ * values: bool is one byte, integer is a little endian int32, double is its 8 bytes
+ */
+#define USERDEFAULT_MAGIC           0x44554343  // "CCUD"
+#define USERDEFAULT_VERSION         1
+#define USERDEFAULT_HEADER_SIZE     8
+#define USERDEFAULT_RECORD_OVERHEAD 11
+
+// the log is compacted when it holds more than twice as many records as keys, plus this
+#define USERDEFAULT_COMPACTION_SLACK 256
+
 using namespace std;
 
 NS_CC_BEGIN
 
-static xmlDocPtr g_sharedDoc = NULL;
+enum {
+    kCCUserDefaultTypeBool = 1,
+    kCCUserDefaultTypeInteger,
+    kCCUserDefaultTypeDouble,
+    kCCUserDefaultTypeString,
+};
+
+typedef struct _hashUserDefaultEntry
+{
+    std::string     key;
+    unsigned char   type;
+    bool            dirty;          // set since the last flush()
+    int             intValue;       // bool and integer values
+    double          doubleValue;
+    std::string     stringValue;
+    UT_hash_handle  hh;
+} tHashUserDefaultEntry;
+
+// A chunk of the binary file for the writer thread
+typedef struct _userDefaultWrite
+{
+    bool            replace;        // a snapshot replacing the file, or records to append
+    std::string     bytes;
+} tUserDefaultWrite;
+
+static tHashUserDefaultEntry *s_pEntries = NULL;
+static std::vector<tHashUserDefaultEntry*> s_dirtyEntries;
+static unsigned int s_uLogRecords = 0;      // records in the binary file, stale ones included
+static bool s_bNeedsCompaction = false;
+static std::string s_sBinaryFilePath;
+
+static pthread_t s_writerThread;
+static pthread_mutex_t s_writerMutex;
+static pthread_cond_t s_writerCondition;
+static std::vector<tUserDefaultWrite*> s_pendingWrites;
+static bool s_bWriterRunning = false;
+static bool s_bWriterQuit = false;
+static bool s_bWriteFailed = false;        // guarded by s_writerMutex while the writer runs
 
 /**
  * define the functions here because we don't want to
- * export xmlNodePtr and other types in "CCUserDefault.h"
+ * export the entry and file types in "CCUserDefault.h"
  */
 
-static xmlNodePtr getXMLNodeForKey(const char* pKey, xmlNodePtr *rootNode)
+static tHashUserDefaultEntry* getEntryForKey(const char* pKey, bool bCreate)
 {
-    xmlNodePtr curNode = NULL;
+    tHashUserDefaultEntry *pEntry = NULL;
 
     // check the key value
     if (! pKey)
     {
         return NULL;
     }
+    CCAssert(strlen(pKey) <= 0xffff, "CCUserDefault: the key is too long");
+
+    HASH_FIND(hh, s_pEntries, pKey, strlen(pKey), pEntry);
+    if (! pEntry && bCreate)
+    {
+        pEntry = new tHashUserDefaultEntry();
+        pEntry->key = pKey;
+        pEntry->type = 0;
+        pEntry->dirty = false;
+        pEntry->intValue = 0;
+        pEntry->doubleValue = 0;
+        HASH_ADD_KEYPTR(hh, s_pEntries, pEntry->key.c_str(), pEntry->key.length(), pEntry);
+    }
+
+    return pEntry;
+}
+
+static void markDirty(tHashUserDefaultEntry *pEntry)
+{
+    if (! pEntry->dirty)
+    {
+        pEntry->dirty = true;
+        s_dirtyEntries.push_back(pEntry);
+    }
+}
+
+// Formats the value the way the XML backend stored it, for the getters of another type than the value's
+static std::string getStringForEntry(const tHashUserDefaultEntry *pEntry)
+{
+    char tmp[50];
+
+    switch (pEntry->type)
+    {
+        case kCCUserDefaultTypeBool:
+            return pEntry->intValue ? "true" : "false";
+        case kCCUserDefaultTypeInteger:
+            sprintf(tmp, "%d", pEntry->intValue);
+            return tmp;
+        case kCCUserDefaultTypeDouble:
+            sprintf(tmp, "%f", pEntry->doubleValue);
+            return tmp;
+        default:
+            return pEntry->stringValue;
+    }
+}
+
+static inline void appendUInt16(std::string& bytes, unsigned int value)
+{
+    bytes += (char)(value & 0xff);
+    bytes += (char)((value >> 8) & 0xff);
+}
+
+static inline void appendUInt32(std::string& bytes, unsigned int value)
+{
+    appendUInt16(bytes, value & 0xffff);
+    appendUInt16(bytes, value >> 16);
+}
+
+static inline unsigned int readUInt16(const unsigned char *pBytes)
+{
+    return pBytes[0] | (pBytes[1] << 8);
+}
+
+static inline unsigned int readUInt32(const unsigned char *pBytes)
+{
+    return readUInt16(pBytes) | (readUInt16(pBytes + 2) << 16);
+}
+
+static void appendHeader(std::string& bytes)
+{
+    appendUInt32(bytes, USERDEFAULT_MAGIC);
+    appendUInt32(bytes, USERDEFAULT_VERSION);
+}
+
+static void appendRecord(std::string& bytes, const tHashUserDefaultEntry *pEntry)
+{
+    size_t start = bytes.size();
+    unsigned char value[8];
+    const void *pValue = value;
+    unsigned int valueLength = 0;
+
+    switch (pEntry->type)
+    {
+        case kCCUserDefaultTypeBool:
+            value[0] = pEntry->intValue ? 1 : 0;
+            valueLength = 1;
+            break;
+        case kCCUserDefaultTypeInteger:
+            for (int i = 0; i < 4; ++i)
+            {
+                value[i] = (unsigned char)((unsigned int)pEntry->intValue >> (i * 8));
+            }
+            valueLength = 4;
+            break;
+        case kCCUserDefaultTypeDouble:
+            memcpy(value, &pEntry->doubleValue, 8);
+            valueLength = 8;
+            break;
+        default:
+            pValue = pEntry->stringValue.data();
+            valueLength = pEntry->stringValue.length();
+            break;
+    }
+
+    bytes += (char)pEntry->type;
+    appendUInt16(bytes, pEntry->key.length());
+    appendUInt32(bytes, valueLength);
+    bytes.append(pEntry->key);
+    bytes.append((const char*)pValue, valueLength);
+
+    uLong crc = crc32(0L, (const Bytef*)bytes.data() + start, bytes.size() - start);
+    appendUInt32(bytes, (unsigned int)crc);
+}
+
+// Applies the records of the binary file, returns false if there is no valid file
+static bool loadBinaryFile(const std::string& path)
+{
+    FILE *fp = fopen(path.c_str(), "rb");
+    if (! fp)
+    {
+        return false;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (size < 0)
+    {
+        size = 0;
+    }
 
-    do 
+    std::vector<unsigned char> data(size > 0 ? size : 1);
+    size = fread(&data[0], 1, size, fp);
+    fclose(fp);
+
+    const unsigned char *pBytes = &data[0];
+    if (size < USERDEFAULT_HEADER_SIZE
+        || readUInt32(pBytes) != USERDEFAULT_MAGIC
+        || readUInt32(pBytes + 4) != USERDEFAULT_VERSION)
+    {
+        CCLOG("%s is not a valid user default file", path.c_str());
+        return false;
+    }
+
+    long pos = USERDEFAULT_HEADER_SIZE;
+    while (pos + USERDEFAULT_RECORD_OVERHEAD <= size)
     {
-        // get root node
-        *rootNode = xmlDocGetRootElement(g_sharedDoc);
-        if (NULL == *rootNode)
+        const unsigned char *pRecord = pBytes + pos;
+        unsigned char type = pRecord[0];
+        unsigned int keyLength = readUInt16(pRecord + 1);
+        unsigned int valueLength = readUInt32(pRecord + 3);
+        long recordSize = USERDEFAULT_RECORD_OVERHEAD + keyLength + valueLength;
+        if (valueLength > (unsigned long)size || pos + recordSize > size)
         {
-            CCLOG("read root node error");
             break;
         }
 
-        // find the node
-        curNode = (*rootNode)->xmlChildrenNode;
-        while (NULL != curNode)
+        long crcOffset = recordSize - 4;
+        if (readUInt32(pRecord + crcOffset) != (unsigned int)crc32(0L, pRecord, crcOffset))
         {
-            if (! xmlStrcmp(curNode->name, BAD_CAST pKey))
-            {
+            break;
+        }
+
+        std::string key((const char*)pRecord + 7, keyLength);
+        const unsigned char *pValue = pRecord + 7 + keyLength;
+        tHashUserDefaultEntry *pEntry = getEntryForKey(key.c_str(), true);
+        pEntry->type = type;
+        switch (type)
+        {
+            case kCCUserDefaultTypeBool:
+                pEntry->intValue = valueLength > 0 && pValue[0];
                 break;
-            }
+            case kCCUserDefaultTypeInteger:
+                pEntry->intValue = valueLength == 4 ? (int)readUInt32(pValue) : 0;
+                break;
+            case kCCUserDefaultTypeDouble:
+                pEntry->doubleValue = 0;
+                if (valueLength == 8)
+                {
+                    memcpy(&pEntry->doubleValue, pValue, 8);
+                }
+                break;
+            default:
+                pEntry->type = kCCUserDefaultTypeString;
+                pEntry->stringValue.assign((const char*)pValue, valueLength);
+                break;
+        }
+
+        ++s_uLogRecords;
+        pos += recordSize;
+    }
+
+    if (pos != size)
+    {
+        // a write was cut short, the records after it would never be read: rewrite the file
+        CCLOG("%s is truncated, keeping the first %ld bytes", path.c_str(), pos);
+        s_bNeedsCompaction = true;
+    }
+
+    return true;
+}
 
-            curNode = curNode->next;
+// Imports the keys of the XML backend, as strings since it didn't keep the types
+static void migrateXMLFile(const std::string& path)
+{
+    xmlDocPtr doc = xmlReadFile(path.c_str(), "utf-8", XML_PARSE_RECOVER);
+    if (! doc)
+    {
+        return;
+    }
+
+    xmlNodePtr rootNode = xmlDocGetRootElement(doc);
+    for (xmlNodePtr curNode = rootNode ? rootNode->xmlChildrenNode : NULL; curNode; curNode = curNode->next)
+    {
+        if (curNode->type != XML_ELEMENT_NODE)
+        {
+            continue;
         }
-    } while (0);
 
-    return curNode;
+        xmlChar *content = xmlNodeGetContent(curNode);
+        tHashUserDefaultEntry *pEntry = getEntryForKey((const char*)curNode->name, true);
+        pEntry->type = kCCUserDefaultTypeString;
+        pEntry->stringValue = content ? (const char*)content : "";
+        xmlFree(content);
+    }
+
+    xmlFreeDoc(doc);
 }
 
-static inline const char* getValueForKey(const char* pKey)
+static bool writeFileAtomically(const std::string& path, const std::string& bytes)
 {
-    const char* ret = NULL;
-    xmlNodePtr rootNode;
-    xmlNodePtr node = getXMLNodeForKey(pKey, &rootNode);
+    std::string tmpPath = path + ".tmp";
+    FILE *fp = fopen(tmpPath.c_str(), "wb");
+    if (! fp)
+    {
+        return false;
+    }
+
+    bool bRet = fwrite(bytes.data(), 1, bytes.size(), fp) == bytes.size();
+    bRet = (fflush(fp) == 0) && bRet;
+    fsync(fileno(fp));
+    fclose(fp);
 
-    // find the node
-    if (node)
+    // rename() replaces the file at once, readers see either the old file or the new one
+    if (! bRet || rename(tmpPath.c_str(), path.c_str()) != 0)
     {
-        ret = (const char*)xmlNodeGetContent(node);
+        remove(tmpPath.c_str());
+        return false;
     }
+    return true;
+}
 
-    return ret;
+static bool appendToFile(const std::string& path, const std::string& bytes)
+{
+    FILE *fp = fopen(path.c_str(), "ab");
+    if (! fp)
+    {
+        return false;
+    }
+
+    bool bRet = fwrite(bytes.data(), 1, bytes.size(), fp) == bytes.size();
+    bRet = (fflush(fp) == 0) && bRet;
+    fsync(fileno(fp));
+    fclose(fp);
+    return bRet;
 }
 
-static void setValueForKey(const char* pKey, const char* pValue)
+static void* writeUserDefault(void *data)
 {
-    xmlNodePtr rootNode;
-    xmlNodePtr node;
+    std::vector<tUserDefaultWrite*> writes;
 
-    // check the params
-    if (! pKey || ! pValue)
+    pthread_mutex_lock(&s_writerMutex);
+    while (true)
     {
-        return;
+        while (s_pendingWrites.empty() && ! s_bWriterQuit)
+        {
+            pthread_cond_wait(&s_writerCondition, &s_writerMutex);
+        }
+        if (s_pendingWrites.empty())
+        {
+            break;
+        }
+        writes.swap(s_pendingWrites);
+        pthread_mutex_unlock(&s_writerMutex);
+
+        // coalesce the flushes queued meanwhile: start from the last snapshot, if any,
+        // and write the records flushed after it at once
+        size_t first = 0;
+        for (size_t i = 0; i < writes.size(); ++i)
+        {
+            if (writes[i]->replace)
+            {
+                first = i;
+            }
+        }
+
+        std::string bytes;
+        for (size_t i = first; i < writes.size(); ++i)
+        {
+            bytes += writes[i]->bytes;
+        }
+
+        bool bWritten = writes[first]->replace
+            ? writeFileAtomically(s_sBinaryFilePath, bytes)
+            : appendToFile(s_sBinaryFilePath, bytes);
+
+        for (size_t i = 0; i < writes.size(); ++i)
+        {
+            delete writes[i];
+        }
+        writes.clear();
+
+        pthread_mutex_lock(&s_writerMutex);
+        if (! bWritten)
+        {
+            CCLOG("failed to write %s", s_sBinaryFilePath.c_str());
+            s_bWriteFailed = true;
+        }
     }
+    pthread_mutex_unlock(&s_writerMutex);
 
-    // find the node
-    node = getXMLNodeForKey(pKey, &rootNode);
+    return NULL;
+}
 
-    // if node exist, change the content
-    if (node)
+static void queueWrite(tUserDefaultWrite *pWrite)
+{
+    if (! s_bWriterRunning)
     {
-        xmlNodeSetContent(node, BAD_CAST pValue);
+        pthread_mutex_init(&s_writerMutex, NULL);
+        pthread_cond_init(&s_writerCondition, NULL);
+        s_bWriterQuit = false;
+        pthread_create(&s_writerThread, NULL, writeUserDefault, NULL);
+        s_bWriterRunning = true;
     }
-    else
+
+    pthread_mutex_lock(&s_writerMutex);
+    s_pendingWrites.push_back(pWrite);
+    pthread_cond_signal(&s_writerCondition);
+    pthread_mutex_unlock(&s_writerMutex);
+}
+
+// Returns true if a write failed since the last call
+static bool takeWriteFailure()
+{
+    if (s_bWriterRunning)
     {
-        if (rootNode)
-        {
-            // the node doesn't exist, add a new one
-            // libxml in android doesn't support xmlNewTextChild, so use this approach
-            xmlNodePtr tmpNode = xmlNewNode(NULL, BAD_CAST pKey);
-            xmlNodePtr content = xmlNewText(BAD_CAST pValue);
-            xmlAddChild(rootNode, tmpNode);
-            xmlAddChild(tmpNode, content);
-        }    
+        pthread_mutex_lock(&s_writerMutex);
+    }
+    bool bFailed = s_bWriteFailed;
+    s_bWriteFailed = false;
+    if (s_bWriterRunning)
+    {
+        pthread_mutex_unlock(&s_writerMutex);
+    }
+    return bFailed;
+}
+
+// Waits for the queued writes and stops the writer thread
+static void stopWriter()
+{
+    if (! s_bWriterRunning)
+    {
+        return;
     }
+
+    pthread_mutex_lock(&s_writerMutex);
+    s_bWriterQuit = true;
+    pthread_cond_signal(&s_writerCondition);
+    pthread_mutex_unlock(&s_writerMutex);
+
+    pthread_join(s_writerThread, NULL);
+    pthread_cond_destroy(&s_writerCondition);
+    pthread_mutex_destroy(&s_writerMutex);
+    s_bWriterRunning = false;
 }
 
 /**
@@ -142,18 +503,42 @@ bool CCUserDefault::m_sbIsFilePathInitialized = false;
 CCUserDefault::~CCUserDefault()
 {
     flush();
-    if (g_sharedDoc)
+    stopWriter();
+    if (s_bWriteFailed)
+    {
+        // one more try, with a snapshot
+        flush();
+        stopWriter();
+    }
+
+    tHashUserDefaultEntry *pEntry, *pTmp;
+    HASH_ITER(hh, s_pEntries, pEntry, pTmp)
     {
-        xmlFreeDoc(g_sharedDoc);
-        g_sharedDoc = NULL;
+        HASH_DEL(s_pEntries, pEntry);
+        delete pEntry;
     }
+    s_dirtyEntries.clear();
+    s_uLogRecords = 0;
+    s_bNeedsCompaction = false;
+    s_bWriteFailed = false;
 
     m_spUserDefault = NULL;
 }
 
 CCUserDefault::CCUserDefault()
 {
-    g_sharedDoc = xmlReadFile(getXMLFilePath().c_str(), "utf-8", XML_PARSE_RECOVER);
+    if (! loadBinaryFile(s_sBinaryFilePath))
+    {
+        // first run of the binary backend
+        if (isXMLFileExist())
+        {
+            migrateXMLFile(m_sFilePath);
+        }
+
+        // the first flush writes a snapshot, creating the file
+        s_bNeedsCompaction = true;
+        flush();
+    }
 }
 
 void CCUserDefault::purgeSharedUserDefault()
@@ -169,13 +554,19 @@ void CCUserDefault::purgeSharedUserDefault()
 
 bool CCUserDefault::getBoolForKey(const char* pKey, bool defaultValue)
 {
-    const char* value = getValueForKey(pKey);
+    tHashUserDefaultEntry *pEntry = getEntryForKey(pKey, false);
     bool ret = defaultValue;
 
-    if (value)
+    if (pEntry)
     {
-        ret = (! strcmp(value, "true"));
-        xmlFree((void*)value);
+        if (pEntry->type == kCCUserDefaultTypeBool)
+        {
+            ret = pEntry->intValue != 0;
+        }
+        else
+        {
+            ret = (getStringForEntry(pEntry) == "true");
+        }
     }
 
     return ret;
@@ -188,13 +579,19 @@ int CCUserDefault::getIntegerForKey(const char* pKey)
 
 int CCUserDefault::getIntegerForKey(const char* pKey, int defaultValue)
 {
-    const char* value = getValueForKey(pKey);
+    tHashUserDefaultEntry *pEntry = getEntryForKey(pKey, false);
     int ret = defaultValue;
 
-    if (value)
+    if (pEntry)
     {
-        ret = atoi(value);
-        xmlFree((void*)value);
+        if (pEntry->type == kCCUserDefaultTypeInteger)
+        {
+            ret = pEntry->intValue;
+        }
+        else
+        {
+            ret = atoi(getStringForEntry(pEntry).c_str());
+        }
     }
 
     return ret;
@@ -219,13 +616,19 @@ double  CCUserDefault::getDoubleForKey(const char* pKey)
 
 double CCUserDefault::getDoubleForKey(const char* pKey, double defaultValue)
 {
-    const char* value = getValueForKey(pKey);
+    tHashUserDefaultEntry *pEntry = getEntryForKey(pKey, false);
     double ret = defaultValue;
 
-    if (value)
+    if (pEntry)
     {
-        ret = atof(value);
-        xmlFree((void*)value);
+        if (pEntry->type == kCCUserDefaultTypeDouble)
+        {
+            ret = pEntry->doubleValue;
+        }
+        else
+        {
+            ret = atof(getStringForEntry(pEntry).c_str());
+        }
     }
 
     return ret;
@@ -238,13 +641,12 @@ std::string CCUserDefault::getStringForKey(const char* pKey)
 
 string CCUserDefault::getStringForKey(const char* pKey, const std::string & defaultValue)
 {
-    const char* value = getValueForKey(pKey);
+    tHashUserDefaultEntry *pEntry = getEntryForKey(pKey, false);
     string ret = defaultValue;
 
-    if (value)
+    if (pEntry)
     {
-        ret = string(value);
-        xmlFree((void*)value);
+        ret = getStringForEntry(pEntry);
     }
 
     return ret;
@@ -252,32 +654,28 @@ string CCUserDefault::getStringForKey(const char* pKey, const std::string & defa
 
 void CCUserDefault::setBoolForKey(const char* pKey, bool value)
 {
-    // save bool value as string
-
-    if (true == value)
-    {
-        setStringForKey(pKey, "true");
-    }
-    else
+    tHashUserDefaultEntry *pEntry = getEntryForKey(pKey, true);
+    if (! pEntry || (pEntry->type == kCCUserDefaultTypeBool && (pEntry->intValue != 0) == value))
     {
-        setStringForKey(pKey, "false");
+        return;
     }
+
+    pEntry->type = kCCUserDefaultTypeBool;
+    pEntry->intValue = value ? 1 : 0;
+    markDirty(pEntry);
 }
 
 void CCUserDefault::setIntegerForKey(const char* pKey, int value)
 {
-    // check key
-    if (! pKey)
+    tHashUserDefaultEntry *pEntry = getEntryForKey(pKey, true);
+    if (! pEntry || (pEntry->type == kCCUserDefaultTypeInteger && pEntry->intValue == value))
     {
         return;
     }
 
-    // format the value
-    char tmp[50];
-    memset(tmp, 0, 50);
-    sprintf(tmp, "%d", value);
-
-    setValueForKey(pKey, tmp);
+    pEntry->type = kCCUserDefaultTypeInteger;
+    pEntry->intValue = value;
+    markDirty(pEntry);
 }
 
 void CCUserDefault::setFloatForKey(const char* pKey, float value)
@@ -287,42 +685,34 @@ void CCUserDefault::setFloatForKey(const char* pKey, float value)
 
 void CCUserDefault::setDoubleForKey(const char* pKey, double value)
 {
-    // check key
-    if (! pKey)
+    tHashUserDefaultEntry *pEntry = getEntryForKey(pKey, true);
+    if (! pEntry || (pEntry->type == kCCUserDefaultTypeDouble && pEntry->doubleValue == value))
     {
         return;
     }
 
-    // format the value
-    char tmp[50];
-    memset(tmp, 0, 50);
-    sprintf(tmp, "%f", value);
-
-    setValueForKey(pKey, tmp);
+    pEntry->type = kCCUserDefaultTypeDouble;
+    pEntry->doubleValue = value;
+    markDirty(pEntry);
 }
 
 void CCUserDefault::setStringForKey(const char* pKey, const std::string & value)
 {
-    // check key
-    if (! pKey)
+    tHashUserDefaultEntry *pEntry = getEntryForKey(pKey, true);
+    if (! pEntry || (pEntry->type == kCCUserDefaultTypeString && pEntry->stringValue == value))
     {
         return;
     }
 
-    setValueForKey(pKey, value.c_str());
+    pEntry->type = kCCUserDefaultTypeString;
+    pEntry->stringValue = value;
+    markDirty(pEntry);
 }
 
 CCUserDefault* CCUserDefault::sharedUserDefault()
 {
     initXMLFilePath();
 
-    // only create xml file one time
-    // the file exists after the program exit
-    if ((! isXMLFileExist()) && (! createXMLFile()))
-    {
-        return NULL;
-    }
-
     if (! m_spUserDefault)
     {
         m_spUserDefault = new CCUserDefault();
@@ -349,65 +739,68 @@ void CCUserDefault::initXMLFilePath()
 {
     if (! m_sbIsFilePathInitialized)
     {
-        m_sFilePath += CCFileUtils::sharedFileUtils()->getWriteablePath() + XML_FILE_NAME;
+        std::string writablePath = CCFileUtils::sharedFileUtils()->getWriteablePath();
+        m_sFilePath += writablePath + XML_FILE_NAME;
+        s_sBinaryFilePath = writablePath + BINARY_FILE_NAME;
         m_sbIsFilePathInitialized = true;
     }    
 }
 
-// create new xml file
-bool CCUserDefault::createXMLFile()
+const string& CCUserDefault::getXMLFilePath()
 {
-    bool bRet = false;
-    xmlDocPtr doc = NULL;
+    return m_sFilePath;
+}
 
-    do 
+const string& CCUserDefault::getFilePath()
+{
+    return s_sBinaryFilePath;
+}
+
+void CCUserDefault::flush()
+{
+    // the records of a failed write are lost and the file may end with a partial one:
+    // rewrite every value
+    if (takeWriteFailure())
     {
-        // new doc
-        doc = xmlNewDoc(BAD_CAST"1.0");
-        if (doc == NULL)
-        {
-            CCLOG("can not create xml doc");
-            break;
-        }
+        s_bNeedsCompaction = true;
+    }
 
-        // new root node
-        xmlNodePtr rootNode = xmlNewNode(NULL, BAD_CAST USERDEFAULT_ROOT_NAME);
-        if (rootNode == NULL)
+    unsigned int uCount = HASH_COUNT(s_pEntries);
+    if (s_dirtyEntries.empty() && ! s_bNeedsCompaction)
+    {
+        return;
+    }
+
+    tUserDefaultWrite *pWrite = new tUserDefaultWrite();
+    if (s_bNeedsCompaction || s_uLogRecords + s_dirtyEntries.size() > 2 * uCount + USERDEFAULT_COMPACTION_SLACK)
+    {
+        // rewrite the file with the current values only
+        pWrite->replace = true;
+        appendHeader(pWrite->bytes);
+        for (tHashUserDefaultEntry *pEntry = s_pEntries; pEntry != NULL; pEntry = (tHashUserDefaultEntry*)pEntry->hh.next)
         {
-            CCLOG("can not create root node");
-            break;
+            appendRecord(pWrite->bytes, pEntry);
         }
-
-        // set root node
-        xmlDocSetRootElement(doc, rootNode);
-
-        // save xml file
-        xmlSaveFile(m_sFilePath.c_str(), doc);
-
-        bRet = true;
-    } while (0);
-
-    // if doc is not null, free it
-    if (doc)
+        s_uLogRecords = uCount;
+        s_bNeedsCompaction = false;
+    }
+    else
     {
-        xmlFreeDoc(doc);
+        pWrite->replace = false;
+        for (size_t i = 0; i < s_dirtyEntries.size(); ++i)
+        {
+            appendRecord(pWrite->bytes, s_dirtyEntries[i]);
+        }
+        s_uLogRecords += s_dirtyEntries.size();
     }
 
-    return bRet;
-}
-
-const string& CCUserDefault::getXMLFilePath()
-{
-    return m_sFilePath;
-}
-
-void CCUserDefault::flush()
-{
-    // save to file
-    if (g_sharedDoc)
+    for (size_t i = 0; i < s_dirtyEntries.size(); ++i)
     {
-        xmlSaveFile(CCUserDefault::sharedUserDefault()->getXMLFilePath().c_str(), g_sharedDoc);
+        s_dirtyEntries[i]->dirty = false;
     }
+    s_dirtyEntries.clear();
+
+    queueWrite(pWrite);
 }
 
 NS_CC_END
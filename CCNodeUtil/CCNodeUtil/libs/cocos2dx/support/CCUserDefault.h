@@ -41,6 +41,10 @@ NS_CC_BEGIN
  * 
  * It supports the following base types:
  * bool, int, float, double, string
+ *
+ * The values live in a hash table and are saved by flush() into a binary file, on a
+ * background thread. Only the values set since the previous flush() are appended to it.
+ * The keys of the UserDefault.xml file of former versions are imported on first use.
  */
 class CC_DLL CCUserDefault
 {
@@ -103,17 +107,22 @@ public:
     */
     void    setStringForKey(const char* pKey, const std::string & value);
     /**
-     @brief Save content to xml file
+     @brief Save the values set since the last call to the file. It returns at once, the file
+     is written on a background thread; purgeSharedUserDefault() waits for it to be done.
      */
     void    flush();
 
     static CCUserDefault* sharedUserDefault();
     static void purgeSharedUserDefault();
+    /** Returns the path of the XML file of former versions, which is only read to migrate it */
     const static std::string& getXMLFilePath();
+    /** Returns the path of the binary file the values are saved to
+     @since v2.1.x
+     */
+    const static std::string& getFilePath();
 
 private:
     CCUserDefault();
-    static bool createXMLFile();
     static bool isXMLFileExist();
     static void initXMLFilePath();
     
@@ -117,4 +117,62 @@ int base64Decode(unsigned char *in, unsigned int inLength, unsigned char **out)
     return outLength;
 }
 
+static inline int _base64DecodeChar(unsigned char c)
+{
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+') return 62;
+    if (c == '/') return 63;
+    return -1;
+}
+
+int base64DecodeChunk(ccBase64DecodeState *state, const unsigned char *in, unsigned int inLength, unsigned char *out)
+{
+    unsigned int output_idx = 0;
+    int bits = state->bits;
+    int char_count = state->charCount;
+
+    for (unsigned int input_idx = 0; input_idx < inLength && ! state->finished; input_idx++) {
+        unsigned char c = in[ input_idx ];
+        if (c == '=') {
+            // same tail handling as _base64Decode
+            state->finished = 1;
+            switch (char_count) {
+                case 1:
+                    return -1;
+                case 2:
+                    out[ output_idx++ ] = ( bits >> 10 );
+                    break;
+                case 3:
+                    out[ output_idx++ ] = ( bits >> 16 );
+                    out[ output_idx++ ] = (( bits >> 8 ) & 0xff);
+                    break;
+            }
+            bits = 0;
+            char_count = 0;
+            break;
+        }
+
+        int value = _base64DecodeChar(c);
+        if (value < 0)
+            continue;
+        bits += value;
+        char_count++;
+        if (char_count == 4) {
+            out[ output_idx++ ] = (bits >> 16);
+            out[ output_idx++ ] = ((bits >> 8) & 0xff);
+            out[ output_idx++ ] = ( bits & 0xff);
+            bits = 0;
+            char_count = 0;
+        } else {
+            bits <<= 6;
+        }
+    }
+
+    state->bits = bits;
+    state->charCount = char_count;
+    return (int)output_idx;
+}
+
 }//namespace   cocos2d 
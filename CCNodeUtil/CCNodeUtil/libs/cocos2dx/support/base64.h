@@ -45,6 +45,28 @@ namespace cocos2d {
  */
 int base64Decode(unsigned char *in, unsigned int inLength, unsigned char **out);
 
+/** State of an incremental base64 decode. Zero it before decoding the first chunk.
+ @since v2.1.x
+ */
+typedef struct _ccBase64DecodeState
+{
+    int bits;
+    int charCount;
+    int finished;
+} ccBase64DecodeState;
+
+/**
+ * Decodes the next chunk of a base64 stream, which may be split anywhere.
+ * Characters outside of the base64 alphabet (like whitespace) are skipped,
+ * and everything after the padding is ignored.
+ * out must have room for (inLength / 4 + 1) * 3 bytes.
+ *
+ * @returns the number of bytes written to out, or -1 if the stream is malformed
+ *
+ @since v2.1.x
+ */
+int base64DecodeChunk(ccBase64DecodeState *state, const unsigned char *in, unsigned int inLength, unsigned char *out);
+
 }//namespace   cocos2d 
 
 #ifdef __cplusplus
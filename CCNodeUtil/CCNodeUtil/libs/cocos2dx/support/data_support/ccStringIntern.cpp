@@ -0,0 +1,224 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "ccStringIntern.h"
+#include "ccMacros.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+NS_CC_BEGIN
+
+// The entries are stored in chunks which never move, so an entry can be read without the lock
+#define CC_STRING_INTERN_CHUNK_BITS     10
+#define CC_STRING_INTERN_CHUNK_SIZE     (1 << CC_STRING_INTERN_CHUNK_BITS)
+#define CC_STRING_INTERN_MAX_CHUNKS     4096
+
+// The strings are copied into blocks of this size; longer strings get a block of their own
+#define CC_STRING_INTERN_BLOCK_SIZE     (64 * 1024)
+
+typedef struct _ccInternedString
+{
+    const char      *string;
+    unsigned int    length;
+    unsigned int    hash;
+} ccInternedString;
+
+static pthread_mutex_t s_internMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static ccInternedString *s_pChunks[CC_STRING_INTERN_MAX_CHUNKS];
+static unsigned int s_uCount = 0;
+
+// open addressing table of ids, guarded by s_internMutex
+static unsigned int *s_pSlots = NULL;
+static unsigned int s_uSlotMask = 0;
+
+static char *s_pBlock = NULL;
+static unsigned int s_uBlockLeft = 0;
+
+static inline const ccInternedString* entryForId(unsigned int uId)
+{
+    return &s_pChunks[(uId - 1) >> CC_STRING_INTERN_CHUNK_BITS][(uId - 1) & (CC_STRING_INTERN_CHUNK_SIZE - 1)];
+}
+
+unsigned int ccStringHash(const char *pszString, unsigned int uLength)
+{
+    // FNV-1a
+    unsigned int uHash = 2166136261u;
+    for (unsigned int i = 0; i < uLength; ++i)
+    {
+        uHash = (uHash ^ (unsigned char)pszString[i]) * 16777619u;
+    }
+    return uHash;
+}
+
+// returns the slot of the string, or the empty slot where it belongs
+static unsigned int findSlot(const char *pszString, unsigned int uLength, unsigned int uHash)
+{
+    unsigned int uSlot = uHash & s_uSlotMask;
+    while (s_pSlots[uSlot] != 0)
+    {
+        const ccInternedString *pEntry = entryForId(s_pSlots[uSlot]);
+        if (pEntry->hash == uHash && pEntry->length == uLength && memcmp(pEntry->string, pszString, uLength) == 0)
+        {
+            break;
+        }
+        uSlot = (uSlot + 1) & s_uSlotMask;
+    }
+    return uSlot;
+}
+
+static void growSlots()
+{
+    unsigned int uSlotCount = s_pSlots ? (s_uSlotMask + 1) * 2 : 1024;
+    unsigned int *pOldSlots = s_pSlots;
+    unsigned int uOldSlotCount = s_pSlots ? s_uSlotMask + 1 : 0;
+
+    s_pSlots = (unsigned int*)calloc(uSlotCount, sizeof(unsigned int));
+    s_uSlotMask = uSlotCount - 1;
+    for (unsigned int i = 0; i < uOldSlotCount; ++i)
+    {
+        if (pOldSlots[i] != 0)
+        {
+            unsigned int uSlot = entryForId(pOldSlots[i])->hash & s_uSlotMask;
+            while (s_pSlots[uSlot] != 0)
+            {
+                uSlot = (uSlot + 1) & s_uSlotMask;
+            }
+            s_pSlots[uSlot] = pOldSlots[i];
+        }
+    }
+    free(pOldSlots);
+}
+
+static const char* copyString(const char *pszString, unsigned int uLength)
+{
+    char *pCopy;
+    if (uLength + 1 > CC_STRING_INTERN_BLOCK_SIZE / 4)
+    {
+        pCopy = (char*)malloc(uLength + 1);
+    }
+    else
+    {
+        if (uLength + 1 > s_uBlockLeft)
+        {
+            s_pBlock = (char*)malloc(CC_STRING_INTERN_BLOCK_SIZE);
+            s_uBlockLeft = CC_STRING_INTERN_BLOCK_SIZE;
+        }
+        pCopy = s_pBlock;
+        s_pBlock += uLength + 1;
+        s_uBlockLeft -= uLength + 1;
+    }
+    memcpy(pCopy, pszString, uLength);
+    pCopy[uLength] = '\0';
+    return pCopy;
+}
+
+unsigned int ccStringInternIdWithHash(const char *pszString, unsigned int uLength, unsigned int uHash)
+{
+    pthread_mutex_lock(&s_internMutex);
+
+    // keep the load factor under 1/2
+    if ((s_uCount + 1) * 2 > (s_pSlots ? s_uSlotMask + 1 : 0))
+    {
+        growSlots();
+    }
+
+    unsigned int uSlot = findSlot(pszString, uLength, uHash);
+    unsigned int uId = s_pSlots[uSlot];
+    if (uId == 0)
+    {
+        unsigned int uChunk = s_uCount >> CC_STRING_INTERN_CHUNK_BITS;
+        if (uChunk >= CC_STRING_INTERN_MAX_CHUNKS)
+        {
+            // interned strings are never freed, so there is no way to go on: fail in release builds too
+            pthread_mutex_unlock(&s_internMutex);
+            CCLog("cocos2d: ccStringIntern: more than %d strings interned", CC_STRING_INTERN_MAX_CHUNKS * CC_STRING_INTERN_CHUNK_SIZE);
+            abort();
+        }
+        if (s_pChunks[uChunk] == NULL)
+        {
+            s_pChunks[uChunk] = (ccInternedString*)malloc(CC_STRING_INTERN_CHUNK_SIZE * sizeof(ccInternedString));
+        }
+
+        ccInternedString *pEntry = &s_pChunks[uChunk][s_uCount & (CC_STRING_INTERN_CHUNK_SIZE - 1)];
+        pEntry->string = copyString(pszString, uLength);
+        pEntry->length = uLength;
+        pEntry->hash = uHash;
+
+        uId = ++s_uCount;
+        s_pSlots[uSlot] = uId;
+    }
+
+    pthread_mutex_unlock(&s_internMutex);
+    return uId;
+}
+
+unsigned int ccStringInternId(const char *pszString)
+{
+    CCAssert(pszString != NULL, "ccStringInternId: invalid string");
+    unsigned int uLength = (unsigned int)strlen(pszString);
+    return ccStringInternIdWithHash(pszString, uLength, ccStringHash(pszString, uLength));
+}
+
+unsigned int ccStringInternFind(const char *pszString)
+{
+    if (pszString == NULL)
+    {
+        return 0;
+    }
+
+    unsigned int uLength = (unsigned int)strlen(pszString);
+    unsigned int uHash = ccStringHash(pszString, uLength);
+    unsigned int uId = 0;
+
+    pthread_mutex_lock(&s_internMutex);
+    if (s_pSlots != NULL)
+    {
+        uId = s_pSlots[findSlot(pszString, uLength, uHash)];
+    }
+    pthread_mutex_unlock(&s_internMutex);
+
+    return uId;
+}
+
+const char* ccStringInternString(unsigned int uId)
+{
+    CCAssert(uId > 0, "ccStringInternString: invalid id");
+    return entryForId(uId)->string;
+}
+
+unsigned int ccStringInternLength(unsigned int uId)
+{
+    CCAssert(uId > 0, "ccStringInternLength: invalid id");
+    return entryForId(uId)->length;
+}
+
+unsigned int ccStringInternHash(unsigned int uId)
+{
+    CCAssert(uId > 0, "ccStringInternHash: invalid id");
+    return entryForId(uId)->hash;
+}
+
+NS_CC_END
@@ -0,0 +1,68 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+/**
+ @file
+ Global table of interned strings.
+ Interning a string gives it an id, a small non-zero integer, and a copy of the string which
+ is never moved nor freed: ids and interned strings stay valid for the lifetime of the application.
+ Equal strings get the same id, so interned strings can be compared by id, and the hash of
+ every string is computed only once, when it is interned.
+ As they are never freed, only a bounded set of strings should be interned, such as the keys
+ of the caches; the application is aborted past 4194304 interned strings.
+ All the functions are thread safe.
+ @since v2.1.x
+ */
+
+#ifndef __CC_STRING_INTERN_H__
+#define __CC_STRING_INTERN_H__
+
+#include "platform/CCPlatformMacros.h"
+
+NS_CC_BEGIN
+
+/** Hash function of the interned strings */
+unsigned int ccStringHash(const char *pszString, unsigned int uLength);
+
+/** Interns a string and returns its id */
+unsigned int ccStringInternId(const char *pszString);
+
+/** Interns uLength bytes of pszString, whose ccStringHash() is uHash, and returns their id */
+unsigned int ccStringInternIdWithHash(const char *pszString, unsigned int uLength, unsigned int uHash);
+
+/** Returns the id of a string if it is interned, 0 otherwise. It never interns the string. */
+unsigned int ccStringInternFind(const char *pszString);
+
+/** Returns the interned, NUL terminated copy of the string of an id */
+const char* ccStringInternString(unsigned int uId);
+
+/** Returns the length of the string of an id */
+unsigned int ccStringInternLength(unsigned int uId);
+
+/** Returns the hash of the string of an id */
+unsigned int ccStringInternHash(unsigned int uId);
+
+NS_CC_END
+
+#endif // __CC_STRING_INTERN_H__
@@ -24,12 +24,17 @@ THE SOFTWARE.
 #include <zlib.h>
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "ZipUtils.h"
 #include "ccMacros.h"
 #include "platform/CCFileUtils.h"
+#include "support/CCJobSystem.h"
 #include "unzip.h"
 #include <map>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 NS_CC_BEGIN
 
@@ -83,17 +88,21 @@ int ZipUtils::ccInflateMemoryWithHint(unsigned char *in, unsigned int inLength,
         // not enough memory ?
         if (err != Z_STREAM_END) 
         {
-            delete [] *out;
-            *out = new unsigned char[bufferSize * BUFFER_INC_FACTOR];
+            // keep what has been inflated so far
+            unsigned char *tmp = new unsigned char[bufferSize * BUFFER_INC_FACTOR];
 
             /* not enough memory, ouch */
-            if (! *out ) 
+            if (! tmp ) 
             {
                 CCLOG("cocos2d: ZipUtils: realloc failed");
                 inflateEnd(&d_stream);
                 return Z_MEM_ERROR;
             }
 
+            memcpy(tmp, *out, bufferSize);
+            delete [] *out;
+            *out = tmp;
+
             d_stream.next_out = *out + bufferSize;
             d_stream.avail_out = bufferSize;
             bufferSize *= BUFFER_INC_FACTOR;
@@ -142,6 +151,51 @@ int ZipUtils::ccInflateMemory(unsigned char *in, unsigned int inLength, unsigned
     return ccInflateMemoryWithHint(in, inLength, out, 256 * 1024);
 }
 
+int ZipUtils::ccInflateMemoryIntoBuffer(const unsigned char *in, unsigned int inLength, unsigned char *out, unsigned int outLength)
+{
+    z_stream d_stream; /* decompression stream */
+    memset(&d_stream, 0, sizeof(d_stream));
+
+    d_stream.next_in  = (Bytef*)in;
+    d_stream.avail_in = inLength;
+    d_stream.next_out = out;
+    d_stream.avail_out = outLength;
+
+    if (inflateInit2(&d_stream, 15 + 32) != Z_OK)
+    {
+        return -1;
+    }
+
+    // the whole output is there, one call is enough
+    int err = inflate(&d_stream, Z_FINISH);
+    unsigned int len = outLength - d_stream.avail_out;
+    inflateEnd(&d_stream);
+
+    return (err == Z_STREAM_END) ? (int)len : -1;
+}
+
+// size of the reads when inflating a file as it is read
+#define ZIP_READ_CHUNK (64 * 1024)
+
+// an ISIZE claiming more than this ratio is more likely corrupt than right, the buffer grows instead
+#define ZIP_GZIP_MAX_RATIO 64
+
+// Returns the ISIZE of a gzip file (the size of its last member modulo 2^32), or 0 when it can't be trusted
+static unsigned int ccGZipSizeHint(const unsigned char *header, const unsigned char *trailer, unsigned long length)
+{
+    if (length < 18 || header[0] != 0x1f || header[1] != 0x8b)
+    {
+        return 0;
+    }
+
+    unsigned int size = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) | ((unsigned int)trailer[3] << 24);
+    if (size / ZIP_GZIP_MAX_RATIO > length)
+    {
+        return 0;
+    }
+    return size;
+}
+
 int ZipUtils::ccInflateGZipFile(const char *path, unsigned char **out)
 {
     int len;
@@ -150,30 +204,60 @@ int ZipUtils::ccInflateGZipFile(const char *path, unsigned char **out)
     CCAssert(out, "");
     CCAssert(&*out, "");
 
-    gzFile inFile = gzopen(path, "rb");
+    std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(path);
+
+    // the last member ends with its size modulo 2^32, use it as the initial buffer size
+    unsigned int bufferSize = 0;
+    FILE *fp = fopen(fullPath.c_str(), "rb");
+    if (fp)
+    {
+        unsigned char header[2];
+        unsigned char trailer[4];
+        if (fread(header, 1, 2, fp) == 2 && fseek(fp, -4, SEEK_END) == 0 && fread(trailer, 1, 4, fp) == 4)
+        {
+            bufferSize = ccGZipSizeHint(header, trailer, (unsigned long)ftell(fp));
+        }
+        fclose(fp);
+    }
+
+    gzFile inFile = gzopen(fullPath.c_str(), "rb");
     if( inFile == NULL ) {
+        // not a plain file, like an entry of an asset pack
+        unsigned long fileLen = 0;
+        unsigned char *compressed = CCFileUtils::sharedFileUtils()->getFileData(fullPath.c_str(), "rb", &fileLen);
+        if (compressed && fileLen > 4)
+        {
+            bufferSize = ccGZipSizeHint(compressed, compressed + fileLen - 4, fileLen);
+            len = ccInflateMemoryWithHint(compressed, (unsigned int)fileLen, out, bufferSize ? bufferSize : 512 * 1024);
+            delete [] compressed;
+            return *out ? len : -1;
+        }
+        CC_SAFE_DELETE_ARRAY(compressed);
         CCLOG("cocos2d: ZipUtils: error open gzip file: %s", path);
         return -1;
     }
 
-    /* 512k initial decompress buffer */
-    unsigned int bufferSize = 512 * 1024;
-    unsigned int totalBufferSize = bufferSize;
+    // one more byte, so that reaching the end doesn't need a bigger buffer.
+    // 512k initial decompress buffer if the size is unknown
+    bufferSize = bufferSize ? bufferSize + 1 : 512 * 1024;
 
-    *out = (unsigned char*)malloc( bufferSize );
-    if( ! out ) 
+    *out = new unsigned char[bufferSize];
+    if( ! *out ) 
     {
         CCLOG("cocos2d: ZipUtils: out of memory");
+        gzclose(inFile);
         return -1;
     }
 
     for (;;) {
-        len = gzread(inFile, *out + offset, bufferSize);
+        // gzread goes on with the next member, if any
+        len = gzread(inFile, *out + offset, bufferSize - offset);
         if (len < 0) 
         {
             CCLOG("cocos2d: ZipUtils: error in gzread");
-            free( *out );
+            delete [] *out;
             *out = NULL;
+            gzclose(inFile);
             return -1;
         }
         if (len == 0)
@@ -182,26 +266,25 @@ int ZipUtils::ccInflateGZipFile(const char *path, unsigned char **out)
         }
 
         offset += len;
-
-        // finish reading the file
-        if( (unsigned int)len < bufferSize )
+        if (offset < bufferSize)
         {
-            break;
+            continue;
         }
 
-        bufferSize *= BUFFER_INC_FACTOR;
-        totalBufferSize += bufferSize;
-        unsigned char *tmp = (unsigned char*)realloc(*out, totalBufferSize );
-
+        unsigned char *tmp = new unsigned char[bufferSize * BUFFER_INC_FACTOR];
         if( ! tmp ) 
         {
             CCLOG("cocos2d: ZipUtils: out of memory");
-            free( *out );
+            delete [] *out;
             *out = NULL;
+            gzclose(inFile);
             return -1;
         }
 
+        memcpy(tmp, *out, offset);
+        delete [] *out;
         *out = tmp;
+        bufferSize *= BUFFER_INC_FACTOR;
     }
 
     if (gzclose(inFile) != Z_OK)
@@ -212,76 +295,345 @@ int ZipUtils::ccInflateGZipFile(const char *path, unsigned char **out)
     return offset;
 }
 
+// A CCZ file, either in memory or read from a file descriptor as needed
+typedef struct _ccCCZSource
+{
+    const unsigned char *data;
+    int                 fd;
+    unsigned long       length;
+} ccCCZSource;
+
+static bool ccReadCCZSource(const ccCCZSource *source, unsigned long offset, void *buffer, unsigned int len)
+{
+    if (offset + len > source->length)
+    {
+        return false;
+    }
+    if (source->data)
+    {
+        memcpy(buffer, source->data + offset, len);
+        return true;
+    }
+
+    // pread keeps the chunks of a parallel inflate independent
+    unsigned int done = 0;
+    while (done < len)
+    {
+        ssize_t ret = pread(source->fd, (unsigned char*)buffer + done, len - done, offset + done);
+        if (ret <= 0)
+        {
+            return false;
+        }
+        done += (unsigned int)ret;
+    }
+    return true;
+}
+
+typedef struct _ccCCZChunks
+{
+    const ccCCZSource   *source;
+    const unsigned long *offsets;   // start of every chunk in the source, plus the end of the last one
+    unsigned int        chunkSize;
+    unsigned char       *out;
+    unsigned int        outLength;
+    volatile bool       failed;
+} ccCCZChunks;
+
+static void ccInflateCCZChunks(unsigned int uBegin, unsigned int uEnd, void *pUserData)
+{
+    ccCCZChunks *chunks = (ccCCZChunks*)pUserData;
+    const ccCCZSource *source = chunks->source;
+
+    for (unsigned int i = uBegin; i < uEnd && ! chunks->failed; i++)
+    {
+        unsigned int compressedLen = (unsigned int)(chunks->offsets[i + 1] - chunks->offsets[i]);
+        unsigned int outOffset = i * chunks->chunkSize;
+        unsigned int outLen = MIN(chunks->chunkSize, chunks->outLength - outOffset);
+
+        const unsigned char *compressed = NULL;
+        unsigned char *buffer = NULL;
+        if (source->data)
+        {
+            compressed = source->data + chunks->offsets[i];
+        }
+        else
+        {
+            buffer = new unsigned char[compressedLen];
+            if (ccReadCCZSource(source, chunks->offsets[i], buffer, compressedLen))
+            {
+                compressed = buffer;
+            }
+        }
+
+        if (! compressed || ZipUtils::ccInflateMemoryIntoBuffer(compressed, compressedLen, chunks->out + outOffset, outLen) != (int)outLen)
+        {
+            chunks->failed = true;
+        }
+        CC_SAFE_DELETE_ARRAY(buffer);
+    }
+}
+
+static int ccInflateCCZSource(const ccCCZSource *source, unsigned char **out)
+{
+    struct CCZHeader header;
+    if (! ccReadCCZSource(source, 0, &header, sizeof(header)))
+    {
+        CCLOG("cocos2d: Error loading CCZ compressed file");
+        return -1;
+    }
+
+    // verify header
+    if( header.sig[0] != 'C' || header.sig[1] != 'C' || header.sig[2] != 'Z' || header.sig[3] != '!' ) 
+    {
+        CCLOG("cocos2d: Invalid CCZ file");
+        return -1;
+    }
+
+    // verify header version
+    unsigned int version = CC_SWAP_INT16_BIG_TO_HOST( header.version );
+    if( version > 2 ) 
+    {
+        CCLOG("cocos2d: Unsupported CCZ header format");
+        return -1;
+    }
+
+    // verify compression format
+    unsigned int compression = CC_SWAP_INT16_BIG_TO_HOST(header.compression_type);
+    if( compression != CCZ_COMPRESSION_ZLIB && compression != CCZ_COMPRESSION_ZLIB_CHUNKED ) 
+    {
+        CCLOG("cocos2d: CCZ Unsupported compression method");
+        return -1;
+    }
+
+    unsigned int len = CC_SWAP_INT32_BIG_TO_HOST( header.len );
+
+    // the exact size is known, no buffer ever grows
+    *out = new unsigned char[len];
+    if(! *out )
+    {
+        CCLOG("cocos2d: CCZ: Failed to allocate memory for texture");
+        return -1;
+    }
+
+    bool bRet = false;
+    if (compression == CCZ_COMPRESSION_ZLIB)
+    {
+        if (source->data)
+        {
+            bRet = ZipUtils::ccInflateMemoryIntoBuffer(source->data + sizeof(header), (unsigned int)(source->length - sizeof(header)), *out, len) == (int)len;
+        }
+        else
+        {
+            // inflate as the file is read
+            ZipInflateStream stream;
+            unsigned char *buffer = new unsigned char[ZIP_READ_CHUNK];
+            unsigned long offset = sizeof(header);
+            bRet = stream.begin(*out, len);
+            while (bRet && ! stream.isFinished() && offset < source->length)
+            {
+                unsigned int chunk = (unsigned int)MIN((unsigned long)ZIP_READ_CHUNK, source->length - offset);
+                bRet = ccReadCCZSource(source, offset, buffer, chunk) && stream.feed(buffer, chunk);
+                offset += chunk;
+            }
+            bRet = bRet && stream.isFinished() && stream.getOutLength() == len;
+            delete [] buffer;
+        }
+    }
+    else
+    {
+        unsigned int table[2];
+        if (ccReadCCZSource(source, sizeof(header), table, sizeof(table)))
+        {
+            unsigned int chunkSize = CC_SWAP_INT32_BIG_TO_HOST(table[0]);
+            unsigned int chunkCount = CC_SWAP_INT32_BIG_TO_HOST(table[1]);
+            if (chunkSize > 0 && chunkCount == (len + chunkSize - 1) / chunkSize)
+            {
+                unsigned int *sizes = new unsigned int[chunkCount];
+                unsigned long *offsets = new unsigned long[chunkCount + 1];
+                bRet = ccReadCCZSource(source, sizeof(header) + sizeof(table), sizes, chunkCount * sizeof(unsigned int));
+
+                offsets[0] = sizeof(header) + sizeof(table) + chunkCount * sizeof(unsigned int);
+                for (unsigned int i = 0; bRet && i < chunkCount; i++)
+                {
+                    offsets[i + 1] = offsets[i] + CC_SWAP_INT32_BIG_TO_HOST(sizes[i]);
+                    bRet = offsets[i + 1] <= source->length;
+                }
+
+                if (bRet)
+                {
+                    ccCCZChunks chunks;
+                    chunks.source = source;
+                    chunks.offsets = offsets;
+                    chunks.chunkSize = chunkSize;
+                    chunks.out = *out;
+                    chunks.outLength = len;
+                    chunks.failed = false;
+                    CCJobSystem::sharedJobSystem()->parallelFor(chunkCount, 1, ccInflateCCZChunks, &chunks);
+                    bRet = ! chunks.failed;
+                }
+
+                delete [] sizes;
+                delete [] offsets;
+            }
+        }
+    }
+
+    if (! bRet)
+    {
+        CCLOG("cocos2d: CCZ: Failed to uncompress data");
+        delete [] *out;
+        *out = NULL;
+        return -1;
+    }
+
+    return len;
+}
+
 int ZipUtils::ccInflateCCZFile(const char *path, unsigned char **out)
 {
-     CCAssert(out, "");
-     CCAssert(&*out, "");
-
-     // load file into memory
-     unsigned char* compressed = NULL;
-    
-     unsigned long fileLen = 0;
-     compressed = CCFileUtils::sharedFileUtils()->getFileData(path, "rb", &fileLen);
-
-     if(NULL == compressed || 0 == fileLen) 
-     {
-         CCLOG("cocos2d: Error loading CCZ compressed file");
-         return -1;
-     }
-
-     struct CCZHeader *header = (struct CCZHeader*) compressed;
-
-     // verify header
-     if( header->sig[0] != 'C' || header->sig[1] != 'C' || header->sig[2] != 'Z' || header->sig[3] != '!' ) 
-     {
-         CCLOG("cocos2d: Invalid CCZ file");
-         delete [] compressed;
-         return -1;
-     }
-
-     // verify header version
-     unsigned int version = CC_SWAP_INT16_BIG_TO_HOST( header->version );
-     if( version > 2 ) 
-     {
-         CCLOG("cocos2d: Unsupported CCZ header format");
-         delete [] compressed;
-         return -1;
-     }
-
-     // verify compression format
-     if( CC_SWAP_INT16_BIG_TO_HOST(header->compression_type) != CCZ_COMPRESSION_ZLIB ) 
-     {
-         CCLOG("cocos2d: CCZ Unsupported compression method");
-         delete [] compressed;
-         return -1;
-     }
-
-     unsigned int len = CC_SWAP_INT32_BIG_TO_HOST( header->len );
-
-     *out = (unsigned char*)malloc( len );
-     if(! *out )
-     {
-         CCLOG("cocos2d: CCZ: Failed to allocate memory for texture");
-         delete [] compressed;
-         return -1;
-     }
-
-
-     unsigned long destlen = len;
-     unsigned long source = (unsigned long) compressed + sizeof(*header);
-     int ret = uncompress(*out, &destlen, (Bytef*)source, fileLen - sizeof(*header) );
-
-     delete [] compressed;
-
-     if( ret != Z_OK )
-     {
-         CCLOG("cocos2d: CCZ: Failed to uncompress data");
-         free( *out );
-         *out = NULL;
-         return -1;
-     }
-
-     return len;
+    CCAssert(out, "");
+    CCAssert(&*out, "");
+
+    std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(path);
+    ccCCZSource source = { NULL, -1, 0 };
+    int ret = -1;
+
+    // straight from the mapped data of an asset pack
+    source.data = CCFileUtils::sharedFileUtils()->getFileDataView(fullPath.c_str(), &source.length);
+    if (source.data)
+    {
+        return ccInflateCCZSource(&source, out);
+    }
+
+    // read the file as it is inflated, instead of loading it first
+    struct stat st;
+    source.fd = open(fullPath.c_str(), O_RDONLY);
+    if (source.fd >= 0 && fstat(source.fd, &st) == 0)
+    {
+        source.length = (unsigned long)st.st_size;
+        ret = ccInflateCCZSource(&source, out);
+        close(source.fd);
+        return ret;
+    }
+    if (source.fd >= 0)
+    {
+        close(source.fd);
+    }
+
+    // load file into memory
+    unsigned char *compressed = CCFileUtils::sharedFileUtils()->getFileData(fullPath.c_str(), "rb", &source.length);
+    if (NULL == compressed || 0 == source.length)
+    {
+        CCLOG("cocos2d: Error loading CCZ compressed file");
+        CC_SAFE_DELETE_ARRAY(compressed);
+        return -1;
+    }
+
+    source.data = compressed;
+    source.fd = -1;
+    ret = ccInflateCCZSource(&source, out);
+    delete [] compressed;
+    return ret;
+}
+
+// --------------------- ZipInflateStream ---------------------
+
+class ZipInflateStreamPrivate
+{
+public:
+    z_stream stream;
+    unsigned char *out;
+    unsigned int outLength;
+    bool open;
+    bool finished;
+};
+
+ZipInflateStream::ZipInflateStream()
+    : m_data(new ZipInflateStreamPrivate)
+{
+    memset(&m_data->stream, 0, sizeof(m_data->stream));
+    m_data->out = NULL;
+    m_data->outLength = 0;
+    m_data->open = false;
+    m_data->finished = false;
+}
+
+ZipInflateStream::~ZipInflateStream()
+{
+    if (m_data->open)
+    {
+        inflateEnd(&m_data->stream);
+    }
+    CC_SAFE_DELETE(m_data);
+}
+
+bool ZipInflateStream::begin(unsigned char *out, unsigned int outLength)
+{
+    if (m_data->open)
+    {
+        inflateEnd(&m_data->stream);
+        m_data->open = false;
+    }
+
+    memset(&m_data->stream, 0, sizeof(m_data->stream));
+    m_data->out = out;
+    m_data->outLength = outLength;
+    m_data->finished = false;
+
+    m_data->stream.next_out = out;
+    m_data->stream.avail_out = outLength;
+
+    // 15 + 32: any window size, zlib or gzip header
+    if (inflateInit2(&m_data->stream, 15 + 32) != Z_OK)
+    {
+        return false;
+    }
+    m_data->open = true;
+    return true;
+}
+
+bool ZipInflateStream::feed(const unsigned char *in, unsigned int inLength)
+{
+    if (! m_data->open)
+    {
+        // trailing data after the end of the stream is ignored, like ccInflateMemory does
+        return m_data->finished;
+    }
+
+    m_data->stream.next_in = (Bytef*)in;
+    m_data->stream.avail_in = inLength;
+
+    while (m_data->stream.avail_in > 0)
+    {
+        int err = inflate(&m_data->stream, Z_NO_FLUSH);
+        if (err == Z_STREAM_END)
+        {
+            m_data->finished = true;
+            inflateEnd(&m_data->stream);
+            m_data->open = false;
+            return true;
+        }
+
+        // Z_BUF_ERROR with input left means the output is full
+        if (err != Z_OK)
+        {
+            CCLOG("cocos2d: ZipUtils: inflate stream error %d", err);
+            inflateEnd(&m_data->stream);
+            m_data->open = false;
+            return false;
+        }
+    }
+    return true;
+}
+
+unsigned int ZipInflateStream::getOutLength() const
+{
+    return m_data->outLength - m_data->stream.avail_out;
+}
+
+bool ZipInflateStream::isFinished() const
+{
+    return m_data->finished;
 }
 
 // --------------------- ZipFile ---------------------
@@ -30,6 +30,11 @@ namespace cocos2d
 {
     /* XXX: pragma pack ??? */
     /** @struct CCZHeader
+    *
+    * With CCZ_COMPRESSION_ZLIB_CHUNKED, the header is followed by the size of the chunks before
+    * inflating, their count, and the deflated size of every chunk, all big endian 32 bits integers.
+    * Then come the chunks, each one a zlib stream of its own which can be inflated in parallel.
+    * Every chunk but the last one inflates to exactly the chunk size.
     */
     struct CCZHeader {
         unsigned char            sig[4];                // signature. Should be 'CCZ!' 4 bytes
@@ -44,6 +49,7 @@ namespace cocos2d
         CCZ_COMPRESSION_BZIP2,                // bzip2 format (not supported yet)
         CCZ_COMPRESSION_GZIP,                // gzip format (not supported yet)
         CCZ_COMPRESSION_NONE,                // plain (not supported yet)
+        CCZ_COMPRESSION_ZLIB_CHUNKED,        // zlib chunks, inflated in parallel. @since v2.1.x
     };
 
     class ZipUtils
@@ -72,8 +78,22 @@ namespace cocos2d
         */
         static int ccInflateMemoryWithHint(unsigned char *in, unsigned int inLength, unsigned char **out, unsigned int outLenghtHint);
 
+        /** 
+        * Inflates either zlib or gzip deflated memory into a buffer whose size is known beforehand,
+        * like the size in a CCZ header. Nothing is allocated.
+        *
+        * @returns the length of the inflated data, or -1 if the data is corrupted or doesn't fit in out
+        *
+        @since v2.1.x
+        */
+        static int ccInflateMemoryIntoBuffer(const unsigned char *in, unsigned int inLength, unsigned char *out, unsigned int outLength);
+
         /** inflates a GZip file into memory
         *
+        * The file is inflated as it is read. The size stored at the end of the file is used to allocate the buffer,
+        * files made of several members are supported.
+        * The inflated memory is expected to be freed by the caller with delete[].
+        *
         * @returns the length of the deflated buffer
         *
         * @since v0.99.5
@@ -82,6 +102,10 @@ namespace cocos2d
 
         /** inflates a CCZ file into memory
         *
+        * The buffer is allocated once with the size of the header. The file is inflated as it is read, or straight
+        * from the mapped data if it is in an asset pack. Chunked CCZ files are inflated in parallel by CCJobSystem.
+        * The inflated memory is expected to be freed by the caller with delete[].
+        *
         * @returns the length of the deflated buffer
         *
         * @since v0.99.5
@@ -93,6 +117,48 @@ namespace cocos2d
             unsigned int outLenghtHint);
     };
 
+    // forward declaration
+    class ZipInflateStreamPrivate;
+
+    /**
+    * Inflates either zlib or gzip deflated data as it arrives, straight into a caller-owned buffer.
+    *
+    * Unlike ccInflateMemory, neither the whole deflated input nor a growing output buffer have to be kept in memory.
+    *
+    * @since v2.1.x
+    */
+    class ZipInflateStream
+    {
+    public:
+        ZipInflateStream();
+        virtual ~ZipInflateStream();
+
+        /**
+        * Starts a new stream, dropping the previous one.
+        *
+        * @param out Buffer receiving the inflated data. It isn't freed by the stream.
+        * @param outLength Size of out. Inflated data which doesn't fit is an error.
+        * @return false if zlib couldn't be initialized
+        */
+        bool begin(unsigned char *out, unsigned int outLength);
+
+        /**
+        * Inflates the next piece of deflated data.
+        *
+        * @return false on a data error or if out is full before the end of the stream
+        */
+        bool feed(const unsigned char *in, unsigned int inLength);
+
+        /** number of bytes written to out so far */
+        unsigned int getOutLength() const;
+
+        /** returns true once the end of the deflated stream has been reached */
+        bool isFinished() const;
+
+    private:
+        ZipInflateStreamPrivate *m_data;
+    };
+
     // forward declaration
     class ZipFilePrivate;
 
@@ -43,6 +43,8 @@ THE SOFTWARE.
 #include "CCDirector.h"
 #include "shaders/CCGLProgram.h"
 #include "shaders/ccGLStateCache.h"
+#include "support/CCUploadScheduler.h"
+#include "textures/ccPixelConversion.h"
 #include "shaders/CCShaderCache.h"
 
 #if CC_ENABLE_CACHE_TEXTURE_DATA
@@ -60,6 +62,9 @@ static CCTexture2DPixelFormat g_defaultAlphaPixelFormat = kCCTexture2DPixelForma
 // By default PVR images are treated as if they don't have the alpha channel premultiplied
 static bool PVRHaveAlphaPremultiplied_ = false;
 
+// By default images converted to the 16-bit formats are truncated
+static bool s_bDitherEnabled = false;
+
 CCTexture2D::CCTexture2D()
 : m_uPixelsWide(0)
 , m_uPixelsHigh(0)
@@ -225,6 +230,11 @@ bool CCTexture2D::initWithData(const void *data, CCTexture2DPixelFormat pixelFor
 
     }
 
+    if (data)
+    {
+        CCUploadScheduler::sharedUploadScheduler()->reportUpload(pixelsWide * pixelsHigh * bitsPerPixelForFormat(pixelFormat) / 8);
+    }
+
     m_tContentSize = contentSize;
     m_uPixelsWide = pixelsWide;
     m_uPixelsHigh = pixelsHigh;
@@ -274,143 +284,92 @@ bool CCTexture2D::initWithImage(CCImage *uiImage)
     return initPremultipliedATextureWithImage(uiImage, imageWidth, imageHeight);
 }
 
-bool CCTexture2D::initPremultipliedATextureWithImage(CCImage *image, unsigned int width, unsigned int height)
+bool CCTexture2D::initWithImage(CCImage *uiImage, CCTexture2DPixelFormat pixelFormat, const unsigned char *pConvertedData)
 {
-    unsigned char*            tempData = image->getData();
-    unsigned int*             inPixel32 = NULL;
-    unsigned char*            inPixel8 = NULL;
-    unsigned short*           outPixel16 = NULL;
-    bool                      hasAlpha = image->hasAlpha();
-    CCSize                    imageSize = CCSizeMake((float)(image->getWidth()), (float)(image->getHeight()));
-    CCTexture2DPixelFormat    pixelFormat;
-    size_t                    bpp = image->getBitsPerComponent();
-
-    // compute pixel format
-    if(hasAlpha)
-    {
-        pixelFormat = g_defaultAlphaPixelFormat;
-    }
-    else
-    {
-        if (bpp >= 8)
-        {
-            pixelFormat = kCCTexture2DPixelFormat_RGB888;
-        }
-        else 
-        {
-            pixelFormat = kCCTexture2DPixelFormat_RGB565;
-        }
-        
-    }
-    
-    // Repack the pixel data into the right format
-    unsigned int length = width * height;
-    
-    if (pixelFormat == kCCTexture2DPixelFormat_RGB565)
-    {
-        if (hasAlpha)
-        {
-            // Convert "RRRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA" to "RRRRRGGGGGGBBBBB"
-            
-            tempData = new unsigned char[width * height * 2];
-            outPixel16 = (unsigned short*)tempData;
-            inPixel32 = (unsigned int*)image->getData();
-            
-            for(unsigned int i = 0; i < length; ++i, ++inPixel32)
-            {
-                *outPixel16++ = 
-                ((((*inPixel32 >>  0) & 0xFF) >> 3) << 11) |  // R
-                ((((*inPixel32 >>  8) & 0xFF) >> 2) << 5)  |  // G
-                ((((*inPixel32 >> 16) & 0xFF) >> 3) << 0);    // B
-            }
-        }
-        else 
-        {
-            // Convert "RRRRRRRRRGGGGGGGGBBBBBBBB" to "RRRRRGGGGGGBBBBB"
-            
-            tempData = new unsigned char[width * height * 2];
-            outPixel16 = (unsigned short*)tempData;
-            inPixel8 = (unsigned char*)image->getData();
-            
-            for(unsigned int i = 0; i < length; ++i)
-            {
-                *outPixel16++ = 
-                (((*inPixel8++ & 0xFF) >> 3) << 11) |  // R
-                (((*inPixel8++ & 0xFF) >> 2) << 5)  |  // G
-                (((*inPixel8++ & 0xFF) >> 3) << 0);    // B
-            }
-        }    
-    }
-    else if (pixelFormat == kCCTexture2DPixelFormat_RGBA4444)
+    if (uiImage == NULL)
     {
-        // Convert "RRRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA" to "RRRRGGGGBBBBAAAA"
-        
-        inPixel32 = (unsigned int*)image->getData();  
-        tempData = new unsigned char[width * height * 2];
-        outPixel16 = (unsigned short*)tempData;
-        
-        for(unsigned int i = 0; i < length; ++i, ++inPixel32)
-        {
-            *outPixel16++ = 
-            ((((*inPixel32 >> 0) & 0xFF) >> 4) << 12) | // R
-            ((((*inPixel32 >> 8) & 0xFF) >> 4) <<  8) | // G
-            ((((*inPixel32 >> 16) & 0xFF) >> 4) << 4) | // B
-            ((((*inPixel32 >> 24) & 0xFF) >> 4) << 0);  // A
-        }
+        CCLOG("cocos2d: CCTexture2D. Can't create Texture. UIImage is nil");
+        this->release();
+        return false;
     }
-    else if (pixelFormat == kCCTexture2DPixelFormat_RGB5A1)
+
+    unsigned int imageWidth = uiImage->getWidth();
+    unsigned int imageHeight = uiImage->getHeight();
+
+    unsigned maxTextureSize = CCConfiguration::sharedConfiguration()->getMaxTextureSize();
+    if (imageWidth > maxTextureSize || imageHeight > maxTextureSize)
     {
-        // Convert "RRRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA" to "RRRRRGGGGGBBBBBA"
-        inPixel32 = (unsigned int*)image->getData();   
-        tempData = new unsigned char[width * height * 2];
-        outPixel16 = (unsigned short*)tempData;
-        
-        for(unsigned int i = 0; i < length; ++i, ++inPixel32)
-        {
-            *outPixel16++ = 
-            ((((*inPixel32 >> 0) & 0xFF) >> 3) << 11) | // R
-            ((((*inPixel32 >> 8) & 0xFF) >> 3) <<  6) | // G
-            ((((*inPixel32 >> 16) & 0xFF) >> 3) << 1) | // B
-            ((((*inPixel32 >> 24) & 0xFF) >> 7) << 0);  // A
-        }
+        CCLOG("cocos2d: WARNING: Image (%u x %u) is bigger than the supported %u x %u", imageWidth, imageHeight, maxTextureSize, maxTextureSize);
+        this->release();
+        return false;
     }
-    else if (pixelFormat == kCCTexture2DPixelFormat_A8)
+
+    CCSize imageSize = CCSizeMake((float)imageWidth, (float)imageHeight);
+    initWithData(pConvertedData ? pConvertedData : uiImage->getData(), pixelFormat, imageWidth, imageHeight, imageSize);
+
+    m_bHasPremultipliedAlpha = uiImage->isPremultipliedAlpha();
+    return true;
+}
+
+bool CCTexture2D::initPremultipliedATextureWithImage(CCImage *image, unsigned int width, unsigned int height)
+{
+    CCTexture2DPixelFormat pixelFormat = pixelFormatForImage(image, g_defaultAlphaPixelFormat);
+    unsigned char *tempData = convertImageData(image, pixelFormat, s_bDitherEnabled);
+    CCSize imageSize = CCSizeMake((float)(image->getWidth()), (float)(image->getHeight()));
+
+    initWithData(tempData ? tempData : image->getData(), pixelFormat, width, height, imageSize);
+    CC_SAFE_DELETE_ARRAY(tempData);
+
+    m_bHasPremultipliedAlpha = image->isPremultipliedAlpha();
+    return true;
+}
+
+CCTexture2DPixelFormat CCTexture2D::pixelFormatForImage(CCImage *image, CCTexture2DPixelFormat eAlphaPixelFormat)
+{
+    if (image->hasAlpha())
     {
-        // Convert "RRRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA" to "AAAAAAAA"
-        inPixel32 = (unsigned int*)image->getData();
-        tempData = new unsigned char[width * height];
-        unsigned char *outPixel8 = tempData;
-        
-        for(unsigned int i = 0; i < length; ++i, ++inPixel32)
-        {
-            *outPixel8++ = (*inPixel32 >> 24) & 0xFF;  // A
-        }
+        return eAlphaPixelFormat;
     }
-    
-    if (hasAlpha && pixelFormat == kCCTexture2DPixelFormat_RGB888)
+
+    return image->getBitsPerComponent() >= 8 ? kCCTexture2DPixelFormat_RGB888 : kCCTexture2DPixelFormat_RGB565;
+}
+
+unsigned char* CCTexture2D::convertImageData(CCImage *image, CCTexture2DPixelFormat pixelFormat, bool bDither)
+{
+    unsigned int width = image->getWidth();
+    unsigned int height = image->getHeight();
+    unsigned char *outData = NULL;
+
+    if (image->hasAlpha())
     {
-        // Convert "RRRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA" to "RRRRRRRRGGGGGGGGBBBBBBBB"
-        inPixel32 = (unsigned int*)image->getData();
-        tempData = new unsigned char[width * height * 3];
-        unsigned char *outPixel8 = tempData;
-        
-        for(unsigned int i = 0; i < length; ++i, ++inPixel32)
+        // decoded images with alpha are RGBA8888
+        switch (pixelFormat)
         {
-            *outPixel8++ = (*inPixel32 >> 0) & 0xFF; // R
-            *outPixel8++ = (*inPixel32 >> 8) & 0xFF; // G
-            *outPixel8++ = (*inPixel32 >> 16) & 0xFF; // B
+        case kCCTexture2DPixelFormat_RGB565:
+        case kCCTexture2DPixelFormat_RGBA4444:
+        case kCCTexture2DPixelFormat_RGB5A1:
+            outData = new unsigned char[width * height * 2];
+            break;
+        case kCCTexture2DPixelFormat_A8:
+            outData = new unsigned char[width * height];
+            break;
+        case kCCTexture2DPixelFormat_RGB888:
+            outData = new unsigned char[width * height * 3];
+            break;
+        default:
+            // uploaded as it is
+            return NULL;
         }
+        ccConvertRGBA8888(image->getData(), width, height, pixelFormat, bDither, outData);
     }
-    
-    initWithData(tempData, pixelFormat, width, height, imageSize);
-    
-    if (tempData != image->getData())
+    else if (pixelFormat == kCCTexture2DPixelFormat_RGB565)
     {
-        delete [] tempData;
+        // decoded images without alpha are RGB888
+        outData = new unsigned char[width * height * 2];
+        ccConvertRGB888ToRGB565(image->getData(), width, height, bDither, outData);
     }
 
-    m_bHasPremultipliedAlpha = image->isPremultipliedAlpha();
-    return true;
+    return outData;
 }
 
 // implementation CCTexture2D (Text)
@@ -596,6 +555,16 @@ void CCTexture2D::PVRImagesHavePremultipliedAlpha(bool haveAlphaPremultiplied)
     PVRHaveAlphaPremultiplied_ = haveAlphaPremultiplied;
 }
 
+void CCTexture2D::setDitherEnabled(bool bDither)
+{
+    s_bDitherEnabled = bDither;
+}
+
+bool CCTexture2D::isDitherEnabled()
+{
+    return s_bDitherEnabled;
+}
+
     
 //
 // Use to apply MIN/MAG filter
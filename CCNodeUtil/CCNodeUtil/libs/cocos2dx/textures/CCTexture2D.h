@@ -134,6 +134,26 @@ public:
 
     bool initWithImage(CCImage * uiImage);
 
+    /** Initializes a texture from an image whose data was repacked beforehand by convertImageData().
+    pixelFormat must be the format given to convertImageData(), and pConvertedData the buffer it returned,
+    which may be NULL. The caller keeps ownership of pConvertedData.
+    @since v2.1.x
+    */
+    bool initWithImage(CCImage * uiImage, CCTexture2DPixelFormat pixelFormat, const unsigned char *pConvertedData);
+
+    /** returns the pixel format initWithImage() uses for image: eAlphaPixelFormat if the image has
+    an alpha channel, RGB888 or RGB565 otherwise.
+    @since v2.1.x
+    */
+    static CCTexture2DPixelFormat pixelFormatForImage(CCImage *image, CCTexture2DPixelFormat eAlphaPixelFormat);
+
+    /** Repacks the data of image into pixelFormat, which must come from pixelFormatForImage().
+    Returns a buffer allocated with new[], or NULL if the image data can be used as it is.
+    It doesn't touch OpenGL, so CCTextureCache calls it on its loader threads.
+    @since v2.1.x
+    */
+    static unsigned char* convertImageData(CCImage *image, CCTexture2DPixelFormat pixelFormat, bool bDither);
+
     /** Initializes a texture from a string with dimensions, alignment, font name and font size */
     bool initWithString(const char *text,  const char *fontName, float fontSize, const CCSize& dimensions, CCTextAlignment hAlignment, CCVerticalTextAlignment vAlignment);
     /** Initializes a texture from a string with font name and font size */
@@ -236,6 +256,20 @@ public:
      */
     static void PVRImagesHavePremultipliedAlpha(bool haveAlphaPremultiplied);
 
+    /** dithers (or not) images converted to RGB565, RGBA4444 or RGB5A1.
+     Dithering hides the banding of smooth gradients at the cost of a faint pattern.
+     
+     By default it is disabled.
+     
+     @since v2.1.x
+     */
+    static void setDitherEnabled(bool bDither);
+
+    /** returns whether images converted to the 16-bit formats are dithered
+    @since v2.1.x
+    */
+    static bool isDitherEnabled();
+
     /** content size */
     const CCSize& getContentSizeInPixels();
     
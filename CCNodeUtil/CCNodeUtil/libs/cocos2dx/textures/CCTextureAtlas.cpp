@@ -36,6 +36,7 @@ THE SOFTWARE.
 // support
 #include "CCTexture2D.h"
 #include "cocoa/CCString.h"
+#include "support/CCUploadScheduler.h"
 #include <stdlib.h>
 
 //According to some tests GL_TRIANGLE_STRIP is slower, MUCH slower. Probably I'm doing something very wrong
@@ -47,6 +48,7 @@ NS_CC_BEGIN
 CCTextureAtlas::CCTextureAtlas()
     :m_pIndices(NULL)
     ,m_bDirty(false)
+    ,m_uDirtyRangeCount(0)
     ,m_pTexture(NULL)
     ,m_pQuads(NULL)
 {}
@@ -97,9 +99,16 @@ ccV3F_C4B_T2F_Quad* CCTextureAtlas::getQuads()
     return m_pQuads;
 }
 
+ccV3F_C4B_T2F_Quad* CCTextureAtlas::getQuadsForUpdate(unsigned int index, unsigned int amount)
+{
+    markDirty(index, amount);
+    return m_pQuads;
+}
+
 void CCTextureAtlas::setQuads(ccV3F_C4B_T2F_Quad *var)
 {
     m_pQuads = var;
+    m_bDirty = true;
 }
 
 // TextureAtlas - alloc & init
@@ -252,7 +261,7 @@ void CCTextureAtlas::setupVBOandVAO()
     glGenBuffers(2, &m_pBuffersVBO[0]);
 
     glBindBuffer(GL_ARRAY_BUFFER, m_pBuffersVBO[0]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(m_pQuads[0]) * m_uCapacity, m_pQuads, GL_DYNAMIC_DRAW);
+    CCUploadScheduler::sharedUploadScheduler()->bufferData(GL_ARRAY_BUFFER, sizeof(m_pQuads[0]) * m_uCapacity, m_pQuads, GL_DYNAMIC_DRAW);
 
     // vertices
     glEnableVertexAttribArray(kCCVertexAttrib_Position);
@@ -267,7 +276,7 @@ void CCTextureAtlas::setupVBOandVAO()
     glVertexAttribPointer(kCCVertexAttrib_TexCoords, 2, GL_FLOAT, GL_FALSE, kQuadSize, (GLvoid*) offsetof( ccV3F_C4B_T2F, texCoords));
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_pBuffersVBO[1]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(m_pIndices[0]) * m_uCapacity * 6, m_pIndices, GL_STATIC_DRAW);
+    CCUploadScheduler::sharedUploadScheduler()->bufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(m_pIndices[0]) * m_uCapacity * 6, m_pIndices, GL_STATIC_DRAW);
 
     // Must unbind the VAO before changing the element buffer.
     ccGLBindVAO(0);
@@ -291,11 +300,11 @@ void CCTextureAtlas::mapBuffers()
 	ccGLBindVAO(0);
     
     glBindBuffer(GL_ARRAY_BUFFER, m_pBuffersVBO[0]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(m_pQuads[0]) * m_uCapacity, m_pQuads, GL_DYNAMIC_DRAW);
+    CCUploadScheduler::sharedUploadScheduler()->bufferData(GL_ARRAY_BUFFER, sizeof(m_pQuads[0]) * m_uCapacity, m_pQuads, GL_DYNAMIC_DRAW);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_pBuffersVBO[1]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(m_pIndices[0]) * m_uCapacity * 6, m_pIndices, GL_STATIC_DRAW);
+    CCUploadScheduler::sharedUploadScheduler()->bufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(m_pIndices[0]) * m_uCapacity * 6, m_pIndices, GL_STATIC_DRAW);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
     CHECK_GL_ERROR_DEBUG();
@@ -312,7 +321,7 @@ void CCTextureAtlas::updateQuad(ccV3F_C4B_T2F_Quad *quad, unsigned int index)
     m_pQuads[index] = *quad;    
 
 
-    m_bDirty = true;
+    markDirty(index, 1);
 
 }
 
@@ -336,7 +345,7 @@ void CCTextureAtlas::insertQuad(ccV3F_C4B_T2F_Quad *quad, unsigned int index)
     m_pQuads[index] = *quad;
 
 
-    m_bDirty = true;
+    markDirty(index, m_uTotalQuads - index);
 
 }
 
@@ -359,6 +368,8 @@ void CCTextureAtlas::insertQuads(ccV3F_C4B_T2F_Quad* quads, unsigned int index,
     }
 
 
+    markDirty(index, m_uTotalQuads - index);
+
     unsigned int max = index + amount;
     unsigned int j = 0;
     for (unsigned int i = index; i < max ; i++)
@@ -367,8 +378,6 @@ void CCTextureAtlas::insertQuads(ccV3F_C4B_T2F_Quad* quads, unsigned int index,
         index++;
         j++;
     }
-
-    m_bDirty = true;
 }
 
 void CCTextureAtlas::insertQuadFromIndex(unsigned int oldIndex, unsigned int newIndex)
@@ -397,7 +406,7 @@ void CCTextureAtlas::insertQuadFromIndex(unsigned int oldIndex, unsigned int new
     m_pQuads[newIndex] = quadsBackup;
 
 
-    m_bDirty = true;
+    markDirty(MIN(oldIndex, newIndex), howMany + 1);
 
 }
 
@@ -418,7 +427,7 @@ void CCTextureAtlas::removeQuadAtIndex(unsigned int index)
     m_uTotalQuads--;
 
 
-    m_bDirty = true;
+    markDirty(index, remaining);
 
 }
 
@@ -435,7 +444,7 @@ void CCTextureAtlas::removeQuadsAtIndex(unsigned int index, unsigned int amount)
         memmove( &m_pQuads[index], &m_pQuads[index+amount], sizeof(m_pQuads[0]) * remaining );
     }
 
-    m_bDirty = true;
+    markDirty(index, remaining);
 }
 
 void CCTextureAtlas::removeAllQuads()
@@ -512,13 +521,16 @@ bool CCTextureAtlas::resizeCapacity(unsigned int newCapacity)
     setupIndices();
     mapBuffers();
 
-    m_bDirty = true;
+    // mapBuffers uploaded everything
+    m_bDirty = false;
+    m_uDirtyRangeCount = 0;
 
     return true;
 }
 
 void CCTextureAtlas::increaseTotalQuadsWith(unsigned int amount)
 {
+    markDirty(m_uTotalQuads, amount);
     m_uTotalQuads += amount;
 }
 
@@ -550,7 +562,7 @@ void CCTextureAtlas::moveQuadsFromIndex(unsigned int oldIndex, unsigned int amou
 
     free(tempQuads);
 
-    m_bDirty = true;
+    markDirty(MIN(oldIndex, newIndex), (newIndex > oldIndex ? newIndex - oldIndex : oldIndex - newIndex) + amount);
 }
 
 void CCTextureAtlas::moveQuadsFromIndex(unsigned int index, unsigned int newIndex)
@@ -558,6 +570,8 @@ void CCTextureAtlas::moveQuadsFromIndex(unsigned int index, unsigned int newInde
     CCAssert(newIndex + (m_uTotalQuads - index) <= m_uCapacity, "moveQuadsFromIndex move is out of bounds");
 
     memmove(m_pQuads + newIndex,m_pQuads + index, (m_uTotalQuads - index) * sizeof(m_pQuads[0]));
+
+    markDirty(newIndex, m_uTotalQuads - index);
 }
 
 void CCTextureAtlas::fillWithEmptyQuadsFromIndex(unsigned int index, unsigned int amount)
@@ -570,6 +584,122 @@ void CCTextureAtlas::fillWithEmptyQuadsFromIndex(unsigned int index, unsigned in
     {
         m_pQuads[i] = quad;
     }
+
+    markDirty(index, amount);
+}
+
+void CCTextureAtlas::markDirty(unsigned int index, unsigned int amount)
+{
+    if (m_bDirty || amount == 0)
+    {
+        return;
+    }
+
+    unsigned int start = index;
+    unsigned int end = index + amount;
+
+    // first range which ends at or after start
+    unsigned int i = 0;
+    while (i < m_uDirtyRangeCount && m_pDirtyRangeEnd[i] < start)
+    {
+        i++;
+    }
+
+    if (i < m_uDirtyRangeCount && m_pDirtyRangeStart[i] <= end)
+    {
+        // overlaps or touches range i, absorb it and every following range it reaches
+        start = MIN(start, m_pDirtyRangeStart[i]);
+        unsigned int j = i;
+        while (j < m_uDirtyRangeCount && m_pDirtyRangeStart[j] <= end)
+        {
+            end = MAX(end, m_pDirtyRangeEnd[j]);
+            j++;
+        }
+        m_pDirtyRangeStart[i] = start;
+        m_pDirtyRangeEnd[i] = end;
+
+        unsigned int absorbed = j - i - 1;
+        for (unsigned int k = i + 1; k + absorbed < m_uDirtyRangeCount; k++)
+        {
+            m_pDirtyRangeStart[k] = m_pDirtyRangeStart[k + absorbed];
+            m_pDirtyRangeEnd[k] = m_pDirtyRangeEnd[k + absorbed];
+        }
+        m_uDirtyRangeCount -= absorbed;
+        return;
+    }
+
+    if (m_uDirtyRangeCount == kCCTextureAtlasMaxDirtyRanges)
+    {
+        // no room left: merge the two neighbouring ranges with the smallest gap
+        unsigned int closest = 0;
+        for (unsigned int k = 1; k + 1 < m_uDirtyRangeCount; k++)
+        {
+            if (m_pDirtyRangeStart[k + 1] - m_pDirtyRangeEnd[k] < m_pDirtyRangeStart[closest + 1] - m_pDirtyRangeEnd[closest])
+            {
+                closest = k;
+            }
+        }
+        m_pDirtyRangeEnd[closest] = m_pDirtyRangeEnd[closest + 1];
+        for (unsigned int k = closest + 1; k + 1 < m_uDirtyRangeCount; k++)
+        {
+            m_pDirtyRangeStart[k] = m_pDirtyRangeStart[k + 1];
+            m_pDirtyRangeEnd[k] = m_pDirtyRangeEnd[k + 1];
+        }
+        m_uDirtyRangeCount--;
+
+        // there is room now, and the merged range may have grown into the new one
+        markDirty(start, end - start);
+        return;
+    }
+
+    for (unsigned int k = m_uDirtyRangeCount; k > i; k--)
+    {
+        m_pDirtyRangeStart[k] = m_pDirtyRangeStart[k - 1];
+        m_pDirtyRangeEnd[k] = m_pDirtyRangeEnd[k - 1];
+    }
+    m_pDirtyRangeStart[i] = start;
+    m_pDirtyRangeEnd[i] = end;
+    m_uDirtyRangeCount++;
+}
+
+void CCTextureAtlas::uploadDirtyQuads()
+{
+    CCUploadScheduler *pScheduler = CCUploadScheduler::sharedUploadScheduler();
+
+    unsigned int uDirtyQuads = 0;
+    unsigned int uEnd = m_uTotalQuads;
+    for (unsigned int i = 0; i < m_uDirtyRangeCount; i++)
+    {
+        m_pDirtyRangeEnd[i] = MIN(m_pDirtyRangeEnd[i], m_uCapacity);
+        if (m_pDirtyRangeStart[i] < m_pDirtyRangeEnd[i])
+        {
+            uDirtyQuads += m_pDirtyRangeEnd[i] - m_pDirtyRangeStart[i];
+            uEnd = MAX(uEnd, m_pDirtyRangeEnd[i]);
+        }
+    }
+
+    // a single upload beats several small ones once most of the atlas has changed
+    if (m_bDirty || uDirtyQuads * CC_TEXTURE_ATLAS_FULL_UPLOAD_RATIO >= m_uTotalQuads)
+    {
+        // orphan the buffer, the GPU may still be drawing from the old one
+        pScheduler->bufferData(GL_ARRAY_BUFFER, sizeof(m_pQuads[0]) * m_uCapacity, NULL, GL_DYNAMIC_DRAW);
+        pScheduler->bufferSubData(GL_ARRAY_BUFFER, 0, sizeof(m_pQuads[0]) * uEnd, m_pQuads);
+    }
+    else
+    {
+        for (unsigned int i = 0; i < m_uDirtyRangeCount; i++)
+        {
+            if (m_pDirtyRangeStart[i] < m_pDirtyRangeEnd[i])
+            {
+                pScheduler->bufferSubData(GL_ARRAY_BUFFER, sizeof(m_pQuads[0]) * m_pDirtyRangeStart[i],
+                                          sizeof(m_pQuads[0]) * (m_pDirtyRangeEnd[i] - m_pDirtyRangeStart[i]),
+                                          &m_pQuads[m_pDirtyRangeStart[i]]);
+            }
+        }
+    }
+
+    m_bDirty = false;
+    m_uDirtyRangeCount = 0;
 }
 
 // TextureAtlas - Drawing
@@ -599,24 +729,11 @@ void CCTextureAtlas::drawNumberOfQuads(unsigned int n, unsigned int start)
     //
 
     // XXX: update is done in draw... perhaps it should be done in a timer
-    if (m_bDirty) 
+    if (isDirty()) 
     {
         glBindBuffer(GL_ARRAY_BUFFER, m_pBuffersVBO[0]);
-        // option 1: subdata
-        //glBufferSubData(GL_ARRAY_BUFFER, sizeof(m_pQuads[0])*start, sizeof(m_pQuads[0]) * n , &m_pQuads[start] );
-		
-		// option 2: data
-        //		glBufferData(GL_ARRAY_BUFFER, sizeof(quads_[0]) * (n-start), &quads_[start], GL_DYNAMIC_DRAW);
-		
-		// option 3: orphaning + glMapBuffer
-		glBufferData(GL_ARRAY_BUFFER, sizeof(m_pQuads[0]) * (n-start), NULL, GL_DYNAMIC_DRAW);
-		void *buf = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-		memcpy(buf, m_pQuads, sizeof(m_pQuads[0])* (n-start));
-		glUnmapBuffer(GL_ARRAY_BUFFER);
-		
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-        m_bDirty = false;
+        uploadDirtyQuads();
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
     }
 
     ccGLBindVAO(m_uVAOname);
@@ -647,10 +764,9 @@ void CCTextureAtlas::drawNumberOfQuads(unsigned int n, unsigned int start)
     glBindBuffer(GL_ARRAY_BUFFER, m_pBuffersVBO[0]);
 
     // XXX: update is done in draw... perhaps it should be done in a timer
-    if (m_bDirty) 
+    if (isDirty()) 
     {
-        glBufferSubData(GL_ARRAY_BUFFER, sizeof(m_pQuads[0])*start, sizeof(m_pQuads[0]) * n , &m_pQuads[start] );
-        m_bDirty = false;
+        uploadDirtyQuads();
     }
 
     ccGLEnableVertexAttribs(kCCVertexAttribFlag_PosColorTex);
@@ -41,6 +41,9 @@ class CCTexture2D;
  * @{
  */
 
+//! Number of separate dirty ranges CCTextureAtlas tracks before it merges the closest ones
+#define kCCTextureAtlasMaxDirtyRanges 8
+
 /** @brief A class that implements a Texture Atlas.
 Supported features:
 * The atlas file can be a PVRTC, PNG or any other format supported by Texture2D
@@ -61,7 +64,11 @@ protected:
     GLuint              m_uVAOname;
 #endif
     GLuint              m_pBuffersVBO[2]; //0: vertex  1: indices
-    bool                m_bDirty; //indicates whether or not the array buffer of the VBO needs to be updated
+    bool                m_bDirty; //indicates whether or not the whole array buffer of the VBO needs to be updated
+    // quads changed since the last upload, as sorted and disjoint [start, end) ranges
+    unsigned int        m_uDirtyRangeCount;
+    unsigned int        m_pDirtyRangeStart[kCCTextureAtlasMaxDirtyRanges];
+    unsigned int        m_pDirtyRangeEnd[kCCTextureAtlasMaxDirtyRanges];
 
 
     /** quantity of quads that are going to be drawn */
@@ -202,9 +209,31 @@ public:
     /** listen the event that coming to foreground on Android
      */
     void listenBackToForeground(CCObject *obj);
+
+    /** Marks quads written directly through getQuads() for upload at the next draw.
+    Only the changed ranges are uploaded, unless they cover most of the atlas.
+    @since v2.1.x
+    */
+    void markDirty(unsigned int index, unsigned int amount);
+
+    /** Returns the quads like getQuads() does, but only marks [index, index + amount) as changed.
+    Prefer it over getQuads() when you know which quads are going to be written.
+    @since v2.1.x
+    */
+    ccV3F_C4B_T2F_Quad* getQuadsForUpdate(unsigned int index, unsigned int amount);
+
+    /** Forces the whole quad array to be uploaded at the next draw
+    @since v2.1.x
+    */
+    inline void setDirty(bool bDirty) { m_bDirty = bDirty; }
+    /** returns true if some quads still have to be uploaded
+    @since v2.1.x
+    */
+    inline bool isDirty() const { return m_bDirty || m_uDirtyRangeCount > 0; }
 private:
     void setupIndices();
     void mapBuffers();
+    void uploadDirtyQuads();
 #if CC_TEXTURE_ATLAS_USE_VAO
     void setupVBOandVAO();
 #else
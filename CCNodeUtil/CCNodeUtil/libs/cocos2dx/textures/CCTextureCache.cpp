@@ -35,14 +35,17 @@ THE SOFTWARE.
 #include "support/ccUtils.h"
 #include "CCScheduler.h"
 #include "cocoa/CCString.h"
+#include "support/CCJobSystem.h"
+#include "support/CCUploadScheduler.h"
 #include <errno.h>
 #include <stack>
 #include <string>
 #include <cctype>
 #include <queue>
 #include <list>
+#include <vector>
+#include <algorithm>
 #include <pthread.h>
-#include <semaphore.h>
 
 using namespace std;
 
@@ -51,43 +54,59 @@ NS_CC_BEGIN
 typedef struct _AsyncStruct
 {
     std::string            filename;
+    unsigned int           handle;         // CCFileUtils handle of filename, the texture's key
     CCObject    *target;
     SEL_CallFuncO        selector;
+    int                    priority;
+    unsigned int           sequence;       // keeps requests of the same priority in FIFO order
+    volatile bool          cancelled;      // set on the main thread, the decoders drop cancelled requests
+    CCImage                *image;         // NULL if decoding failed
+    CCImage::EImageFormat  imageType;
+    CCTexture2DPixelFormat pixelFormat;    // the default alpha format when queued, the texture format once decoded
+    bool                   dither;
+    unsigned char          *convertedData; // image data repacked into pixelFormat, NULL if it is used as it is
 } AsyncStruct;
 
-typedef struct _ImageInfo
+// orders the pending heap: highest priority first, then oldest first
+struct AsyncStructCompare
 {
-    AsyncStruct *asyncStruct;
-    CCImage        *image;
-    CCImage::EImageFormat imageType;
-} ImageInfo;
+    bool operator()(const AsyncStruct *a, const AsyncStruct *b) const
+    {
+        if (a->priority != b->priority)
+        {
+            return a->priority < b->priority;
+        }
+        return a->sequence > b->sequence;
+    }
+};
 
-static pthread_t s_loadingThread;
+static void deleteAsyncStruct(AsyncStruct *pAsyncStruct)
+{
+    CC_SAFE_RELEASE(pAsyncStruct->image);
+    CC_SAFE_DELETE_ARRAY(pAsyncStruct->convertedData);
+    delete pAsyncStruct;
+}
 
+// guards s_pAsyncStructQueue
 static pthread_mutex_t      s_asyncStructQueueMutex;
+// guards s_pImageQueue
 static pthread_mutex_t      s_ImageInfoMutex;
 
-static sem_t* s_pSem = NULL;
 static unsigned long s_nAsyncRefCount = 0;
+static unsigned int s_uAsyncSequence = 0;
+// decode jobs which haven't seen the queue empty yet, guarded by s_asyncStructQueueMutex
+static unsigned int s_uDecodeJobs = 0;
 
-#if CC_TARGET_PLATFORM == CC_PLATFORM_IOS
-    #define CC_ASYNC_TEXTURE_CACHE_USE_NAMED_SEMAPHORE 1
-#else
-    #define CC_ASYNC_TEXTURE_CACHE_USE_NAMED_SEMAPHORE 0
-#endif
-    
-
-#if CC_ASYNC_TEXTURE_CACHE_USE_NAMED_SEMAPHORE
-    #define CC_ASYNC_TEXTURE_CACHE_SEMAPHORE "ccAsync"
-#else
-    static sem_t s_sem;
-#endif
-
-
-static bool need_quit = false;
+// progress of the current loading batch, reset once every request is done
+static unsigned int s_uAsyncLoaded = 0;
+static unsigned int s_uAsyncTotal = 0;
 
-static std::queue<AsyncStruct*>* s_pAsyncStructQueue = NULL;
-static std::queue<ImageInfo*>*   s_pImageQueue = NULL;
+// requests waiting for a decoder, kept as a heap
+static std::vector<AsyncStruct*>* s_pAsyncStructQueue = NULL;
+// decoded images waiting for their upload
+static std::queue<AsyncStruct*>*  s_pImageQueue = NULL;
+// every request which has not been uploaded nor cancelled yet, main thread only
+static std::vector<AsyncStruct*>* s_pAsyncRequests = NULL;
 
 static CCImage::EImageFormat computeImageFormatType(string& filename)
 {
@@ -109,90 +128,194 @@ static CCImage::EImageFormat computeImageFormatType(string& filename)
     return ret;
 }
 
-static void* loadImage(void* data)
+// Decodes pending requests, highest priority first, until the queue is empty.
+// Up to CC_TEXTURE_CACHE_MAX_DECODE_JOBS of them run at the same time.
+class CCTextureDecodeJob : public CCJob
 {
-    AsyncStruct *pAsyncStruct = NULL;
+public:
+    CCTextureDecodeJob()
+    : m_bCounted(true)
+    {
+    }
 
-    while (true)
+    virtual ~CCTextureDecodeJob()
     {
-        // create autorelease pool for iOS
-        CCThread thread;
-        thread.createAutoreleasePool();
-        
-        // wait for rendering thread to ask for loading if s_pAsyncStructQueue is empty
-        int semWaitRet = sem_wait(s_pSem);
-        if( semWaitRet < 0 )
+        // the job system drops the jobs which never ran when it is purged
+        if (m_bCounted)
         {
-            CCLOG( "CCTextureCache async thread semaphore error: %s\n", strerror( errno ) );
-            break;
+            pthread_mutex_lock(&s_asyncStructQueueMutex);
+            --s_uDecodeJobs;
+            pthread_mutex_unlock(&s_asyncStructQueueMutex);
         }
+    }
 
-        std::queue<AsyncStruct*> *pQueue = s_pAsyncStructQueue;
-
-        pthread_mutex_lock(&s_asyncStructQueueMutex);// get async struct from queue
-        if (pQueue->empty())
+    virtual void execute()
+    {
+        while (true)
         {
+            AsyncStruct *pAsyncStruct = NULL;
+
+            pthread_mutex_lock(&s_asyncStructQueueMutex);
+            if (! s_pAsyncStructQueue->empty())
+            {
+                std::pop_heap(s_pAsyncStructQueue->begin(), s_pAsyncStructQueue->end(), AsyncStructCompare());
+                pAsyncStruct = s_pAsyncStructQueue->back();
+                s_pAsyncStructQueue->pop_back();
+            }
+            else
+            {
+                // done under the lock, so a request queued right after this gets a new job
+                --s_uDecodeJobs;
+                m_bCounted = false;
+            }
             pthread_mutex_unlock(&s_asyncStructQueueMutex);
-            if (need_quit)
+
+            if (pAsyncStruct == NULL)
+            {
                 break;
-            else
+            }
+
+            // cancelled requests are no longer referenced by the main thread
+            if (pAsyncStruct->cancelled)
+            {
+                delete pAsyncStruct;
                 continue;
+            }
+
+            const char *filename = pAsyncStruct->filename.c_str();
+
+            // compute image type
+            pAsyncStruct->imageType = computeImageFormatType(pAsyncStruct->filename);
+            if (pAsyncStruct->imageType == CCImage::kFmtUnKnown)
+            {
+                CCLOG("unsupported format %s",filename);
+            }
+            else
+            {
+                // generate image
+                CCImage *pImage = new CCImage();
+                if (pImage && !pImage->initWithImageFileThreadSafe(filename, pAsyncStruct->imageType))
+                {
+                    CC_SAFE_RELEASE_NULL(pImage);
+                    CCLOG("can not load %s", filename);
+                }
+                pAsyncStruct->image = pImage;
+
+                // repack the pixels here rather than on the main thread right before the upload
+                if (pImage)
+                {
+                    pAsyncStruct->pixelFormat = CCTexture2D::pixelFormatForImage(pImage, pAsyncStruct->pixelFormat);
+                    pAsyncStruct->convertedData = CCTexture2D::convertImageData(pImage, pAsyncStruct->pixelFormat, pAsyncStruct->dither);
+                }
+            }
+
+            // failures go through the queue as well, so the main thread can release the target
+            pthread_mutex_lock(&s_ImageInfoMutex);
+            s_pImageQueue->push(pAsyncStruct);
+            pthread_mutex_unlock(&s_ImageInfoMutex);
         }
-        else
-        {
-            pAsyncStruct = pQueue->front();
-            pQueue->pop();
-            pthread_mutex_unlock(&s_asyncStructQueueMutex);
-        }        
+    }
+
+private:
+    bool m_bCounted;
+};
+
+static void scheduleDecodeJobs()
+{
+    pthread_mutex_lock(&s_asyncStructQueueMutex);
+    unsigned int uPending = s_pAsyncStructQueue->size();
+    unsigned int uNewJobs = 0;
+    while (s_uDecodeJobs < MIN(uPending, (unsigned int)CC_TEXTURE_CACHE_MAX_DECODE_JOBS))
+    {
+        ++s_uDecodeJobs;
+        ++uNewJobs;
+    }
+    pthread_mutex_unlock(&s_asyncStructQueueMutex);
 
-        const char *filename = pAsyncStruct->filename.c_str();
+    // scheduled outside of the lock, the job may run inline when there is no worker
+    for (unsigned int i = 0; i < uNewJobs; ++i)
+    {
+        CCTextureDecodeJob *pJob = new CCTextureDecodeJob();
+        CCJobSystem::sharedJobSystem()->scheduleJob(pJob);
+        pJob->release();
+    }
+}
+
+// Main thread. Releases the target of a request and counts it as done.
+static void finishAsyncStruct(AsyncStruct *pAsyncStruct)
+{
+    std::vector<AsyncStruct*>::iterator it = std::find(s_pAsyncRequests->begin(), s_pAsyncRequests->end(), pAsyncStruct);
+    if (it != s_pAsyncRequests->end())
+    {
+        s_pAsyncRequests->erase(it);
+    }
+
+    CC_SAFE_RELEASE_NULL(pAsyncStruct->target);
+    ++s_uAsyncLoaded;
+    --s_nAsyncRefCount;
+}
 
-        // compute image type
-        CCImage::EImageFormat imageType = computeImageFormatType(pAsyncStruct->filename);
-        if (imageType == CCImage::kFmtUnKnown)
+// Turns one decoded image into a texture when CCUploadScheduler has room for it in a frame
+class CCTextureAsyncUploadTask : public CCUploadTask
+{
+public:
+    CCTextureAsyncUploadTask(CCTextureCache *pCache, AsyncStruct *pAsyncStruct)
+    : m_pCache(pCache)
+    , m_pAsyncStruct(pAsyncStruct)
+    {
+    }
+
+    virtual ~CCTextureAsyncUploadTask()
+    {
+        if (m_pAsyncStruct)
         {
-            CCLOG("unsupported format %s",filename);
-            delete pAsyncStruct;
-            
-            continue;
+            // dropped by the upload scheduler before it could run
+            if (! m_pAsyncStruct->cancelled)
+            {
+                finishAsyncStruct(m_pAsyncStruct);
+            }
+            deleteAsyncStruct(m_pAsyncStruct);
         }
-        
-        // generate image            
-        CCImage *pImage = new CCImage();
-        if (pImage && !pImage->initWithImageFileThreadSafe(filename, imageType))
+    }
+
+    virtual unsigned int getUploadSize()
+    {
+        if (m_pAsyncStruct->image == NULL)
         {
-            CC_SAFE_RELEASE(pImage);
-            CCLOG("can not load %s", filename);
-            continue;
+            return 0;
         }
 
-        // generate image info
-        ImageInfo *pImageInfo = new ImageInfo();
-        pImageInfo->asyncStruct = pAsyncStruct;
-        pImageInfo->image = pImage;
-        pImageInfo->imageType = imageType;
-
-        // put the image info into the queue
-        pthread_mutex_lock(&s_ImageInfoMutex);
-        s_pImageQueue->push(pImageInfo);
-        pthread_mutex_unlock(&s_ImageInfoMutex);    
+        // the decoder has picked the texture format already
+        unsigned int uPixels = m_pAsyncStruct->image->getDataLen();
+        switch (m_pAsyncStruct->pixelFormat)
+        {
+        case kCCTexture2DPixelFormat_RGBA8888:
+            return uPixels * 4;
+        case kCCTexture2DPixelFormat_RGB888:
+            return uPixels * 3;
+        case kCCTexture2DPixelFormat_A8:
+            return uPixels;
+        default:
+            return uPixels * 2;
+        }
     }
-    
-    if( s_pSem != NULL )
-    {
-    #if CC_ASYNC_TEXTURE_CACHE_USE_NAMED_SEMAPHORE
-        sem_unlink(CC_ASYNC_TEXTURE_CACHE_SEMAPHORE);
-        sem_close(s_pSem);
-    #else
-        sem_destroy(s_pSem);
-    #endif
-        s_pSem = NULL;
-        delete s_pAsyncStructQueue;
-        delete s_pImageQueue;
+
+    virtual void upload()
+    {
+        // a cancelled request may have outlived its texture cache
+        if (! m_pAsyncStruct->cancelled)
+        {
+            m_pCache->uploadAsyncImage(m_pAsyncStruct);
+        }
+
+        deleteAsyncStruct(m_pAsyncStruct);
+        m_pAsyncStruct = NULL;
     }
-    
-    return 0;
-}
+
+private:
+    CCTextureCache *m_pCache;
+    AsyncStruct *m_pAsyncStruct;
+};
 
 // implementation CCTextureCache
 
@@ -213,15 +336,25 @@ CCTextureCache::CCTextureCache()
     CCAssert(g_sharedTextureCache == NULL, "Attempted to allocate a second instance of a singleton.");
     
     m_pTextures = new CCDictionary();
+    m_pTextures->setInternKeys(true);
+    m_pAsyncDelegate = NULL;
 }
 
 CCTextureCache::~CCTextureCache()
 {
     CCLOGINFO("cocos2d: deallocing CCTextureCache.");
-    need_quit = true;
-    if (s_pSem != NULL)
+
+    if (s_pAsyncRequests)
     {
-        sem_post(s_pSem);
+        // the decoders drop what they haven't started yet, the rest is dropped by the next cache
+        while (! s_pAsyncRequests->empty())
+        {
+            AsyncStruct *pAsyncStruct = s_pAsyncRequests->back();
+            pAsyncStruct->cancelled = true;
+            finishAsyncStruct(pAsyncStruct);
+        }
+        s_nAsyncRefCount = 0;
+        s_uAsyncLoaded = s_uAsyncTotal = 0;
     }
     
     CC_SAFE_RELEASE(m_pTextures);
@@ -243,12 +376,17 @@ CCDictionary* CCTextureCache::snapshotTextures()
     CCDictElement* pElement = NULL;
     CCDICT_FOREACH(m_pTextures, pElement)
     {
-        pRet->setObject(pElement->getObject(), pElement->getStrKey());
+        pRet->setObject(pElement->getObject(), CCFileUtils::sharedFileUtils()->pathForHandle(pElement->getIntKey()));
     }
     return pRet;
 }
 
 void CCTextureCache::addImageAsync(const char *path, CCObject *target, SEL_CallFuncO selector)
+{
+    addImageAsync(path, target, selector, 0);
+}
+
+void CCTextureCache::addImageAsync(const char *path, CCObject *target, SEL_CallFuncO selector, int nPriority)
 {
     CCAssert(path != NULL, "TextureCache: fileimage MUST not be NULL");    
 
@@ -256,12 +394,9 @@ void CCTextureCache::addImageAsync(const char *path, CCObject *target, SEL_CallF
 
     // optimization
 
-    std::string pathKey = path;
-
-    pathKey = CCFileUtils::sharedFileUtils()->fullPathForFilename(pathKey.c_str());
-    texture = (CCTexture2D*)m_pTextures->objectForKey(pathKey.c_str());
+    unsigned int uHandle = CCFileUtils::sharedFileUtils()->fullPathHandleForFilename(path);
+    texture = (CCTexture2D*)m_pTextures->objectForKey((int)uHandle);
 
-    std::string fullpath = pathKey;
     if (texture != NULL)
     {
         if (target && selector)
@@ -272,34 +407,22 @@ void CCTextureCache::addImageAsync(const char *path, CCObject *target, SEL_CallF
         return;
     }
 
+    // only existing files get a handle
+    if (uHandle == 0)
+    {
+        CCLOG("cocos2d: CCTextureCache: can not find %s", path);
+        return;
+    }
+
     // lazy init
-    if (s_pSem == NULL)
+    if (s_pAsyncStructQueue == NULL)
     {             
-#if CC_ASYNC_TEXTURE_CACHE_USE_NAMED_SEMAPHORE
-        s_pSem = sem_open(CC_ASYNC_TEXTURE_CACHE_SEMAPHORE, O_CREAT, 0644, 0);
-        if( s_pSem == SEM_FAILED )
-        {
-            CCLOG( "CCTextureCache async thread semaphore init error: %s\n", strerror( errno ) );
-            s_pSem = NULL;
-            return;
-        }
-#else
-        int semInitRet = sem_init(&s_sem, 0, 0);
-        if( semInitRet < 0 )
-        {
-            CCLOG( "CCTextureCache async thread semaphore init error: %s\n", strerror( errno ) );
-            return;
-        }
-        s_pSem = &s_sem;
-#endif
-        s_pAsyncStructQueue = new queue<AsyncStruct*>();
-        s_pImageQueue = new queue<ImageInfo*>();        
+        s_pAsyncStructQueue = new std::vector<AsyncStruct*>();
+        s_pImageQueue = new queue<AsyncStruct*>();        
+        s_pAsyncRequests = new std::vector<AsyncStruct*>();
         
         pthread_mutex_init(&s_asyncStructQueueMutex, NULL);
         pthread_mutex_init(&s_ImageInfoMutex, NULL);
-        pthread_create(&s_loadingThread, NULL, loadImage, NULL);
-
-        need_quit = false;
     }
 
     if (0 == s_nAsyncRefCount)
@@ -308,6 +431,7 @@ void CCTextureCache::addImageAsync(const char *path, CCObject *target, SEL_CallF
     }
 
     ++s_nAsyncRefCount;
+    ++s_uAsyncTotal;
 
     if (target)
     {
@@ -316,74 +440,173 @@ void CCTextureCache::addImageAsync(const char *path, CCObject *target, SEL_CallF
 
     // generate async struct
     AsyncStruct *data = new AsyncStruct();
-    data->filename = fullpath.c_str();
+    data->filename = CCFileUtils::sharedFileUtils()->pathForHandle(uHandle);
+    data->handle = uHandle;
     data->target = target;
     data->selector = selector;
+    data->priority = nPriority;
+    data->sequence = s_uAsyncSequence++;
+    data->cancelled = false;
+    data->image = NULL;
+    data->imageType = CCImage::kFmtUnKnown;
+    data->pixelFormat = CCTexture2D::defaultAlphaPixelFormat();
+    data->dither = CCTexture2D::isDitherEnabled();
+    data->convertedData = NULL;
+
+    s_pAsyncRequests->push_back(data);
 
     // add async struct into queue
     pthread_mutex_lock(&s_asyncStructQueueMutex);
-    s_pAsyncStructQueue->push(data);
+    s_pAsyncStructQueue->push_back(data);
+    std::push_heap(s_pAsyncStructQueue->begin(), s_pAsyncStructQueue->end(), AsyncStructCompare());
     pthread_mutex_unlock(&s_asyncStructQueueMutex);
 
-    sem_post(s_pSem);
+    scheduleDecodeJobs();
 }
 
-void CCTextureCache::addImageAsyncCallBack(float dt)
+void CCTextureCache::cancelImageAsync(const char *path)
 {
-    // the image is generated in loading thread
-    std::queue<ImageInfo*> *imagesQueue = s_pImageQueue;
+    CCAssert(path != NULL, "TextureCache: fileimage MUST not be NULL");
 
-    pthread_mutex_lock(&s_ImageInfoMutex);
-    if (imagesQueue->empty())
+    if (s_pAsyncRequests == NULL)
     {
-        pthread_mutex_unlock(&s_ImageInfoMutex);
+        return;
     }
-    else
+
+    unsigned int uHandle = CCFileUtils::sharedFileUtils()->fullPathHandleForFilename(path);
+
+    for (unsigned int i = s_pAsyncRequests->size(); i > 0; --i)
+    {
+        AsyncStruct *pAsyncStruct = (*s_pAsyncRequests)[i - 1];
+        if (pAsyncStruct->handle == uHandle)
+        {
+            pAsyncStruct->cancelled = true;
+            finishAsyncStruct(pAsyncStruct);
+        }
+    }
+
+    notifyAsyncProgress();
+}
+
+void CCTextureCache::cancelImageAsyncForTarget(CCObject *target)
+{
+    CCAssert(target != NULL, "TextureCache: target MUST not be NULL");
+
+    if (s_pAsyncRequests == NULL)
+    {
+        return;
+    }
+
+    for (unsigned int i = s_pAsyncRequests->size(); i > 0; --i)
+    {
+        AsyncStruct *pAsyncStruct = (*s_pAsyncRequests)[i - 1];
+        if (pAsyncStruct->target == target)
+        {
+            pAsyncStruct->cancelled = true;
+            finishAsyncStruct(pAsyncStruct);
+        }
+    }
+
+    notifyAsyncProgress();
+}
+
+void CCTextureCache::notifyAsyncProgress()
+{
+    if (s_uAsyncTotal == 0)
+    {
+        return;
+    }
+
+    unsigned int uLoaded = s_uAsyncLoaded;
+    unsigned int uTotal = s_uAsyncTotal;
+
+    // a new batch begins with the next request
+    if (uLoaded == uTotal)
+    {
+        s_uAsyncLoaded = s_uAsyncTotal = 0;
+    }
+
+    if (m_pAsyncDelegate)
+    {
+        m_pAsyncDelegate->textureCacheAsyncProgress(uLoaded, uTotal);
+    }
+
+    if (0 == s_nAsyncRefCount)
+    {
+        CCDirector::sharedDirector()->getScheduler()->unscheduleSelector(schedule_selector(CCTextureCache::addImageAsyncCallBack), this);
+    }
+}
+
+void CCTextureCache::addImageAsyncCallBack(float dt)
+{
+    // the images are generated by the decode jobs, CCUploadScheduler spreads their uploads over frames
+    std::queue<AsyncStruct*> *imagesQueue = s_pImageQueue;
+
+    while (true)
     {
-        ImageInfo *pImageInfo = imagesQueue->front();
+        pthread_mutex_lock(&s_ImageInfoMutex);
+        if (imagesQueue->empty())
+        {
+            pthread_mutex_unlock(&s_ImageInfoMutex);
+            break;
+        }
+        AsyncStruct *pAsyncStruct = imagesQueue->front();
         imagesQueue->pop();
         pthread_mutex_unlock(&s_ImageInfoMutex);
 
-        AsyncStruct *pAsyncStruct = pImageInfo->asyncStruct;
-        CCImage *pImage = pImageInfo->image;
+        if (pAsyncStruct->cancelled)
+        {
+            // already finished by the cancel call
+            deleteAsyncStruct(pAsyncStruct);
+            continue;
+        }
+
+        CCTextureAsyncUploadTask *pTask = new CCTextureAsyncUploadTask(this, pAsyncStruct);
+        CCUploadScheduler::sharedUploadScheduler()->scheduleUpload(pTask);
+        pTask->release();
+    }
+}
 
-        CCObject *target = pAsyncStruct->target;
-        SEL_CallFuncO selector = pAsyncStruct->selector;
-        const char* filename = pAsyncStruct->filename.c_str();
+void CCTextureCache::uploadAsyncImage(AsyncStruct *pAsyncStruct)
+{
+    CCImage *pImage = pAsyncStruct->image;
+    CCObject *target = pAsyncStruct->target;
+    SEL_CallFuncO selector = pAsyncStruct->selector;
 
-        // generate texture in render thread
-        CCTexture2D *texture = new CCTexture2D();
+    if (pImage)
+    {
+        // another request for the same file may have been uploaded already
+        CCTexture2D *texture = (CCTexture2D*)m_pTextures->objectForKey((int)pAsyncStruct->handle);
+        if (texture == NULL)
+        {
+            // generate texture in render thread
+            texture = new CCTexture2D();
 #if 0 //TODO: (CC_TARGET_PLATFORM == CC_PLATFORM_IOS)
-        texture->initWithImage(pImage, kCCResolutioniPhone);
+            texture->initWithImage(pImage, kCCResolutioniPhone);
 #else
-        texture->initWithImage(pImage);
+            // the decoder has converted the pixels already
+            texture->initWithImage(pImage, pAsyncStruct->pixelFormat, pAsyncStruct->convertedData);
 #endif
 
 #if CC_ENABLE_CACHE_TEXTURE_DATA
-       // cache the texture file name
-       VolatileTexture::addImageTexture(texture, filename, pImageInfo->imageType);
+           // cache the texture file name
+           const char* filename = pAsyncStruct->filename.c_str();
+           VolatileTexture::addImageTexture(texture, filename, pAsyncStruct->imageType);
 #endif
 
-        // cache the texture
-        m_pTextures->setObject(texture, filename);
-        texture->autorelease();
+            // cache the texture
+            m_pTextures->setObject(texture, (int)pAsyncStruct->handle);
+            texture->autorelease();
+        }
 
         if (target && selector)
         {
             (target->*selector)(texture);
-            target->release();
-        }        
-
-        pImage->release();
-        delete pAsyncStruct;
-        delete pImageInfo;
-
-        --s_nAsyncRefCount;
-        if (0 == s_nAsyncRefCount)
-        {
-            CCDirector::sharedDirector()->getScheduler()->unscheduleSelector(schedule_selector(CCTextureCache::addImageAsyncCallBack), this);
         }
     }
+
+    finishAsyncStruct(pAsyncStruct);
+    notifyAsyncProgress();
 }
 
 CCTexture2D * CCTextureCache::addImage(const char * path)
@@ -399,15 +622,22 @@ CCTexture2D * CCTextureCache::addImage(const char * path)
     //pthread_mutex_lock(m_pDictLock);
 
     // remove possible -HD suffix to prevent caching the same image twice (issue #1040)
-    std::string pathKey = path;
-
-    pathKey = CCFileUtils::sharedFileUtils()->fullPathForFilename(pathKey.c_str());
-    texture = (CCTexture2D*)m_pTextures->objectForKey(pathKey.c_str());
+    // a hit costs one lookup of the interned path and one of the texture
+    unsigned int uHandle = CCFileUtils::sharedFileUtils()->fullPathHandleForFilename(path);
+    texture = (CCTexture2D*)m_pTextures->objectForKey((int)uHandle);
 
-    std::string fullpath = pathKey; // (CCFileUtils::sharedFileUtils()->fullPathFromRelativePath(path));
-    if( ! texture ) 
+    if( ! texture && uHandle == 0 )
     {
-        std::string lowerCase(pathKey);
+        // only existing files get a handle
+        CCLOG("cocos2d: Couldn't add image:%s in CCTextureCache", path);
+    }
+    else if( ! texture ) 
+    {
+        std::string fullpath = CCFileUtils::sharedFileUtils()->pathForHandle(uHandle);
+
+        // only the file name tells the format
+        size_t uNameStart = fullpath.find_last_of('/');
+        std::string lowerCase(fullpath, uNameStart == std::string::npos ? 0 : uNameStart + 1);
         for (unsigned int i = 0; i < lowerCase.length(); ++i)
         {
             lowerCase[i] = tolower(lowerCase[i]);
@@ -454,7 +684,7 @@ CCTexture2D * CCTextureCache::addImage(const char * path)
                     VolatileTexture::addImageTexture(texture, fullpath.c_str(), eImageFormat);
 #endif
 
-                    m_pTextures->setObject(texture, pathKey.c_str());
+                    m_pTextures->setObject(texture, (int)uHandle);
                     texture->release();
                 }
                 else
@@ -479,9 +709,10 @@ CCTexture2D* CCTextureCache::addPVRTCImage(const char* path, int bpp, bool hasAl
 
     CCTexture2D * texture;
 
-    std::string temp(path);
+    // the path is interned once the texture is loaded
+    unsigned int uHandle = CCFileUtils::sharedFileUtils()->findHandleForPath(path);
     
-    if ( (texture = (CCTexture2D*)m_pTextures->objectForKey(temp.c_str())) )
+    if ( (texture = (CCTexture2D*)m_pTextures->objectForKey((int)uHandle)) )
     {
         return texture;
     }
@@ -497,7 +728,7 @@ CCTexture2D* CCTextureCache::addPVRTCImage(const char* path, int bpp, bool hasAl
     if( texture->initWithPVRTCData(pData, 0, bpp, hasAlpha, width,
                                    (bpp==2 ? kCCTexture2DPixelFormat_PVRTC2 : kCCTexture2DPixelFormat_PVRTC4)))
     {
-        m_pTextures->setObject(texture, temp.c_str());
+        m_pTextures->setObject(texture, (int)CCFileUtils::sharedFileUtils()->handleForPath(path));
         texture->autorelease();
     }
     else
@@ -516,8 +747,10 @@ CCTexture2D * CCTextureCache::addPVRImage(const char* path)
 
     CCTexture2D* texture = NULL;
     std::string key(path);
+    // the path is interned once the texture is loaded
+    unsigned int uHandle = CCFileUtils::sharedFileUtils()->findHandleForPath(path);
     
-    if( (texture = (CCTexture2D*)m_pTextures->objectForKey(key.c_str())) ) 
+    if( (texture = (CCTexture2D*)m_pTextures->objectForKey((int)uHandle)) ) 
     {
         return texture;
     }
@@ -531,7 +764,7 @@ CCTexture2D * CCTextureCache::addPVRImage(const char* path)
         // cache the texture file name
         VolatileTexture::addImageTexture(texture, fullpath.c_str(), CCImage::kFmtRawData);
 #endif
-        m_pTextures->setObject(texture, key.c_str());
+        m_pTextures->setObject(texture, (int)CCFileUtils::sharedFileUtils()->handleForPath(path));
         texture->autorelease();
     }
     else
@@ -549,10 +782,15 @@ CCTexture2D* CCTextureCache::addUIImage(CCImage *image, const char *key)
 
     CCTexture2D * texture = NULL;
     // textureForKey() use full path,so the key should be full path
-    std::string forKey;
+    unsigned int uHandle = 0;
     if (key)
     {
-        forKey = CCFileUtils::sharedFileUtils()->fullPathForFilename(key);
+        uHandle = CCFileUtils::sharedFileUtils()->fullPathHandleForFilename(key);
+        // keys which aren't files are interned as is
+        if (uHandle == 0)
+        {
+            uHandle = CCFileUtils::sharedFileUtils()->handleForPath(key);
+        }
     }
 
     // Don't have to lock here, because addImageAsync() will not 
@@ -561,7 +799,7 @@ CCTexture2D* CCTextureCache::addUIImage(CCImage *image, const char *key)
     do 
     {
         // If key is nil, then create a new texture each time
-        if(key && (texture = (CCTexture2D *)m_pTextures->objectForKey(forKey.c_str())))
+        if(key && (texture = (CCTexture2D *)m_pTextures->objectForKey((int)uHandle)))
         {
             break;
         }
@@ -572,7 +810,7 @@ CCTexture2D* CCTextureCache::addUIImage(CCImage *image, const char *key)
 
         if(key && texture)
         {
-            m_pTextures->setObject(texture, forKey.c_str());
+            m_pTextures->setObject(texture, (int)uHandle);
             texture->autorelease();
         }
         else
@@ -602,11 +840,11 @@ void CCTextureCache::removeUnusedTextures()
     CCDictElement* pElement = NULL;
     CCDICT_FOREACH(m_pTextures, pElement)
     {
-        CCLOG("cocos2d: CCTextureCache: texture: %s", pElement->getStrKey());
+        CCLOG("cocos2d: CCTextureCache: texture: %s", CCFileUtils::sharedFileUtils()->pathForHandle(pElement->getIntKey()).c_str());
         CCTexture2D *value = (CCTexture2D*)pElement->getObject();
         if (value->retainCount() == 1)
         {
-            CCLOG("cocos2d: CCTextureCache: removing unused texture: %s", pElement->getStrKey());
+            CCLOG("cocos2d: CCTextureCache: removing unused texture: %s", CCFileUtils::sharedFileUtils()->pathForHandle(pElement->getIntKey()).c_str());
             m_pTextures->removeObjectForElememt(pElement);
         }
     }
@@ -621,7 +859,7 @@ void CCTextureCache::removeUnusedTextures()
         list<CCDictElement*> elementToRemove;
         CCDICT_FOREACH(m_pTextures, pElement)
         {
-            CCLOG("cocos2d: CCTextureCache: texture: %s", pElement->getStrKey());
+            CCLOG("cocos2d: CCTextureCache: texture: %s", CCFileUtils::sharedFileUtils()->pathForHandle(pElement->getIntKey()).c_str());
             CCTexture2D *value = (CCTexture2D*)pElement->getObject();
             if (value->retainCount() == 1)
             {
@@ -632,7 +870,7 @@ void CCTextureCache::removeUnusedTextures()
         // remove elements
         for (list<CCDictElement*>::iterator iter = elementToRemove.begin(); iter != elementToRemove.end(); ++iter)
         {
-            CCLOG("cocos2d: CCTextureCache: removing unused texture: %s", (*iter)->getStrKey());
+            CCLOG("cocos2d: CCTextureCache: removing unused texture: %s", CCFileUtils::sharedFileUtils()->pathForHandle((*iter)->getIntKey()).c_str());
             m_pTextures->removeObjectForElememt(*iter);
         }
     }
@@ -656,13 +894,13 @@ void CCTextureCache::removeTextureForKey(const char *textureKeyName)
         return;
     }
 
-    string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(textureKeyName);
-    m_pTextures->removeObjectForKey(fullPath);
+    unsigned int uHandle = CCFileUtils::sharedFileUtils()->fullPathHandleForFilename(textureKeyName);
+    m_pTextures->removeObjectForKey((int)uHandle);
 }
 
 CCTexture2D* CCTextureCache::textureForKey(const char* key)
 {
-    return (CCTexture2D*)m_pTextures->objectForKey(CCFileUtils::sharedFileUtils()->fullPathForFilename(key));
+    return (CCTexture2D*)m_pTextures->objectForKey((int)CCFileUtils::sharedFileUtils()->fullPathHandleForFilename(key));
 }
 
 void CCTextureCache::reloadAllTextures()
@@ -687,7 +925,7 @@ void CCTextureCache::dumpCachedTextureInfo()
         totalBytes += bytes;
         count++;
         CCLOG("cocos2d: \"%s\" rc=%lu id=%lu %lu x %lu @ %ld bpp => %lu KB",
-               pElement->getStrKey(),
+               CCFileUtils::sharedFileUtils()->pathForHandle(pElement->getIntKey()).c_str(),
                (long)tex->retainCount(),
                (long)tex->getName(),
                (long)tex->getPixelsWide(),
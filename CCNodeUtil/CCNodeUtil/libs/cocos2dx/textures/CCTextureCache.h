@@ -42,12 +42,28 @@ NS_CC_BEGIN
 
 class CCLock;
 class CCImage;
+struct _AsyncStruct;
 
 /**
  * @addtogroup textures
  * @{
  */
 
+/** @brief Receives the progress of CCTextureCache::addImageAsync, e.g. to drive a loading bar.
+ @since v2.1.x
+ */
+class CC_DLL CCTextureCacheAsyncDelegate
+{
+public:
+    virtual ~CCTextureCacheAsyncDelegate() {}
+
+    /** Called on the main thread whenever asynchronous requests have finished, been cancelled or failed.
+     uLoaded counts the finished requests of the current batch, out of uTotal. A batch ends, and the
+     counters restart, once uLoaded reaches uTotal.
+     */
+    virtual void textureCacheAsyncProgress(unsigned int uLoaded, unsigned int uTotal) = 0;
+};
+
 /** @brief Singleton that handles the loading of textures
 * Once the texture is loaded, the next time it will return
 * a reference of the previously loaded texture reducing GPU & CPU memory
@@ -55,13 +71,22 @@ class CCImage;
 class CC_DLL CCTextureCache : public CCObject
 {
 protected:
+    //! textures keyed on the CCFileUtils handle of their full path
     CCDictionary* m_pTextures;
     //pthread_mutex_t                *m_pDictLock;
 
+    /** receives the progress of the asynchronous loads, not retained
+     @since v2.1.x
+     */
+    CC_SYNTHESIZE(CCTextureCacheAsyncDelegate*, m_pAsyncDelegate, AsyncDelegate);
 
 private:
     /// todo: void addImageWithAsyncObject(CCAsyncObject* async);
     void addImageAsyncCallBack(float dt);
+    void notifyAsyncProgress();
+    void uploadAsyncImage(struct _AsyncStruct *pAsyncStruct);
+
+    friend class CCTextureAsyncUploadTask;
 
 public:
 
@@ -98,6 +123,23 @@ public:
     
     void addImageAsync(const char *path, CCObject *target, SEL_CallFuncO selector);
 
+    /** Same as addImageAsync(path, target, selector), but pending requests with a higher nPriority are decoded first.
+    * Images are decoded by up to CC_TEXTURE_CACHE_MAX_DECODE_JOBS CCJobSystem jobs in parallel, and
+    * uploaded by CCUploadScheduler within its per-frame budget. The callback is not called if the image can't be loaded.
+    * @since v2.1.x
+    */
+    void addImageAsync(const char *path, CCObject *target, SEL_CallFuncO selector, int nPriority);
+
+    /** Cancels the pending asynchronous loads of a file. Their callbacks won't be called and their targets are released.
+    * @since v2.1.x
+    */
+    void cancelImageAsync(const char *path);
+
+    /** Cancels the pending asynchronous loads whose callback target is target, e.g. when a scene is left before it finished loading.
+    * @since v2.1.x
+    */
+    void cancelImageAsyncForTarget(CCObject *target);
+
     /* Returns a Texture2D object given an CGImageRef image
     * If the image was not previously loaded, it will create a new CCTexture2D object and it will return it.
     * Otherwise it will return a reference of a previously loaded image
@@ -33,6 +33,7 @@ THE SOFTWARE.
 #include "platform/CCFileUtils.h"
 #include "support/zip_support/ZipUtils.h"
 #include "shaders/ccGLStateCache.h"
+#include "support/CCUploadScheduler.h"
 #include <ctype.h>
 #include <cctype>
 
@@ -560,6 +561,7 @@ bool CCTexturePVR::createGLTexture()
         {
 			glTexImage2D(GL_TEXTURE_2D, i, internalFormat, width, height, 0, format, type, data);
         }
+        CCUploadScheduler::sharedUploadScheduler()->reportUpload(datalen);
         
 		if (i > 0 && (width != height || ccNextPOT(width) != width ))
         {
@@ -0,0 +1,433 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "ccPixelConversion.h"
+#include "ccConfig.h"
+#include "ccMacros.h"
+#include "support/CCJobSystem.h"
+
+#if CC_TEXTURE_CONVERSION_USE_SIMD && defined(__SSE2__)
+#include <emmintrin.h>
+#define CC_PIXEL_SSE2 1
+#elif CC_TEXTURE_CONVERSION_USE_SIMD && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#include <arm_neon.h>
+#define CC_PIXEL_NEON 1
+#endif
+
+NS_CC_BEGIN
+
+// number of pixels converted by one parallelFor range
+#define kCCPixelConversionGrain (64 * 1024)
+
+// 4x4 ordered (Bayer) dither matrix
+static const unsigned char s_ditherMatrix[4][4] =
+{
+    {  0,  8,  2, 10 },
+    { 12,  4, 14,  6 },
+    {  3, 11,  1,  9 },
+    { 15,  7, 13,  5 },
+};
+
+// Per channel offsets added to the pixels of one row before they are truncated.
+// The 4 offsets of the row are repeated twice so NEON can load 8 lanes at once.
+typedef struct _ccDitherRow
+{
+    unsigned char r[8];
+    unsigned char g[8];
+    unsigned char b[8];
+    unsigned char a[8];
+} ccDitherRow;
+
+typedef void (*ccConvertRowFunc)(const unsigned char *pSrc, unsigned char *pDst, unsigned int width, const ccDitherRow *pDither);
+
+typedef struct _ccConversion
+{
+    const unsigned char *pSrc;
+    unsigned char       *pDst;
+    unsigned int        width;
+    unsigned int        srcStride;
+    unsigned int        dstStride;
+    ccConvertRowFunc    pfnRow;
+    ccDitherRow         dither[4];     // one per row of the dither matrix
+} ccConversion;
+
+// offset which spreads the bits lost by truncating a channel to uBits bits, 0 if the channel isn't dithered
+static inline unsigned char ditherOffset(unsigned int d, unsigned int uBits)
+{
+    return (uBits >= 4 && uBits < 8) ? (unsigned char)(d >> (uBits - 4)) : 0;
+}
+
+static void initDither(ccConversion *pConversion, bool bDither, unsigned int rBits, unsigned int gBits, unsigned int bBits, unsigned int aBits)
+{
+    for (unsigned int y = 0; y < 4; ++y)
+    {
+        ccDitherRow *pRow = &pConversion->dither[y];
+        for (unsigned int i = 0; i < 8; ++i)
+        {
+            unsigned int d = bDither ? s_ditherMatrix[y][i & 3] : 0;
+            pRow->r[i] = ditherOffset(d, rBits);
+            pRow->g[i] = ditherOffset(d, gBits);
+            pRow->b[i] = ditherOffset(d, bBits);
+            pRow->a[i] = ditherOffset(d, aBits);
+        }
+    }
+}
+
+// saturating add, the scalar twin of _mm_adds_epu8 and vqadd_u8
+static inline unsigned int addSaturate(unsigned int c, unsigned int d)
+{
+    c += d;
+    return c > 255 ? 255 : c;
+}
+
+#if CC_PIXEL_SSE2
+// interleaves the offsets of 4 pixels the way they are laid out in memory
+static inline __m128i loadDither(const ccDitherRow *pDither)
+{
+    unsigned char offsets[16];
+    for (unsigned int k = 0; k < 4; ++k)
+    {
+        offsets[k * 4 + 0] = pDither->r[k];
+        offsets[k * 4 + 1] = pDither->g[k];
+        offsets[k * 4 + 2] = pDither->b[k];
+        offsets[k * 4 + 3] = pDither->a[k];
+    }
+    return _mm_loadu_si128((const __m128i*)offsets);
+}
+
+// sign extends the low 16 bits of every lane, so _mm_packs_epi32 doesn't saturate them
+static inline __m128i signExtend16(__m128i v)
+{
+    return _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+}
+#endif
+
+// "RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA" to "RRRRRGGGGGGBBBBB"
+static void convertRowRGBA8888ToRGB565(const unsigned char *pSrc, unsigned char *pDst, unsigned int width, const ccDitherRow *pDither)
+{
+    unsigned short *pOut = (unsigned short*)pDst;
+    unsigned int x = 0;
+#if CC_PIXEL_SSE2
+    const __m128i vDither = loadDither(pDither);
+    const __m128i vMaskR = _mm_set1_epi32(0xF8);
+    const __m128i vMaskG = _mm_set1_epi32(0xFC00);
+    const __m128i vMaskB = _mm_set1_epi32(0xF80000);
+    __m128i v[2];
+    for (; x + 8 <= width; x += 8, pSrc += 32)
+    {
+        for (int k = 0; k < 2; ++k)
+        {
+            __m128i p = _mm_adds_epu8(_mm_loadu_si128((const __m128i*)(pSrc + k * 16)), vDither);
+            v[k] = signExtend16(_mm_or_si128(_mm_or_si128(
+                _mm_slli_epi32(_mm_and_si128(p, vMaskR), 8),
+                _mm_srli_epi32(_mm_and_si128(p, vMaskG), 5)),
+                _mm_srli_epi32(_mm_and_si128(p, vMaskB), 19)));
+        }
+        _mm_storeu_si128((__m128i*)(pOut + x), _mm_packs_epi32(v[0], v[1]));
+    }
+#elif CC_PIXEL_NEON
+    const uint8x8_t vDitherR = vld1_u8(pDither->r);
+    const uint8x8_t vDitherG = vld1_u8(pDither->g);
+    const uint8x8_t vDitherB = vld1_u8(pDither->b);
+    for (; x + 8 <= width; x += 8, pSrc += 32)
+    {
+        uint8x8x4_t p = vld4_u8(pSrc);
+        uint16x8_t r = vmovl_u8(vshr_n_u8(vqadd_u8(p.val[0], vDitherR), 3));
+        uint16x8_t g = vmovl_u8(vshr_n_u8(vqadd_u8(p.val[1], vDitherG), 2));
+        uint16x8_t b = vmovl_u8(vshr_n_u8(vqadd_u8(p.val[2], vDitherB), 3));
+        vst1q_u16(pOut + x, vorrq_u16(vorrq_u16(vshlq_n_u16(r, 11), vshlq_n_u16(g, 5)), b));
+    }
+#endif
+    for (; x < width; ++x, pSrc += 4)
+    {
+        unsigned int i = x & 3;
+        pOut[x] =
+        ((addSaturate(pSrc[0], pDither->r[i]) >> 3) << 11) |  // R
+        ((addSaturate(pSrc[1], pDither->g[i]) >> 2) << 5)  |  // G
+        ((addSaturate(pSrc[2], pDither->b[i]) >> 3) << 0);    // B
+    }
+}
+
+// "RRRRRRRRGGGGGGGGBBBBBBBB" to "RRRRRGGGGGGBBBBB"
+static void convertRowRGB888ToRGB565(const unsigned char *pSrc, unsigned char *pDst, unsigned int width, const ccDitherRow *pDither)
+{
+    unsigned short *pOut = (unsigned short*)pDst;
+    unsigned int x = 0;
+#if CC_PIXEL_NEON
+    const uint8x8_t vDitherR = vld1_u8(pDither->r);
+    const uint8x8_t vDitherG = vld1_u8(pDither->g);
+    const uint8x8_t vDitherB = vld1_u8(pDither->b);
+    for (; x + 8 <= width; x += 8, pSrc += 24)
+    {
+        uint8x8x3_t p = vld3_u8(pSrc);
+        uint16x8_t r = vmovl_u8(vshr_n_u8(vqadd_u8(p.val[0], vDitherR), 3));
+        uint16x8_t g = vmovl_u8(vshr_n_u8(vqadd_u8(p.val[1], vDitherG), 2));
+        uint16x8_t b = vmovl_u8(vshr_n_u8(vqadd_u8(p.val[2], vDitherB), 3));
+        vst1q_u16(pOut + x, vorrq_u16(vorrq_u16(vshlq_n_u16(r, 11), vshlq_n_u16(g, 5)), b));
+    }
+#endif
+    // 3 byte pixels don't fit SSE2 registers without shuffles, images without alpha are rare enough
+    for (; x < width; ++x, pSrc += 3)
+    {
+        unsigned int i = x & 3;
+        pOut[x] =
+        ((addSaturate(pSrc[0], pDither->r[i]) >> 3) << 11) |  // R
+        ((addSaturate(pSrc[1], pDither->g[i]) >> 2) << 5)  |  // G
+        ((addSaturate(pSrc[2], pDither->b[i]) >> 3) << 0);    // B
+    }
+}
+
+// "RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA" to "RRRRGGGGBBBBAAAA"
+static void convertRowRGBA8888ToRGBA4444(const unsigned char *pSrc, unsigned char *pDst, unsigned int width, const ccDitherRow *pDither)
+{
+    unsigned short *pOut = (unsigned short*)pDst;
+    unsigned int x = 0;
+#if CC_PIXEL_SSE2
+    const __m128i vDither = loadDither(pDither);
+    const __m128i vMaskR = _mm_set1_epi32(0xF0);
+    const __m128i vMaskG = _mm_set1_epi32(0xF000);
+    const __m128i vMaskB = _mm_set1_epi32(0xF00000);
+    __m128i v[2];
+    for (; x + 8 <= width; x += 8, pSrc += 32)
+    {
+        for (int k = 0; k < 2; ++k)
+        {
+            __m128i p = _mm_adds_epu8(_mm_loadu_si128((const __m128i*)(pSrc + k * 16)), vDither);
+            v[k] = signExtend16(_mm_or_si128(
+                _mm_or_si128(_mm_slli_epi32(_mm_and_si128(p, vMaskR), 8), _mm_srli_epi32(_mm_and_si128(p, vMaskG), 4)),
+                _mm_or_si128(_mm_srli_epi32(_mm_and_si128(p, vMaskB), 16), _mm_srli_epi32(p, 28))));
+        }
+        _mm_storeu_si128((__m128i*)(pOut + x), _mm_packs_epi32(v[0], v[1]));
+    }
+#elif CC_PIXEL_NEON
+    const uint8x8_t vDitherR = vld1_u8(pDither->r);
+    const uint8x8_t vDitherG = vld1_u8(pDither->g);
+    const uint8x8_t vDitherB = vld1_u8(pDither->b);
+    const uint8x8_t vDitherA = vld1_u8(pDither->a);
+    for (; x + 8 <= width; x += 8, pSrc += 32)
+    {
+        uint8x8x4_t p = vld4_u8(pSrc);
+        uint16x8_t r = vmovl_u8(vshr_n_u8(vqadd_u8(p.val[0], vDitherR), 4));
+        uint16x8_t g = vmovl_u8(vshr_n_u8(vqadd_u8(p.val[1], vDitherG), 4));
+        uint16x8_t b = vmovl_u8(vshr_n_u8(vqadd_u8(p.val[2], vDitherB), 4));
+        uint16x8_t a = vmovl_u8(vshr_n_u8(vqadd_u8(p.val[3], vDitherA), 4));
+        vst1q_u16(pOut + x, vorrq_u16(vorrq_u16(vshlq_n_u16(r, 12), vshlq_n_u16(g, 8)),
+                                      vorrq_u16(vshlq_n_u16(b, 4), a)));
+    }
+#endif
+    for (; x < width; ++x, pSrc += 4)
+    {
+        unsigned int i = x & 3;
+        pOut[x] =
+        ((addSaturate(pSrc[0], pDither->r[i]) >> 4) << 12) | // R
+        ((addSaturate(pSrc[1], pDither->g[i]) >> 4) <<  8) | // G
+        ((addSaturate(pSrc[2], pDither->b[i]) >> 4) <<  4) | // B
+        ((addSaturate(pSrc[3], pDither->a[i]) >> 4) <<  0);  // A
+    }
+}
+
+// "RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA" to "RRRRRGGGGGBBBBBA"
+static void convertRowRGBA8888ToRGB5A1(const unsigned char *pSrc, unsigned char *pDst, unsigned int width, const ccDitherRow *pDither)
+{
+    unsigned short *pOut = (unsigned short*)pDst;
+    unsigned int x = 0;
+#if CC_PIXEL_SSE2
+    const __m128i vDither = loadDither(pDither);
+    const __m128i vMaskR = _mm_set1_epi32(0xF8);
+    const __m128i vMaskG = _mm_set1_epi32(0xF800);
+    const __m128i vMaskB = _mm_set1_epi32(0xF80000);
+    __m128i v[2];
+    for (; x + 8 <= width; x += 8, pSrc += 32)
+    {
+        for (int k = 0; k < 2; ++k)
+        {
+            __m128i p = _mm_adds_epu8(_mm_loadu_si128((const __m128i*)(pSrc + k * 16)), vDither);
+            v[k] = signExtend16(_mm_or_si128(
+                _mm_or_si128(_mm_slli_epi32(_mm_and_si128(p, vMaskR), 8), _mm_srli_epi32(_mm_and_si128(p, vMaskG), 5)),
+                _mm_or_si128(_mm_srli_epi32(_mm_and_si128(p, vMaskB), 18), _mm_srli_epi32(p, 31))));
+        }
+        _mm_storeu_si128((__m128i*)(pOut + x), _mm_packs_epi32(v[0], v[1]));
+    }
+#elif CC_PIXEL_NEON
+    const uint8x8_t vDitherR = vld1_u8(pDither->r);
+    const uint8x8_t vDitherG = vld1_u8(pDither->g);
+    const uint8x8_t vDitherB = vld1_u8(pDither->b);
+    for (; x + 8 <= width; x += 8, pSrc += 32)
+    {
+        uint8x8x4_t p = vld4_u8(pSrc);
+        uint16x8_t r = vmovl_u8(vshr_n_u8(vqadd_u8(p.val[0], vDitherR), 3));
+        uint16x8_t g = vmovl_u8(vshr_n_u8(vqadd_u8(p.val[1], vDitherG), 3));
+        uint16x8_t b = vmovl_u8(vshr_n_u8(vqadd_u8(p.val[2], vDitherB), 3));
+        uint16x8_t a = vmovl_u8(vshr_n_u8(p.val[3], 7));
+        vst1q_u16(pOut + x, vorrq_u16(vorrq_u16(vshlq_n_u16(r, 11), vshlq_n_u16(g, 6)),
+                                      vorrq_u16(vshlq_n_u16(b, 1), a)));
+    }
+#endif
+    for (; x < width; ++x, pSrc += 4)
+    {
+        unsigned int i = x & 3;
+        pOut[x] =
+        ((addSaturate(pSrc[0], pDither->r[i]) >> 3) << 11) | // R
+        ((addSaturate(pSrc[1], pDither->g[i]) >> 3) <<  6) | // G
+        ((addSaturate(pSrc[2], pDither->b[i]) >> 3) <<  1) | // B
+        ((pSrc[3] >> 7) << 0);                               // A
+    }
+}
+
+// "RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA" to "AAAAAAAA"
+static void convertRowRGBA8888ToA8(const unsigned char *pSrc, unsigned char *pDst, unsigned int width, const ccDitherRow *pDither)
+{
+    CC_UNUSED_PARAM(pDither);
+    unsigned int x = 0;
+#if CC_PIXEL_SSE2
+    __m128i v[4];
+    for (; x + 16 <= width; x += 16, pSrc += 64)
+    {
+        for (int k = 0; k < 4; ++k)
+        {
+            v[k] = _mm_srli_epi32(_mm_loadu_si128((const __m128i*)(pSrc + k * 16)), 24);
+        }
+        _mm_storeu_si128((__m128i*)(pDst + x), _mm_packus_epi16(_mm_packs_epi32(v[0], v[1]), _mm_packs_epi32(v[2], v[3])));
+    }
+#elif CC_PIXEL_NEON
+    for (; x + 8 <= width; x += 8, pSrc += 32)
+    {
+        vst1_u8(pDst + x, vld4_u8(pSrc).val[3]);
+    }
+#endif
+    for (; x < width; ++x, pSrc += 4)
+    {
+        pDst[x] = pSrc[3];
+    }
+}
+
+// "RRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA" to "RRRRRRRRGGGGGGGGBBBBBBBB"
+static void convertRowRGBA8888ToRGB888(const unsigned char *pSrc, unsigned char *pDst, unsigned int width, const ccDitherRow *pDither)
+{
+    CC_UNUSED_PARAM(pDither);
+    unsigned int x = 0;
+#if CC_PIXEL_NEON
+    for (; x + 8 <= width; x += 8, pSrc += 32, pDst += 24)
+    {
+        uint8x8x4_t p = vld4_u8(pSrc);
+        uint8x8x3_t rgb;
+        rgb.val[0] = p.val[0];
+        rgb.val[1] = p.val[1];
+        rgb.val[2] = p.val[2];
+        vst3_u8(pDst, rgb);
+    }
+#endif
+    for (; x < width; ++x, pSrc += 4)
+    {
+        *pDst++ = pSrc[0]; // R
+        *pDst++ = pSrc[1]; // G
+        *pDst++ = pSrc[2]; // B
+    }
+}
+
+static void convertRows(unsigned int uBegin, unsigned int uEnd, void *pUserData)
+{
+    const ccConversion *pConversion = (const ccConversion*)pUserData;
+    for (unsigned int y = uBegin; y < uEnd; ++y)
+    {
+        pConversion->pfnRow(pConversion->pSrc + y * pConversion->srcStride,
+                            pConversion->pDst + y * pConversion->dstStride,
+                            pConversion->width, &pConversion->dither[y & 3]);
+    }
+}
+
+// large images are split between the job system workers, a few rows per range
+static void runConversion(ccConversion *pConversion, unsigned int height)
+{
+    if (pConversion->width == 0 || height == 0)
+    {
+        return;
+    }
+
+    unsigned int uGrain = MAX(1u, kCCPixelConversionGrain / pConversion->width);
+    CCJobSystem::sharedJobSystem()->parallelFor(height, uGrain, convertRows, pConversion);
+}
+
+void ccConvertRGBA8888(const unsigned char *pSrc, unsigned int width, unsigned int height,
+                       CCTexture2DPixelFormat eDstFormat, bool bDither, unsigned char *pDst)
+{
+    ccConversion conversion;
+    conversion.pSrc = pSrc;
+    conversion.pDst = pDst;
+    conversion.width = width;
+    conversion.srcStride = width * 4;
+
+    switch (eDstFormat)
+    {
+    case kCCTexture2DPixelFormat_RGB565:
+        conversion.dstStride = width * 2;
+        conversion.pfnRow = convertRowRGBA8888ToRGB565;
+        initDither(&conversion, bDither, 5, 6, 5, 8);
+        break;
+    case kCCTexture2DPixelFormat_RGBA4444:
+        // alpha is dithered like the colors, so premultiplied colors never exceed it
+        conversion.dstStride = width * 2;
+        conversion.pfnRow = convertRowRGBA8888ToRGBA4444;
+        initDither(&conversion, bDither, 4, 4, 4, 4);
+        break;
+    case kCCTexture2DPixelFormat_RGB5A1:
+        // dithering a 1 bit alpha would only fray the edges
+        conversion.dstStride = width * 2;
+        conversion.pfnRow = convertRowRGBA8888ToRGB5A1;
+        initDither(&conversion, bDither, 5, 5, 5, 8);
+        break;
+    case kCCTexture2DPixelFormat_A8:
+        conversion.dstStride = width;
+        conversion.pfnRow = convertRowRGBA8888ToA8;
+        initDither(&conversion, false, 8, 8, 8, 8);
+        break;
+    case kCCTexture2DPixelFormat_RGB888:
+        conversion.dstStride = width * 3;
+        conversion.pfnRow = convertRowRGBA8888ToRGB888;
+        initDither(&conversion, false, 8, 8, 8, 8);
+        break;
+    default:
+        CCAssert(false, "ccConvertRGBA8888: unsupported pixel format");
+        return;
+    }
+
+    runConversion(&conversion, height);
+}
+
+void ccConvertRGB888ToRGB565(const unsigned char *pSrc, unsigned int width, unsigned int height,
+                             bool bDither, unsigned char *pDst)
+{
+    ccConversion conversion;
+    conversion.pSrc = pSrc;
+    conversion.pDst = pDst;
+    conversion.width = width;
+    conversion.srcStride = width * 3;
+    conversion.dstStride = width * 2;
+    conversion.pfnRow = convertRowRGB888ToRGB565;
+    initDither(&conversion, bDither, 5, 6, 5, 8);
+
+    runConversion(&conversion, height);
+}
+
+NS_CC_END
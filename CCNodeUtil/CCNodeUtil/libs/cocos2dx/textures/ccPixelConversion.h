@@ -0,0 +1,63 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CC_PIXEL_CONVERSION_H__
+#define __CC_PIXEL_CONVERSION_H__
+
+#include "textures/CCTexture2D.h"
+
+/** @file ccPixelConversion.h
+Kernels repacking decoded images into the texture pixel formats.
+They don't touch OpenGL, so they may be called from any thread.
+*/
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup textures
+ * @{
+ */
+
+/** Repacks a width x height RGBA8888 image into eDstFormat, which may be
+ kCCTexture2DPixelFormat_RGB888, RGB565, A8, RGBA4444 or RGB5A1.
+ pDst must hold width * height * bits per pixel / 8 bytes.
+ If bDither is true the 16-bit formats are dithered with a 4x4 ordered pattern
+ instead of being truncated, which hides the banding of smooth gradients.
+ @since v2.1.x
+ */
+void CC_DLL ccConvertRGBA8888(const unsigned char *pSrc, unsigned int width, unsigned int height,
+                              CCTexture2DPixelFormat eDstFormat, bool bDither, unsigned char *pDst);
+
+/** Repacks a width x height RGB888 image into RGB565, see ccConvertRGBA8888().
+ @since v2.1.x
+ */
+void CC_DLL ccConvertRGB888ToRGB565(const unsigned char *pSrc, unsigned int width, unsigned int height,
+                                    bool bDither, unsigned char *pDst);
+
+// end of textures group
+/// @}
+
+NS_CC_END
+
+#endif // __CC_PIXEL_CONVERSION_H__
@@ -31,7 +31,9 @@ THE SOFTWARE.
 #include "shaders/CCShaderCache.h"
 #include "shaders/CCGLProgram.h"
 #include "support/CCPointExtension.h"
-#include "support/data_support/ccCArray.h"
+#include "textures/CCTextureAtlas.h"
+#include "support/CCProfiling.h"
+#include "shaders/ccGLStateCache.h"
 #include "CCDirector.h"
 
 NS_CC_BEGIN
@@ -51,10 +53,7 @@ CCTMXLayer * CCTMXLayer::create(CCTMXTilesetInfo *tilesetInfo, CCTMXLayerInfo *l
 }
 bool CCTMXLayer::initWithTilesetInfo(CCTMXTilesetInfo *tilesetInfo, CCTMXLayerInfo *layerInfo, CCTMXMapInfo *mapInfo)
 {    
-    // XXX: is 35% a good estimate ?
     CCSize size = layerInfo->m_tLayerSize;
-    float totalNumberOfTiles = size.width * size.height;
-    float capacity = totalNumberOfTiles * 0.35f + 1; // 35 percent is occupied ?
 
     CCTexture2D *texture = NULL;
     if( tilesetInfo )
@@ -62,7 +61,8 @@ bool CCTMXLayer::initWithTilesetInfo(CCTMXTilesetInfo *tilesetInfo, CCTMXLayerIn
         texture = CCTextureCache::sharedTextureCache()->addImage(tilesetInfo->m_sSourceImage.c_str());
     }
 
-    if (CCSpriteBatchNode::initWithTexture(texture, (unsigned int)capacity))
+    // the layer's own atlas only holds the tiles turned into sprites, the others live in the chunks
+    if (CCSpriteBatchNode::initWithTexture(texture, kDefaultSpriteBatchCapacity))
     {
         // layerInfo
         m_sLayerName = layerInfo->m_sName;
@@ -86,8 +86,6 @@ bool CCTMXLayer::initWithTilesetInfo(CCTMXTilesetInfo *tilesetInfo, CCTMXLayerIn
         CCPoint offset = this->calculateLayerOffset(layerInfo->m_tOffset);
         this->setPosition(CC_POINT_PIXELS_TO_POINTS(offset));
 
-        m_pAtlasIndexArray = ccCArrayNew((unsigned int)totalNumberOfTiles);
-
         this->setContentSize(CC_SIZE_PIXELS_TO_POINTS(CCSizeMake(m_tLayerSize.width * m_tMapTileSize.width, m_tLayerSize.height * m_tMapTileSize.height)));
 
         m_bUseAutomaticVertexZ = false;
@@ -105,20 +103,24 @@ CCTMXLayer::CCTMXLayer()
 ,m_pTileSet(NULL)
 ,m_pProperties(NULL)
 ,m_sLayerName("")
-,m_pReusedTile(NULL)
-,m_pAtlasIndexArray(NULL)    
+,m_pChunks(NULL)
+,m_uChunksWide(0)
+,m_uChunksHigh(0)
 {}
 
 CCTMXLayer::~CCTMXLayer()
 {
     CC_SAFE_RELEASE(m_pTileSet);
-    CC_SAFE_RELEASE(m_pReusedTile);
     CC_SAFE_RELEASE(m_pProperties);
 
-    if (m_pAtlasIndexArray)
+    if (m_pChunks)
     {
-        ccCArrayFree(m_pAtlasIndexArray);
-        m_pAtlasIndexArray = NULL;
+        for (unsigned int i = 0; i < m_uChunksWide * m_uChunksHigh; i++)
+        {
+            CC_SAFE_RELEASE(m_pChunks[i].atlas);
+        }
+        free(m_pChunks);
+        m_pChunks = NULL;
     }
 
     CC_SAFE_DELETE_ARRAY(m_pTiles);
@@ -140,15 +142,18 @@ void CCTMXLayer::releaseMap()
 {
     if (m_pTiles)
     {
+        // chunks can't be rebuilt without the map
+        for (unsigned int i = 0; i < m_uChunksWide * m_uChunksHigh; i++)
+        {
+            if (! m_pChunks[i].atlas && m_pChunks[i].tileCount)
+            {
+                buildChunk(i);
+            }
+        }
+
         delete [] m_pTiles;
         m_pTiles = NULL;
     }
-
-    if (m_pAtlasIndexArray)
-    {
-        ccCArrayFree(m_pAtlasIndexArray);
-        m_pAtlasIndexArray = NULL;
-    }
 }
 
 // CCTMXLayer - setup Tiles
@@ -169,6 +174,8 @@ void CCTMXLayer::setupTiles()
     // Parse cocos2d properties
     this->parseInternalProperties();
 
+    this->setupChunks();
+
     for (unsigned int y=0; y < m_tLayerSize.height; y++) 
     {
         for (unsigned int x=0; x < m_tLayerSize.width; x++) 
@@ -185,7 +192,8 @@ void CCTMXLayer::setupTiles()
             // XXX: gid == 0 --> empty tile
             if (gid != 0) 
             {
-                this->appendTileForGID(gid, ccp(x, y));
+                // the quads are only built once the chunk is on screen
+                m_pChunks[(y / CC_TMX_LAYER_CHUNK_SIZE) * m_uChunksWide + x / CC_TMX_LAYER_CHUNK_SIZE].tileCount++;
 
                 // Optimization: update min and max GID rendered by the layer
                 m_uMinGID = MIN(gid, m_uMinGID);
@@ -198,6 +206,274 @@ void CCTMXLayer::setupTiles()
         m_uMinGID >= m_pTileSet->m_uFirstGid, "TMX: Only 1 tileset per layer is supported");    
 }
 
+// CCTMXLayer - chunks
+void CCTMXLayer::setupChunks()
+{
+    unsigned int uLayerWidth = (unsigned int)m_tLayerSize.width;
+    unsigned int uLayerHeight = (unsigned int)m_tLayerSize.height;
+
+    m_uChunksWide = (uLayerWidth + CC_TMX_LAYER_CHUNK_SIZE - 1) / CC_TMX_LAYER_CHUNK_SIZE;
+    m_uChunksHigh = (uLayerHeight + CC_TMX_LAYER_CHUNK_SIZE - 1) / CC_TMX_LAYER_CHUNK_SIZE;
+    m_pChunks = (tCCTMXChunk*)calloc(m_uChunksWide * m_uChunksHigh, sizeof(tCCTMXChunk));
+
+    // tiles may be bigger than the map's grid, they grow up and to the right. Flipped diagonally, they swap their sides.
+    CCSize tileSize = CC_SIZE_PIXELS_TO_POINTS(m_pTileSet->m_tTileSize);
+    CCSize gridSize = CC_SIZE_PIXELS_TO_POINTS(m_tMapTileSize);
+    float fExtent = MAX(MAX(tileSize.width, tileSize.height), MAX(gridSize.width, gridSize.height));
+
+    for (unsigned int cy = 0; cy < m_uChunksHigh; cy++)
+    {
+        for (unsigned int cx = 0; cx < m_uChunksWide; cx++)
+        {
+            unsigned int x0 = cx * CC_TMX_LAYER_CHUNK_SIZE;
+            unsigned int y0 = cy * CC_TMX_LAYER_CHUNK_SIZE;
+            unsigned int x1 = MIN(x0 + CC_TMX_LAYER_CHUNK_SIZE, uLayerWidth) - 1;
+            unsigned int y1 = MIN(y0 + CC_TMX_LAYER_CHUNK_SIZE, uLayerHeight) - 1;
+
+            // tile positions are linear in the tile coordinates, so the corner tiles bound the chunk
+            CCPoint corners[4] = { positionAt(ccp(x0, y0)), positionAt(ccp(x1, y0)), positionAt(ccp(x0, y1)), positionAt(ccp(x1, y1)) };
+            float minX = corners[0].x, maxX = corners[0].x;
+            float minY = corners[0].y, maxY = corners[0].y;
+            for (int i = 1; i < 4; i++)
+            {
+                minX = MIN(minX, corners[i].x);
+                maxX = MAX(maxX, corners[i].x);
+                minY = MIN(minY, corners[i].y);
+                maxY = MAX(maxY, corners[i].y);
+            }
+
+            // hexagonal maps move every other column down by half a tile
+            minY -= gridSize.height / 2;
+
+            m_pChunks[cy * m_uChunksWide + cx].rect = CCRectMake(minX, minY, maxX - minX + fExtent, maxY - minY + fExtent);
+        }
+    }
+}
+
+tCCTMXChunk* CCTMXLayer::chunkForPos(const CCPoint& pos)
+{
+    unsigned int cx = (unsigned int)pos.x / CC_TMX_LAYER_CHUNK_SIZE;
+    unsigned int cy = (unsigned int)pos.y / CC_TMX_LAYER_CHUNK_SIZE;
+    return &m_pChunks[cy * m_uChunksWide + cx];
+}
+
+void CCTMXLayer::buildChunk(unsigned int uChunk)
+{
+    CCAssert(m_pTiles, "TMXLayer: the tiles map has been released");
+
+    tCCTMXChunk *pChunk = &m_pChunks[uChunk];
+    unsigned int x0 = (uChunk % m_uChunksWide) * CC_TMX_LAYER_CHUNK_SIZE;
+    unsigned int y0 = (uChunk / m_uChunksWide) * CC_TMX_LAYER_CHUNK_SIZE;
+    unsigned int uWidth = MIN(CC_TMX_LAYER_CHUNK_SIZE, (unsigned int)m_tLayerSize.width - x0);
+    unsigned int uHeight = MIN(CC_TMX_LAYER_CHUNK_SIZE, (unsigned int)m_tLayerSize.height - y0);
+    unsigned int uCount = uWidth * uHeight;
+
+    // one quad per cell so a tile can be updated in place, empty cells stay degenerate
+    pChunk->atlas = new CCTextureAtlas();
+    pChunk->atlas->initWithTexture(m_pobTextureAtlas->getTexture(), uCount);
+    pChunk->atlas->increaseTotalQuadsWith(uCount);
+
+    ccV3F_C4B_T2F_Quad *quads = pChunk->atlas->getQuadsForUpdate(0, uCount);
+    bool bHasSprites = ! m_tileSprites.empty();
+    for (unsigned int y = 0; y < uHeight; y++)
+    {
+        for (unsigned int x = 0; x < uWidth; x++)
+        {
+            unsigned int z = (unsigned int)((x0 + x) + (y0 + y) * m_tLayerSize.width);
+            unsigned int gid = m_pTiles[z];
+
+            // tiles turned into sprites are drawn by the layer's own atlas
+            if (gid && ! (bHasSprites && m_tileSprites.count(z)))
+            {
+                setupTileQuad(&quads[y * uWidth + x], ccp(x0 + x, y0 + y), gid);
+            }
+        }
+    }
+}
+
+CCSprite* CCTMXLayer::spriteForTile(unsigned int z)
+{
+    std::map<unsigned int, CCSprite*>::iterator it = m_tileSprites.find(z);
+    return it != m_tileSprites.end() ? it->second : NULL;
+}
+
+void CCTMXLayer::updateChunkTile(const CCPoint& pos, unsigned int gid)
+{
+    tCCTMXChunk *pChunk = chunkForPos(pos);
+    if (! pChunk->atlas)
+    {
+        // built from m_pTiles when it gets on screen
+        return;
+    }
+
+    unsigned int x0 = ((unsigned int)pos.x / CC_TMX_LAYER_CHUNK_SIZE) * CC_TMX_LAYER_CHUNK_SIZE;
+    unsigned int y0 = ((unsigned int)pos.y / CC_TMX_LAYER_CHUNK_SIZE) * CC_TMX_LAYER_CHUNK_SIZE;
+    unsigned int uWidth = MIN(CC_TMX_LAYER_CHUNK_SIZE, (unsigned int)m_tLayerSize.width - x0);
+
+    ccV3F_C4B_T2F_Quad quad;
+    memset(&quad, 0, sizeof(quad));
+    if (gid)
+    {
+        setupTileQuad(&quad, pos, gid);
+    }
+    pChunk->atlas->updateQuad(&quad, ((unsigned int)pos.y - y0) * uWidth + ((unsigned int)pos.x - x0));
+}
+
+void CCTMXLayer::setupTileQuad(ccV3F_C4B_T2F_Quad *quad, const CCPoint& pos, unsigned int gid)
+{
+    CCTexture2D *tex = m_pobTextureAtlas->getTexture();
+    CCRect rect = m_pTileSet->rectForGID(gid);
+
+    float atlasWidth = (float)tex->getPixelsWide();
+    float atlasHeight = (float)tex->getPixelsHigh();
+
+#if CC_FIX_ARTIFACTS_BY_STRECHING_TEXEL
+    float left    = (2*rect.origin.x+1)/(2*atlasWidth);
+    float right   = left + (rect.size.width*2-2)/(2*atlasWidth);
+    float top     = (2*rect.origin.y+1)/(2*atlasHeight);
+    float bottom  = top + (rect.size.height*2-2)/(2*atlasHeight);
+#else
+    float left    = rect.origin.x/atlasWidth;
+    float right   = (rect.origin.x + rect.size.width) / atlasWidth;
+    float top     = rect.origin.y/atlasHeight;
+    float bottom  = (rect.origin.y + rect.size.height) / atlasHeight;
+#endif // ! CC_FIX_ARTIFACTS_BY_STRECHING_TEXEL
+
+    // Rotation in tiled is achieved using 3 flipped states. The horizontal and vertical flips mirror
+    // the corners, then the diagonal flip swaps the axes of the tile image (y goes down).
+    static const float corners[4][2] = { {0, 1}, {1, 1}, {0, 0}, {1, 0} }; // bl, br, tl, tr
+    ccV3F_C4B_T2F *vertices[4] = { &quad->bl, &quad->br, &quad->tl, &quad->tr };
+    for (int i = 0; i < 4; i++)
+    {
+        float u = (gid & kCCTMXTileHorizontalFlag) ? 1 - corners[i][0] : corners[i][0];
+        float v = (gid & kCCTMXTileVerticalFlag) ? 1 - corners[i][1] : corners[i][1];
+        if (gid & kCCTMXTileDiagonalFlag)
+        {
+            CC_SWAP(u, v, float);
+        }
+        vertices[i]->texCoords.u = left + u * (right - left);
+        vertices[i]->texCoords.v = top + v * (bottom - top);
+    }
+
+    // a diagonally flipped tile is rotated, its sides are swapped
+    CCSize size = CC_SIZE_PIXELS_TO_POINTS(rect.size);
+    if (gid & kCCTMXTileDiagonalFlag)
+    {
+        CC_SWAP(size.width, size.height, float);
+    }
+
+    CCPoint origin = positionAt(pos);
+    float z = (float)vertexZForPos(pos);
+    quad->bl.vertices = vertex3(origin.x, origin.y, z);
+    quad->br.vertices = vertex3(origin.x + size.width, origin.y, z);
+    quad->tl.vertices = vertex3(origin.x, origin.y + size.height, z);
+    quad->tr.vertices = vertex3(origin.x + size.width, origin.y + size.height, z);
+
+    // same color as a CCSprite with the layer's opacity
+    GLubyte rgb = tex->hasPremultipliedAlpha() ? m_cOpacity : 255;
+    ccColor4B color = { rgb, rgb, rgb, m_cOpacity };
+    quad->bl.colors = color;
+    quad->br.colors = color;
+    quad->tl.colors = color;
+    quad->tr.colors = color;
+}
+
+// CCTMXLayer - draw
+
+// draws the tiles of a chunk, with each tile turned into a sprite in the place of its tile
+void CCTMXLayer::drawChunkWithSprites(unsigned int uChunk, bool bDrawTiles)
+{
+    CCTextureAtlas *pAtlas = m_pChunks[uChunk].atlas;
+    unsigned int uLayerWidth = (unsigned int)m_tLayerSize.width;
+    unsigned int x0 = (uChunk % m_uChunksWide) * CC_TMX_LAYER_CHUNK_SIZE;
+    unsigned int y0 = (uChunk / m_uChunksWide) * CC_TMX_LAYER_CHUNK_SIZE;
+    unsigned int uWidth = MIN(CC_TMX_LAYER_CHUNK_SIZE, uLayerWidth - x0);
+    unsigned int uHeight = MIN(CC_TMX_LAYER_CHUNK_SIZE, (unsigned int)m_tLayerSize.height - y0);
+
+    // the cells of a chunk are in the order of the map, one row of the chunk at a time
+    unsigned int uDrawn = 0;
+    for (unsigned int y = 0; y < uHeight; y++)
+    {
+        unsigned int zRow = x0 + (y0 + y) * uLayerWidth;
+        std::map<unsigned int, CCSprite*>::iterator it = m_tileSprites.lower_bound(zRow);
+        for (; it != m_tileSprites.end() && it->first < zRow + uWidth; ++it)
+        {
+            unsigned int uCell = y * uWidth + (it->first - zRow);
+            if (bDrawTiles && uCell > uDrawn)
+            {
+                pAtlas->drawNumberOfQuads(uCell - uDrawn, uDrawn);
+            }
+            uDrawn = uCell;
+
+            // the quads of the sprite and of its children follow each other in the layer's atlas
+            CCSprite *pSprite = it->second;
+            unsigned int uFirst = lowestAtlasIndexInChild(pSprite);
+            m_pobTextureAtlas->drawNumberOfQuads(highestAtlasIndexInChild(pSprite) - uFirst + 1, uFirst);
+        }
+    }
+
+    if (bDrawTiles && uDrawn < pAtlas->getTotalQuads())
+    {
+        pAtlas->drawNumberOfQuads(pAtlas->getTotalQuads() - uDrawn, uDrawn);
+    }
+}
+
+void CCTMXLayer::draw(void)
+{
+    CC_PROFILER_START("CCTMXLayer - draw");
+
+    CC_NODE_DRAW_SETUP();
+
+    ccGLBlendFunc( m_blendFunc.src, m_blendFunc.dst );
+
+    // the screen in the layer's space, and one chunk more on every side before the chunks are evicted
+    CCDirector *pDirector = CCDirector::sharedDirector();
+    CCPoint visibleOrigin = pDirector->getVisibleOrigin();
+    CCSize visibleSize = pDirector->getVisibleSize();
+    CCRect visibleRect = CCRectApplyAffineTransform(CCRectMake(visibleOrigin.x, visibleOrigin.y, visibleSize.width, visibleSize.height),
+                                                    worldToNodeTransform());
+
+    CCSize margin = CC_SIZE_PIXELS_TO_POINTS(CCSizeMake(m_tMapTileSize.width * CC_TMX_LAYER_CHUNK_SIZE, m_tMapTileSize.height * CC_TMX_LAYER_CHUNK_SIZE));
+    CCRect keepRect = CCRectMake(visibleRect.origin.x - margin.width, visibleRect.origin.y - margin.height,
+                                 visibleRect.size.width + margin.width * 2, visibleRect.size.height + margin.height * 2);
+
+    // tiles turned into sprites, drawn with their chunk even when it's off screen since they may have been moved
+    bool bHasSprites = ! m_tileSprites.empty();
+    if (bHasSprites)
+    {
+        arrayMakeObjectsPerformSelector(m_pChildren, updateTransform, CCSprite*);
+    }
+
+    for (unsigned int i = 0; i < m_uChunksWide * m_uChunksHigh; i++)
+    {
+        tCCTMXChunk *pChunk = &m_pChunks[i];
+        bool bDrawTiles = false;
+        if (pChunk->rect.intersectsRect(visibleRect))
+        {
+            if (! pChunk->atlas && pChunk->tileCount)
+            {
+                buildChunk(i);
+            }
+            bDrawTiles = (pChunk->atlas != NULL);
+        }
+        else if (pChunk->atlas && m_pTiles && ! pChunk->rect.intersectsRect(keepRect))
+        {
+            CC_SAFE_RELEASE_NULL(pChunk->atlas);
+        }
+
+        if (bHasSprites)
+        {
+            drawChunkWithSprites(i, bDrawTiles);
+        }
+        else if (bDrawTiles)
+        {
+            pChunk->atlas->drawQuads();
+        }
+    }
+
+    CC_PROFILER_STOP("CCTMXLayer - draw");
+}
+
 // CCTMXLayer - Properties
 CCString* CCTMXLayer::propertyNamed(const char *propertyName)
 {
@@ -292,44 +568,21 @@ void CCTMXLayer::setupTileSprite(CCSprite* sprite, CCPoint pos, unsigned int gid
     }
 }
 
-CCSprite* CCTMXLayer::reusedTileWithRect(CCRect rect)
-{
-    if (! m_pReusedTile) 
-    {
-        m_pReusedTile = new CCSprite();
-        m_pReusedTile->initWithTexture(m_pobTextureAtlas->getTexture(), rect, false);
-        m_pReusedTile->setBatchNode(this);
-    }
-    else
-    {
-        // XXX HACK: Needed because if "batch node" is nil,
-		// then the Sprite'squad will be reset
-        m_pReusedTile->setBatchNode(NULL);
-        
-		// Re-init the sprite
-        m_pReusedTile->setTextureRect(rect, false, rect.size);
-        
-		// restore the batch node
-        m_pReusedTile->setBatchNode(this);
-    }
-
-    return m_pReusedTile;
-}
-
 // CCTMXLayer - obtaining tiles/gids
 CCSprite * CCTMXLayer::tileAt(const CCPoint& pos)
 {
     CCAssert(pos.x < m_tLayerSize.width && pos.y < m_tLayerSize.height && pos.x >=0 && pos.y >=0, "TMXLayer: invalid position");
-    CCAssert(m_pTiles && m_pAtlasIndexArray, "TMXLayer: the tiles map has been released");
+    CCAssert(m_pTiles, "TMXLayer: the tiles map has been released");
 
     CCSprite *tile = NULL;
-    unsigned int gid = this->tileGIDAt(pos);
+    ccTMXTileFlags flags;
+    unsigned int gid = this->tileGIDAt(pos, &flags);
 
     // if GID == 0, then no tile is present
     if (gid) 
     {
         int z = (int)(pos.x + pos.y * m_tLayerSize.width);
-        tile = (CCSprite*) this->getChildByTag(z);
+        tile = spriteForTile(z);
 
         // tile not created yet. create it
         if (! tile) 
@@ -339,14 +592,12 @@ CCSprite * CCTMXLayer::tileAt(const CCPoint& pos)
 
             tile = new CCSprite();
             tile->initWithTexture(this->getTexture(), rect);
-            tile->setBatchNode(this);
-            tile->setPosition(positionAt(pos));
-            tile->setVertexZ((float)vertexZForPos(pos));
-            tile->setAnchorPoint(CCPointZero);
-            tile->setOpacity(m_cOpacity);
-
-            unsigned int indexForZ = atlasIndexForExistantZ(z);
-            this->addSpriteWithoutQuad(tile, indexForZ, z);
+            setupTileSprite(tile, pos, gid | flags);
+
+            // the sprite replaces the tile's quad in its chunk
+            updateChunkTile(pos, 0);
+            CCSpriteBatchNode::addChild(tile, z, z);
+            m_tileSprites[z] = tile;
             tile->release();
         }
     }
@@ -362,7 +613,7 @@ unsigned int CCTMXLayer::tileGIDAt(const CCPoint& pos)
 unsigned int CCTMXLayer::tileGIDAt(const CCPoint& pos, ccTMXTileFlags* flags)
 {
     CCAssert(pos.x < m_tLayerSize.width && pos.y < m_tLayerSize.height && pos.x >=0 && pos.y >=0, "TMXLayer: invalid position");
-    CCAssert(m_pTiles && m_pAtlasIndexArray, "TMXLayer: the tiles map has been released");
+    CCAssert(m_pTiles, "TMXLayer: the tiles map has been released");
 
     int idx = (int)(pos.x + pos.y * m_tLayerSize.width);
     // Bits on the far end of the 32-bit global tile ID are used for tile flags
@@ -377,125 +628,6 @@ unsigned int CCTMXLayer::tileGIDAt(const CCPoint& pos, ccTMXTileFlags* flags)
     return (tile & kCCFlippedMask);
 }
 
-// CCTMXLayer - adding helper methods
-CCSprite * CCTMXLayer::insertTileForGID(unsigned int gid, const CCPoint& pos)
-{
-    CCRect rect = m_pTileSet->rectForGID(gid);
-    rect = CC_RECT_PIXELS_TO_POINTS(rect);
-
-    intptr_t z = (intptr_t)(pos.x + pos.y * m_tLayerSize.width);
-
-    CCSprite *tile = reusedTileWithRect(rect);
-
-    setupTileSprite(tile, pos, gid);
-
-    // get atlas index
-    unsigned int indexForZ = atlasIndexForNewZ(z);
-
-    // Optimization: add the quad without adding a child
-    this->insertQuadFromSprite(tile, indexForZ);
-
-    // insert it into the local atlasindex array
-    ccCArrayInsertValueAtIndex(m_pAtlasIndexArray, (void*)z, indexForZ);
-
-    // update possible children
-    if (m_pChildren && m_pChildren->count()>0)
-    {
-        CCObject* pObject = NULL;
-        CCARRAY_FOREACH(m_pChildren, pObject)
-        {
-            CCSprite* pChild = (CCSprite*) pObject;
-            if (pChild)
-            {
-                unsigned int ai = pChild->getAtlasIndex();
-                if ( ai >= indexForZ )
-                {
-                    pChild->setAtlasIndex(ai+1);
-                }
-            }
-        }
-    }
-    m_pTiles[z] = gid;
-    return tile;
-}
-CCSprite * CCTMXLayer::updateTileForGID(unsigned int gid, const CCPoint& pos)    
-{
-    CCRect rect = m_pTileSet->rectForGID(gid);
-    rect = CCRectMake(rect.origin.x / m_fContentScaleFactor, rect.origin.y / m_fContentScaleFactor, rect.size.width/ m_fContentScaleFactor, rect.size.height/ m_fContentScaleFactor);
-    int z = (int)(pos.x + pos.y * m_tLayerSize.width);
-
-    CCSprite *tile = reusedTileWithRect(rect);
-
-    setupTileSprite(tile ,pos ,gid);
-
-    // get atlas index
-    unsigned int indexForZ = atlasIndexForExistantZ(z);
-    tile->setAtlasIndex(indexForZ);
-    tile->setDirty(true);
-    tile->updateTransform();
-    m_pTiles[z] = gid;
-
-    return tile;
-}
-
-// used only when parsing the map. useless after the map was parsed
-// since lot's of assumptions are no longer true
-CCSprite * CCTMXLayer::appendTileForGID(unsigned int gid, const CCPoint& pos)
-{
-    CCRect rect = m_pTileSet->rectForGID(gid);
-    rect = CC_RECT_PIXELS_TO_POINTS(rect);
-
-    intptr_t z = (intptr_t)(pos.x + pos.y * m_tLayerSize.width);
-
-    CCSprite *tile = reusedTileWithRect(rect);
-
-    setupTileSprite(tile ,pos ,gid);
-
-    // optimization:
-    // The difference between appendTileForGID and insertTileforGID is that append is faster, since
-    // it appends the tile at the end of the texture atlas
-    unsigned int indexForZ = m_pAtlasIndexArray->num;
-
-    // don't add it using the "standard" way.
-    insertQuadFromSprite(tile, indexForZ);
-
-    // append should be after addQuadFromSprite since it modifies the quantity values
-    ccCArrayInsertValueAtIndex(m_pAtlasIndexArray, (void*)z, indexForZ);
-
-    return tile;
-}
-
-// CCTMXLayer - atlasIndex and Z
-static inline int compareInts(const void * a, const void * b)
-{
-    return ((*(int*)a) - (*(int*)b));
-}
-unsigned int CCTMXLayer::atlasIndexForExistantZ(unsigned int z)
-{
-    int key=z;
-    int *item = (int*)bsearch((void*)&key, (void*)&m_pAtlasIndexArray->arr[0], m_pAtlasIndexArray->num, sizeof(void*), compareInts);
-
-    CCAssert(item, "TMX atlas index not found. Shall not happen");
-
-    int index = ((size_t)item - (size_t)m_pAtlasIndexArray->arr) / sizeof(void*);
-    return index;
-}
-unsigned int CCTMXLayer::atlasIndexForNewZ(int z)
-{
-    // XXX: This can be improved with a sort of binary search
-    unsigned int i=0;
-    for (i=0; i< m_pAtlasIndexArray->num ; i++) 
-    {
-        int val = (size_t) m_pAtlasIndexArray->arr[i];
-        if (z < val)
-        {
-            break;
-        }
-    } 
-    
-    return i;
-}
-
 // CCTMXLayer - adding / remove tiles
 void CCTMXLayer::setTileGID(unsigned int gid, const CCPoint& pos)
 {
@@ -505,7 +637,7 @@ void CCTMXLayer::setTileGID(unsigned int gid, const CCPoint& pos)
 void CCTMXLayer::setTileGID(unsigned int gid, const CCPoint& pos, ccTMXTileFlags flags)
 {
     CCAssert(pos.x < m_tLayerSize.width && pos.y < m_tLayerSize.height && pos.x >=0 && pos.y >=0, "TMXLayer: invalid position");
-    CCAssert(m_pTiles && m_pAtlasIndexArray, "TMXLayer: the tiles map has been released");
+    CCAssert(m_pTiles, "TMXLayer: the tiles map has been released");
     CCAssert(gid == 0 || gid >= m_pTileSet->m_uFirstGid, "TMXLayer: invalid gid" );
 
     ccTMXTileFlags currentFlags;
@@ -520,18 +652,13 @@ void CCTMXLayer::setTileGID(unsigned int gid, const CCPoint& pos, ccTMXTileFlags
         {
             removeTileAt(pos);
         }
-        // empty tile. create a new one
-        else if (currentGID == 0)
-        {
-            insertTileForGID(gidAndFlags, pos);
-        }
-        // modifying an existing tile with a non-empty tile
-        else 
+        else
         {
             unsigned int z = (unsigned int)(pos.x + pos.y * m_tLayerSize.width);
-            CCSprite *sprite = (CCSprite*)getChildByTag(z);
+            CCSprite *sprite = (currentGID != 0) ? spriteForTile(z) : NULL;
             if (sprite)
             {
+                // modifying a tile which was turned into a sprite
                 CCRect rect = m_pTileSet->rectForGID(gid);
                 rect = CC_RECT_PIXELS_TO_POINTS(rect);
 
@@ -540,12 +667,17 @@ void CCTMXLayer::setTileGID(unsigned int gid, const CCPoint& pos, ccTMXTileFlags
                 {
                     setupTileSprite(sprite, sprite->getPosition(), gidAndFlags);
                 }
-                m_pTiles[z] = gidAndFlags;
             } 
             else 
             {
-                updateTileForGID(gidAndFlags, pos);
+                // empty or existing tile, only its quad changes
+                if (currentGID == 0)
+                {
+                    chunkForPos(pos)->tileCount++;
+                }
+                updateChunkTile(pos, gidAndFlags);
             }
+            m_pTiles[z] = gidAndFlags;
         }
     }
 }
@@ -567,57 +699,46 @@ void CCTMXLayer::removeChild(CCNode* node, bool cleanup)
 
     CCAssert(m_pChildren->containsObject(sprite), "Tile does not belong to TMXLayer");
 
-    unsigned int atlasIndex = sprite->getAtlasIndex();
-    unsigned int zz = (size_t)m_pAtlasIndexArray->arr[atlasIndex];
-    m_pTiles[zz] = 0;
-    ccCArrayRemoveValueAtIndex(m_pAtlasIndexArray, atlasIndex);
+    // the tag of a tile sprite is its index in the map
+    unsigned int zz = (unsigned int)sprite->getTag();
+    m_tileSprites.erase(zz);
+    if (m_pTiles && m_pTiles[zz])
+    {
+        m_pTiles[zz] = 0;
+        chunkForPos(ccp(zz % (unsigned int)m_tLayerSize.width, zz / (unsigned int)m_tLayerSize.width))->tileCount--;
+    }
     CCSpriteBatchNode::removeChild(sprite, cleanup);
 }
+void CCTMXLayer::removeAllChildrenWithCleanup(bool cleanup)
+{
+    m_tileSprites.clear();
+    CCSpriteBatchNode::removeAllChildrenWithCleanup(cleanup);
+}
 void CCTMXLayer::removeTileAt(const CCPoint& pos)
 {
     CCAssert(pos.x < m_tLayerSize.width && pos.y < m_tLayerSize.height && pos.x >=0 && pos.y >=0, "TMXLayer: invalid position");
-    CCAssert(m_pTiles && m_pAtlasIndexArray, "TMXLayer: the tiles map has been released");
+    CCAssert(m_pTiles, "TMXLayer: the tiles map has been released");
 
     unsigned int gid = tileGIDAt(pos);
 
     if (gid) 
     {
         unsigned int z = (unsigned int)(pos.x + pos.y * m_tLayerSize.width);
-        unsigned int atlasIndex = atlasIndexForExistantZ(z);
 
         // remove tile from GID map
         m_pTiles[z] = 0;
+        chunkForPos(pos)->tileCount--;
 
-        // remove tile from atlas position array
-        ccCArrayRemoveValueAtIndex(m_pAtlasIndexArray, atlasIndex);
-
-        // remove it from sprites and/or texture atlas
-        CCSprite *sprite = (CCSprite*)getChildByTag(z);
+        // remove it from sprites and/or its chunk
+        CCSprite *sprite = spriteForTile(z);
         if (sprite)
         {
+            m_tileSprites.erase(z);
             CCSpriteBatchNode::removeChild(sprite, true);
         }
         else 
         {
-            m_pobTextureAtlas->removeQuadAtIndex(atlasIndex);
-
-            // update possible children
-            if (m_pChildren && m_pChildren->count()>0)
-            {
-                CCObject* pObject = NULL;
-                CCARRAY_FOREACH(m_pChildren, pObject)
-                {
-                    CCSprite* pChild = (CCSprite*) pObject;
-                    if (pChild)
-                    {
-                        unsigned int ai = pChild->getAtlasIndex();
-                        if ( ai >= atlasIndex )
-                        {
-                            pChild->setAtlasIndex(ai-1);
-                        }
-                    }
-                }
-            }
+            updateChunkTile(pos, 0);
         }
     }
 }
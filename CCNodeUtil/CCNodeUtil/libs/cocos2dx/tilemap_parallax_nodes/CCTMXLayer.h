@@ -30,22 +30,38 @@ THE SOFTWARE.
 #include "base_nodes/CCAtlasNode.h"
 #include "sprite_nodes/CCSpriteBatchNode.h"
 #include "CCTMXXMLParser.h"
+#include <map>
 NS_CC_BEGIN
 
 class CCTMXMapInfo;
 class CCTMXLayerInfo;
 class CCTMXTilesetInfo;
-struct _ccCArray;
+class CCTextureAtlas;
 
 /**
  * @addtogroup tilemap_parallax_nodes
  * @{
  */
 
+/** A square block of tiles of a CCTMXLayer, drawn with its own CCTextureAtlas
+@since v2.1.x
+*/
+typedef struct _ccTMXChunk
+{
+    //! NULL until the chunk gets on screen, and again once it is far from it
+    CCTextureAtlas  *atlas;
+    //! bounding box of the chunk's tiles in points, in the layer's space
+    CCRect          rect;
+    //! non-empty tiles of the chunk, empty chunks are never built
+    unsigned int    tileCount;
+} tCCTMXChunk;
+
 /** @brief CCTMXLayer represents the TMX layer.
 
-It is a subclass of CCSpriteBatchNode. By default the tiles are rendered using a CCTextureAtlas.
-If you modify a tile on runtime, then, that tile will become a CCSprite, otherwise no CCSprite objects are created.
+It is a subclass of CCSpriteBatchNode. The tiles are rendered in square chunks of CC_TMX_LAYER_CHUNK_SIZE
+tiles a side. A chunk's quads are only built when the chunk gets on screen, and dropped again when it is
+far from the screen, so loading a layer doesn't depend on its size.
+If you call tileAt(), then that tile will become a CCSprite batched in the layer, otherwise no CCSprite objects are created.
 The benefits of using CCSprite objects as tiles are:
 - tiles (CCSprite) can be rotated/scaled/moved with a nice API
 
@@ -97,13 +113,16 @@ public:
 
     /** dealloc the map that contains the tile position from memory.
     Unless you want to know at runtime the tiles positions, you can safely call this method.
-    If you are going to call layer->tileGIDAt() then, don't release the map
+    If you are going to call layer->tileGIDAt() then, don't release the map.
+    Every chunk is built before the map is released, and none is evicted afterwards.
     */
     void releaseMap();
 
     /** returns the tile (CCSprite) at a given a tile coordinate.
     The returned CCSprite will be already added to the CCTMXLayer. Don't add it again.
     The CCSprite can be treated like any other CCSprite: rotated, scaled, translated, opacity, color, etc.
+    It is drawn in the place of the tile it replaces, between the tiles of its chunk, so it keeps
+    its z-order against the tiles it overlaps however far it is moved.
     You can remove either by calling:
     - layer->removeChild(sprite, cleanup);
     - or layer->removeTileAt(ccp(x,y));
@@ -154,6 +173,9 @@ public:
     virtual void addChild(CCNode * child, int zOrder, int tag);
     // super method
     void removeChild(CCNode* child, bool cleanup);
+    virtual void removeAllChildrenWithCleanup(bool cleanup);
+    /** draws the chunks on screen, each tile turned into a sprite in the place of its tile */
+    virtual void draw(void);
 
     inline const char* getLayerName(){ return m_sLayerName.c_str(); }
     inline void setLayerName(const char *layerName){ m_sLayerName = layerName; }
@@ -164,20 +186,19 @@ private:
 
     CCPoint calculateLayerOffset(const CCPoint& offset);
 
-    /* optimization methods */
-    CCSprite* appendTileForGID(unsigned int gid, const CCPoint& pos);
-    CCSprite* insertTileForGID(unsigned int gid, const CCPoint& pos);
-    CCSprite* updateTileForGID(unsigned int gid, const CCPoint& pos);
+    /* chunks */
+    void setupChunks();
+    void buildChunk(unsigned int uChunk);
+    void updateChunkTile(const CCPoint& pos, unsigned int gid);
+    void setupTileQuad(ccV3F_C4B_T2F_Quad *quad, const CCPoint& pos, unsigned int gid);
+    tCCTMXChunk* chunkForPos(const CCPoint& pos);
+    void drawChunkWithSprites(unsigned int uChunk, bool bDrawTiles);
+    CCSprite* spriteForTile(unsigned int z);
 
     /* The layer recognizes some special properties, like cc_vertez */
     void parseInternalProperties();
     void setupTileSprite(CCSprite* sprite, CCPoint pos, unsigned int gid);
-    CCSprite* reusedTileWithRect(CCRect rect);
     int vertexZForPos(const CCPoint& pos);
-
-    // index
-    unsigned int atlasIndexForExistantZ(unsigned int z);
-    unsigned int atlasIndexForNewZ(int z);
 protected:
     //! name of the layer
     std::string m_sLayerName;
@@ -191,9 +212,13 @@ protected:
     int                    m_nVertexZvalue;
     bool                m_bUseAutomaticVertexZ;
 
-    //! used for optimization
-    CCSprite            *m_pReusedTile;
-    ccCArray            *m_pAtlasIndexArray;
+    //! chunks, row by row
+    tCCTMXChunk         *m_pChunks;
+    unsigned int        m_uChunksWide;
+    unsigned int        m_uChunksHigh;
+
+    //! tiles turned into sprites, by index in the map; the sprites are retained as children
+    std::map<unsigned int, CCSprite*> m_tileSprites;
     
     // used for retina display
     float               m_fContentScaleFactor;            
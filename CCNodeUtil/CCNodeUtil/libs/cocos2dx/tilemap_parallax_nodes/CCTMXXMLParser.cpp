@@ -54,6 +54,25 @@ void tmx_endElement(void *ctx, const xmlChar *name);
 void tmx_characters(void *ctx, const xmlChar *ch, int len);
 */
 
+/** @brief Decodes the base64, possibly deflated, tile data of a layer while it is parsed.
+ The characters are decoded as they arrive and inflated straight into the final GID array,
+ so neither the text, the decoded nor the deflated data are kept in memory.
+ */
+struct _ccTMXTileDataStream
+{
+    CCTMXLayerInfo *layer;
+    unsigned int *tiles;
+    unsigned int length;
+    unsigned int written;
+    bool compressed;
+    bool failed;
+    ccBase64DecodeState base64;
+    ZipInflateStream inflater;
+};
+
+// characters decoded at once, the decoded bytes live on the stack
+#define kCCTMXTileDataChunk 4096
+
 static const char* valueForKey(const char *key, std::map<std::string, std::string>* dict)
 {
     if (dict)
@@ -199,6 +218,7 @@ CCTMXMapInfo::CCTMXMapInfo()
     ,m_bStoringCharacters(false)        
     ,m_pProperties(NULL)
     ,m_pTileProperties(NULL)
+    ,m_pTileDataStream(NULL)
 {
 }
 CCTMXMapInfo::~CCTMXMapInfo()
@@ -209,6 +229,12 @@ CCTMXMapInfo::~CCTMXMapInfo()
     CC_SAFE_RELEASE(m_pProperties);
     CC_SAFE_RELEASE(m_pTileProperties);
     CC_SAFE_RELEASE(m_pObjectGroups);
+    if (m_pTileDataStream)
+    {
+        // the parsing stopped inside of a <data> element
+        CC_SAFE_DELETE_ARRAY(m_pTileDataStream->tiles);
+        CC_SAFE_DELETE(m_pTileDataStream);
+    }
 }
 CCArray* CCTMXMapInfo::getLayers()
 {
@@ -478,6 +504,28 @@ void CCTMXMapInfo::startElement(void *ctx, const char *name, const char **atts)
                 pTMXMapInfo->setLayerAttribs(layerAttribs | TMXLayerAttribZlib);
             }
             CCAssert( compression == "" || compression == "gzip" || compression == "zlib", "TMX: unsupported compression method" );
+
+            // the final GID array is allocated up front, the tile data is decoded into it as it arrives
+            CCTMXLayerInfo* layer = (CCTMXLayerInfo*)pTMXMapInfo->getLayers()->lastObject();
+            CCSize s = layer->m_tLayerSize;
+            unsigned int count = (unsigned int)(s.width * s.height);
+
+            CCAssert(! m_pTileDataStream, "TMX: nested data elements");
+            m_pTileDataStream = new _ccTMXTileDataStream();
+            m_pTileDataStream->layer = layer;
+            m_pTileDataStream->tiles = new unsigned int[count];
+            memset(m_pTileDataStream->tiles, 0, count * sizeof(unsigned int));
+            m_pTileDataStream->length = count * sizeof(unsigned int);
+            m_pTileDataStream->written = 0;
+            m_pTileDataStream->compressed = (pTMXMapInfo->getLayerAttribs() & (TMXLayerAttribGzip | TMXLayerAttribZlib)) != 0;
+            m_pTileDataStream->failed = false;
+            memset(&m_pTileDataStream->base64, 0, sizeof(m_pTileDataStream->base64));
+            if (m_pTileDataStream->compressed 
+                && ! m_pTileDataStream->inflater.begin((unsigned char*)m_pTileDataStream->tiles, m_pTileDataStream->length))
+            {
+                CCLOG("cocos2d: TiledMap: inflate data error");
+                m_pTileDataStream->failed = true;
+            }
         }
         CCAssert( pTMXMapInfo->getLayerAttribs() != TMXLayerAttribNone, "TMX tile map: Only base64 and/or gzip/zlib maps are supported" );
 
@@ -625,53 +673,36 @@ void CCTMXMapInfo::endElement(void *ctx, const char *name)
     CCTMXMapInfo *pTMXMapInfo = this;
     std::string elementName = (char*)name;
 
-    int len = 0;
-
     if(elementName == "data" && pTMXMapInfo->getLayerAttribs()&TMXLayerAttribBase64) 
     {
         pTMXMapInfo->setStoringCharacters(false);
 
-        CCTMXLayerInfo* layer = (CCTMXLayerInfo*)pTMXMapInfo->getLayers()->lastObject();
-
-        std::string currentString = pTMXMapInfo->getCurrentString();
-        unsigned char *buffer;
-        len = base64Decode((unsigned char*)currentString.c_str(), (unsigned int)currentString.length(), &buffer);
-        if( ! buffer ) 
+        _ccTMXTileDataStream *stream = m_pTileDataStream;
+        m_pTileDataStream = NULL;
+        if (! stream)
         {
-            CCLOG("cocos2d: TiledMap: decode data error");
             return;
         }
 
-        if( pTMXMapInfo->getLayerAttribs() & (TMXLayerAttribGzip | TMXLayerAttribZlib) )
+        if (! stream->failed && stream->compressed && ! stream->inflater.isFinished())
         {
-            unsigned char *deflated;
-            CCSize s = layer->m_tLayerSize;
-            // int sizeHint = s.width * s.height * sizeof(uint32_t);
-            int sizeHint = (int)(s.width * s.height * sizeof(unsigned int));
-
-            int inflatedLen = ZipUtils::ccInflateMemoryWithHint(buffer, len, &deflated, sizeHint);
-            CCAssert(inflatedLen == sizeHint, "");
-
-            inflatedLen = (size_t)&inflatedLen; // XXX: to avoid warnings in compiler
-            
-            delete [] buffer;
-            buffer = NULL;
-
-            if( ! deflated ) 
-            {
-                CCLOG("cocos2d: TiledMap: inflate data error");
-                return;
-            }
-
-            layer->m_pTiles = (unsigned int*) deflated;
+            CCLOG("cocos2d: TiledMap: inflate data error");
+            stream->failed = true;
         }
-        else
+
+        if (stream->failed)
         {
-            layer->m_pTiles = (unsigned int*) buffer;
+            delete [] stream->tiles;
+            delete stream;
+            return;
         }
 
-        pTMXMapInfo->setCurrentString("");
+        unsigned int len = stream->compressed ? stream->inflater.getOutLength() : stream->written;
+        CCAssert(len == stream->length, "TMX: the tile data doesn't match the layer size");
+        CC_UNUSED_PARAM(len);
 
+        stream->layer->m_pTiles = stream->tiles;
+        delete stream;
     } 
     else if (elementName == "map")
     {
@@ -699,13 +730,48 @@ void CCTMXMapInfo::textHandler(void *ctx, const char *ch, int len)
 {
     CC_UNUSED_PARAM(ctx);
     CCTMXMapInfo *pTMXMapInfo = this;
-    std::string pText((char*)ch,0,len);
 
-    if (pTMXMapInfo->getStoringCharacters())
+    if (! pTMXMapInfo->getStoringCharacters())
+    {
+        return;
+    }
+
+    _ccTMXTileDataStream *stream = m_pTileDataStream;
+    if (! stream)
     {
-        std::string currentString = pTMXMapInfo->getCurrentString();
-        currentString += pText;
-        pTMXMapInfo->setCurrentString(currentString.c_str());
+        m_sCurrentString.append(ch, len);
+        return;
+    }
+
+    unsigned char buffer[(kCCTMXTileDataChunk / 4 + 1) * 3];
+    while (len > 0 && ! stream->failed)
+    {
+        unsigned int count = MIN(len, kCCTMXTileDataChunk);
+        int decoded = base64DecodeChunk(&stream->base64, (const unsigned char*)ch, count, buffer);
+        ch += count;
+        len -= count;
+
+        if (decoded < 0)
+        {
+            CCLOG("cocos2d: TiledMap: decode data error");
+            stream->failed = true;
+        }
+        else if (stream->compressed)
+        {
+            if (! stream->inflater.feed(buffer, decoded))
+            {
+                CCLOG("cocos2d: TiledMap: inflate data error");
+                stream->failed = true;
+            }
+        }
+        else
+        {
+            unsigned int room = stream->length - stream->written;
+            unsigned int copied = MIN((unsigned int)decoded, room);
+            memcpy((unsigned char*)stream->tiles + stream->written, buffer, copied);
+            stream->written += copied;
+            CCAssert(copied == (unsigned int)decoded, "TMX: the tile data doesn't match the layer size");
+        }
     }
 }
 
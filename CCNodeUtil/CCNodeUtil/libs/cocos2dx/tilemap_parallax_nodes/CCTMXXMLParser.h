@@ -209,6 +209,8 @@ protected:
     std::string m_sCurrentString;
     //! tile properties
     CCDictionary* m_pTileProperties;
+    //! tile data of the current layer, decoded as it is parsed
+    struct _ccTMXTileDataStream *m_pTileDataStream;
 };
 
 // end of tilemap_parallax_nodes group
@@ -26,6 +26,7 @@ THE SOFTWARE.
 #define __CC_TOUCH_H__
 
 #include "cocoa/CCObject.h"
+#include "cocoa/CCObjectPool.h"
 #include "cocoa/CCGeometry.h"
 
 NS_CC_BEGIN
@@ -37,6 +38,7 @@ NS_CC_BEGIN
 
 class CC_DLL CCTouch : public CCObject
 {
+    CC_POOLED_ALLOCATION(touchPool)
 public:
     CCTouch() 
         : m_nId(0)
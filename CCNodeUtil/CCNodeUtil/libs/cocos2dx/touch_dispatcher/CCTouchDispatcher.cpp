@@ -31,10 +31,44 @@ THE SOFTWARE.
 #include "textures/CCTexture2D.h"
 #include "support/data_support/ccCArray.h"
 #include "ccMacros.h"
+#include "base_nodes/CCNode.h"
+#include "CCDirector.h"
 #include <algorithm>
+#include <vector>
 
 NS_CC_BEGIN
 
+// side of the touch index cells, in points
+#define CC_TOUCH_INDEX_CELL_SIZE 64.0f
+
+// Uniform grid over the window of the targeted handlers which have a hit test node.
+// A handler is in every cell its m_obHitTestBounds overlaps.
+typedef struct _ccTouchIndex
+{
+    bool                                    dirty;          // handlers or hit test nodes changed
+    unsigned int                            epoch;          // CCNode::getTransformEpoch() when last updated
+    CCSize                                  winSize;
+    unsigned int                            columns;
+    unsigned int                            rows;
+    std::vector<std::vector<CCTargetedTouchHandler*> > cells;
+    unsigned int                            stamp;          // last mark given by queryTouchIndex()
+} tCCTouchIndex;
+
+static CCRect hitTestBoundsOfNode(CCNode *pNode)
+{
+    CCSize size = pNode->getContentSize();
+    return CCRectApplyAffineTransform(CCRectMake(0, 0, size.width, size.height), pNode->nodeToWorldTransform());
+}
+
+// range of cells covered by [fMin, fMax], clamped to [0, uCells)
+static void cellRange(float fMin, float fMax, unsigned int uCells, unsigned int& uFirst, unsigned int& uLast)
+{
+    int nFirst = (int)floorf(fMin / CC_TOUCH_INDEX_CELL_SIZE);
+    int nLast = (int)floorf(fMax / CC_TOUCH_INDEX_CELL_SIZE);
+    uFirst = (unsigned int)MIN(MAX(nFirst, 0), (int)uCells - 1);
+    uLast = (unsigned int)MIN(MAX(nLast, 0), (int)uCells - 1);
+}
+
 /**
  * Used for sort
  */
@@ -74,6 +108,12 @@ bool CCTouchDispatcher::init(void)
     m_pHandlersToAdd = CCArray::createWithCapacity(8);
     m_pHandlersToAdd->retain();
     m_pHandlersToRemove = ccCArrayNew(8);
+    m_pTouchIndex = new tCCTouchIndex();
+    m_pTouchIndex->dirty = true;
+    m_pTouchIndex->epoch = 0;
+    m_pTouchIndex->columns = 0;
+    m_pTouchIndex->rows = 0;
+    m_pTouchIndex->stamp = 0;
 
     m_bToRemove = false;
     m_bToAdd = false;
@@ -96,6 +136,8 @@ CCTouchDispatcher::~CCTouchDispatcher(void)
  
      ccCArrayFree(m_pHandlersToRemove);
     m_pHandlersToRemove = NULL;    
+
+    CC_SAFE_DELETE(m_pTouchIndex);
 }
 
 //
@@ -125,6 +167,7 @@ void CCTouchDispatcher::forceAddHandler(CCTouchHandler *pHandler, CCArray *pArra
      }
 
     pArray->insertObject(pHandler, u);
+    m_pTouchIndex->dirty = true;
 }
 
 void CCTouchDispatcher::addStandardDelegate(CCTouchDelegate *pDelegate, int nPriority)
@@ -198,6 +241,7 @@ void CCTouchDispatcher::forceRemoveDelegate(CCTouchDelegate *pDelegate)
         if (pHandler && pHandler->getDelegate() == pDelegate)
         {
             m_pTargetedHandlers->removeObject(pHandler);
+            m_pTouchIndex->dirty = true;
             break;
         }
     }
@@ -235,6 +279,7 @@ void CCTouchDispatcher::forceRemoveAllDelegates(void)
 {
      m_pStandardHandlers->removeAllObjects();
      m_pTargetedHandlers->removeAllObjects();
+     m_pTouchIndex->dirty = true;
 }
 
 void CCTouchDispatcher::removeAllDelegates(void)
@@ -313,6 +358,139 @@ void CCTouchDispatcher::setPriority(int nPriority, CCTouchDelegate *pDelegate)
     }
 }
 
+void CCTouchDispatcher::setHitTestNode(CCTouchDelegate *pDelegate, CCNode *pNode)
+{
+    CCAssert(pDelegate != NULL, "");
+
+    CCTouchHandler *pHandler = findHandler(pDelegate);
+    if (pHandler == NULL)
+    {
+        // not added yet, because it was added while touches were being dispatched
+        pHandler = findHandler(m_pHandlersToAdd, pDelegate);
+    }
+
+    CCTargetedTouchHandler *pTargetedHandler = dynamic_cast<CCTargetedTouchHandler*>(pHandler);
+    CCAssert(pTargetedHandler != NULL, "only targeted delegates can have a hit test node");
+
+    if (pTargetedHandler->getHitTestNode() != pNode)
+    {
+        pTargetedHandler->setHitTestNode(pNode);
+        m_pTouchIndex->dirty = true;
+    }
+}
+
+void CCTouchDispatcher::binTouchHandler(CCTargetedTouchHandler *pHandler, bool bAdd)
+{
+    tCCTouchIndex *pIndex = m_pTouchIndex;
+
+    unsigned int x0, x1, y0, y1;
+    cellRange(pHandler->m_obHitTestBounds.getMinX(), pHandler->m_obHitTestBounds.getMaxX(), pIndex->columns, x0, x1);
+    cellRange(pHandler->m_obHitTestBounds.getMinY(), pHandler->m_obHitTestBounds.getMaxY(), pIndex->rows, y0, y1);
+    for (unsigned int y = y0; y <= y1; ++y)
+    {
+        for (unsigned int x = x0; x <= x1; ++x)
+        {
+            std::vector<CCTargetedTouchHandler*>& cell = pIndex->cells[y * pIndex->columns + x];
+            if (bAdd)
+            {
+                cell.push_back(pHandler);
+            }
+            else
+            {
+                // the order of a cell doesn't matter
+                std::vector<CCTargetedTouchHandler*>::iterator it = std::find(cell.begin(), cell.end(), pHandler);
+                if (it != cell.end())
+                {
+                    *it = cell.back();
+                    cell.pop_back();
+                }
+            }
+        }
+    }
+}
+
+void CCTouchDispatcher::updateTouchIndex(void)
+{
+    tCCTouchIndex *pIndex = m_pTouchIndex;
+    CCSize winSize = CCDirector::sharedDirector()->getWinSize();
+    unsigned int uEpoch = CCNode::getTransformEpoch();
+
+    if (pIndex->dirty || ! pIndex->winSize.equals(winSize))
+    {
+        pIndex->dirty = false;
+        pIndex->winSize = winSize;
+        pIndex->columns = MAX((unsigned int)ceilf(winSize.width / CC_TOUCH_INDEX_CELL_SIZE), 1u);
+        pIndex->rows = MAX((unsigned int)ceilf(winSize.height / CC_TOUCH_INDEX_CELL_SIZE), 1u);
+        pIndex->cells.resize(pIndex->columns * pIndex->rows);
+        for (unsigned int c = 0; c < pIndex->cells.size(); ++c)
+        {
+            pIndex->cells[c].clear();
+        }
+
+        CCObject* pObj = NULL;
+        CCARRAY_FOREACH(m_pTargetedHandlers, pObj)
+        {
+            CCTargetedTouchHandler *pHandler = (CCTargetedTouchHandler*)pObj;
+            if (pHandler->m_pHitTestNode)
+            {
+                pHandler->m_obHitTestBounds = hitTestBoundsOfNode(pHandler->m_pHitTestNode);
+                binTouchHandler(pHandler, true);
+            }
+        }
+    }
+    else if (pIndex->epoch != uEpoch)
+    {
+        // only the handlers whose node, or one of its ancestors, changed are binned again
+        CCObject* pObj = NULL;
+        CCARRAY_FOREACH(m_pTargetedHandlers, pObj)
+        {
+            CCTargetedTouchHandler *pHandler = (CCTargetedTouchHandler*)pObj;
+            CCNode *pNode = pHandler->m_pHitTestNode;
+            if (pNode == NULL || ! pNode->isWorldTransformChangedSince(pIndex->epoch))
+            {
+                continue;
+            }
+
+            CCRect bounds = hitTestBoundsOfNode(pNode);
+            if (! bounds.equals(pHandler->m_obHitTestBounds))
+            {
+                binTouchHandler(pHandler, false);
+                pHandler->m_obHitTestBounds = bounds;
+                binTouchHandler(pHandler, true);
+            }
+        }
+    }
+
+    pIndex->epoch = uEpoch;
+}
+
+unsigned int CCTouchDispatcher::queryTouchIndex(const CCPoint& point)
+{
+    tCCTouchIndex *pIndex = m_pTouchIndex;
+    unsigned int uStamp = ++pIndex->stamp;
+
+    if (pIndex->cells.empty())
+    {
+        return uStamp;
+    }
+
+    unsigned int x, y, uUnused;
+    cellRange(point.x, point.x, pIndex->columns, x, uUnused);
+    cellRange(point.y, point.y, pIndex->rows, y, uUnused);
+
+    const std::vector<CCTargetedTouchHandler*>& cell = pIndex->cells[y * pIndex->columns + x];
+    for (unsigned int i = 0; i < cell.size(); ++i)
+    {
+        CCTargetedTouchHandler *pHandler = cell[i];
+        if (pHandler->m_obHitTestBounds.containsPoint(point))
+        {
+            pHandler->m_uHitTestStamp = uStamp;
+        }
+    }
+
+    return uStamp;
+}
+
 //
 // dispatch events
 //
@@ -336,11 +514,17 @@ void CCTouchDispatcher::touches(CCSet *pTouches, CCEvent *pEvent, unsigned int u
     //
     if (uTargetedHandlersCount > 0)
     {
+        if (uIndex == CCTOUCHBEGAN)
+        {
+            updateTouchIndex();
+        }
+
         CCTouch *pTouch;
         CCSetIterator setIter;
         for (setIter = pTouches->begin(); setIter != pTouches->end(); ++setIter)
         {
             pTouch = (CCTouch *)(*setIter);
+            unsigned int uStamp = (uIndex == CCTOUCHBEGAN ? queryTouchIndex(pTouch->getLocation()) : 0);
 
             CCTargetedTouchHandler *pHandler = NULL;
             CCObject* pObj = NULL;
@@ -356,6 +540,12 @@ void CCTouchDispatcher::touches(CCSet *pTouches, CCEvent *pEvent, unsigned int u
                 bool bClaimed = false;
                 if (uIndex == CCTOUCHBEGAN)
                 {
+                    // the touch is outside of the hit test node, the delegate can't claim it
+                    if (pHandler->m_pHitTestNode && pHandler->m_uHitTestStamp != uStamp)
+                    {
+                        continue;
+                    }
+
                     bClaimed = pHandler->getDelegate()->ccTouchBegan(pTouch, pEvent);
 
                     if (bClaimed)
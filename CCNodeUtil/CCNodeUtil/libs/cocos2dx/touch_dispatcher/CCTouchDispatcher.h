@@ -79,7 +79,11 @@ public:
 };
 
 class CCTouchHandler;
+class CCTargetedTouchHandler;
+class CCNode;
+class CCPoint;
 struct _ccCArray;
+struct _ccTouchIndex;
 /** @brief CCTouchDispatcher.
  Singleton that handles all the touch events.
  The dispatcher dispatches events to the registered TouchHandlers.
@@ -94,6 +98,8 @@ struct _ccCArray;
  These touches can be swallowed by the Targeted Touch Handlers. If there are still remaining touches, then the remaining touches will be sent
  to the Standard Touch Handlers.
 
+ Targeted delegates may be given a hit test node with setHitTestNode(). They are kept in a grid
+ of their bounding boxes in world space, and a touch only begins on those whose box contains it.
  @since v0.8.0
  */
 class CC_DLL CCTouchDispatcher : public CCObject, public EGLTouchDelegate
@@ -106,6 +112,7 @@ public:
         , m_pStandardHandlers(NULL)
         , m_pHandlersToAdd(NULL)
         , m_pHandlersToRemove(NULL)
+        , m_pTouchIndex(NULL)
         
     {}
 
@@ -138,6 +145,15 @@ public:
     the higher the priority */
     void setPriority(int nPriority, CCTouchDelegate *pDelegate);
 
+    /** Limits the touches a targeted delegate may claim to the bounding box of pNode in world space.
+     ccTouchBegan() is no longer called for touches outside of it, which spares the delegate its own
+     hit test; the order of the delegates doesn't change. Pass NULL to remove the limit.
+     The box follows pNode as long as it is moved through the CCNode setters.
+     IMPORTANT: The node will be retained.
+     @since v2.1.x
+     */
+    void setHitTestNode(CCTouchDelegate *pDelegate, CCNode *pNode);
+
     void touches(CCSet *pTouches, CCEvent *pEvent, unsigned int uIndex);
 
     virtual void touchesBegan(CCSet* touches, CCEvent* pEvent);
@@ -153,6 +169,14 @@ protected:
     void forceRemoveAllDelegates(void);
     void rearrangeHandlers(CCArray* pArray);
     CCTouchHandler* findHandler(CCArray* pArray, CCTouchDelegate *pDelegate);
+    /** Rebuilds the touch index if a handler or a hit test node changed since it was built,
+     otherwise bins again the handlers whose hit test node moved.
+     */
+    void updateTouchIndex(void);
+    /** adds a handler to, or removes it from, the cells overlapped by its hit test bounds */
+    void binTouchHandler(CCTargetedTouchHandler *pHandler, bool bAdd);
+    /** marks the targeted handlers whose hit test bounds contain point, returns the mark */
+    unsigned int queryTouchIndex(const CCPoint& point);
 
 protected:
      CCArray* m_pTargetedHandlers;
@@ -163,6 +187,7 @@ protected:
     bool m_bToRemove;
      CCArray* m_pHandlersToAdd;
     struct _ccCArray *m_pHandlersToRemove;
+    struct _ccTouchIndex *m_pTouchIndex;
     bool m_bToQuit;
     bool m_bDispatchEvents;
 
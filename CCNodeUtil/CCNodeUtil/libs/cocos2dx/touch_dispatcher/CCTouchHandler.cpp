@@ -25,6 +25,7 @@ THE SOFTWARE.
 
 #include "CCTouchHandler.h"
 #include "ccMacros.h"
+#include "base_nodes/CCNode.h"
 
 NS_CC_BEGIN
 
@@ -156,6 +157,18 @@ CCSet* CCTargetedTouchHandler::getClaimedTouches(void)
     return m_pClaimedTouches;
 }
 
+CCNode* CCTargetedTouchHandler::getHitTestNode(void)
+{
+    return m_pHitTestNode;
+}
+
+void CCTargetedTouchHandler::setHitTestNode(CCNode *pNode)
+{
+    CC_SAFE_RETAIN(pNode);
+    CC_SAFE_RELEASE(m_pHitTestNode);
+    m_pHitTestNode = pNode;
+}
+
 CCTargetedTouchHandler* CCTargetedTouchHandler::handlerWithDelegate(CCTouchDelegate *pDelegate, int nPriority, bool bSwallow)
 {
     CCTargetedTouchHandler *pHandler = new CCTargetedTouchHandler();
@@ -180,6 +193,9 @@ bool CCTargetedTouchHandler::initWithDelegate(CCTouchDelegate *pDelegate, int nP
     {
         m_pClaimedTouches = new CCSet();
         m_bSwallowsTouches = bSwallow;
+        m_pHitTestNode = NULL;
+        m_obHitTestBounds = CCRectZero;
+        m_uHitTestStamp = 0;
 
         return true;
     }
@@ -190,6 +206,7 @@ bool CCTargetedTouchHandler::initWithDelegate(CCTouchDelegate *pDelegate, int nP
 CCTargetedTouchHandler::~CCTargetedTouchHandler(void)
 {
     CC_SAFE_RELEASE(m_pClaimedTouches);
+    CC_SAFE_RELEASE(m_pHitTestNode);
 }
 
 NS_CC_END
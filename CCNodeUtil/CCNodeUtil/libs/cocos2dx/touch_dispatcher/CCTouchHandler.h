@@ -30,6 +30,7 @@ THE SOFTWARE.
 #include "CCTouchDispatcher.h"
 #include "cocoa/CCObject.h"
 #include "cocoa/CCSet.h"
+#include "cocoa/CCGeometry.h"
 
 NS_CC_BEGIN
 
@@ -103,6 +104,13 @@ public:
     /** MutableSet that contains the claimed touches */
     CCSet* getClaimedTouches(void);
 
+    /** node whose bounding box limits the touches the delegate may claim, NULL if unlimited.
+     @see CCTouchDispatcher::setHitTestNode
+     @since v2.1.x
+     */
+    CCNode* getHitTestNode(void);
+    void setHitTestNode(CCNode *pNode);
+
     /** initializes a TargetedTouchHandler with a delegate, a priority and whether or not it swallows touches or not */
     bool initWithDelegate(CCTouchDelegate *pDelegate, int nPriority, bool bSwallow);
 
@@ -113,6 +121,13 @@ public:
 protected:
     bool m_bSwallowsTouches;
     CCSet *m_pClaimedTouches;
+    CCNode *m_pHitTestNode;
+
+    // filled by the touch index of CCTouchDispatcher
+    CCRect m_obHitTestBounds;       ///< bounding box of m_pHitTestNode in world space
+    unsigned int m_uHitTestStamp;   ///< stamp of the last touch found inside m_obHitTestBounds
+
+    friend class CCTouchDispatcher;
 };
 
 // end of input group
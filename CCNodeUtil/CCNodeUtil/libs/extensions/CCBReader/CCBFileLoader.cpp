@@ -4,13 +4,14 @@
 
 NS_CC_EXT_BEGIN
 
-#define PROPERTY_CCBFILE "ccbFile"
-
 void CCBFileLoader::onHandlePropTypeCCBFile(CCNode * pNode, CCNode * pParent, const char * pPropertyName, CCNode * pCCBFileNode, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_CCBFILE) == 0) {
-        ((CCBFile*)pNode)->setCCBFileNode(pCCBFileNode);
-    } else {
-        CCNodeLoader::onHandlePropTypeCCBFile(pNode, pParent, pPropertyName, pCCBFileNode, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyCCBFile:
+            ((CCBFile*)pNode)->setCCBFileNode(pCCBFileNode);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeCCBFile(pNode, pParent, pPropertyName, pCCBFileNode, pCCBReader);
+            break;
     }
 }
 
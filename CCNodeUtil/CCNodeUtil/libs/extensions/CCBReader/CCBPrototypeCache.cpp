@@ -0,0 +1,157 @@
+#include "CCBPrototypeCache.h"
+#include "CCNodeLoaderLibrary.h"
+
+NS_CC_EXT_BEGIN
+
+static CCBPrototypeCache *sSharedPrototypeCache = NULL;
+
+CCBPrototypeCache::CCBPrototypeCache()
+{
+    mPrototypes = new CCDictionary();
+    mPools = new CCDictionary();
+}
+
+CCBPrototypeCache::~CCBPrototypeCache()
+{
+    CC_SAFE_RELEASE(mPools);
+    CC_SAFE_RELEASE(mPrototypes);
+}
+
+CCBPrototypeCache* CCBPrototypeCache::sharedPrototypeCache()
+{
+    if (sSharedPrototypeCache == NULL)
+    {
+        sSharedPrototypeCache = new CCBPrototypeCache();
+    }
+    return sSharedPrototypeCache;
+}
+
+void CCBPrototypeCache::purgeSharedPrototypeCache()
+{
+    CC_SAFE_RELEASE_NULL(sSharedPrototypeCache);
+}
+
+CCBPrototype* CCBPrototypeCache::addPrototype(const char *pCCBFileName)
+{
+    if (NULL == pCCBFileName || strlen(pCCBFileName) == 0)
+    {
+        return NULL;
+    }
+
+    std::string strPath = CCBPrototype::fullPathForFile(pCCBFileName);
+    CCBPrototype *pPrototype = (CCBPrototype*)mPrototypes->objectForKey(strPath);
+    if (pPrototype == NULL)
+    {
+        pPrototype = CCBPrototype::createWithFile(strPath.c_str());
+        if (pPrototype != NULL)
+        {
+            mPrototypes->setObject(pPrototype, strPath);
+        }
+    }
+    return pPrototype;
+}
+
+CCBPrototype* CCBPrototypeCache::prototypeForFile(const char *pCCBFileName)
+{
+    if (NULL == pCCBFileName || strlen(pCCBFileName) == 0 || mPrototypes->count() == 0)
+    {
+        return NULL;
+    }
+
+    return (CCBPrototype*)mPrototypes->objectForKey(CCBPrototype::fullPathForFile(pCCBFileName));
+}
+
+void CCBPrototypeCache::removePrototypeForFile(const char *pCCBFileName)
+{
+    if (NULL == pCCBFileName || strlen(pCCBFileName) == 0)
+    {
+        return;
+    }
+
+    std::string strPath = CCBPrototype::fullPathForFile(pCCBFileName);
+    mPools->removeObjectForKey(strPath);
+    mPrototypes->removeObjectForKey(strPath);
+}
+
+void CCBPrototypeCache::removeAllPrototypes()
+{
+    mPools->removeAllObjects();
+    mPrototypes->removeAllObjects();
+}
+
+void CCBPrototypeCache::prewarm(const char *pCCBFileName, unsigned int uCount, CCNodeLoaderLibrary *pCCNodeLoaderLibrary)
+{
+    CCAssert(pCCNodeLoaderLibrary != NULL, "CCBPrototypeCache: a node loader library is needed to prewarm a pool");
+
+    CCBPrototype *pPrototype = addPrototype(pCCBFileName);
+    if (pPrototype == NULL)
+    {
+        CCLOG("CCBPrototypeCache: can't prewarm %s, it isn't a valid ccbi file", pCCBFileName);
+        return;
+    }
+
+    std::string strPath = CCBPrototype::fullPathForFile(pCCBFileName);
+    CCArray *pPool = (CCArray*)mPools->objectForKey(strPath);
+    if (pPool == NULL)
+    {
+        pPool = CCArray::createWithCapacity(uCount);
+        mPools->setObject(pPool, strPath);
+    }
+
+    while (pPool->count() < uCount)
+    {
+        CCNode *pNode = readNodeGraph(pPrototype, pCCNodeLoaderLibrary);
+        if (pNode == NULL)
+        {
+            break;
+        }
+        pPool->addObject(pNode);
+    }
+}
+
+CCNode* CCBPrototypeCache::nodeGraphFromPool(const char *pCCBFileName, CCNodeLoaderLibrary *pCCNodeLoaderLibrary)
+{
+    if (NULL == pCCBFileName || strlen(pCCBFileName) == 0)
+    {
+        return NULL;
+    }
+
+    CCArray *pPool = (CCArray*)mPools->objectForKey(CCBPrototype::fullPathForFile(pCCBFileName));
+    if (pPool != NULL && pPool->count() > 0)
+    {
+        CCNode *pNode = (CCNode*)pPool->lastObject();
+        pNode->retain();
+        pNode->autorelease();
+        pPool->removeLastObject();
+        return pNode;
+    }
+
+    CCBPrototype *pPrototype = addPrototype(pCCBFileName);
+    if (pPrototype == NULL)
+    {
+        return NULL;
+    }
+    return readNodeGraph(pPrototype, pCCNodeLoaderLibrary);
+}
+
+unsigned int CCBPrototypeCache::getPooledCount(const char *pCCBFileName)
+{
+    if (NULL == pCCBFileName || strlen(pCCBFileName) == 0)
+    {
+        return 0;
+    }
+
+    CCArray *pPool = (CCArray*)mPools->objectForKey(CCBPrototype::fullPathForFile(pCCBFileName));
+    return pPool ? pPool->count() : 0;
+}
+
+CCNode* CCBPrototypeCache::readNodeGraph(CCBPrototype *pPrototype, CCNodeLoaderLibrary *pCCNodeLoaderLibrary)
+{
+    CCBReader *pReader = new CCBReader(pCCNodeLoaderLibrary);
+    CCNode *pNode = pReader->readNodeGraphFromPrototype(pPrototype, NULL, CCDirector::sharedDirector()->getWinSize());
+    pReader->release();
+
+    return pNode;
+}
+
+NS_CC_EXT_END
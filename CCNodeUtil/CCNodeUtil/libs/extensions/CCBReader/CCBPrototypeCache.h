@@ -0,0 +1,76 @@
+#ifndef _CCB_CCBPROTOTYPECACHE_H_
+#define _CCB_CCBPROTOTYPECACHE_H_
+
+#include "cocos2d.h"
+#include "ExtensionMacros.h"
+#include "CCBReader.h"
+
+NS_CC_EXT_BEGIN
+
+/**
+ * @addtogroup cocosbuilder
+ * @{
+ */
+
+/**
+ * @brief Keeps the CCBPrototypes of frequently shown ccbi files, and pools of their node graphs.
+ *
+ * Once a file has been added, CCBReader::readNodeGraphFromFile() and the sub ccb files
+ * embedded in other files instantiate it from its prototype instead of loading it again.
+ * prewarm() goes one step further and instantiates node graphs ahead of time, for example
+ * while a scene is loading, so nodeGraphFromPool() only has to hand one out.
+ * @since v2.1.x
+ */
+class CCBPrototypeCache : public CCObject
+{
+private:
+    CCDictionary *mPrototypes;  // CCBPrototype by full path
+    CCDictionary *mPools;       // CCArray of prewarmed node graphs by full path
+
+public:
+    CCBPrototypeCache();
+    virtual ~CCBPrototypeCache();
+
+    /** Returns the shared prototype cache */
+    static CCBPrototypeCache* sharedPrototypeCache();
+
+    /** Purges the cache. It releases the prototypes and the pooled node graphs. */
+    static void purgeSharedPrototypeCache();
+
+    /** Returns the prototype of pCCBFileName, loading and parsing the file if it isn't cached yet.
+     The .ccbi suffix may be omitted. Returns NULL if the file isn't a valid ccbi file.
+     */
+    CCBPrototype* addPrototype(const char *pCCBFileName);
+
+    /** Returns the cached prototype of pCCBFileName, or NULL. It never loads the file. */
+    CCBPrototype* prototypeForFile(const char *pCCBFileName);
+
+    /** Removes the prototype of pCCBFileName along with its pooled node graphs */
+    void removePrototypeForFile(const char *pCCBFileName);
+
+    /** Removes every prototype and every pooled node graph */
+    void removeAllPrototypes();
+
+    /** Instantiates node graphs of pCCBFileName until its pool holds uCount of them.
+     The graphs are read without owner, so outlets and callbacks must target the document root.
+     */
+    void prewarm(const char *pCCBFileName, unsigned int uCount, CCNodeLoaderLibrary *pCCNodeLoaderLibrary);
+
+    /** Hands out a prewarmed node graph of pCCBFileName, or reads a new one with pCCNodeLoaderLibrary
+     when the pool is empty. The graph is autoreleased and is not put back into the pool.
+     */
+    CCNode* nodeGraphFromPool(const char *pCCBFileName, CCNodeLoaderLibrary *pCCNodeLoaderLibrary);
+
+    /** Returns the number of prewarmed node graphs of pCCBFileName */
+    unsigned int getPooledCount(const char *pCCBFileName);
+
+private:
+    CCNode* readNodeGraph(CCBPrototype *pPrototype, CCNodeLoaderLibrary *pCCNodeLoaderLibrary);
+};
+
+// end of cocosbuilder group
+/// @}
+
+NS_CC_EXT_END
+
+#endif
@@ -12,6 +12,7 @@
 #include "CCBSequenceProperty.h"
 #include "CCBKeyframe.h"
 #include "CCBValue.h"
+#include "CCBPrototypeCache.h"
 
 #include <ctype.h>
 
@@ -53,15 +54,372 @@ void CCBFile::setCCBFileNode(CCNode *pNode)
     CC_SAFE_RETAIN(mCCBFileNode);
 }
 
+/*************************************************************************
+ Property names
+ *************************************************************************/
+
+typedef struct _ccbPropertyName
+{
+    const char *name;
+    int id;
+} ccbPropertyName;
+
+static const ccbPropertyName s_propertyNames[kCCBPropertyCount] =
+{
+    { "anchorPoint",                   kCCBPropertyAnchorPoint },
+    { "angle",                         kCCBPropertyAngle },
+    { "backgroundSpriteFrame|3",       kCCBPropertyBackgroundSpriteFrameDisabled },
+    { "backgroundSpriteFrame|2",       kCCBPropertyBackgroundSpriteFrameHighlighted },
+    { "backgroundSpriteFrame|1",       kCCBPropertyBackgroundSpriteFrameNormal },
+    { "blendFunc",                     kCCBPropertyBlendFunc },
+    { "block",                         kCCBPropertyBlock },
+    { "bounces",                       kCCBPropertyBounces },
+    { "ccbFile",                       kCCBPropertyCCBFile },
+    { "ccControl",                     kCCBPropertyCCControl },
+    { "clipsToBounds",                 kCCBPropertyClipsToBounds },
+    { "color",                         kCCBPropertyColor },
+    { "container",                     kCCBPropertyContainer },
+    { "contentSize",                   kCCBPropertyContentSize },
+    { "dimensions",                    kCCBPropertyDimensions },
+    { "direction",                     kCCBPropertyDirection },
+    { "disabledSpriteFrame",           kCCBPropertyDisabledSpriteFrame },
+    { "displayFrame",                  kCCBPropertyDisplayFrame },
+    { "duration",                      kCCBPropertyDuration },
+    { "emissionRate",                  kCCBPropertyEmissionRate },
+    { "emitterMode",                   kCCBPropertyEmitterMode },
+    { "enabled",                       kCCBPropertyEnabled },
+    { "endColor",                      kCCBPropertyEndColor },
+    { "endOpacity",                    kCCBPropertyEndOpacity },
+    { "endRadius",                     kCCBPropertyEndRadius },
+    { "endSize",                       kCCBPropertyEndSize },
+    { "endSpin",                       kCCBPropertyEndSpin },
+    { "flip",                          kCCBPropertyFlip },
+    { "fntFile",                       kCCBPropertyFntFile },
+    { "fontName",                      kCCBPropertyFontName },
+    { "fontSize",                      kCCBPropertyFontSize },
+    { "gravity",                       kCCBPropertyGravity },
+    { "horizontalAlignment",           kCCBPropertyHorizontalAlignment },
+    { "ignoreAnchorPointForPosition",  kCCBPropertyIgnoreAnchorPointForPosition },
+    { "insetBottom",                   kCCBPropertyInsetBottom },
+    { "insetLeft",                     kCCBPropertyInsetLeft },
+    { "insetRight",                    kCCBPropertyInsetRight },
+    { "insetTop",                      kCCBPropertyInsetTop },
+    { "isAccelerometerEnabled",        kCCBPropertyIsAccelerometerEnabled },
+    { "isEnabled",                     kCCBPropertyIsEnabled },
+    { "isKeyboardEnabled",             kCCBPropertyIsKeyboardEnabled },
+    { "isMouseEnabled",                kCCBPropertyIsMouseEnabled },
+    { "isTouchEnabled",                kCCBPropertyIsTouchEnabled },
+    { "labelAnchorPoint",              kCCBPropertyLabelAnchorPoint },
+    { "life",                          kCCBPropertyLife },
+    { "normalSpriteFrame",             kCCBPropertyNormalSpriteFrame },
+    { "opacity",                       kCCBPropertyOpacity },
+    { "position",                      kCCBPropertyPosition },
+    { "posVar",                        kCCBPropertyPosVar },
+    { "preferedSize",                  kCCBPropertyPreferedSize },
+    { "radialAccel",                   kCCBPropertyRadialAccel },
+    { "rotatePerSecond",               kCCBPropertyRotatePerSecond },
+    { "rotation",                      kCCBPropertyRotation },
+    { "scale",                         kCCBPropertyScale },
+    { "selected",                      kCCBPropertySelected },
+    { "selectedSpriteFrame",           kCCBPropertySelectedSpriteFrame },
+    { "speed",                         kCCBPropertySpeed },
+    { "spriteFrame",                   kCCBPropertySpriteFrame },
+    { "startColor",                    kCCBPropertyStartColor },
+    { "startOpacity",                  kCCBPropertyStartOpacity },
+    { "startRadius",                   kCCBPropertyStartRadius },
+    { "startSize",                     kCCBPropertyStartSize },
+    { "startSpin",                     kCCBPropertyStartSpin },
+    { "string",                        kCCBPropertyString },
+    { "tag",                           kCCBPropertyTag },
+    { "tangentialAccel",               kCCBPropertyTangentialAccel },
+    { "texture",                       kCCBPropertyTexture },
+    { "titleColor|3",                  kCCBPropertyTitleColorDisabled },
+    { "titleColor|2",                  kCCBPropertyTitleColorHighlighted },
+    { "titleColor|1",                  kCCBPropertyTitleColorNormal },
+    { "title|3",                       kCCBPropertyTitleDisabled },
+    { "title|2",                       kCCBPropertyTitleHighlighted },
+    { "title|1",                       kCCBPropertyTitleNormal },
+    { "titleTTF|3",                    kCCBPropertyTitleTTFDisabled },
+    { "titleTTF|2",                    kCCBPropertyTitleTTFHighlighted },
+    { "titleTTF|1",                    kCCBPropertyTitleTTFNormal },
+    { "titleTTFSize|3",                kCCBPropertyTitleTTFSizeDisabled },
+    { "titleTTFSize|2",                kCCBPropertyTitleTTFSizeHighlighted },
+    { "titleTTFSize|1",                kCCBPropertyTitleTTFSizeNormal },
+    { "totalParticles",                kCCBPropertyTotalParticles },
+    { "vector",                        kCCBPropertyVector },
+    { "verticalAlignment",             kCCBPropertyVerticalAlignment },
+    { "visible",                       kCCBPropertyVisible },
+    { "zoomOnTouchDown",               kCCBPropertyZoomOnTouchDown },
+};
+
+// Collision free hash of s_propertyNames. The seed is searched for the first time a name
+// is looked up, so a name only costs one hash and one strcmp.
+#define kCCBPropertyHashSize 4096
+#define kCCBPropertyHashEmpty 0xFF
+
+static unsigned char s_propertyHash[kCCBPropertyHashSize];
+static unsigned int s_propertyHashSeed = 0;
+static bool s_propertyHashBuilt = false;
+
+static unsigned int hashPropertyName(const char *pName, unsigned int seed)
+{
+    // FNV-1a
+    unsigned int hash = 2166136261u ^ seed;
+    for (; *pName; ++pName)
+    {
+        hash ^= (unsigned char)*pName;
+        hash *= 16777619u;
+    }
+    return (hash ^ (hash >> 16)) & (kCCBPropertyHashSize - 1);
+}
+
+static void buildPropertyHash()
+{
+    for (unsigned int seed = 0; ; ++seed)
+    {
+        memset(s_propertyHash, kCCBPropertyHashEmpty, sizeof(s_propertyHash));
+
+        int i = 0;
+        for (; i < kCCBPropertyCount; ++i)
+        {
+            unsigned int slot = hashPropertyName(s_propertyNames[i].name, seed);
+            if (s_propertyHash[slot] != kCCBPropertyHashEmpty)
+            {
+                break;
+            }
+            s_propertyHash[slot] = (unsigned char)i;
+        }
+
+        if (i == kCCBPropertyCount)
+        {
+            s_propertyHashSeed = seed;
+            break;
+        }
+    }
+
+    s_propertyHashBuilt = true;
+}
+
+// Reads an Elias gamma encoded int, which is how every int of a ccbi file is stored.
+static int readEncodedInt(const unsigned char *pBytes, int &currentByte, int &currentBit, bool pSigned)
+{
+    int numBits = 0;
+    while (!(pBytes[currentByte] & (1 << currentBit)))
+    {
+        numBits++;
+        if (++currentBit >= 8)
+        {
+            currentBit = 0;
+            currentByte++;
+        }
+    }
+    if (++currentBit >= 8)
+    {
+        currentBit = 0;
+        currentByte++;
+    }
+
+    long long current = 0;
+    for (int a = numBits - 1; a >= 0; a--)
+    {
+        if (pBytes[currentByte] & (1 << currentBit))
+        {
+            current |= 1LL << a;
+        }
+        if (++currentBit >= 8)
+        {
+            currentBit = 0;
+            currentByte++;
+        }
+    }
+    current |= 1LL << numBits;
+
+    int num;
+    if (pSigned)
+    {
+        int s = current % 2;
+        if (s)
+        {
+            num = (int)(current / 2);
+        }
+        else
+        {
+            num = (int)(-current / 2);
+        }
+    }
+    else
+    {
+        num = current - 1;
+    }
+
+    // align to the next byte
+    if (currentBit)
+    {
+        currentBit = 0;
+        currentByte++;
+    }
+
+    return num;
+}
+
+/*************************************************************************
+ Implementation of CCBPrototype
+ *************************************************************************/
+
+CCBPrototype::CCBPrototype()
+: mData(NULL)
+, mJSControlled(false)
+, mNodeGraphOffset(0)
+, mStringArena(NULL)
+{
+}
+
+CCBPrototype::~CCBPrototype()
+{
+    CC_SAFE_RELEASE(mData);
+    CC_SAFE_DELETE_ARRAY(mStringArena);
+}
+
+std::string CCBPrototype::fullPathForFile(const char *pCCBFileName)
+{
+    std::string strCCBFileName(pCCBFileName);
+    std::string strSuffix(".ccbi");
+    // Add ccbi suffix
+    if (!CCBReader::endsWith(strCCBFileName.c_str(), strSuffix.c_str()))
+    {
+        strCCBFileName += strSuffix;
+    }
+
+    return CCFileUtils::sharedFileUtils()->fullPathForFilename(strCCBFileName.c_str());
+}
+
+CCBPrototype* CCBPrototype::createWithFile(const char *pCCBFileName)
+{
+    if (NULL == pCCBFileName || strlen(pCCBFileName) == 0)
+    {
+        return NULL;
+    }
+
+    std::string strPath = fullPathForFile(pCCBFileName);
+    unsigned long size = 0;
+
+    unsigned char * pBytes = CCFileUtils::sharedFileUtils()->getFileData(strPath.c_str(), "rb", &size);
+    if (pBytes == NULL)
+    {
+        return NULL;
+    }
+    CCData *data = new CCData(pBytes, size);
+    CC_SAFE_DELETE_ARRAY(pBytes);
+
+    CCBPrototype *pRet = createWithData(data);
+    data->release();
+
+    return pRet;
+}
+
+CCBPrototype* CCBPrototype::createWithData(CCData *pData)
+{
+    CCBPrototype *pRet = new CCBPrototype();
+    if (pRet->initWithData(pData))
+    {
+        pRet->autorelease();
+        return pRet;
+    }
+    CC_SAFE_DELETE(pRet);
+    return NULL;
+}
+
+bool CCBPrototype::initWithData(CCData *pData)
+{
+    /* If no bytes loaded, don't crash about it. */
+    if (pData == NULL || pData->getBytes() == NULL || pData->getSize() < 4)
+    {
+        return false;
+    }
+
+    const unsigned char *pBytes = pData->getBytes();
+    int currentByte = 0;
+    int currentBit = 0;
+
+    /* Read magic bytes */
+    int magicBytes = *((int*)pBytes);
+    currentByte += 4;
+
+    if(CC_SWAP_INT32_LITTLE_TO_HOST(magicBytes) != 'ccbi') {
+        return false;
+    }
+
+    /* Read version. */
+    int version = readEncodedInt(pBytes, currentByte, currentBit, false);
+    if(version != kCCBVersion) {
+        CCLog("WARNING! Incompatible ccbi file version (file: %d reader: %d)", version, kCCBVersion);
+        return false;
+    }
+
+    // Read JS check
+    mJSControlled = pBytes[currentByte++] != 0;
+
+    /* Read the string cache. The strings are copied once into a single buffer,
+     * NUL terminated so they can be handed out as they are. */
+    int numStrings = readEncodedInt(pBytes, currentByte, currentBit, false);
+
+    int arenaSize = 0;
+    int pos = currentByte;
+    for(int i = 0; i < numStrings; i++) {
+        int numBytes = pBytes[pos] << 8 | pBytes[pos + 1];
+        arenaSize += numBytes + 1;
+        pos += 2 + numBytes;
+    }
+
+    CC_SAFE_DELETE_ARRAY(mStringArena);
+    mStringArena = new char[MAX(arenaSize, 1)];
+    mStringCache.resize(numStrings);
+    mStringPropertyIds.resize(numStrings);
+
+    char *pOut = mStringArena;
+    for(int i = 0; i < numStrings; i++) {
+        int numBytes = pBytes[currentByte] << 8 | pBytes[currentByte + 1];
+        currentByte += 2;
+
+        memcpy(pOut, pBytes + currentByte, numBytes);
+        pOut[numBytes] = '\0';
+        mStringCache[i] = pOut;
+        mStringPropertyIds[i] = CCBReader::propertyIdForName(pOut);
+
+        pOut += numBytes + 1;
+        currentByte += numBytes;
+    }
+
+    mNodeGraphOffset = currentByte;
+
+    CC_SAFE_RETAIN(pData);
+    CC_SAFE_RELEASE(mData);
+    mData = pData;
+
+    return true;
+}
+
+CCData* CCBPrototype::getData()
+{
+    return mData;
+}
+
+bool CCBPrototype::isJSControlled()
+{
+    return mJSControlled;
+}
+
 /*************************************************************************
  Implementation of CCBReader
  *************************************************************************/
 
 CCBReader::CCBReader(CCNodeLoaderLibrary * pCCNodeLoaderLibrary, CCBMemberVariableAssigner * pCCBMemberVariableAssigner, CCBSelectorResolver * pCCBSelectorResolver, CCNodeLoaderListener * pCCNodeLoaderListener) 
-: mData(NULL)
+: mPrototype(NULL)
 , mBytes(NULL)
 , mCurrentByte(-1)
 , mCurrentBit(-1)
+, mCurrentPropertyName(NULL)
+, mCurrentPropertyId(kCCBPropertyUnknown)
 , mOwner(NULL)
 , mActionManager(NULL)
 , mAnimatedProps(NULL)
@@ -81,10 +439,12 @@ CCBReader::CCBReader(CCNodeLoaderLibrary * pCCNodeLoaderLibrary, CCBMemberVariab
 }
 
 CCBReader::CCBReader(CCBReader * pCCBReader) 
-: mData(NULL)
+: mPrototype(NULL)
 , mBytes(NULL)
 , mCurrentByte(-1)
 , mCurrentBit(-1)
+, mCurrentPropertyName(NULL)
+, mCurrentPropertyId(kCCBPropertyUnknown)
 , mOwner(NULL)
 , mActionManager(NULL)
 , mAnimatedProps(NULL)
@@ -113,10 +473,12 @@ CCBReader::CCBReader(CCBReader * pCCBReader)
 }
 
 CCBReader::CCBReader()
-: mData(NULL)
+: mPrototype(NULL)
 , mBytes(NULL)
 , mCurrentByte(-1)
 , mCurrentBit(-1)
+, mCurrentPropertyName(NULL)
+, mCurrentPropertyId(kCCBPropertyUnknown)
 , mOwner(NULL)
 , mActionManager(NULL)
 , mCCNodeLoaderLibrary(NULL)
@@ -134,7 +496,7 @@ CCBReader::CCBReader()
 
 CCBReader::~CCBReader() {
     CC_SAFE_RELEASE_NULL(mOwner);
-    CC_SAFE_RELEASE_NULL(mData);
+    CC_SAFE_RELEASE_NULL(mPrototype);
 
     this->mCCNodeLoaderLibrary->release();
 
@@ -143,9 +505,6 @@ CCBReader::~CCBReader() {
     CC_SAFE_RELEASE(mOwnerCallbackNodes);
     mOwnerCallbackNames.clear();
 
-    // Clear string cache.
-
-    this->mStringCache.clear();
     CC_SAFE_RELEASE(mNodesWithAnimationManagers);
     CC_SAFE_RELEASE(mAnimationManagersForNodes);
 
@@ -238,35 +597,24 @@ CCNode* CCBReader::readNodeGraphFromFile(const char *pCCBFileName, CCObject *pOw
         return NULL;
     }
 
-    std::string strCCBFileName(pCCBFileName);
-    std::string strSuffix(".ccbi");
-    // Add ccbi suffix
-    if (!CCBReader::endsWith(strCCBFileName.c_str(), strSuffix.c_str()))
+    // Files whose prototype was cached are neither loaded nor parsed again
+    CCBPrototype *pPrototype = CCBPrototypeCache::sharedPrototypeCache()->prototypeForFile(pCCBFileName);
+    if (pPrototype == NULL)
     {
-        strCCBFileName += strSuffix;
+        pPrototype = CCBPrototype::createWithFile(pCCBFileName);
     }
 
-    std::string strPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(strCCBFileName.c_str());
-    unsigned long size = 0;
-
-    unsigned char * pBytes = CCFileUtils::sharedFileUtils()->getFileData(strPath.c_str(), "rb", &size);
-    CCData *data = new CCData(pBytes, size);
-    CC_SAFE_DELETE_ARRAY(pBytes);
-
-    CCNode *ret =  this->readNodeGraphFromData(data, pOwner, parentSize);
-    
-    data->release();
-    
-    return ret;
+    return this->readNodeGraphFromPrototype(pPrototype, pOwner, parentSize);
 }
 
 CCNode* CCBReader::readNodeGraphFromData(CCData *pData, CCObject *pOwner, const CCSize &parentSize)
 {
-    mData = pData;
-    CC_SAFE_RETAIN(mData);
-    mBytes = mData->getBytes();
-    mCurrentByte = 0;
-    mCurrentBit = 0;
+    return this->readNodeGraphFromPrototype(CCBPrototype::createWithData(pData), pOwner, parentSize);
+}
+
+CCNode* CCBReader::readNodeGraphFromPrototype(CCBPrototype *pPrototype, CCObject *pOwner, const CCSize &parentSize)
+{
+    setPrototype(pPrototype);
     mOwner = pOwner;
     CC_SAFE_RETAIN(mOwner);
 
@@ -336,17 +684,27 @@ void CCBReader::cleanUpNodeGraph(CCNode *pNode)
     }
 }
 
+void CCBReader::setPrototype(CCBPrototype *pPrototype)
+{
+    CC_SAFE_RETAIN(pPrototype);
+    CC_SAFE_RELEASE(mPrototype);
+    mPrototype = pPrototype;
+}
+
 CCNode* CCBReader::readFileWithCleanUp(bool bCleanUp, CCDictionary* am)
 {
-    if (! readHeader())
-    {
-        return NULL;
-    }
-    
-    if (! readStringCache())
+    /* If no file parsed, don't crash about it. */
+    if (mPrototype == NULL)
     {
         return NULL;
     }
+
+    // The header and the string cache were parsed by the prototype, carry on with the sequences
+    mBytes = mPrototype->mData->getBytes();
+    mCurrentByte = mPrototype->mNodeGraphOffset;
+    mCurrentBit = 0;
+    jsControlled = mPrototype->mJSControlled;
+    mStringLoaders.assign(mPrototype->mStringCache.size(), (CCNodeLoader*)NULL);
     
     if (! readSequences())
     {
@@ -367,44 +725,6 @@ CCNode* CCBReader::readFileWithCleanUp(bool bCleanUp, CCDictionary* am)
     return pNode;
 }
 
-bool CCBReader::readStringCache() {
-    int numStrings = this->readInt(false);
-
-    for(int i = 0; i < numStrings; i++) {
-        this->mStringCache.push_back(this->readUTF8());
-    }
-
-    return true;
-}
-
-bool CCBReader::readHeader()
-{
-    /* If no bytes loaded, don't crash about it. */
-    if(this->mBytes == NULL) {
-        return false;
-    }
-
-    /* Read magic bytes */
-    int magicBytes = *((int*)(this->mBytes + this->mCurrentByte));
-    this->mCurrentByte += 4;
-
-    if(CC_SWAP_INT32_LITTLE_TO_HOST(magicBytes) != 'ccbi') {
-        return false; 
-    }
-
-    /* Read version. */
-    int version = this->readInt(false);
-    if(version != kCCBVersion) {
-        CCLog("WARNING! Incompatible ccbi file version (file: %d reader: %d)", version, kCCBVersion);
-        return false;
-    }
-
-    // Read JS check
-    jsControlled = this->readBool();
-
-    return true;
-}
-
 unsigned char CCBReader::readByte() {
     unsigned char byte = this->mBytes[this->mCurrentByte];
     this->mCurrentByte++;
@@ -424,73 +744,15 @@ std::string CCBReader::readUTF8()
 
     int numBytes = b0 << 8 | b1;
 
-    char* pStr = (char*)malloc(numBytes+1);
-    memcpy(pStr, mBytes+mCurrentByte, numBytes);
-    pStr[numBytes] = '\0';
-    ret = pStr;
-    free(pStr);
+    ret.assign((const char*)(mBytes + mCurrentByte), numBytes);
 
     mCurrentByte += numBytes;
 
     return ret;
 }
 
-bool CCBReader::getBit() {
-    bool bit;
-    unsigned char byte = *(this->mBytes + this->mCurrentByte);
-    if(byte & (1 << this->mCurrentBit)) {
-        bit = true;
-    } else {
-        bit = false;
-    }
-
-    this->mCurrentBit++;
-
-    if(this->mCurrentBit >= 8) {
-        this->mCurrentBit = 0;
-        this->mCurrentByte++;
-    }
-
-    return bit;
-}
-
-void CCBReader::alignBits() {
-    if(this->mCurrentBit) {
-        this->mCurrentBit = 0;
-        this->mCurrentByte++;
-    }
-}
-
 int CCBReader::readInt(bool pSigned) {
-    // Read encoded int
-    int numBits = 0;
-    while(!this->getBit()) {
-        numBits++;
-    }
-    
-    long long current = 0;
-    for(int a = numBits - 1; a >= 0; a--) {
-        if(this->getBit()) {
-            current |= 1LL << a;
-        }
-    }
-    current |= 1LL << numBits;
-    
-    int num;
-    if(pSigned) {
-        int s = current % 2;
-        if(s) {
-            num = (int)(current / 2);
-        } else {
-            num = (int)(-current / 2);
-        }
-    } else {
-        num = current - 1;
-    }
-    
-    this->alignBits();
-    
-    return num;
+    return readEncodedInt(this->mBytes, this->mCurrentByte, this->mCurrentBit, pSigned);
 }
 
 
@@ -523,18 +785,72 @@ float CCBReader::readFloat() {
 }
 
 std::string CCBReader::readCachedString() {
+    return this->readCachedCString();
+}
+
+const char* CCBReader::readCachedCString() {
+    int n = this->readInt(false);
+    return this->mPrototype->mStringCache[n];
+}
+
+const char* CCBReader::readPropertyName(int *pPropertyId) {
+    int n = this->readInt(false);
+
+    int propertyId = this->mPrototype->mStringPropertyIds[n];
+
+    this->mCurrentPropertyName = this->mPrototype->mStringCache[n];
+    this->mCurrentPropertyId = propertyId;
+
+    if (pPropertyId)
+    {
+        *pPropertyId = propertyId;
+    }
+    return this->mCurrentPropertyName;
+}
+
+int CCBReader::getPropertyId(const char *pPropertyName) {
+    if (pPropertyName == this->mCurrentPropertyName)
+    {
+        return this->mCurrentPropertyId;
+    }
+    return propertyIdForName(pPropertyName);
+}
+
+int CCBReader::propertyIdForName(const char *pPropertyName) {
+    if (! s_propertyHashBuilt)
+    {
+        buildPropertyHash();
+    }
+
+    unsigned char index = s_propertyHash[hashPropertyName(pPropertyName, s_propertyHashSeed)];
+    if (index != kCCBPropertyHashEmpty && strcmp(s_propertyNames[index].name, pPropertyName) == 0)
+    {
+        return s_propertyNames[index].id;
+    }
+    return kCCBPropertyUnknown;
+}
+
+CCNodeLoader* CCBReader::readNodeLoader(const char **pClassName) {
     int n = this->readInt(false);
-    return this->mStringCache[n];
+    *pClassName = this->mPrototype->mStringCache[n];
+
+    // every node of a class shares its loader, so it is only looked up once per file
+    if (this->mStringLoaders[n] == NULL)
+    {
+        this->mStringLoaders[n] = this->mCCNodeLoaderLibrary->getCCNodeLoader(*pClassName);
+    }
+    return this->mStringLoaders[n];
 }
 
 CCNode * CCBReader::readNodeGraph(CCNode * pParent) {
     /* Read class name. */
-    std::string className = this->readCachedString();
+    const char *className = NULL;
+    CCNodeLoader *ccNodeLoader = this->readNodeLoader(&className);
 
-    std::string jsControlledName;
+    const char *jsControlledName = NULL;
     
     if(jsControlled) {
-        jsControlledName = this->readCachedString();
+        jsControlledName = this->readCachedCString();
     }
     
     // Read assignment type and name
@@ -544,10 +860,9 @@ CCNode * CCBReader::readNodeGraph(CCNode * pParent) {
         memberVarAssignmentName = this->readCachedString();
     }
 
-    CCNodeLoader *ccNodeLoader = this->mCCNodeLoaderLibrary->getCCNodeLoader(className.c_str());
     if (! ccNodeLoader)
     {
-        CCLog("no corresponding node loader for %s", className.c_str());
+        CCLog("no corresponding node loader for %s", className);
         return NULL;
     }
 
@@ -582,7 +897,7 @@ CCNode * CCBReader::readNodeGraph(CCNode * pParent) {
             CCBSequenceProperty *seqProp = new CCBSequenceProperty();
             seqProp->autorelease();
             
-            seqProp->setName(readCachedString().c_str());
+            seqProp->setName(readCachedCString());
             seqProp->setType(readInt(false));
             mAnimatedProps->insert(seqProp->getName());
             
@@ -836,7 +1151,7 @@ bool CCBReader::readSequences()
         seq->autorelease();
         
         seq->setDuration(readFloat());
-        seq->setName(readCachedString().c_str());
+        seq->setName(readCachedCString());
         seq->setSequenceId(readInt(false));
         seq->setChainedSequenceId(readInt(true));
         
@@ -128,6 +128,98 @@ enum
     kCCBScaleTypeMultiplyResolution
 };
 
+/* Properties handled by the built-in loaders. CCBReader resolves the names in the
+ * string cache of a ccbi file to these IDs once, so loaders can switch on them. */
+enum
+{
+    kCCBPropertyUnknown = -1,
+    kCCBPropertyAnchorPoint,
+    kCCBPropertyAngle,
+    kCCBPropertyBackgroundSpriteFrameDisabled,
+    kCCBPropertyBackgroundSpriteFrameHighlighted,
+    kCCBPropertyBackgroundSpriteFrameNormal,
+    kCCBPropertyBlendFunc,
+    kCCBPropertyBlock,
+    kCCBPropertyBounces,
+    kCCBPropertyCCBFile,
+    kCCBPropertyCCControl,
+    kCCBPropertyClipsToBounds,
+    kCCBPropertyColor,
+    kCCBPropertyContainer,
+    kCCBPropertyContentSize,
+    kCCBPropertyDimensions,
+    kCCBPropertyDirection,
+    kCCBPropertyDisabledSpriteFrame,
+    kCCBPropertyDisplayFrame,
+    kCCBPropertyDuration,
+    kCCBPropertyEmissionRate,
+    kCCBPropertyEmitterMode,
+    kCCBPropertyEnabled,
+    kCCBPropertyEndColor,
+    kCCBPropertyEndOpacity,
+    kCCBPropertyEndRadius,
+    kCCBPropertyEndSize,
+    kCCBPropertyEndSpin,
+    kCCBPropertyFlip,
+    kCCBPropertyFntFile,
+    kCCBPropertyFontName,
+    kCCBPropertyFontSize,
+    kCCBPropertyGravity,
+    kCCBPropertyHorizontalAlignment,
+    kCCBPropertyIgnoreAnchorPointForPosition,
+    kCCBPropertyInsetBottom,
+    kCCBPropertyInsetLeft,
+    kCCBPropertyInsetRight,
+    kCCBPropertyInsetTop,
+    kCCBPropertyIsAccelerometerEnabled,
+    kCCBPropertyIsEnabled,
+    kCCBPropertyIsKeyboardEnabled,
+    kCCBPropertyIsMouseEnabled,
+    kCCBPropertyIsTouchEnabled,
+    kCCBPropertyLabelAnchorPoint,
+    kCCBPropertyLife,
+    kCCBPropertyNormalSpriteFrame,
+    kCCBPropertyOpacity,
+    kCCBPropertyPosition,
+    kCCBPropertyPosVar,
+    kCCBPropertyPreferedSize,
+    kCCBPropertyRadialAccel,
+    kCCBPropertyRotatePerSecond,
+    kCCBPropertyRotation,
+    kCCBPropertyScale,
+    kCCBPropertySelected,
+    kCCBPropertySelectedSpriteFrame,
+    kCCBPropertySpeed,
+    kCCBPropertySpriteFrame,
+    kCCBPropertyStartColor,
+    kCCBPropertyStartOpacity,
+    kCCBPropertyStartRadius,
+    kCCBPropertyStartSize,
+    kCCBPropertyStartSpin,
+    kCCBPropertyString,
+    kCCBPropertyTag,
+    kCCBPropertyTangentialAccel,
+    kCCBPropertyTexture,
+    kCCBPropertyTitleColorDisabled,
+    kCCBPropertyTitleColorHighlighted,
+    kCCBPropertyTitleColorNormal,
+    kCCBPropertyTitleDisabled,
+    kCCBPropertyTitleHighlighted,
+    kCCBPropertyTitleNormal,
+    kCCBPropertyTitleTTFDisabled,
+    kCCBPropertyTitleTTFHighlighted,
+    kCCBPropertyTitleTTFNormal,
+    kCCBPropertyTitleTTFSizeDisabled,
+    kCCBPropertyTitleTTFSizeHighlighted,
+    kCCBPropertyTitleTTFSizeNormal,
+    kCCBPropertyTotalParticles,
+    kCCBPropertyVector,
+    kCCBPropertyVerticalAlignment,
+    kCCBPropertyVisible,
+    kCCBPropertyZoomOnTouchDown,
+    kCCBPropertyCount
+};
+
 
 NS_CC_EXT_BEGIN
 
@@ -160,6 +252,45 @@ class CCBAnimationManager;
 class CCData;
 class CCBKeyframe;
 
+/**
+ * @brief A ccbi file parsed once, from which CCBReader instantiates node graphs.
+ *
+ * It owns the file data and its string cache, with every property name already
+ * resolved to its kCCBProperty ID, so CCBReader::readNodeGraphFromPrototype() neither
+ * touches CCFileUtils nor parses the header and the strings again.
+ * A prototype doesn't change once created and may be shared by any number of readers.
+ * @since v2.1.x
+ */
+class CCBPrototype : public CCObject
+{
+private:
+    CCData *mData;
+    bool mJSControlled;
+    int mNodeGraphOffset;                   // where the sequences start, right after the string cache
+
+    char *mStringArena;                     // every cached string, NUL terminated, in one buffer
+    std::vector<const char*> mStringCache;  // points into mStringArena
+    std::vector<int> mStringPropertyIds;    // property ID of every cached string
+
+    friend class CCBReader;
+
+public:
+    CCBPrototype();
+    virtual ~CCBPrototype();
+
+    /** Loads and parses pCCBFileName, the .ccbi suffix may be omitted. Returns NULL if it isn't a valid ccbi file. */
+    static CCBPrototype* createWithFile(const char *pCCBFileName);
+    /** Parses pData, which is retained. Returns NULL if it isn't a valid ccbi file. */
+    static CCBPrototype* createWithData(CCData *pData);
+    bool initWithData(CCData *pData);
+
+    /** Returns the full path of pCCBFileName, adding the .ccbi suffix when it is missing */
+    static std::string fullPathForFile(const char *pCCBFileName);
+
+    CCData* getData();
+    bool isJSControlled();
+};
+
 /**
  * @brief Parse CCBI file which is generated by CocosBuilder
  */
@@ -168,12 +299,14 @@ class CCBReader : public CCObject
 private:
     
     bool jsControlled;
-    CCData *mData;
+    CCBPrototype *mPrototype;               // the parsed file, retained
     unsigned char *mBytes;
     int mCurrentByte;
     int mCurrentBit;
     
-    std::vector<std::string> mStringCache;
+    std::vector<CCNodeLoader*> mStringLoaders; // node loader of every cached class name, resolved on first use
+    const char *mCurrentPropertyName;       // the property CCNodeLoader::parseProperties() is handling
+    int mCurrentPropertyId;
     std::set<std::string> mLoadedSpriteSheets;
     
     CCObject *mOwner;
@@ -211,6 +344,11 @@ public:
     CCNode* readNodeGraphFromFile(const char *pCCBFileName, CCObject *pOwner, const CCSize &parentSize);
     
     CCNode* readNodeGraphFromData(CCData *pData, CCObject *pOwner, const CCSize &parentSize);
+    /** Instantiates the node graph of an already parsed file. This is what readNodeGraphFromFile()
+     does too when CCBPrototypeCache holds a prototype of the file.
+     @since v2.1.x
+     */
+    CCNode* readNodeGraphFromPrototype(CCBPrototype *pPrototype, CCObject *pOwner, const CCSize &parentSize);
    
     CCScene* createSceneWithNodeGraphFromFile(const char *pCCBFileName);
     CCScene* createSceneWithNodeGraphFromFile(const char *pCCBFileName, CCObject *pOwner);
@@ -240,6 +378,18 @@ public:
     std::string readUTF8();
     float readFloat();
     std::string readCachedString();
+    /** Same as readCachedString() without the copy. The string lives as long as the reader's prototype. */
+    const char* readCachedCString();
+    /** Reads the name of the next property and stores its kCCBProperty ID into pPropertyId.
+     The ID is resolved once per prototype, not once per property.
+     */
+    const char* readPropertyName(int *pPropertyId);
+    /** Returns the kCCBProperty ID of pPropertyName, kCCBPropertyUnknown for custom properties.
+     It is O(1) for the property being parsed, which is what the onHandleProp* methods get.
+     */
+    int getPropertyId(const char *pPropertyName);
+    /** Looks pPropertyName up in the perfect hash of the kCCBProperty names */
+    static int propertyIdForName(const char *pPropertyName);
     bool isJSControlled();
             
     
@@ -269,14 +419,10 @@ private:
     bool readSequences();
     CCBKeyframe* readKeyframe(int type);
     
-    bool readHeader();
-    bool readStringCache();
-    //void readStringCacheEntry();
+    void setPrototype(CCBPrototype *pPrototype);
     CCNode* readNodeGraph();
     CCNode* readNodeGraph(CCNode * pParent);
-
-    bool getBit();
-    void alignBits();
+    CCNodeLoader* readNodeLoader(const char **pClassName);
 
     friend class CCNodeLoader;
 };
@@ -3,112 +3,127 @@
 
 NS_CC_EXT_BEGIN;
 
-#define PROPERTY_ZOOMONTOUCHDOWN "zoomOnTouchDown"
-#define PROPERTY_TITLE_NORMAL "title|1"
-#define PROPERTY_TITLE_HIGHLIGHTED "title|2"
-#define PROPERTY_TITLE_DISABLED "title|3"
-#define PROPERTY_TITLECOLOR_NORMAL "titleColor|1"
-#define PROPERTY_TITLECOLOR_HIGHLIGHTED "titleColor|2"
-#define PROPERTY_TITLECOLOR_DISABLED "titleColor|3"
-#define PROPERTY_TITLETTF_NORMAL "titleTTF|1"
-#define PROPERTY_TITLETTF_HIGHLIGHTED "titleTTF|2"
-#define PROPERTY_TITLETTF_DISABLED "titleTTF|3"
-#define PROPERTY_TITLETTFSIZE_NORMAL "titleTTFSize|1"
-#define PROPERTY_TITLETTFSIZE_HIGHLIGHTED "titleTTFSize|2"
-#define PROPERTY_TITLETTFSIZE_DISABLED "titleTTFSize|3"
-#define PROPERTY_LABELANCHORPOINT "labelAnchorPoint"
-#define PROPERTY_PREFEREDSIZE "preferedSize" // TODO Should be "preferredSize". This is a typo in cocos2d-iphone, cocos2d-x and CocosBuilder!
-#define PROPERTY_BACKGROUNDSPRITEFRAME_NORMAL "backgroundSpriteFrame|1"
-#define PROPERTY_BACKGROUNDSPRITEFRAME_HIGHLIGHTED "backgroundSpriteFrame|2"
-#define PROPERTY_BACKGROUNDSPRITEFRAME_DISABLED "backgroundSpriteFrame|3"
-
 void CCControlButtonLoader::onHandlePropTypeCheck(CCNode * pNode, CCNode * pParent, const char * pPropertyName, bool pCheck, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_ZOOMONTOUCHDOWN) == 0) {
-        ((CCControlButton *)pNode)->setZoomOnTouchDown(pCheck);
-    } else {
-        CCControlLoader::onHandlePropTypeCheck(pNode, pParent, pPropertyName, pCheck, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyZoomOnTouchDown:
+            ((CCControlButton *)pNode)->setZoomOnTouchDown(pCheck);
+            break;
+        default:
+            CCControlLoader::onHandlePropTypeCheck(pNode, pParent, pPropertyName, pCheck, pCCBReader);
+            break;
     }
 }
 
 void CCControlButtonLoader::onHandlePropTypeString(CCNode * pNode, CCNode * pParent, const char * pPropertyName, const char * pString, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_TITLE_NORMAL) == 0) {
-        ((CCControlButton *)pNode)->setTitleForState(CCString::create(pString), CCControlStateNormal);
-    } else if(strcmp(pPropertyName, PROPERTY_TITLE_HIGHLIGHTED) == 0) {
-        ((CCControlButton *)pNode)->setTitleForState(CCString::create(pString), CCControlStateHighlighted);
-    } else if(strcmp(pPropertyName, PROPERTY_TITLE_DISABLED) == 0) {
-        ((CCControlButton *)pNode)->setTitleForState(CCString::create(pString), CCControlStateDisabled);
-    } else {
-        CCControlLoader::onHandlePropTypeString(pNode, pParent, pPropertyName, pString, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyTitleNormal:
+            ((CCControlButton *)pNode)->setTitleForState(CCString::create(pString), CCControlStateNormal);
+            break;
+        case kCCBPropertyTitleHighlighted:
+            ((CCControlButton *)pNode)->setTitleForState(CCString::create(pString), CCControlStateHighlighted);
+            break;
+        case kCCBPropertyTitleDisabled:
+            ((CCControlButton *)pNode)->setTitleForState(CCString::create(pString), CCControlStateDisabled);
+            break;
+        default:
+            CCControlLoader::onHandlePropTypeString(pNode, pParent, pPropertyName, pString, pCCBReader);
+            break;
     }
 }
 
 void CCControlButtonLoader::onHandlePropTypeFontTTF(CCNode * pNode, CCNode * pParent, const char * pPropertyName, const char * pFontTTF, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_TITLETTF_NORMAL) == 0) {
-        ((CCControlButton *)pNode)->setTitleTTFForState(pFontTTF, CCControlStateNormal);
-    } else if(strcmp(pPropertyName, PROPERTY_TITLETTF_HIGHLIGHTED) == 0) {
-        ((CCControlButton *)pNode)->setTitleTTFForState(pFontTTF, CCControlStateHighlighted);
-    } else if(strcmp(pPropertyName, PROPERTY_TITLETTF_DISABLED) == 0) {
-        ((CCControlButton *)pNode)->setTitleTTFForState(pFontTTF, CCControlStateDisabled);
-    } else {
-        CCControlLoader::onHandlePropTypeFontTTF(pNode, pParent, pPropertyName, pFontTTF, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyTitleTTFNormal:
+            ((CCControlButton *)pNode)->setTitleTTFForState(pFontTTF, CCControlStateNormal);
+            break;
+        case kCCBPropertyTitleTTFHighlighted:
+            ((CCControlButton *)pNode)->setTitleTTFForState(pFontTTF, CCControlStateHighlighted);
+            break;
+        case kCCBPropertyTitleTTFDisabled:
+            ((CCControlButton *)pNode)->setTitleTTFForState(pFontTTF, CCControlStateDisabled);
+            break;
+        default:
+            CCControlLoader::onHandlePropTypeFontTTF(pNode, pParent, pPropertyName, pFontTTF, pCCBReader);
+            break;
     }
 }
 
 void CCControlButtonLoader::onHandlePropTypeFloatScale(CCNode * pNode, CCNode * pParent, const char * pPropertyName, float pFloatScale, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_TITLETTFSIZE_NORMAL) == 0) {
-        ((CCControlButton *)pNode)->setTitleTTFSizeForState(pFloatScale, CCControlStateNormal);
-    } else if(strcmp(pPropertyName, PROPERTY_TITLETTFSIZE_HIGHLIGHTED) == 0) {
-        ((CCControlButton *)pNode)->setTitleTTFSizeForState(pFloatScale, CCControlStateHighlighted);
-    } else if(strcmp(pPropertyName, PROPERTY_TITLETTFSIZE_DISABLED) == 0) {
-        ((CCControlButton *)pNode)->setTitleTTFSizeForState(pFloatScale, CCControlStateDisabled);
-    } else {
-        CCControlLoader::onHandlePropTypeFloatScale(pNode, pParent, pPropertyName, pFloatScale, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyTitleTTFSizeNormal:
+            ((CCControlButton *)pNode)->setTitleTTFSizeForState(pFloatScale, CCControlStateNormal);
+            break;
+        case kCCBPropertyTitleTTFSizeHighlighted:
+            ((CCControlButton *)pNode)->setTitleTTFSizeForState(pFloatScale, CCControlStateHighlighted);
+            break;
+        case kCCBPropertyTitleTTFSizeDisabled:
+            ((CCControlButton *)pNode)->setTitleTTFSizeForState(pFloatScale, CCControlStateDisabled);
+            break;
+        default:
+            CCControlLoader::onHandlePropTypeFloatScale(pNode, pParent, pPropertyName, pFloatScale, pCCBReader);
+            break;
     }
 }
 
 void CCControlButtonLoader::onHandlePropTypePoint(CCNode * pNode, CCNode * pParent, const char * pPropertyName, CCPoint pPoint, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_LABELANCHORPOINT) == 0) {
-        ((CCControlButton *)pNode)->setLabelAnchorPoint(pPoint);
-    } else {
-        CCControlLoader::onHandlePropTypePoint(pNode, pParent, pPropertyName, pPoint, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyLabelAnchorPoint:
+            ((CCControlButton *)pNode)->setLabelAnchorPoint(pPoint);
+            break;
+        default:
+            CCControlLoader::onHandlePropTypePoint(pNode, pParent, pPropertyName, pPoint, pCCBReader);
+            break;
     }
 }
 
 void CCControlButtonLoader::onHandlePropTypeSize(CCNode * pNode, CCNode * pParent, const char * pPropertyName, CCSize pSize, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_PREFEREDSIZE) == 0) {
-        ((CCControlButton *)pNode)->setPreferredSize(pSize);
-    } else {
-        CCControlLoader::onHandlePropTypeSize(pNode, pParent, pPropertyName, pSize, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyPreferedSize:
+            ((CCControlButton *)pNode)->setPreferredSize(pSize);
+            break;
+        default:
+            CCControlLoader::onHandlePropTypeSize(pNode, pParent, pPropertyName, pSize, pCCBReader);
+            break;
     }
 }
 
 void CCControlButtonLoader::onHandlePropTypeSpriteFrame(CCNode * pNode, CCNode * pParent, const char * pPropertyName, CCSpriteFrame * pCCSpriteFrame, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_BACKGROUNDSPRITEFRAME_NORMAL) == 0) {
-        if(pCCSpriteFrame != NULL) {
-            ((CCControlButton *)pNode)->setBackgroundSpriteFrameForState(pCCSpriteFrame, CCControlStateNormal);
-        }
-    } else if(strcmp(pPropertyName, PROPERTY_BACKGROUNDSPRITEFRAME_HIGHLIGHTED) == 0) {
-        if(pCCSpriteFrame != NULL) {
-            ((CCControlButton *)pNode)->setBackgroundSpriteFrameForState(pCCSpriteFrame, CCControlStateHighlighted);
-        }
-    } else if(strcmp(pPropertyName, PROPERTY_BACKGROUNDSPRITEFRAME_DISABLED) == 0) {
-        if(pCCSpriteFrame != NULL) {
-            ((CCControlButton *)pNode)->setBackgroundSpriteFrameForState(pCCSpriteFrame, CCControlStateDisabled);
-        }
-    } else {
-        CCControlLoader::onHandlePropTypeSpriteFrame(pNode, pParent, pPropertyName, pCCSpriteFrame, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyBackgroundSpriteFrameNormal:
+            if(pCCSpriteFrame != NULL) {
+                ((CCControlButton *)pNode)->setBackgroundSpriteFrameForState(pCCSpriteFrame, CCControlStateNormal);
+            }
+            break;
+        case kCCBPropertyBackgroundSpriteFrameHighlighted:
+            if(pCCSpriteFrame != NULL) {
+                ((CCControlButton *)pNode)->setBackgroundSpriteFrameForState(pCCSpriteFrame, CCControlStateHighlighted);
+            }
+            break;
+        case kCCBPropertyBackgroundSpriteFrameDisabled:
+            if(pCCSpriteFrame != NULL) {
+                ((CCControlButton *)pNode)->setBackgroundSpriteFrameForState(pCCSpriteFrame, CCControlStateDisabled);
+            }
+            break;
+        default:
+            CCControlLoader::onHandlePropTypeSpriteFrame(pNode, pParent, pPropertyName, pCCSpriteFrame, pCCBReader);
+            break;
     }
 }
 
 void CCControlButtonLoader::onHandlePropTypeColor3(CCNode * pNode, CCNode * pParent, const char * pPropertyName, ccColor3B pCCColor3B, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_TITLECOLOR_NORMAL) == 0) {
-        ((CCControlButton *)pNode)->setTitleColorForState(pCCColor3B, CCControlStateNormal);
-    } else if(strcmp(pPropertyName, PROPERTY_TITLECOLOR_HIGHLIGHTED) == 0) {
-        ((CCControlButton *)pNode)->setTitleColorForState(pCCColor3B, CCControlStateHighlighted);
-    } else if(strcmp(pPropertyName, PROPERTY_TITLECOLOR_DISABLED) == 0) {
-        ((CCControlButton *)pNode)->setTitleColorForState(pCCColor3B, CCControlStateDisabled);
-    } else {
-        CCControlLoader::onHandlePropTypeColor3(pNode, pParent, pPropertyName, pCCColor3B, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyTitleColorNormal:
+            ((CCControlButton *)pNode)->setTitleColorForState(pCCColor3B, CCControlStateNormal);
+            break;
+        case kCCBPropertyTitleColorHighlighted:
+            ((CCControlButton *)pNode)->setTitleColorForState(pCCColor3B, CCControlStateHighlighted);
+            break;
+        case kCCBPropertyTitleColorDisabled:
+            ((CCControlButton *)pNode)->setTitleColorForState(pCCColor3B, CCControlStateDisabled);
+            break;
+        default:
+            CCControlLoader::onHandlePropTypeColor3(pNode, pParent, pPropertyName, pCCColor3B, pCCBReader);
+            break;
     }
 }
 
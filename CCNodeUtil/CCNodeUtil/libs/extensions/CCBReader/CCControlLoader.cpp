@@ -3,25 +3,28 @@
 
 NS_CC_EXT_BEGIN
 
-#define PROPERTY_ENABLED "enabled"
-#define PROPERTY_SELECTED "selected"
-#define PROPERTY_CCCONTROL "ccControl"
-
 void CCControlLoader::onHandlePropTypeCheck(CCNode * pNode, CCNode * pParent, const char * pPropertyName, bool pCheck, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_ENABLED) == 0) {
-        ((CCControl *)pNode)->setEnabled(pCheck);
-    } else if(strcmp(pPropertyName, PROPERTY_SELECTED) == 0) {
-        ((CCControl *)pNode)->setSelected(pCheck);
-    } else {
-        CCNodeLoader::onHandlePropTypeCheck(pNode, pParent, pPropertyName, pCheck, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyEnabled:
+            ((CCControl *)pNode)->setEnabled(pCheck);
+            break;
+        case kCCBPropertySelected:
+            ((CCControl *)pNode)->setSelected(pCheck);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeCheck(pNode, pParent, pPropertyName, pCheck, pCCBReader);
+            break;
     }
 }
 
 void CCControlLoader::onHandlePropTypeBlockCCControl(CCNode * pNode, CCNode * pParent, const char * pPropertyName, BlockCCControlData * pBlockCCControlData, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_CCCONTROL) == 0) {
-        ((CCControl *)pNode)->addTargetWithActionForControlEvents(pBlockCCControlData->mTarget, pBlockCCControlData->mSELCCControlHandler, pBlockCCControlData->mControlEvents);
-    } else {
-        CCNodeLoader::onHandlePropTypeBlockCCControl(pNode, pParent, pPropertyName, pBlockCCControlData, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyCCControl:
+            ((CCControl *)pNode)->addTargetWithActionForControlEvents(pBlockCCControlData->mTarget, pBlockCCControlData->mSELCCControlHandler, pBlockCCControlData->mControlEvents);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeBlockCCControl(pNode, pParent, pPropertyName, pBlockCCControlData, pCCBReader);
+            break;
     }
 }
 
@@ -4,49 +4,58 @@
 
 NS_CC_EXT_BEGIN
 
-#define PROPERTY_COLOR "color"
-#define PROPERTY_OPACITY "opacity"
-#define PROPERTY_BLENDFUNC "blendFunc"
-#define PROPERTY_FNTFILE "fntFile"
-#define PROPERTY_STRING "string"
-
 void CCLabelBMFontLoader::onHandlePropTypeColor3(CCNode * pNode, CCNode * pParent, const char * pPropertyName, ccColor3B pCCColor3B, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_COLOR) == 0) {
-        ((CCLabelBMFont *)pNode)->setColor(pCCColor3B);
-    } else {
-        CCNodeLoader::onHandlePropTypeColor3(pNode, pParent, pPropertyName, pCCColor3B, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyColor:
+            ((CCLabelBMFont *)pNode)->setColor(pCCColor3B);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeColor3(pNode, pParent, pPropertyName, pCCColor3B, pCCBReader);
+            break;
     }
 }
 
 void CCLabelBMFontLoader::onHandlePropTypeByte(CCNode * pNode, CCNode * pParent, const char * pPropertyName, unsigned char pByte, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_OPACITY) == 0) {
-        ((CCLabelBMFont *)pNode)->setOpacity(pByte);
-    } else {
-        CCNodeLoader::onHandlePropTypeByte(pNode, pParent, pPropertyName, pByte, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyOpacity:
+            ((CCLabelBMFont *)pNode)->setOpacity(pByte);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeByte(pNode, pParent, pPropertyName, pByte, pCCBReader);
+            break;
     }
 }
 
 void CCLabelBMFontLoader::onHandlePropTypeBlendFunc(CCNode * pNode, CCNode * pParent, const char * pPropertyName, ccBlendFunc pCCBlendFunc, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_BLENDFUNC) == 0) {
-        ((CCLabelBMFont *)pNode)->setBlendFunc(pCCBlendFunc);
-    } else {
-        CCNodeLoader::onHandlePropTypeBlendFunc(pNode, pParent, pPropertyName, pCCBlendFunc, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyBlendFunc:
+            ((CCLabelBMFont *)pNode)->setBlendFunc(pCCBlendFunc);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeBlendFunc(pNode, pParent, pPropertyName, pCCBlendFunc, pCCBReader);
+            break;
     }
 }
 
 void CCLabelBMFontLoader::onHandlePropTypeFntFile(CCNode * pNode, CCNode * pParent, const char * pPropertyName, const char* pFntFile, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_FNTFILE) == 0) {
-        ((CCLabelBMFont *)pNode)->setFntFile(pFntFile);
-    } else {
-        CCNodeLoader::onHandlePropTypeFntFile(pNode, pParent, pPropertyName, pFntFile, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyFntFile:
+            ((CCLabelBMFont *)pNode)->setFntFile(pFntFile);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeFntFile(pNode, pParent, pPropertyName, pFntFile, pCCBReader);
+            break;
     }
 }
 
 void CCLabelBMFontLoader::onHandlePropTypeText(CCNode * pNode, CCNode * pParent, const char * pPropertyName, const char* pText, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_STRING) == 0) {
-        ((CCLabelBMFont *)pNode)->setString(pText);
-    } else {
-        CCNodeLoader::onHandlePropTypeText(pNode, pParent, pPropertyName, pText, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyString:
+            ((CCLabelBMFont *)pNode)->setString(pText);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeText(pNode, pParent, pPropertyName, pText, pCCBReader);
+            break;
     }
 }
 
@@ -2,81 +2,96 @@
 
 
 
-#define PROPERTY_COLOR "color"
-#define PROPERTY_OPACITY "opacity"
-#define PROPERTY_BLENDFUNC "blendFunc"
-#define PROPERTY_FONTNAME "fontName"
-#define PROPERTY_FONTSIZE "fontSize"
-#define PROPERTY_HORIZONTALALIGNMENT "horizontalAlignment"
-#define PROPERTY_VERTICALALIGNMENT "verticalAlignment"
-#define PROPERTY_STRING "string"
-#define PROPERTY_DIMENSIONS "dimensions"
-
 NS_CC_EXT_BEGIN
 
 void CCLabelTTFLoader::onHandlePropTypeColor3(CCNode * pNode, CCNode * pParent, const char * pPropertyName, ccColor3B pCCColor3B, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_COLOR) == 0) {
-        ((CCLabelTTF *)pNode)->setColor(pCCColor3B);
-    } else {
-        CCNodeLoader::onHandlePropTypeColor3(pNode, pParent, pPropertyName, pCCColor3B, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyColor:
+            ((CCLabelTTF *)pNode)->setColor(pCCColor3B);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeColor3(pNode, pParent, pPropertyName, pCCColor3B, pCCBReader);
+            break;
     }
 }
 
 void CCLabelTTFLoader::onHandlePropTypeByte(CCNode * pNode, CCNode * pParent, const char * pPropertyName, unsigned char pByte, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_OPACITY) == 0) {
-        ((CCLabelTTF *)pNode)->setOpacity(pByte);
-    } else {
-        CCNodeLoader::onHandlePropTypeByte(pNode, pParent, pPropertyName, pByte, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyOpacity:
+            ((CCLabelTTF *)pNode)->setOpacity(pByte);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeByte(pNode, pParent, pPropertyName, pByte, pCCBReader);
+            break;
     }
 }
 
 void CCLabelTTFLoader::onHandlePropTypeBlendFunc(CCNode * pNode, CCNode * pParent, const char * pPropertyName, ccBlendFunc pCCBlendFunc, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_BLENDFUNC) == 0) {
-        ((CCLabelTTF *)pNode)->setBlendFunc(pCCBlendFunc);
-    } else {
-        CCNodeLoader::onHandlePropTypeBlendFunc(pNode, pParent, pPropertyName, pCCBlendFunc, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyBlendFunc:
+            ((CCLabelTTF *)pNode)->setBlendFunc(pCCBlendFunc);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeBlendFunc(pNode, pParent, pPropertyName, pCCBlendFunc, pCCBReader);
+            break;
     }
 }
 
 void CCLabelTTFLoader::onHandlePropTypeFontTTF(CCNode * pNode, CCNode * pParent, const char * pPropertyName, const char * pFontTTF, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_FONTNAME) == 0) {
-        ((CCLabelTTF *)pNode)->setFontName(pFontTTF);
-    } else {
-        CCNodeLoader::onHandlePropTypeFontTTF(pNode, pParent, pPropertyName, pFontTTF, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyFontName:
+            ((CCLabelTTF *)pNode)->setFontName(pFontTTF);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeFontTTF(pNode, pParent, pPropertyName, pFontTTF, pCCBReader);
+            break;
     }
 }
 
 void CCLabelTTFLoader::onHandlePropTypeText(CCNode * pNode, CCNode * pParent, const char * pPropertyName, const char * pText, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_STRING) == 0) {
-        ((CCLabelTTF *)pNode)->setString(pText);
-    } else {
-        CCNodeLoader::onHandlePropTypeText(pNode, pParent, pPropertyName, pText, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyString:
+            ((CCLabelTTF *)pNode)->setString(pText);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeText(pNode, pParent, pPropertyName, pText, pCCBReader);
+            break;
     }
 }
 
 void CCLabelTTFLoader::onHandlePropTypeFloatScale(CCNode * pNode, CCNode * pParent, const char * pPropertyName, float pFloatScale, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_FONTSIZE) == 0) {
-        ((CCLabelTTF *)pNode)->setFontSize(pFloatScale);
-    } else {
-        CCNodeLoader::onHandlePropTypeFloatScale(pNode, pParent, pPropertyName, pFloatScale, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyFontSize:
+            ((CCLabelTTF *)pNode)->setFontSize(pFloatScale);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeFloatScale(pNode, pParent, pPropertyName, pFloatScale, pCCBReader);
+            break;
     }
 }
 
 void CCLabelTTFLoader::onHandlePropTypeIntegerLabeled(CCNode * pNode, CCNode * pParent, const char * pPropertyName, int pIntegerLabeled, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_HORIZONTALALIGNMENT) == 0) {
-        ((CCLabelTTF *)pNode)->setHorizontalAlignment(CCTextAlignment(pIntegerLabeled));
-    } else if(strcmp(pPropertyName, PROPERTY_VERTICALALIGNMENT) == 0) {
-        ((CCLabelTTF *)pNode)->setVerticalAlignment(CCVerticalTextAlignment(pIntegerLabeled));
-    } else {
-        CCNodeLoader::onHandlePropTypeFloatScale(pNode, pParent, pPropertyName, pIntegerLabeled, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyHorizontalAlignment:
+            ((CCLabelTTF *)pNode)->setHorizontalAlignment(CCTextAlignment(pIntegerLabeled));
+            break;
+        case kCCBPropertyVerticalAlignment:
+            ((CCLabelTTF *)pNode)->setVerticalAlignment(CCVerticalTextAlignment(pIntegerLabeled));
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeFloatScale(pNode, pParent, pPropertyName, pIntegerLabeled, pCCBReader);
+            break;
     }
 }
 
 void CCLabelTTFLoader::onHandlePropTypeSize(CCNode * pNode, CCNode * pParent, const char * pPropertyName, CCSize pSize, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_DIMENSIONS) == 0) {
-        ((CCLabelTTF *)pNode)->setDimensions(pSize);
-    } else {
-        CCNodeLoader::onHandlePropTypeSize(pNode, pParent, pPropertyName, pSize, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyDimensions:
+            ((CCLabelTTF *)pNode)->setDimensions(pSize);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeSize(pNode, pParent, pPropertyName, pSize, pCCBReader);
+            break;
     }
 }
 
@@ -4,31 +4,36 @@
 
 NS_CC_EXT_BEGIN
 
-#define PROPERTY_COLOR "color"
-#define PROPERTY_OPACITY "opacity"
-#define PROPERTY_BLENDFUNC "blendFunc"
-
 void CCLayerColorLoader::onHandlePropTypeColor3(CCNode * pNode, CCNode * pParent, const char * pPropertyName, ccColor3B pCCColor3B, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_COLOR) == 0) {
-        ((CCLayerColor *)pNode)->setColor(pCCColor3B);
-    } else {
-        CCLayerLoader::onHandlePropTypeColor3(pNode, pParent, pPropertyName, pCCColor3B, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyColor:
+            ((CCLayerColor *)pNode)->setColor(pCCColor3B);
+            break;
+        default:
+            CCLayerLoader::onHandlePropTypeColor3(pNode, pParent, pPropertyName, pCCColor3B, pCCBReader);
+            break;
     }
 }
 
 void CCLayerColorLoader::onHandlePropTypeByte(CCNode * pNode, CCNode * pParent, const char * pPropertyName, unsigned char pByte, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_OPACITY) == 0) {
-        ((CCLayerColor *)pNode)->setOpacity(pByte);
-    } else {
-        CCLayerLoader::onHandlePropTypeByte(pNode, pParent, pPropertyName, pByte, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyOpacity:
+            ((CCLayerColor *)pNode)->setOpacity(pByte);
+            break;
+        default:
+            CCLayerLoader::onHandlePropTypeByte(pNode, pParent, pPropertyName, pByte, pCCBReader);
+            break;
     }
 }
 
 void CCLayerColorLoader::onHandlePropTypeBlendFunc(CCNode * pNode, CCNode * pParent, const char * pPropertyName, ccBlendFunc pCCBlendFunc, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_BLENDFUNC) == 0) {
-        ((CCLayerColor *)pNode)->setBlendFunc(pCCBlendFunc);
-    } else {
-        CCLayerLoader::onHandlePropTypeBlendFunc(pNode, pParent, pPropertyName, pCCBlendFunc, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyBlendFunc:
+            ((CCLayerColor *)pNode)->setBlendFunc(pCCBlendFunc);
+            break;
+        default:
+            CCLayerLoader::onHandlePropTypeBlendFunc(pNode, pParent, pPropertyName, pCCBlendFunc, pCCBReader);
+            break;
     }
 }
 
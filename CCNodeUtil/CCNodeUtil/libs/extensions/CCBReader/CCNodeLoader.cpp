@@ -3,6 +3,7 @@
 #include "CCBMemberVariableAssigner.h"
 #include "CCBAnimationManager.h"
 #include "CCData.h"
+#include "CCBPrototypeCache.h"
 #include "CCNode+CCBRelativePositioning.h"
 
 using namespace std;
@@ -40,7 +41,8 @@ void CCNodeLoader::parseProperties(CCNode * pNode, CCNode * pParent, CCBReader *
     for(int i = 0; i < propertyCount; i++) {
         bool isExtraProp = (i >= numRegularProps);
         int type = pCCBReader->readInt(false);
-        std::string propertyName = pCCBReader->readCachedString();
+        // the name is interned by the reader, which also resolves its kCCBProperty ID for the handlers
+        const char *propertyName = pCCBReader->readPropertyName(NULL);
 
         // Check if the property can be set for this platform
         bool setProp = false;
@@ -80,7 +82,7 @@ void CCNodeLoader::parseProperties(CCNode * pNode, CCNode * pParent, CCBReader *
                 CCARRAY_FOREACH(extraPropsNames, pObj)
                 {
                     CCString* pStr = (CCString*)pObj;
-                    if (0 == pStr->compare(propertyName.c_str()))
+                    if (0 == pStr->compare(propertyName))
                     {
                         bFound = true;
                         break;
@@ -105,10 +107,10 @@ void CCNodeLoader::parseProperties(CCNode * pNode, CCNode * pParent, CCBReader *
         {
             case kCCBPropTypePosition: 
             {
-                CCPoint position = this->parsePropTypePosition(pNode, pParent, pCCBReader, propertyName.c_str());
+                CCPoint position = this->parsePropTypePosition(pNode, pParent, pCCBReader, propertyName);
                 if (setProp) 
                 {
-                    this->onHandlePropTypePosition(pNode, pParent, propertyName.c_str(), position, pCCBReader);
+                    this->onHandlePropTypePosition(pNode, pParent, propertyName, position, pCCBReader);
                 }
                 break;
             }
@@ -117,7 +119,7 @@ void CCNodeLoader::parseProperties(CCNode * pNode, CCNode * pParent, CCBReader *
                 CCPoint point = this->parsePropTypePoint(pNode, pParent, pCCBReader);
                 if (setProp) 
                 {
-                    this->onHandlePropTypePoint(pNode, pParent, propertyName.c_str(), point, pCCBReader);
+                    this->onHandlePropTypePoint(pNode, pParent, propertyName, point, pCCBReader);
                 }
                 break;
             }
@@ -126,23 +128,23 @@ void CCNodeLoader::parseProperties(CCNode * pNode, CCNode * pParent, CCBReader *
                 CCPoint pointLock = this->parsePropTypePointLock(pNode, pParent, pCCBReader);
                 if (setProp) 
                 {
-                    this->onHandlePropTypePointLock(pNode, pParent, propertyName.c_str(), pointLock, pCCBReader);
+                    this->onHandlePropTypePointLock(pNode, pParent, propertyName, pointLock, pCCBReader);
                 }
                 break;
             }
             case kCCBPropTypeSize: {
                 CCSize size = this->parsePropTypeSize(pNode, pParent, pCCBReader);
                 if(setProp) {
-                    this->onHandlePropTypeSize(pNode, pParent, propertyName.c_str(), size, pCCBReader);
+                    this->onHandlePropTypeSize(pNode, pParent, propertyName, size, pCCBReader);
                 }
                 break;
             }
             case kCCBPropTypeScaleLock: 
             {
-                float * scaleLock = this->parsePropTypeScaleLock(pNode, pParent, pCCBReader, propertyName.c_str());
+                float * scaleLock = this->parsePropTypeScaleLock(pNode, pParent, pCCBReader, propertyName);
                 if(setProp) 
                 {
-                    this->onHandlePropTypeScaleLock(pNode, pParent, propertyName.c_str(), scaleLock, pCCBReader);
+                    this->onHandlePropTypeScaleLock(pNode, pParent, propertyName, scaleLock, pCCBReader);
                 }
                 CC_SAFE_DELETE_ARRAY(scaleLock);
                 break;
@@ -152,16 +154,16 @@ void CCNodeLoader::parseProperties(CCNode * pNode, CCNode * pParent, CCBReader *
                 float f = this->parsePropTypeFloat(pNode, pParent, pCCBReader);
                 if(setProp) 
                 {
-                    this->onHandlePropTypeFloat(pNode, pParent, propertyName.c_str(), f, pCCBReader);
+                    this->onHandlePropTypeFloat(pNode, pParent, propertyName, f, pCCBReader);
                 }
                 break;
             }
             case kCCBPropTypeDegrees: 
             {
-                float degrees = this->parsePropTypeDegrees(pNode, pParent, pCCBReader, propertyName.c_str());
+                float degrees = this->parsePropTypeDegrees(pNode, pParent, pCCBReader, propertyName);
                 if(setProp) 
                 {
-                    this->onHandlePropTypeDegrees(pNode, pParent, propertyName.c_str(), degrees, pCCBReader);
+                    this->onHandlePropTypeDegrees(pNode, pParent, propertyName, degrees, pCCBReader);
                 }
                 break;
             }
@@ -170,7 +172,7 @@ void CCNodeLoader::parseProperties(CCNode * pNode, CCNode * pParent, CCBReader *
                 float floatScale = this->parsePropTypeFloatScale(pNode, pParent, pCCBReader);
                 if(setProp) 
                 {
-                    this->onHandlePropTypeFloatScale(pNode, pParent, propertyName.c_str(), floatScale, pCCBReader);
+                    this->onHandlePropTypeFloatScale(pNode, pParent, propertyName, floatScale, pCCBReader);
                 }
                 break;
             }
@@ -179,7 +181,7 @@ void CCNodeLoader::parseProperties(CCNode * pNode, CCNode * pParent, CCBReader *
                 int integer = this->parsePropTypeInteger(pNode, pParent, pCCBReader);
                 if(setProp) 
                 {
-                    this->onHandlePropTypeInteger(pNode, pParent, propertyName.c_str(), integer, pCCBReader);
+                    this->onHandlePropTypeInteger(pNode, pParent, propertyName, integer, pCCBReader);
                 }
                 break;
             }
@@ -188,7 +190,7 @@ void CCNodeLoader::parseProperties(CCNode * pNode, CCNode * pParent, CCBReader *
                 int integerLabeled = this->parsePropTypeIntegerLabeled(pNode, pParent, pCCBReader);
                 if(setProp) 
                 {
-                    this->onHandlePropTypeIntegerLabeled(pNode, pParent, propertyName.c_str(), integerLabeled, pCCBReader);
+                    this->onHandlePropTypeIntegerLabeled(pNode, pParent, propertyName, integerLabeled, pCCBReader);
                 }
                 break;
             }
@@ -197,25 +199,25 @@ void CCNodeLoader::parseProperties(CCNode * pNode, CCNode * pParent, CCBReader *
                 float * floatVar = this->parsePropTypeFloatVar(pNode, pParent, pCCBReader);
                 if(setProp) 
                 {
-                    this->onHandlePropTypeFloatVar(pNode, pParent, propertyName.c_str(), floatVar, pCCBReader);
+                    this->onHandlePropTypeFloatVar(pNode, pParent, propertyName, floatVar, pCCBReader);
                 }
                 CC_SAFE_DELETE_ARRAY(floatVar);
                 break;
             }
             case kCCBPropTypeCheck: 
             {
-                bool check = this->parsePropTypeCheck(pNode, pParent, pCCBReader, propertyName.c_str());
+                bool check = this->parsePropTypeCheck(pNode, pParent, pCCBReader, propertyName);
                 if(setProp) 
                 {
-                    this->onHandlePropTypeCheck(pNode, pParent, propertyName.c_str(), check, pCCBReader);
+                    this->onHandlePropTypeCheck(pNode, pParent, propertyName, check, pCCBReader);
                 }
                 break;
             }
             case kCCBPropTypeSpriteFrame: {
-                CCSpriteFrame * ccSpriteFrame = this->parsePropTypeSpriteFrame(pNode, pParent, pCCBReader, propertyName.c_str());
+                CCSpriteFrame * ccSpriteFrame = this->parsePropTypeSpriteFrame(pNode, pParent, pCCBReader, propertyName);
                 if(setProp) 
                 {
-                    this->onHandlePropTypeSpriteFrame(pNode, pParent, propertyName.c_str(), ccSpriteFrame, pCCBReader);
+                    this->onHandlePropTypeSpriteFrame(pNode, pParent, propertyName, ccSpriteFrame, pCCBReader);
                 }
                 break;
             }
@@ -224,7 +226,7 @@ void CCNodeLoader::parseProperties(CCNode * pNode, CCNode * pParent, CCBReader *
                 CCAnimation * ccAnimation = this->parsePropTypeAnimation(pNode, pParent, pCCBReader);
                 if(setProp) 
                 {
-                    this->onHandlePropTypeAnimation(pNode, pParent, propertyName.c_str(), ccAnimation, pCCBReader);
+                    this->onHandlePropTypeAnimation(pNode, pParent, propertyName, ccAnimation, pCCBReader);
                 }
                 break;
             }
@@ -233,25 +235,25 @@ void CCNodeLoader::parseProperties(CCNode * pNode, CCNode * pParent, CCBReader *
                 CCTexture2D * ccTexture2D = this->parsePropTypeTexture(pNode, pParent, pCCBReader);
                 if(setProp) 
                 {
-                    this->onHandlePropTypeTexture(pNode, pParent, propertyName.c_str(), ccTexture2D, pCCBReader);
+                    this->onHandlePropTypeTexture(pNode, pParent, propertyName, ccTexture2D, pCCBReader);
                 }
                 break;
             }
             case kCCBPropTypeByte: 
             {
-                unsigned char byte = this->parsePropTypeByte(pNode, pParent, pCCBReader, propertyName.c_str());
+                unsigned char byte = this->parsePropTypeByte(pNode, pParent, pCCBReader, propertyName);
                 if(setProp) 
                 {
-                    this->onHandlePropTypeByte(pNode, pParent, propertyName.c_str(), byte, pCCBReader);
+                    this->onHandlePropTypeByte(pNode, pParent, propertyName, byte, pCCBReader);
                 }
                 break;
             }
             case kCCBPropTypeColor3: 
             {
-                ccColor3B color3B = this->parsePropTypeColor3(pNode, pParent, pCCBReader, propertyName.c_str());
+                ccColor3B color3B = this->parsePropTypeColor3(pNode, pParent, pCCBReader, propertyName);
                 if(setProp) 
                 {
-                    this->onHandlePropTypeColor3(pNode, pParent, propertyName.c_str(), color3B, pCCBReader);
+                    this->onHandlePropTypeColor3(pNode, pParent, propertyName, color3B, pCCBReader);
                 }
                 break;
             }
@@ -260,7 +262,7 @@ void CCNodeLoader::parseProperties(CCNode * pNode, CCNode * pParent, CCBReader *
                 ccColor4F * color4FVar = this->parsePropTypeColor4FVar(pNode, pParent, pCCBReader);
                 if(setProp) 
                 {
-                    this->onHandlePropTypeColor4FVar(pNode, pParent, propertyName.c_str(), color4FVar, pCCBReader);
+                    this->onHandlePropTypeColor4FVar(pNode, pParent, propertyName, color4FVar, pCCBReader);
                 }
                 CC_SAFE_DELETE_ARRAY(color4FVar);
                 break;
@@ -268,7 +270,7 @@ void CCNodeLoader::parseProperties(CCNode * pNode, CCNode * pParent, CCBReader *
             case kCCBPropTypeFlip: {
                 bool * flip = this->parsePropTypeFlip(pNode, pParent, pCCBReader);
                 if(setProp) {
-                    this->onHandlePropTypeFlip(pNode, pParent, propertyName.c_str(), flip, pCCBReader);
+                    this->onHandlePropTypeFlip(pNode, pParent, propertyName, flip, pCCBReader);
                 }
                 CC_SAFE_DELETE_ARRAY(flip);
                 break;
@@ -278,7 +280,7 @@ void CCNodeLoader::parseProperties(CCNode * pNode, CCNode * pParent, CCBReader *
                 ccBlendFunc blendFunc = this->parsePropTypeBlendFunc(pNode, pParent, pCCBReader);
                 if(setProp) 
                 {
-                    this->onHandlePropTypeBlendFunc(pNode, pParent, propertyName.c_str(), blendFunc, pCCBReader);
+                    this->onHandlePropTypeBlendFunc(pNode, pParent, propertyName, blendFunc, pCCBReader);
                 }
                 break;
             }
@@ -287,35 +289,35 @@ void CCNodeLoader::parseProperties(CCNode * pNode, CCNode * pParent, CCBReader *
                 std::string fntFile = pCCBReader->getCCBRootPath() + this->parsePropTypeFntFile(pNode, pParent, pCCBReader);
                 if(setProp) 
                 {
-                    this->onHandlePropTypeFntFile(pNode, pParent, propertyName.c_str(), fntFile.c_str(), pCCBReader);
+                    this->onHandlePropTypeFntFile(pNode, pParent, propertyName, fntFile.c_str(), pCCBReader);
                 }
                 break;
             }
             case kCCBPropTypeFontTTF: {
                 std::string fontTTF = this->parsePropTypeFontTTF(pNode, pParent, pCCBReader);
                 if(setProp) {
-                    this->onHandlePropTypeFontTTF(pNode, pParent, propertyName.c_str(), fontTTF.c_str(), pCCBReader);
+                    this->onHandlePropTypeFontTTF(pNode, pParent, propertyName, fontTTF.c_str(), pCCBReader);
                 }
                 break;
             }
             case kCCBPropTypeString: {
                 std::string string = this->parsePropTypeString(pNode, pParent, pCCBReader);
                 if(setProp) {
-                    this->onHandlePropTypeString(pNode, pParent, propertyName.c_str(), string.c_str(), pCCBReader);
+                    this->onHandlePropTypeString(pNode, pParent, propertyName, string.c_str(), pCCBReader);
                 }
                 break;
             }
             case kCCBPropTypeText: {
                 std::string text = this->parsePropTypeText(pNode, pParent, pCCBReader);
                 if(setProp) {
-                    this->onHandlePropTypeText(pNode, pParent, propertyName.c_str(), text.c_str(), pCCBReader);
+                    this->onHandlePropTypeText(pNode, pParent, propertyName, text.c_str(), pCCBReader);
                 }
                 break;
             }
             case kCCBPropTypeBlock: {
                 BlockData * blockData = this->parsePropTypeBlock(pNode, pParent, pCCBReader);
                 if(setProp) {
-                    this->onHandlePropTypeBlock(pNode, pParent, propertyName.c_str(), blockData, pCCBReader);
+                    this->onHandlePropTypeBlock(pNode, pParent, propertyName, blockData, pCCBReader);
                 }
                 CC_SAFE_DELETE(blockData);
                 break;
@@ -323,7 +325,7 @@ void CCNodeLoader::parseProperties(CCNode * pNode, CCNode * pParent, CCBReader *
             case kCCBPropTypeBlockCCControl: {
                 BlockCCControlData * blockCCControlData = this->parsePropTypeBlockCCControl(pNode, pParent, pCCBReader);
                 if(setProp && blockCCControlData != NULL) {
-                    this->onHandlePropTypeBlockCCControl(pNode, pParent, propertyName.c_str(), blockCCControlData, pCCBReader);
+                    this->onHandlePropTypeBlockCCControl(pNode, pParent, propertyName, blockCCControlData, pCCBReader);
                 }
                 CC_SAFE_DELETE(blockCCControlData);
                 break;
@@ -331,7 +333,7 @@ void CCNodeLoader::parseProperties(CCNode * pNode, CCNode * pParent, CCBReader *
             case kCCBPropTypeCCBFile: {
                 CCNode * ccbFileNode = this->parsePropTypeCCBFile(pNode, pParent, pCCBReader);
                 if(setProp) {
-                    this->onHandlePropTypeCCBFile(pNode, pParent, propertyName.c_str(), ccbFileNode, pCCBReader);
+                    this->onHandlePropTypeCCBFile(pNode, pParent, propertyName, ccbFileNode, pCCBReader);
                 }
                 break;
             }
@@ -839,23 +841,18 @@ CCNode * CCNodeLoader::parsePropTypeCCBFile(CCNode * pNode, CCNode * pParent, CC
     std::string ccbFileWithoutPathExtension = CCBReader::deletePathExtension(ccbFileName.c_str());
     ccbFileName = ccbFileWithoutPathExtension + ".ccbi";
     
-    // Load sub file
-    std::string path = CCFileUtils::sharedFileUtils()->fullPathForFilename(ccbFileName.c_str());
-    unsigned long size = 0;
-    unsigned char * pBytes = CCFileUtils::sharedFileUtils()->getFileData(path.c_str(), "rb", &size);
+    // Load sub file, unless CCBPrototypeCache already holds it
+    CCBPrototype *prototype = CCBPrototypeCache::sharedPrototypeCache()->prototypeForFile(ccbFileName.c_str());
+    if (prototype == NULL)
+    {
+        prototype = CCBPrototype::createWithFile(ccbFileName.c_str());
+    }
 
     CCBReader * ccbReader = new CCBReader(pCCBReader);
     ccbReader->autorelease();
     ccbReader->getAnimationManager()->setRootContainerSize(pParent->getContentSize());
-    
-    CCData *data = new CCData(pBytes, size);
-    CC_SAFE_DELETE_ARRAY(pBytes);
-
-    data->retain();
-    ccbReader->mData = data;
-    ccbReader->mBytes = data->getBytes();
-    ccbReader->mCurrentByte = 0;
-    ccbReader->mCurrentBit = 0;
+
+    ccbReader->setPrototype(prototype);
     CC_SAFE_RETAIN(pCCBReader->mOwner);
     ccbReader->mOwner = pCCBReader->mOwner;
 
@@ -867,8 +864,6 @@ CCNode * CCNodeLoader::parsePropTypeCCBFile(CCNode * pNode, CCNode * pParent, CC
 //     ccbReader->mOwnerCallbackNodes = pCCBReader->mOwnerCallbackNodes;
 //     ccbReader->mOwnerCallbackNodes->retain();
 
-    data->release();
-    
     CCNode * ccbFileNode = ccbReader->readFileWithCleanUp(false, pCCBReader->getAnimationManagers());
     
     if (ccbFileNode && ccbReader->getAnimationManager()->getAutoPlaySequenceId() != -1)
@@ -883,18 +878,24 @@ CCNode * CCNodeLoader::parsePropTypeCCBFile(CCNode * pNode, CCNode * pParent, CC
 
 
 void CCNodeLoader::onHandlePropTypePosition(CCNode * pNode, CCNode * pParent, const char* pPropertyName, CCPoint pPosition, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_POSITION) == 0) {
-        pNode->setPosition(pPosition);
-    } else {
-        ASSERT_FAIL_UNEXPECTED_PROPERTY(pPropertyName);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyPosition:
+            pNode->setPosition(pPosition);
+            break;
+        default:
+            ASSERT_FAIL_UNEXPECTED_PROPERTY(pPropertyName);
+            break;
     }
 }
 
 void CCNodeLoader::onHandlePropTypePoint(CCNode * pNode, CCNode * pParent, const char* pPropertyName, CCPoint pPoint, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_ANCHORPOINT) == 0) {
-        pNode->setAnchorPoint(pPoint);
-    } else {
-        ASSERT_FAIL_UNEXPECTED_PROPERTY(pPropertyName);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyAnchorPoint:
+            pNode->setAnchorPoint(pPoint);
+            break;
+        default:
+            ASSERT_FAIL_UNEXPECTED_PROPERTY(pPropertyName);
+            break;
     }
 }
 
@@ -903,19 +904,25 @@ void CCNodeLoader::onHandlePropTypePointLock(CCNode * pNode, CCNode * pParent, c
 }
 
 void CCNodeLoader::onHandlePropTypeSize(CCNode * pNode, CCNode * pParent, const char* pPropertyName, CCSize pSize, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_CONTENTSIZE) == 0) {
-        pNode->setContentSize(pSize);
-    } else {
-        ASSERT_FAIL_UNEXPECTED_PROPERTY(pPropertyName);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyContentSize:
+            pNode->setContentSize(pSize);
+            break;
+        default:
+            ASSERT_FAIL_UNEXPECTED_PROPERTY(pPropertyName);
+            break;
     }
 }
 
 void CCNodeLoader::onHandlePropTypeScaleLock(CCNode * pNode, CCNode * pParent, const char* pPropertyName, float * pScaleLock, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_SCALE) == 0) {
-        pNode->setScaleX(pScaleLock[0]);
-        pNode->setScaleY(pScaleLock[1]);
-    } else {
-        ASSERT_FAIL_UNEXPECTED_PROPERTY(pPropertyName);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyScale:
+            pNode->setScaleX(pScaleLock[0]);
+            pNode->setScaleY(pScaleLock[1]);
+            break;
+        default:
+            ASSERT_FAIL_UNEXPECTED_PROPERTY(pPropertyName);
+            break;
     }
 }
 
@@ -926,10 +933,13 @@ void CCNodeLoader::onHandlePropTypeFloat(CCNode * pNode, CCNode * pParent, const
 }
 
 void CCNodeLoader::onHandlePropTypeDegrees(CCNode * pNode, CCNode * pParent, const char* pPropertyName, float pDegrees, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_ROTATION) == 0) {
-        pNode->setRotation(pDegrees);
-    } else {
-        ASSERT_FAIL_UNEXPECTED_PROPERTY(pPropertyName);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyRotation:
+            pNode->setRotation(pDegrees);
+            break;
+        default:
+            ASSERT_FAIL_UNEXPECTED_PROPERTY(pPropertyName);
+            break;
     }
 }
 
@@ -938,12 +948,15 @@ void CCNodeLoader::onHandlePropTypeFloatScale(CCNode * pNode, CCNode * pParent,
 }
 
 void CCNodeLoader::onHandlePropTypeInteger(CCNode * pNode, CCNode * pParent, const char* pPropertyName, int pInteger, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_TAG) == 0) {
-        pNode->setTag(pInteger);
-    } else {
- //       ASSERT_FAIL_UNEXPECTED_PROPERTY(pPropertyName);
-        // It may be a custom property, add it to custom property dictionary.
-        m_pCustomProperties->setObject(CCBValue::create(pInteger), pPropertyName);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyTag:
+            pNode->setTag(pInteger);
+            break;
+        default:
+     //       ASSERT_FAIL_UNEXPECTED_PROPERTY(pPropertyName);
+            // It may be a custom property, add it to custom property dictionary.
+            m_pCustomProperties->setObject(CCBValue::create(pInteger), pPropertyName);
+            break;
     }
 }
 
@@ -956,14 +969,18 @@ void CCNodeLoader::onHandlePropTypeFloatVar(CCNode * pNode, CCNode * pParent, co
 }
 
 void CCNodeLoader::onHandlePropTypeCheck(CCNode * pNode, CCNode * pParent, const char* pPropertyName, bool pCheck, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_VISIBLE) == 0) {
-        pNode->setVisible(pCheck);
-    } else if(strcmp(pPropertyName, PROPERTY_IGNOREANCHORPOINTFORPOSITION) == 0) {
-        pNode->ignoreAnchorPointForPosition(pCheck);
-    } else {
-        //ASSERT_FAIL_UNEXPECTED_PROPERTY(pPropertyName);
-        // It may be a custom property, add it to custom property dictionary.
-        m_pCustomProperties->setObject(CCBValue::create(pCheck), pPropertyName);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyVisible:
+            pNode->setVisible(pCheck);
+            break;
+        case kCCBPropertyIgnoreAnchorPointForPosition:
+            pNode->ignoreAnchorPointForPosition(pCheck);
+            break;
+        default:
+            //ASSERT_FAIL_UNEXPECTED_PROPERTY(pPropertyName);
+            // It may be a custom property, add it to custom property dictionary.
+            m_pCustomProperties->setObject(CCBValue::create(pCheck), pPropertyName);
+            break;
     }
 }
 
@@ -2,134 +2,149 @@
 
 
 
-#define PROPERTY_EMITERMODE "emitterMode"
-#define PROPERTY_POSVAR "posVar"
-#define PROPERTY_EMISSIONRATE "emissionRate"
-#define PROPERTY_DURATION "duration"
-#define PROPERTY_TOTALPARTICLES "totalParticles"
-#define PROPERTY_LIFE "life"
-#define PROPERTY_STARTSIZE "startSize"
-#define PROPERTY_ENDSIZE "endSize"
-#define PROPERTY_STARTSPIN "startSpin"
-#define PROPERTY_ENDSPIN "endSpin"
-#define PROPERTY_ANGLE "angle"
-#define PROPERTY_STARTCOLOR "startColor"
-#define PROPERTY_ENDCOLOR "endColor"
-#define PROPERTY_BLENDFUNC "blendFunc"
-#define PROPERTY_GRAVITY "gravity"
-#define PROPERTY_SPEED "speed"
-#define PROPERTY_TANGENTIALACCEL "tangentialAccel"
-#define PROPERTY_RADIALACCEL "radialAccel"
-#define PROPERTY_TEXTURE "texture"
-#define PROPERTY_STARTRADIUS "startRadius"
-#define PROPERTY_ENDRADIUS "endRadius"
-#define PROPERTY_ROTATEPERSECOND "rotatePerSecond"
-
 NS_CC_EXT_BEGIN
 
 void CCParticleSystemQuadLoader::onHandlePropTypeIntegerLabeled(CCNode * pNode, CCNode * pParent, const char * pPropertyName, int pIntegerLabeled, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_EMITERMODE) == 0) {
-        ((CCParticleSystemQuad *)pNode)->setEmitterMode(pIntegerLabeled);
-    } else {
-        CCNodeLoader::onHandlePropTypeIntegerLabeled(pNode, pParent, pPropertyName, pIntegerLabeled, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyEmitterMode:
+            ((CCParticleSystemQuad *)pNode)->setEmitterMode(pIntegerLabeled);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeIntegerLabeled(pNode, pParent, pPropertyName, pIntegerLabeled, pCCBReader);
+            break;
     }
 }
 
 void CCParticleSystemQuadLoader::onHandlePropTypePoint(CCNode * pNode, CCNode * pParent, const char * pPropertyName, CCPoint pPoint, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_POSVAR) == 0) {
-        ((CCParticleSystemQuad *)pNode)->setPosVar(pPoint);
-    } else if(strcmp(pPropertyName, PROPERTY_GRAVITY) == 0) {
-        ((CCParticleSystemQuad *)pNode)->setGravity(pPoint);
-    } else {
-        CCNodeLoader::onHandlePropTypePoint(pNode, pParent, pPropertyName, pPoint, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyPosVar:
+            ((CCParticleSystemQuad *)pNode)->setPosVar(pPoint);
+            break;
+        case kCCBPropertyGravity:
+            ((CCParticleSystemQuad *)pNode)->setGravity(pPoint);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypePoint(pNode, pParent, pPropertyName, pPoint, pCCBReader);
+            break;
     }
 }
 
 void CCParticleSystemQuadLoader::onHandlePropTypeFloat(CCNode * pNode, CCNode * pParent, const char * pPropertyName, float pFloat, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_EMISSIONRATE) == 0) {
-        ((CCParticleSystemQuad *)pNode)->setEmissionRate(pFloat);
-    } else if(strcmp(pPropertyName, PROPERTY_DURATION) == 0) {
-        ((CCParticleSystemQuad *)pNode)->setDuration(pFloat);
-    } else {
-        CCNodeLoader::onHandlePropTypeFloat(pNode, pParent, pPropertyName, pFloat, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyEmissionRate:
+            ((CCParticleSystemQuad *)pNode)->setEmissionRate(pFloat);
+            break;
+        case kCCBPropertyDuration:
+            ((CCParticleSystemQuad *)pNode)->setDuration(pFloat);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeFloat(pNode, pParent, pPropertyName, pFloat, pCCBReader);
+            break;
     }
 }
 
 void CCParticleSystemQuadLoader::onHandlePropTypeInteger(CCNode * pNode, CCNode * pParent, const char * pPropertyName, int pInteger, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_TOTALPARTICLES) == 0) {
-        ((CCParticleSystemQuad *)pNode)->setTotalParticles(pInteger);
-    } else {
-        CCNodeLoader::onHandlePropTypeInteger(pNode, pParent, pPropertyName, pInteger, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyTotalParticles:
+            ((CCParticleSystemQuad *)pNode)->setTotalParticles(pInteger);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeInteger(pNode, pParent, pPropertyName, pInteger, pCCBReader);
+            break;
     }
 }
 
 void CCParticleSystemQuadLoader::onHandlePropTypeFloatVar(CCNode * pNode, CCNode * pParent, const char * pPropertyName, float * pFloatVar, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_LIFE) == 0) {
-        ((CCParticleSystemQuad *)pNode)->setLife(pFloatVar[0]);
-        ((CCParticleSystemQuad *)pNode)->setLifeVar(pFloatVar[1]);
-    } else if(strcmp(pPropertyName, PROPERTY_STARTSIZE) == 0) {
-        ((CCParticleSystemQuad *)pNode)->setStartSize(pFloatVar[0]);
-        ((CCParticleSystemQuad *)pNode)->setStartSizeVar(pFloatVar[1]);
-    } else if(strcmp(pPropertyName, PROPERTY_ENDSIZE) == 0) {
-        ((CCParticleSystemQuad *)pNode)->setEndSize(pFloatVar[0]);
-        ((CCParticleSystemQuad *)pNode)->setEndSizeVar(pFloatVar[1]);
-    } else if(strcmp(pPropertyName, PROPERTY_STARTSPIN) == 0) {
-        ((CCParticleSystemQuad *)pNode)->setStartSpin(pFloatVar[0]);
-        ((CCParticleSystemQuad *)pNode)->setStartSpinVar(pFloatVar[1]);
-    } else if(strcmp(pPropertyName, PROPERTY_ENDSPIN) == 0) {
-        ((CCParticleSystemQuad *)pNode)->setEndSpin(pFloatVar[0]);
-        ((CCParticleSystemQuad *)pNode)->setEndSpinVar(pFloatVar[1]);
-    } else if(strcmp(pPropertyName, PROPERTY_ANGLE) == 0) {
-        ((CCParticleSystemQuad *)pNode)->setAngle(pFloatVar[0]);
-        ((CCParticleSystemQuad *)pNode)->setAngleVar(pFloatVar[1]);
-    } else if(strcmp(pPropertyName, PROPERTY_SPEED) == 0) {
-        ((CCParticleSystemQuad *)pNode)->setSpeed(pFloatVar[0]);
-        ((CCParticleSystemQuad *)pNode)->setSpeedVar(pFloatVar[1]);
-    } else if(strcmp(pPropertyName, PROPERTY_TANGENTIALACCEL) == 0) {
-        ((CCParticleSystemQuad *)pNode)->setTangentialAccel(pFloatVar[0]);
-        ((CCParticleSystemQuad *)pNode)->setTangentialAccelVar(pFloatVar[1]);
-    } else if(strcmp(pPropertyName, PROPERTY_RADIALACCEL) == 0) {
-        ((CCParticleSystemQuad *)pNode)->setRadialAccel(pFloatVar[0]);
-        ((CCParticleSystemQuad *)pNode)->setRadialAccelVar(pFloatVar[1]);
-    } else if(strcmp(pPropertyName, PROPERTY_STARTRADIUS) == 0) {
-        ((CCParticleSystemQuad *)pNode)->setStartRadius(pFloatVar[0]);
-        ((CCParticleSystemQuad *)pNode)->setStartRadiusVar(pFloatVar[1]);
-    } else if(strcmp(pPropertyName, PROPERTY_ENDRADIUS) == 0) {
-        ((CCParticleSystemQuad *)pNode)->setEndRadius(pFloatVar[0]);
-        ((CCParticleSystemQuad *)pNode)->setEndRadiusVar(pFloatVar[1]);
-    } else if(strcmp(pPropertyName, PROPERTY_ROTATEPERSECOND) == 0) {
-        ((CCParticleSystemQuad *)pNode)->setRotatePerSecond(pFloatVar[0]);
-        ((CCParticleSystemQuad *)pNode)->setRotatePerSecondVar(pFloatVar[1]);
-    } else {
-        CCNodeLoader::onHandlePropTypeFloatVar(pNode, pParent, pPropertyName, pFloatVar, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyLife:
+            ((CCParticleSystemQuad *)pNode)->setLife(pFloatVar[0]);
+            ((CCParticleSystemQuad *)pNode)->setLifeVar(pFloatVar[1]);
+            break;
+        case kCCBPropertyStartSize:
+            ((CCParticleSystemQuad *)pNode)->setStartSize(pFloatVar[0]);
+            ((CCParticleSystemQuad *)pNode)->setStartSizeVar(pFloatVar[1]);
+            break;
+        case kCCBPropertyEndSize:
+            ((CCParticleSystemQuad *)pNode)->setEndSize(pFloatVar[0]);
+            ((CCParticleSystemQuad *)pNode)->setEndSizeVar(pFloatVar[1]);
+            break;
+        case kCCBPropertyStartSpin:
+            ((CCParticleSystemQuad *)pNode)->setStartSpin(pFloatVar[0]);
+            ((CCParticleSystemQuad *)pNode)->setStartSpinVar(pFloatVar[1]);
+            break;
+        case kCCBPropertyEndSpin:
+            ((CCParticleSystemQuad *)pNode)->setEndSpin(pFloatVar[0]);
+            ((CCParticleSystemQuad *)pNode)->setEndSpinVar(pFloatVar[1]);
+            break;
+        case kCCBPropertyAngle:
+            ((CCParticleSystemQuad *)pNode)->setAngle(pFloatVar[0]);
+            ((CCParticleSystemQuad *)pNode)->setAngleVar(pFloatVar[1]);
+            break;
+        case kCCBPropertySpeed:
+            ((CCParticleSystemQuad *)pNode)->setSpeed(pFloatVar[0]);
+            ((CCParticleSystemQuad *)pNode)->setSpeedVar(pFloatVar[1]);
+            break;
+        case kCCBPropertyTangentialAccel:
+            ((CCParticleSystemQuad *)pNode)->setTangentialAccel(pFloatVar[0]);
+            ((CCParticleSystemQuad *)pNode)->setTangentialAccelVar(pFloatVar[1]);
+            break;
+        case kCCBPropertyRadialAccel:
+            ((CCParticleSystemQuad *)pNode)->setRadialAccel(pFloatVar[0]);
+            ((CCParticleSystemQuad *)pNode)->setRadialAccelVar(pFloatVar[1]);
+            break;
+        case kCCBPropertyStartRadius:
+            ((CCParticleSystemQuad *)pNode)->setStartRadius(pFloatVar[0]);
+            ((CCParticleSystemQuad *)pNode)->setStartRadiusVar(pFloatVar[1]);
+            break;
+        case kCCBPropertyEndRadius:
+            ((CCParticleSystemQuad *)pNode)->setEndRadius(pFloatVar[0]);
+            ((CCParticleSystemQuad *)pNode)->setEndRadiusVar(pFloatVar[1]);
+            break;
+        case kCCBPropertyRotatePerSecond:
+            ((CCParticleSystemQuad *)pNode)->setRotatePerSecond(pFloatVar[0]);
+            ((CCParticleSystemQuad *)pNode)->setRotatePerSecondVar(pFloatVar[1]);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeFloatVar(pNode, pParent, pPropertyName, pFloatVar, pCCBReader);
+            break;
     }
 }
 
 void CCParticleSystemQuadLoader::onHandlePropTypeColor4FVar(CCNode * pNode, CCNode * pParent, const char * pPropertyName, ccColor4F * pCCColor4FVar, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_STARTCOLOR) == 0) {
-        ((CCParticleSystemQuad *)pNode)->setStartColor(pCCColor4FVar[0]);
-        ((CCParticleSystemQuad *)pNode)->setStartColorVar(pCCColor4FVar[1]);
-    } else if(strcmp(pPropertyName, PROPERTY_ENDCOLOR) == 0) {
-        ((CCParticleSystemQuad *)pNode)->setEndColor(pCCColor4FVar[0]);
-        ((CCParticleSystemQuad *)pNode)->setEndColorVar(pCCColor4FVar[1]);
-    } else {
-        CCNodeLoader::onHandlePropTypeColor4FVar(pNode, pParent, pPropertyName, pCCColor4FVar, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyStartColor:
+            ((CCParticleSystemQuad *)pNode)->setStartColor(pCCColor4FVar[0]);
+            ((CCParticleSystemQuad *)pNode)->setStartColorVar(pCCColor4FVar[1]);
+            break;
+        case kCCBPropertyEndColor:
+            ((CCParticleSystemQuad *)pNode)->setEndColor(pCCColor4FVar[0]);
+            ((CCParticleSystemQuad *)pNode)->setEndColorVar(pCCColor4FVar[1]);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeColor4FVar(pNode, pParent, pPropertyName, pCCColor4FVar, pCCBReader);
+            break;
     }
 }
 
 void CCParticleSystemQuadLoader::onHandlePropTypeBlendFunc(CCNode * pNode, CCNode * pParent, const char * pPropertyName, ccBlendFunc pCCBlendFunc, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_BLENDFUNC) == 0) {
-        ((CCParticleSystemQuad *)pNode)->setBlendFunc(pCCBlendFunc);
-    } else {
-        CCNodeLoader::onHandlePropTypeBlendFunc(pNode, pParent, pPropertyName, pCCBlendFunc, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyBlendFunc:
+            ((CCParticleSystemQuad *)pNode)->setBlendFunc(pCCBlendFunc);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeBlendFunc(pNode, pParent, pPropertyName, pCCBlendFunc, pCCBReader);
+            break;
     }
 }
 
 void CCParticleSystemQuadLoader::onHandlePropTypeTexture(CCNode * pNode, CCNode * pParent, const char * pPropertyName, CCTexture2D * pCCTexture2D, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_TEXTURE) == 0) {
-        ((CCParticleSystemQuad *)pNode)->setTexture(pCCTexture2D);
-    } else {
-        CCNodeLoader::onHandlePropTypeTexture(pNode, pParent, pPropertyName, pCCTexture2D, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyTexture:
+            ((CCParticleSystemQuad *)pNode)->setTexture(pCCTexture2D);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeTexture(pNode, pParent, pPropertyName, pCCTexture2D, pCCBReader);
+            break;
     }
 }
 
@@ -2,73 +2,84 @@
 
 
 
-#define PROPERTY_CONTENTSIZE "contentSize"
-#define PROPERTY_SPRITEFRAME "spriteFrame"
-#define PROPERTY_COLOR "color"
-#define PROPERTY_OPACITY "opacity"
-#define PROPERTY_BLENDFUNC "blendFunc"
-#define PROPERTY_PREFEREDSIZE "preferedSize" // TODO Should be "preferredSize". This is a typo in cocos2d-iphone, cocos2d-x and CocosBuilder!
-#define PROPERTY_INSETLEFT "insetLeft"
-#define PROPERTY_INSETTOP "insetTop"
-#define PROPERTY_INSETRIGHT "insetRight"
-#define PROPERTY_INSETBOTTOM "insetBottom"
-
 NS_CC_EXT_BEGIN
 
 void CCScale9SpriteLoader::onHandlePropTypeSpriteFrame(CCNode * pNode, CCNode * pParent, const char * pPropertyName, CCSpriteFrame * pCCSpriteFrame, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_SPRITEFRAME) == 0) {
-        ((CCScale9Sprite *)pNode)->initWithSpriteFrame(pCCSpriteFrame);
-    } else {
-        CCNodeLoader::onHandlePropTypeSpriteFrame(pNode, pParent, pPropertyName, pCCSpriteFrame, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertySpriteFrame:
+            ((CCScale9Sprite *)pNode)->initWithSpriteFrame(pCCSpriteFrame);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeSpriteFrame(pNode, pParent, pPropertyName, pCCSpriteFrame, pCCBReader);
+            break;
     }
 }
 
 void CCScale9SpriteLoader::onHandlePropTypeColor3(CCNode * pNode, CCNode * pParent, const char * pPropertyName, ccColor3B pCCColor3B, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_COLOR) == 0) {
-        ((CCScale9Sprite *)pNode)->setColor(pCCColor3B);
-    } else {
-        CCNodeLoader::onHandlePropTypeColor3(pNode, pParent, pPropertyName, pCCColor3B, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyColor:
+            ((CCScale9Sprite *)pNode)->setColor(pCCColor3B);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeColor3(pNode, pParent, pPropertyName, pCCColor3B, pCCBReader);
+            break;
     }
 }
 
 void CCScale9SpriteLoader::onHandlePropTypeByte(CCNode * pNode, CCNode * pParent, const char * pPropertyName, unsigned char pByte, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_OPACITY) == 0) {
-        ((CCScale9Sprite *)pNode)->setOpacity(pByte);
-    } else {
-        CCNodeLoader::onHandlePropTypeByte(pNode, pParent, pPropertyName, pByte, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyOpacity:
+            ((CCScale9Sprite *)pNode)->setOpacity(pByte);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeByte(pNode, pParent, pPropertyName, pByte, pCCBReader);
+            break;
     }
 }
 
 void CCScale9SpriteLoader::onHandlePropTypeBlendFunc(CCNode * pNode, CCNode * pParent, const char * pPropertyName, ccBlendFunc pCCBlendFunc, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_BLENDFUNC) == 0) {
-        // TODO Not exported by CocosBuilder yet!
-        // ((CCScale9Sprite *)pNode)->setBlendFunc(pCCBlendFunc);
-    } else {
-        CCNodeLoader::onHandlePropTypeBlendFunc(pNode, pParent, pPropertyName, pCCBlendFunc, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyBlendFunc:
+            // TODO Not exported by CocosBuilder yet!
+            // ((CCScale9Sprite *)pNode)->setBlendFunc(pCCBlendFunc);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeBlendFunc(pNode, pParent, pPropertyName, pCCBlendFunc, pCCBReader);
+            break;
     }
 }
 
 void CCScale9SpriteLoader::onHandlePropTypeSize(CCNode * pNode, CCNode * pParent, const char * pPropertyName, CCSize pSize, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_CONTENTSIZE) == 0) {
-        //((CCScale9Sprite *)pNode)->setContentSize(pSize);
-    } else if(strcmp(pPropertyName, PROPERTY_PREFEREDSIZE) == 0) {
-        ((CCScale9Sprite *)pNode)->setPreferredSize(pSize);
-    } else {
-        CCNodeLoader::onHandlePropTypeSize(pNode, pParent, pPropertyName, pSize, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyContentSize:
+            //((CCScale9Sprite *)pNode)->setContentSize(pSize);
+            break;
+        case kCCBPropertyPreferedSize:
+            ((CCScale9Sprite *)pNode)->setPreferredSize(pSize);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeSize(pNode, pParent, pPropertyName, pSize, pCCBReader);
+            break;
     }
 }
 
 void CCScale9SpriteLoader::onHandlePropTypeFloat(CCNode * pNode, CCNode * pParent, const char * pPropertyName, float pFloat, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_INSETLEFT) == 0) {
-        ((CCScale9Sprite *)pNode)->setInsetLeft(pFloat);
-    } else if(strcmp(pPropertyName, PROPERTY_INSETTOP) == 0) {
-        ((CCScale9Sprite *)pNode)->setInsetTop(pFloat);
-    } else if(strcmp(pPropertyName, PROPERTY_INSETRIGHT) == 0) {
-        ((CCScale9Sprite *)pNode)->setInsetRight(pFloat);
-    } else if(strcmp(pPropertyName, PROPERTY_INSETBOTTOM) == 0) {
-        ((CCScale9Sprite *)pNode)->setInsetBottom(pFloat);
-    } else {
-        CCNodeLoader::onHandlePropTypeFloat(pNode, pParent, pPropertyName, pFloat, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyInsetLeft:
+            ((CCScale9Sprite *)pNode)->setInsetLeft(pFloat);
+            break;
+        case kCCBPropertyInsetTop:
+            ((CCScale9Sprite *)pNode)->setInsetTop(pFloat);
+            break;
+        case kCCBPropertyInsetRight:
+            ((CCScale9Sprite *)pNode)->setInsetRight(pFloat);
+            break;
+        case kCCBPropertyInsetBottom:
+            ((CCScale9Sprite *)pNode)->setInsetBottom(pFloat);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeFloat(pNode, pParent, pPropertyName, pFloat, pCCBReader);
+            break;
     }
 }
 
@@ -2,54 +2,64 @@
 
 
 
-#define PROPERTY_CONTAINER "container"
-#define PROPERTY_DIRECTION "direction"
-#define PROPERTY_CLIPSTOBOUNDS "clipsToBounds"
-#define PROPERTY_BOUNCES "bounces"
-#define PROPERTY_SCALE "scale"
-
 NS_CC_EXT_BEGIN
 
 void CCScrollViewLoader::onHandlePropTypeSize(CCNode * pNode, CCNode * pParent, const char * pPropertyName, CCSize pSize, CCBReader * pCCBReader) {
-	if(strcmp(pPropertyName, PROPERTY_CONTENTSIZE) == 0) {
-		((CCScrollView *)pNode)->setViewSize(pSize);
-	} else {
-		CCNodeLoader::onHandlePropTypeSize(pNode, pParent, pPropertyName, pSize, pCCBReader);
+	switch(pCCBReader->getPropertyId(pPropertyName)) {
+		case kCCBPropertyContentSize:
+			((CCScrollView *)pNode)->setViewSize(pSize);
+			break;
+		default:
+			CCNodeLoader::onHandlePropTypeSize(pNode, pParent, pPropertyName, pSize, pCCBReader);
+			break;
 	}
 }
 
 void CCScrollViewLoader::onHandlePropTypeCheck(CCNode * pNode, CCNode * pParent, const char * pPropertyName, bool pCheck, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_CLIPSTOBOUNDS) == 0) {
-        ((CCScrollView *)pNode)->setClippingToBounds(pCheck);
-    } else if(strcmp(pPropertyName, PROPERTY_BOUNCES) == 0) {
-        ((CCScrollView *)pNode)->setBounceable(pCheck);
-    } else {
-        CCNodeLoader::onHandlePropTypeCheck(pNode, pParent, pPropertyName, pCheck, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyClipsToBounds:
+            ((CCScrollView *)pNode)->setClippingToBounds(pCheck);
+            break;
+        case kCCBPropertyBounces:
+            ((CCScrollView *)pNode)->setBounceable(pCheck);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeCheck(pNode, pParent, pPropertyName, pCheck, pCCBReader);
+            break;
     }
 }
 
 void CCScrollViewLoader::onHandlePropTypeCCBFile(CCNode * pNode, CCNode * pParent, const char * pPropertyName, CCNode * pCCBFileNode, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_CONTAINER) == 0) {
-        ((CCScrollView *)pNode)->setContainer(pCCBFileNode);
-		((CCScrollView *)pNode)->updateInset();
-    } else {
-        CCNodeLoader::onHandlePropTypeCCBFile(pNode, pParent, pPropertyName, pCCBFileNode, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyContainer:
+            ((CCScrollView *)pNode)->setContainer(pCCBFileNode);
+            ((CCScrollView *)pNode)->updateInset();
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeCCBFile(pNode, pParent, pPropertyName, pCCBFileNode, pCCBReader);
+            break;
     }
 }
 
 void CCScrollViewLoader::onHandlePropTypeFloat(CCNode * pNode, CCNode * pParent, const char * pPropertyName, float pFloat, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_SCALE) == 0) {
-        ((CCScrollView *)pNode)->setScale(pFloat);
-    } else {
-        CCNodeLoader::onHandlePropTypeFloat(pNode, pParent, pPropertyName, pFloat, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyScale:
+            ((CCScrollView *)pNode)->setScale(pFloat);
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeFloat(pNode, pParent, pPropertyName, pFloat, pCCBReader);
+            break;
     }
 }
 
 void CCScrollViewLoader::onHandlePropTypeIntegerLabeled(CCNode * pNode, CCNode * pParent, const char * pPropertyName, int pIntegerLabeled, CCBReader * pCCBReader) {
-    if(strcmp(pPropertyName, PROPERTY_DIRECTION) == 0) {
-        ((CCScrollView *)pNode)->setDirection(CCScrollViewDirection(pIntegerLabeled));
-    } else {
-        CCNodeLoader::onHandlePropTypeFloatScale(pNode, pParent, pPropertyName, pIntegerLabeled, pCCBReader);
+    switch(pCCBReader->getPropertyId(pPropertyName)) {
+        case kCCBPropertyDirection:
+            ((CCScrollView *)pNode)->setDirection(CCScrollViewDirection(pIntegerLabeled));
+            break;
+        default:
+            CCNodeLoader::onHandlePropTypeFloatScale(pNode, pParent, pPropertyName, pIntegerLabeled, pCCBReader);
+            break;
     }
 }
 
@@ -34,13 +34,79 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <pthread.h>
 #include <sqlite3.h>
+#include <deque>
+#include <string>
+#include <vector>
+#include "support/data_support/uthash.h"
+#include "LocalStorage.h"
+
+// number of values kept in memory by localStorageGetItem()
+#define LOCALSTORAGE_CACHE_SIZE 1024
 
 static int _initialized = 0;
 static sqlite3 *_db;
 static sqlite3_stmt *_stmt_select;
 static sqlite3_stmt *_stmt_remove;
 static sqlite3_stmt *_stmt_update;
+static sqlite3_stmt *_stmt_begin;
+static sqlite3_stmt *_stmt_commit;
+
+// Read-through cache of the values. Every write goes into it first, so it always
+// holds the values which are still waiting for the writer thread.
+typedef struct _localStorageCacheEntry
+{
+	char *key;
+	char *value;				// NULL if the key was removed
+	unsigned int writeSeq;		// sequence number of the last write of the key, 0 if none
+	int unwritten;				// 1 while the writer thread may not have written it, it can't be evicted
+	UT_hash_handle hh;
+} localStorageCacheEntry;
+
+// A write handed to the writer thread, to find out when its entry can be evicted again
+typedef struct _localStorageUnwrittenEntry
+{
+	localStorageCacheEntry *entry;
+	unsigned int writeSeq;
+} localStorageUnwrittenEntry;
+
+static localStorageCacheEntry *_cache = NULL;
+// the writes of the cached entries, in sequence order
+static std::deque<localStorageUnwrittenEntry> _unwrittenEntries;
+// number of cache entries marked unwritten, they don't count against LOCALSTORAGE_CACHE_SIZE
+static unsigned int _unwrittenCount = 0;
+// values replaced since the last localStorageGetItem(), which may still be in use by its caller
+static std::vector<char*> _retiredValues;
+
+// A write for the writer thread
+typedef struct _localStorageWrite
+{
+	std::string key;
+	std::string value;
+	bool remove;
+} localStorageWrite;
+
+static int _async = 0;
+static int _batchDepth = 0;
+static unsigned int _writeSeq = 0;				// last write made by the main thread
+static std::vector<localStorageWrite> _pendingWrites;	// made inside the current batch
+
+// The writer thread has its own connection; with WAL it doesn't block the reads of _db
+static sqlite3 *_writer_db;
+static sqlite3_stmt *_writer_stmt_remove;
+static sqlite3_stmt *_writer_stmt_update;
+static sqlite3_stmt *_writer_stmt_begin;
+static sqlite3_stmt *_writer_stmt_commit;
+
+static pthread_t _writerThread;
+static pthread_mutex_t _writerMutex;
+static pthread_cond_t _writerCondition;
+static pthread_cond_t _writtenCondition;
+static std::vector<localStorageWrite> _queuedWrites;	// guarded by _writerMutex
+static unsigned int _queuedSeq = 0;						// guarded by _writerMutex
+static unsigned int _writtenSeq = 0;					// guarded by _writerMutex
+static int _writerQuit = 0;
 
 
 static void localStorageLazyInit();
@@ -58,6 +124,265 @@ static void localStorageCreateTable()
 		printf("Error in CREATE TABLE\n");
 }
 
+static int localStorageStep( sqlite3_stmt *stmt )
+{
+	int ok = sqlite3_step(stmt);
+	ok |= sqlite3_reset(stmt);
+	return ok;
+}
+
+static int localStorageWriteItem( sqlite3_stmt *stmt_update, sqlite3_stmt *stmt_remove, const char *key, const char *value)
+{
+	int ok;
+	if( value ) {
+		ok = sqlite3_bind_text(stmt_update, 1, key, -1, SQLITE_TRANSIENT);
+		ok |= sqlite3_bind_text(stmt_update, 2, value, -1, SQLITE_TRANSIENT);
+		ok |= localStorageStep(stmt_update);
+	} else {
+		ok = sqlite3_bind_text(stmt_remove, 1, key, -1, SQLITE_TRANSIENT);
+		ok |= localStorageStep(stmt_remove);
+	}
+	return ok;
+}
+
+#pragma mark - cache
+
+static void localStorageCacheRetire( char *value )
+{
+	if( value )
+		_retiredValues.push_back(value);
+}
+
+// Marks the entries whose last write is done as evictable again
+static void localStorageCacheUpdateWritten( unsigned int writtenSeq )
+{
+	while( ! _unwrittenEntries.empty() && _unwrittenEntries.front().writeSeq <= writtenSeq ) {
+		const localStorageUnwrittenEntry &unwritten = _unwrittenEntries.front();
+		// otherwise a later write of the key is still queued
+		if( unwritten.entry->writeSeq == unwritten.writeSeq ) {
+			unwritten.entry->unwritten = 0;
+			_unwrittenCount--;
+		}
+		_unwrittenEntries.pop_front();
+	}
+}
+
+static void localStorageCacheEvict()
+{
+	if( _async ) {
+		pthread_mutex_lock(&_writerMutex);
+		unsigned int writtenSeq = _writtenSeq;
+		pthread_mutex_unlock(&_writerMutex);
+		localStorageCacheUpdateWritten(writtenSeq);
+	}
+
+	// The least recently used entries come first. The ones still waiting for the writer must stay,
+	// they are moved to the end so that the next evictions don't walk over them again.
+	localStorageCacheEntry *entry, *tmp;
+	HASH_ITER(hh, _cache, entry, tmp) {
+		if( HASH_COUNT(_cache) - _unwrittenCount < LOCALSTORAGE_CACHE_SIZE )
+			break;
+		if( entry->unwritten ) {
+			HASH_DEL(_cache, entry);
+			HASH_ADD_KEYPTR(hh, _cache, entry->key, strlen(entry->key), entry);
+			continue;
+		}
+
+		HASH_DEL(_cache, entry);
+		localStorageCacheRetire(entry->value);
+		free(entry->key);
+		free(entry);
+	}
+}
+
+static localStorageCacheEntry* localStorageCacheFind( const char *key )
+{
+	localStorageCacheEntry *entry = NULL;
+	HASH_FIND_STR(_cache, key, entry);
+	if( entry ) {
+		// move it to the end of the LRU order
+		HASH_DEL(_cache, entry);
+		HASH_ADD_KEYPTR(hh, _cache, entry->key, strlen(entry->key), entry);
+	}
+	return entry;
+}
+
+static localStorageCacheEntry* localStorageCacheStore( const char *key, const char *value, unsigned int writeSeq )
+{
+	localStorageCacheEntry *entry = localStorageCacheFind(key);
+	if( ! entry ) {
+		if( HASH_COUNT(_cache) - _unwrittenCount >= LOCALSTORAGE_CACHE_SIZE )
+			localStorageCacheEvict();
+
+		entry = (localStorageCacheEntry*)calloc(1, sizeof(*entry));
+		entry->key = strdup(key);
+		HASH_ADD_KEYPTR(hh, _cache, entry->key, strlen(entry->key), entry);
+	}
+
+	localStorageCacheRetire(entry->value);
+	entry->value = value ? strdup(value) : NULL;
+	if( writeSeq )
+		entry->writeSeq = writeSeq;
+	return entry;
+}
+
+static void localStorageCacheFree()
+{
+	localStorageCacheEntry *entry, *tmp;
+	HASH_ITER(hh, _cache, entry, tmp) {
+		HASH_DEL(_cache, entry);
+		free(entry->key);
+		free(entry->value);
+		free(entry);
+	}
+
+	for( size_t i = 0; i < _retiredValues.size(); i++ )
+		free(_retiredValues[i]);
+	_retiredValues.clear();
+
+	_unwrittenEntries.clear();
+	_unwrittenCount = 0;
+}
+
+#pragma mark - writer thread
+
+static void* localStorageWriterLoop( void *data )
+{
+	std::vector<localStorageWrite> writes;
+
+	pthread_mutex_lock(&_writerMutex);
+	while( true ) {
+		while( _queuedWrites.empty() && ! _writerQuit )
+			pthread_cond_wait(&_writerCondition, &_writerMutex);
+		if( _queuedWrites.empty() )
+			break;
+
+		writes.swap(_queuedWrites);
+		unsigned int seq = _queuedSeq;
+		pthread_mutex_unlock(&_writerMutex);
+
+		// everything queued meanwhile is written in one transaction, so it costs one sync
+		int ok = localStorageStep(_writer_stmt_begin);
+		for( size_t i = 0; i < writes.size(); i++ ) {
+			const localStorageWrite &write = writes[i];
+			ok |= localStorageWriteItem(_writer_stmt_update, _writer_stmt_remove, write.key.c_str(), write.remove ? NULL : write.value.c_str());
+		}
+		ok |= localStorageStep(_writer_stmt_commit);
+
+		if( ok != SQLITE_OK && ok != SQLITE_DONE)
+			printf("Error in localStorage writer thread\n");
+
+		writes.clear();
+
+		pthread_mutex_lock(&_writerMutex);
+		_writtenSeq = seq;
+		pthread_cond_broadcast(&_writtenCondition);
+	}
+	pthread_mutex_unlock(&_writerMutex);
+
+	return NULL;
+}
+
+static int localStorageStartWriter( const char *fullpath )
+{
+	if( sqlite3_open(fullpath, &_writer_db) != SQLITE_OK ) {
+		sqlite3_close(_writer_db);
+		return 0;
+	}
+	sqlite3_busy_timeout(_writer_db, 1000);
+	sqlite3_exec(_writer_db, "PRAGMA synchronous=NORMAL;", NULL, NULL, NULL);
+
+	int ret = sqlite3_prepare_v2(_writer_db, "REPLACE INTO data (key, value) VALUES (?,?);", -1, &_writer_stmt_update, NULL);
+	ret |= sqlite3_prepare_v2(_writer_db, "DELETE FROM data WHERE key=?;", -1, &_writer_stmt_remove, NULL);
+	ret |= sqlite3_prepare_v2(_writer_db, "BEGIN;", -1, &_writer_stmt_begin, NULL);
+	ret |= sqlite3_prepare_v2(_writer_db, "COMMIT;", -1, &_writer_stmt_commit, NULL);
+	if( ret != SQLITE_OK ) {
+		printf("Error initializing the localStorage writer, writing synchronously\n");
+		sqlite3_finalize(_writer_stmt_update);
+		sqlite3_finalize(_writer_stmt_remove);
+		sqlite3_finalize(_writer_stmt_begin);
+		sqlite3_finalize(_writer_stmt_commit);
+		sqlite3_close(_writer_db);
+		return 0;
+	}
+
+	pthread_mutex_init(&_writerMutex, NULL);
+	pthread_cond_init(&_writerCondition, NULL);
+	pthread_cond_init(&_writtenCondition, NULL);
+	_writerQuit = 0;
+	_queuedSeq = _writtenSeq = _writeSeq;
+	pthread_create(&_writerThread, NULL, localStorageWriterLoop, NULL);
+	return 1;
+}
+
+static void localStorageStopWriter()
+{
+	pthread_mutex_lock(&_writerMutex);
+	_writerQuit = 1;
+	pthread_cond_signal(&_writerCondition);
+	pthread_mutex_unlock(&_writerMutex);
+
+	pthread_join(_writerThread, NULL);
+	pthread_cond_destroy(&_writtenCondition);
+	pthread_cond_destroy(&_writerCondition);
+	pthread_mutex_destroy(&_writerMutex);
+
+	sqlite3_finalize(_writer_stmt_update);
+	sqlite3_finalize(_writer_stmt_remove);
+	sqlite3_finalize(_writer_stmt_begin);
+	sqlite3_finalize(_writer_stmt_commit);
+	sqlite3_close(_writer_db);
+}
+
+// Hands the writes of the finished batch over to the writer thread
+static void localStorageSubmitWrites()
+{
+	if( _pendingWrites.empty() )
+		return;
+
+	pthread_mutex_lock(&_writerMutex);
+	_queuedWrites.insert(_queuedWrites.end(), _pendingWrites.begin(), _pendingWrites.end());
+	_queuedSeq = _writeSeq;
+	unsigned int writtenSeq = _writtenSeq;
+	pthread_cond_signal(&_writerCondition);
+	pthread_mutex_unlock(&_writerMutex);
+
+	_pendingWrites.clear();
+
+	// keeps _unwrittenEntries short even when the cache never fills up
+	localStorageCacheUpdateWritten(writtenSeq);
+}
+
+static void localStorageQueueWrite( const char *key, const char *value )
+{
+	localStorageCacheEntry *entry = localStorageCacheStore(key, value, ++_writeSeq);
+
+	if( _async ) {
+		if( ! entry->unwritten ) {
+			entry->unwritten = 1;
+			_unwrittenCount++;
+		}
+		localStorageUnwrittenEntry unwritten = { entry, _writeSeq };
+		_unwrittenEntries.push_back(unwritten);
+
+		_pendingWrites.push_back(localStorageWrite());
+		localStorageWrite &write = _pendingWrites.back();
+		write.key = key;
+		write.remove = (value == NULL);
+		if( value )
+			write.value = value;
+
+		if( _batchDepth == 0 )
+			localStorageSubmitWrites();
+	} else {
+		int ok = localStorageWriteItem(_stmt_update, _stmt_remove, key, value);
+		if( ok != SQLITE_OK && ok != SQLITE_DONE)
+			printf("Error in localStorage.%s()\n", value ? "setItem" : "removeItem");
+	}
+}
+
+#pragma mark - API
+
 void localStorageInit( const char *fullpath)
 {
 	if( ! _initialized ) {
@@ -69,6 +394,14 @@ void localStorageInit( const char *fullpath)
 		else
 			ret = sqlite3_open(fullpath, &_db);
 
+		if (fullpath) {
+			// WAL lets the writer thread commit while this connection reads, and a
+			// commit only needs to sync the log
+			sqlite3_exec(_db, "PRAGMA journal_mode=WAL;", NULL, NULL, NULL);
+			sqlite3_exec(_db, "PRAGMA synchronous=NORMAL;", NULL, NULL, NULL);
+			sqlite3_busy_timeout(_db, 1000);
+		}
+
 		localStorageCreateTable();
 
 		// SELECT
@@ -83,10 +416,17 @@ void localStorageInit( const char *fullpath)
 		const char *sql_remove = "DELETE FROM data WHERE key=?;";
 		ret |= sqlite3_prepare_v2(_db, sql_remove, -1, &_stmt_remove, NULL);
 
+		// BEGIN / COMMIT
+		ret |= sqlite3_prepare_v2(_db, "BEGIN;", -1, &_stmt_begin, NULL);
+		ret |= sqlite3_prepare_v2(_db, "COMMIT;", -1, &_stmt_commit, NULL);
+
 		if( ret != SQLITE_OK ) {
 			printf("Error initializing DB\n");
 			// report error
 		}
+
+		// an in-memory DB can't be shared with a second connection, it is written synchronously
+		_async = fullpath ? localStorageStartWriter(fullpath) : 0;
 		
 		_initialized = 1;
 	}
@@ -95,11 +435,27 @@ void localStorageInit( const char *fullpath)
 void localStorageFree()
 {
 	if( _initialized ) {
+		if( _batchDepth > 0 ) {
+			printf("localStorageFree() called inside a batch, committing it\n");
+			_batchDepth = 1;
+			localStorageCommitBatch();
+		}
+
+		if( _async ) {
+			localStorageFlush();
+			localStorageStopWriter();
+			_async = 0;
+		}
+
 		sqlite3_finalize(_stmt_select);
 		sqlite3_finalize(_stmt_remove);
 		sqlite3_finalize(_stmt_update);		
+		sqlite3_finalize(_stmt_begin);
+		sqlite3_finalize(_stmt_commit);
 
 		sqlite3_close(_db);
+
+		localStorageCacheFree();
 		
 		_initialized = 0;
 	}
@@ -109,16 +465,8 @@ void localStorageFree()
 void localStorageSetItem( const char *key, const char *value)
 {
 	assert( _initialized );
-	
-	int ok = sqlite3_bind_text(_stmt_update, 1, key, -1, SQLITE_TRANSIENT);
-	ok |= sqlite3_bind_text(_stmt_update, 2, value, -1, SQLITE_TRANSIENT);
 
-	ok |= sqlite3_step(_stmt_update);
-	
-	ok |= sqlite3_reset(_stmt_update);
-	
-	if( ok != SQLITE_OK && ok != SQLITE_DONE)
-		printf("Error in localStorage.setItem()\n");
+	localStorageQueueWrite(key, value);
 }
 
 /** gets an item from the LS */
@@ -126,6 +474,14 @@ const char* localStorageGetItem( const char *key )
 {
 	assert( _initialized );
 
+	for( size_t i = 0; i < _retiredValues.size(); i++ )
+		free(_retiredValues[i]);
+	_retiredValues.clear();
+
+	localStorageCacheEntry *entry = localStorageCacheFind(key);
+	if( entry )
+		return entry->value;
+
 	int ok = sqlite3_reset(_stmt_select);
 
 	ok |= sqlite3_bind_text(_stmt_select, 1, key, -1, SQLITE_TRANSIENT);
@@ -136,7 +492,11 @@ const char* localStorageGetItem( const char *key )
 	if( ok != SQLITE_OK && ok != SQLITE_DONE && ok != SQLITE_ROW)
 		printf("Error in localStorage.getItem()\n");
 
-	return (const char*)ret;
+	// misses are cached as well, as NULL values
+	entry = localStorageCacheStore(key, (const char*)ret, 0);
+	sqlite3_reset(_stmt_select);
+
+	return entry->value;
 }
 
 /** removes an item from the LS */
@@ -144,14 +504,45 @@ void localStorageRemoveItem( const char *key )
 {
 	assert( _initialized );
 
-	int ok = sqlite3_bind_text(_stmt_remove, 1, key, -1, SQLITE_TRANSIENT);
-	
-	ok |= sqlite3_step(_stmt_remove);
-	
-	ok |= sqlite3_reset(_stmt_remove);
+	localStorageQueueWrite(key, NULL);
+}
 
-	if( ok != SQLITE_OK && ok != SQLITE_DONE)
-		printf("Error in localStorage.removeItem()\n");
+void localStorageBeginBatch()
+{
+	assert( _initialized );
+
+	if( _batchDepth++ == 0 && ! _async ) {
+		int ok = localStorageStep(_stmt_begin);
+		if( ok != SQLITE_OK && ok != SQLITE_DONE)
+			printf("Error in localStorageBeginBatch()\n");
+	}
+}
+
+void localStorageCommitBatch()
+{
+	assert( _initialized && _batchDepth > 0 );
+
+	if( --_batchDepth == 0 ) {
+		if( _async ) {
+			localStorageSubmitWrites();
+		} else {
+			int ok = localStorageStep(_stmt_commit);
+			if( ok != SQLITE_OK && ok != SQLITE_DONE)
+				printf("Error in localStorageCommitBatch()\n");
+		}
+	}
+}
+
+void localStorageFlush()
+{
+	assert( _initialized );
+
+	if( _async ) {
+		pthread_mutex_lock(&_writerMutex);
+		while( _writtenSeq != _queuedSeq )
+			pthread_cond_wait(&_writtenCondition, &_writerMutex);
+		pthread_mutex_unlock(&_writerMutex);
+	}
 }
 
 #endif // #if (CC_TARGET_PLATFORM != CC_PLATFORM_ANDROID)
@@ -48,4 +48,18 @@ const char* localStorageGetItem( const char *key );
 /** removes an item from the LS */
 void localStorageRemoveItem( const char *key );
 
+/** Starts a batch. The writes made until the matching localStorageCommitBatch() are stored
+ in a single transaction. Batches may be nested, only the outermost one is committed.
+ */
+void localStorageBeginBatch();
+
+/** Ends a batch started by localStorageBeginBatch() */
+void localStorageCommitBatch();
+
+/** Waits until the writes made outside of a batch, and those of the committed batches, are
+ stored in the DB. With a file DB they are written by a background thread; call it before
+ the DB file is read by other means.
+ */
+void localStorageFlush();
+
 #endif // __JSB_LOCALSTORAGE_H
@@ -141,4 +141,20 @@ void localStorageRemoveItem( const char *key )
 
 }
 
+// Cocos2dxLocalStorage writes synchronously on the Java side, there is nothing to batch or flush
+void localStorageBeginBatch()
+{
+	assert( _initialized );
+}
+
+void localStorageCommitBatch()
+{
+	assert( _initialized );
+}
+
+void localStorageFlush()
+{
+	assert( _initialized );
+}
+
 #endif // #if (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID)
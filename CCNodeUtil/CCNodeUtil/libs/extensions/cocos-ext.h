@@ -6,6 +6,7 @@
 #include "CCBReader/CCBFileLoader.h"
 #include "CCBReader/CCBMemberVariableAssigner.h"
 #include "CCBReader/CCBReader.h"
+#include "CCBReader/CCBPrototypeCache.h"
 #include "CCBReader/CCBSelectorResolver.h"
 #include "CCBReader/CCControlButtonLoader.h"
 #include "CCBReader/CCControlLoader.h"
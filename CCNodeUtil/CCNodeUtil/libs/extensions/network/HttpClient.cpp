@@ -26,46 +26,60 @@
 #include "HttpClient.h"
 // #include "platform/CCThread.h"
 
-#include <queue>
+#include <vector>
+#include <algorithm>
 #include <pthread.h>
-#include <semaphore.h>
+#include <unistd.h>
 #include <errno.h>
 
 #include "curl/curl.h"
 
 NS_CC_EXT_BEGIN
 
-static pthread_t        s_networkThread;
-static pthread_mutex_t  s_requestQueueMutex;
-static pthread_mutex_t  s_responseQueueMutex;
-static sem_t *          s_pSem = NULL;
-static unsigned long    s_asyncRequestCount = 0;
-
-#if CC_TARGET_PLATFORM == CC_PLATFORM_IOS
-#define CC_ASYNC_HTTPREQUEST_USE_NAMED_SEMAPHORE 1
-#else
-#define CC_ASYNC_HTTPREQUEST_USE_NAMED_SEMAPHORE 0
-#endif
+// number of responses a network thread may hand over before the main thread picks them up
+#define CC_HTTP_RESPONSE_QUEUE_SIZE 64
 
-#if CC_ASYNC_HTTPREQUEST_USE_NAMED_SEMAPHORE
-#define CC_ASYNC_HTTPREQUEST_SEMAPHORE "ccHttpAsync"
-#else
-static sem_t s_sem;
-#endif
+// A queued request. The response is created by send() on the main thread, so the
+// network threads never touch a reference count.
+typedef struct _ccHttpTask
+{
+    CCHttpResponse  *response;
+    int             priority;
+    unsigned int    order;          // send() order, breaks ties between equal priorities
+} tCCHttpTask;
+
+typedef struct _ccHttpWorker
+{
+    pthread_t       thread;
+    CURL            *curl;          // kept between requests, so its connections are reused
+    char            errorBuffer[CURL_ERROR_SIZE];
+
+    // Finished responses. The network thread is the only producer and the main thread
+    // the only consumer, so the ring needs no lock.
+    CCHttpResponse  *responses[CC_HTTP_RESPONSE_QUEUE_SIZE];
+    volatile unsigned int responseHead;     // next slot read by the main thread
+    volatile unsigned int responseTail;     // next slot written by the network thread
+    // finished while quitting with the ring full, released by the main thread once the thread is joined
+    CCHttpResponse  *unqueuedResponse;
+} tCCHttpWorker;
+
+static tCCHttpWorker    *s_pWorkers = NULL;
+static unsigned int     s_uWorkerCount = 0;
+
+static pthread_mutex_t  s_requestQueueMutex;
+static pthread_cond_t   s_requestQueueCondition;
+static std::vector<tCCHttpTask> s_requestQueue;     // binary heap, guarded by s_requestQueueMutex
+static unsigned int     s_uRequestOrder = 0;
+static unsigned long    s_asyncRequestCount = 0;    // sent and not dispatched nor cancelled yet
 
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32)
 typedef int int32_t;
 #endif
 
-static bool need_quit = false;
-
-static CCArray* s_requestQueue = NULL;
-static CCArray* s_responseQueue = NULL;
+static volatile bool need_quit = false;
 
 static CCHttpClient *s_pHttpClient = NULL; // pointer to singleton
 
-static char s_errorBuffer[CURL_ERROR_SIZE];
-
 typedef size_t (*write_callback)(void *ptr, size_t size, size_t nmemb, void *stream);
 
 
@@ -82,58 +96,56 @@ size_t writeData(void *ptr, size_t size, size_t nmemb, void *stream)
     return sizes;
 }
 
+// Callback function used by libcurl to abort cancelled transfers
+static int progressData(void *clientp, double dltotal, double dlnow, double ultotal, double ulnow)
+{
+    CCHttpResponse *response = (CCHttpResponse*)clientp;
+    return (need_quit || response->isCancelled()) ? 1 : 0;
+}
+
+// Orders the request heap: the highest priority first, then the oldest
+static bool taskLess(const tCCHttpTask& a, const tCCHttpTask& b)
+{
+    if (a.priority != b.priority)
+    {
+        return a.priority < b.priority;
+    }
+    return (int)(a.order - b.order) > 0;
+}
+
 // Prototypes
-bool configureCURL(CURL *handle);
-int processGetTask(CCHttpRequest *request, write_callback callback, void *stream, int32_t *errorCode);
-int processPostTask(CCHttpRequest *request, write_callback callback, void *stream, int32_t *errorCode);
+bool configureCURL(CURL *handle, char *errorBuffer);
+int processGetTask(CURL *curl, char *errorBuffer, CCHttpResponse *response, write_callback callback, void *stream, int32_t *errorCode);
+int processPostTask(CURL *curl, char *errorBuffer, CCHttpResponse *response, write_callback callback, void *stream, int32_t *errorCode);
 // int processDownloadTask(HttpRequest *task, write_callback callback, void *stream, int32_t *errorCode);
 
 
 // Worker thread
 static void* networkThread(void *data)
 {    
-    CCHttpRequest *request = NULL;
+    tCCHttpWorker *worker = (tCCHttpWorker*)data;
     
     while (true) 
     {
-        // Wait for http request tasks from main thread
-        int semWaitRet = sem_wait(s_pSem);
-        if (semWaitRet < 0) {
-            CCLog("HttpRequest async thread semaphore error: %s\n", strerror(errno));
-            break;
+        // step 1: wait for the most urgent http request from main thread
+        pthread_mutex_lock(&s_requestQueueMutex);
+        while (s_requestQueue.empty() && !need_quit)
+        {
+            pthread_cond_wait(&s_requestQueueCondition, &s_requestQueueMutex);
         }
-        
         if (need_quit)
         {
+            pthread_mutex_unlock(&s_requestQueueMutex);
             break;
         }
         
-        // step 1: send http request if the requestQueue isn't empty
-        request = NULL;
-        
-        pthread_mutex_lock(&s_requestQueueMutex); //Get request task from queue
-        if (0 != s_requestQueue->count())
-        {
-            request = dynamic_cast<CCHttpRequest*>(s_requestQueue->objectAtIndex(0));
-            s_requestQueue->removeObjectAtIndex(0);  
-            // request's refcount = 1 here
-        }
+        std::pop_heap(s_requestQueue.begin(), s_requestQueue.end(), taskLess);
+        CCHttpResponse *response = s_requestQueue.back().response;
+        s_requestQueue.pop_back();
         pthread_mutex_unlock(&s_requestQueueMutex);
         
-        if (NULL == request)
-        {
-            continue;
-        }
-        
         // step 2: libcurl sync access
-        
-        // Create a HttpResponse object, the default setting is http access failed
-        CCHttpResponse *response = new CCHttpResponse(request);
-        
-        // request's refcount = 2 here, it's retained by HttpRespose constructor
-        request->release();
-        // ok, refcount = 1 now, only HttpResponse hold it.
-        
+        CCHttpRequest *request = response->getHttpRequest();
         int responseCode = -1;
         int retValue = 0;
 
@@ -141,14 +153,18 @@ static void* networkThread(void *data)
         switch (request->getRequestType())
         {
             case CCHttpRequest::kHttpGet: // HTTP GET
-                retValue = processGetTask(request, 
+                retValue = processGetTask(worker->curl,
+                                          worker->errorBuffer,
+                                          response, 
                                           writeData, 
                                           response->getResponseData(), 
                                           &responseCode);
                 break;
             
             case CCHttpRequest::kHttpPost: // HTTP POST
-                retValue = processPostTask(request, 
+                retValue = processPostTask(worker->curl,
+                                           worker->errorBuffer,
+                                           response, 
                                            writeData, 
                                            response->getResponseData(), 
                                            &responseCode);
@@ -165,7 +181,7 @@ static void* networkThread(void *data)
         if (retValue != 0) 
         {
             response->setSucceed(false);
-            response->setErrorBuffer(s_errorBuffer);
+            response->setErrorBuffer(worker->errorBuffer);
         }
         else
         {
@@ -173,52 +189,38 @@ static void* networkThread(void *data)
         }
 
         
-        // add response packet into queue
-        pthread_mutex_lock(&s_responseQueueMutex);
-        s_responseQueue->addObject(response);
-        pthread_mutex_unlock(&s_responseQueueMutex);
-        
-        // resume dispatcher selector
-        CCDirector::sharedDirector()->getScheduler()->resumeTarget(CCHttpClient::getInstance());
-    }
-    
-    // cleanup: if worker thread received quit signal, clean up un-completed request queue
-    pthread_mutex_lock(&s_requestQueueMutex);
-    s_requestQueue->removeAllObjects();
-    pthread_mutex_unlock(&s_requestQueueMutex);
-    s_asyncRequestCount -= s_requestQueue->count();
-    
-    if (s_pSem != NULL) {
-#if CC_ASYNC_HTTPREQUEST_USE_NAMED_SEMAPHORE
-        sem_unlink(CC_ASYNC_HTTPREQUEST_SEMAPHORE);
-        sem_close(s_pSem);
-#else
-        sem_destroy(s_pSem);
-#endif
-        
-        s_pSem = NULL;
-        
-        pthread_mutex_destroy(&s_requestQueueMutex);
-        pthread_mutex_destroy(&s_responseQueueMutex);
-        
-        s_requestQueue->release();
-        s_responseQueue->release();
+        // step 3: hand the response over to the main thread; it drains the ring every frame,
+        // so it's only full if the main thread stalls
+        while (worker->responseTail - worker->responseHead == CC_HTTP_RESPONSE_QUEUE_SIZE && !need_quit)
+        {
+            usleep(1000);
+        }
+        if (worker->responseTail - worker->responseHead == CC_HTTP_RESPONSE_QUEUE_SIZE)
+        {
+            // quitting, the slot still holds a response the main thread hasn't dispatched
+            worker->unqueuedResponse = response;
+            break;
+        }
+        worker->responses[worker->responseTail % CC_HTTP_RESPONSE_QUEUE_SIZE] = response;
+        __sync_synchronize();
+        worker->responseTail++;
     }
-
-    pthread_exit(NULL);
     
-    return 0;
+    return NULL;
 }
 
 //Configure curl's timeout property
-bool configureCURL(CURL *handle)
+bool configureCURL(CURL *handle, char *errorBuffer)
 {
     if (!handle) {
         return false;
     }
     
+    // forget the options of the previous request; the connections and the DNS cache are kept
+    curl_easy_reset(handle);
+    
     int32_t code;
-    code = curl_easy_setopt(handle, CURLOPT_ERRORBUFFER, s_errorBuffer);
+    code = curl_easy_setopt(handle, CURLOPT_ERRORBUFFER, errorBuffer);
     if (code != CURLE_OK) {
         return false;
     }
@@ -230,25 +232,50 @@ bool configureCURL(CURL *handle)
     if (code != CURLE_OK) {
         return false;
     }
+    // signals can't be used for the timeouts of several threads
+    code = curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+    if (code != CURLE_OK) {
+        return false;
+    }
+    
+    return true;
+}
+
+//Configure the cancellation of the request
+static bool configureCancel(CURL *handle, CCHttpResponse *response)
+{
+    int32_t code;
+    code = curl_easy_setopt(handle, CURLOPT_NOPROGRESS, 0L);
+    if (code != CURLE_OK) {
+        return false;
+    }
+    code = curl_easy_setopt(handle, CURLOPT_PROGRESSFUNCTION, progressData);
+    if (code != CURLE_OK) {
+        return false;
+    }
+    code = curl_easy_setopt(handle, CURLOPT_PROGRESSDATA, response);
+    if (code != CURLE_OK) {
+        return false;
+    }
     
     return true;
 }
 
 //Process Get Request
-int processGetTask(CCHttpRequest *request, write_callback callback, void *stream, int *responseCode)
+int processGetTask(CURL *curl, char *errorBuffer, CCHttpResponse *response, write_callback callback, void *stream, int *responseCode)
 {
+    CCHttpRequest *request = response->getHttpRequest();
     CURLcode code = CURL_LAST;
-    CURL *curl = curl_easy_init();
+    /* create curl linked list */
+    struct curl_slist *cHeaders=NULL;
     
     do {
-        if (!configureCURL(curl)) 
+        if (!configureCURL(curl, errorBuffer) || !configureCancel(curl, response)) 
         {
             break;
         }
         
         /* handle custom header data */
-        /* create curl linked list */
-        struct curl_slist *cHeaders=NULL;
         /* get custom header data (if set) */
        	std::vector<std::string> headers=request->getHeaders();
       		if(!headers.empty())
@@ -295,9 +322,6 @@ int processGetTask(CCHttpRequest *request, write_callback callback, void *stream
             break;
         }
         
-        /* free the linked list for header data */
-        curl_slist_free_all(cHeaders);
-
         code = curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, responseCode); 
         if (code != CURLE_OK || *responseCode != 200) 
         {
@@ -305,27 +329,26 @@ int processGetTask(CCHttpRequest *request, write_callback callback, void *stream
         }
     } while (0);
     
-    if (curl) {
-        curl_easy_cleanup(curl);
-    }
+    /* free the linked list for header data */
+    curl_slist_free_all(cHeaders);
     
     return (code == CURLE_OK ? 0 : 1);
 }
 
 //Process POST Request
-int processPostTask(CCHttpRequest *request, write_callback callback, void *stream, int32_t *responseCode)
+int processPostTask(CURL *curl, char *errorBuffer, CCHttpResponse *response, write_callback callback, void *stream, int32_t *responseCode)
 {
+    CCHttpRequest *request = response->getHttpRequest();
     CURLcode code = CURL_LAST;
-    CURL *curl = curl_easy_init();
+    /* create curl linked list */
+    struct curl_slist *cHeaders=NULL;
     
     do {
-        if (!configureCURL(curl)) {
+        if (!configureCURL(curl, errorBuffer) || !configureCancel(curl, response)) {
             break;
         }
         
         /* handle custom header data */
-        /* create curl linked list */
-        struct curl_slist *cHeaders=NULL;
         /* get custom header data (if set) */
       		std::vector<std::string> headers=request->getHeaders();
       		if(!headers.empty())
@@ -371,17 +394,14 @@ int processPostTask(CCHttpRequest *request, write_callback callback, void *strea
             break;
         }
         
-        /* free the linked list for header data */
-        curl_slist_free_all(cHeaders);
-
         code = curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, responseCode); 
         if (code != CURLE_OK || *responseCode != 200) {
             code = CURLE_HTTP_RETURNED_ERROR;
         }
     } while (0);
-    if (curl) {
-        curl_easy_cleanup(curl);
-    }
+    
+    /* free the linked list for header data */
+    curl_slist_free_all(cHeaders);
     
     return (code == CURLE_OK ? 0 : 1);    
 }
@@ -406,6 +426,7 @@ void CCHttpClient::destroyInstance()
 CCHttpClient::CCHttpClient()
 :_timeoutForRead(60)
 ,_timeoutForConnect(30)
+,_maxConnections(4)
 {
     CCDirector::sharedDirector()->getScheduler()->scheduleSelector(
                     schedule_selector(CCHttpClient::dispatchResponseCallbacks), this, 0, false);
@@ -414,51 +435,72 @@ CCHttpClient::CCHttpClient()
 
 CCHttpClient::~CCHttpClient()
 {
-    need_quit = true;
-    
-    if (s_pSem != NULL) {
-        sem_post(s_pSem);
+    if (s_pWorkers != NULL) {
+        // in-flight transfers are aborted by progressData()
+        pthread_mutex_lock(&s_requestQueueMutex);
+        need_quit = true;
+        pthread_cond_broadcast(&s_requestQueueCondition);
+        pthread_mutex_unlock(&s_requestQueueMutex);
+        
+        for (unsigned int i = 0; i < s_uWorkerCount; i++) {
+            tCCHttpWorker *worker = &s_pWorkers[i];
+            pthread_join(worker->thread, NULL);
+            
+            // cleanup: release the responses which were never dispatched
+            while (worker->responseHead != worker->responseTail) {
+                worker->responses[worker->responseHead % CC_HTTP_RESPONSE_QUEUE_SIZE]->release();
+                worker->responseHead++;
+            }
+            CC_SAFE_RELEASE_NULL(worker->unqueuedResponse);
+            curl_easy_cleanup(worker->curl);
+        }
+        delete [] s_pWorkers;
+        s_pWorkers = NULL;
+        s_uWorkerCount = 0;
+        
+        // cleanup: release the un-completed request queue
+        for (std::vector<tCCHttpTask>::iterator it = s_requestQueue.begin(); it != s_requestQueue.end(); ++it) {
+            it->response->release();
+        }
+        s_requestQueue.clear();
+        s_asyncRequestCount = 0;
+        
+        pthread_cond_destroy(&s_requestQueueCondition);
+        pthread_mutex_destroy(&s_requestQueueMutex);
+        
+        need_quit = false;
     }
     
     s_pHttpClient = NULL;
 }
 
-//Lazy create semaphore & mutex & thread
-bool CCHttpClient::lazyInitThreadSemphore()
+//Lazy create mutex, condition & threads
+bool CCHttpClient::lazyInitThreads()
 {
-    if (s_pSem != NULL) {
+    if (s_pWorkers != NULL) {
         return true;
-    } else {
-#if CC_ASYNC_HTTPREQUEST_USE_NAMED_SEMAPHORE
-        s_pSem = sem_open(CC_ASYNC_HTTPREQUEST_SEMAPHORE, O_CREAT, 0644, 0);
-        if (s_pSem == SEM_FAILED) {
-            CCLog("Open HttpRequest Semaphore failed");
-            s_pSem = NULL;
-            return false;
-        }
-#else
-        int semRet = sem_init(&s_sem, 0, 0);
-        if (semRet < 0) {
-            CCLog("Init HttpRequest Semaphore failed");
-            return false;
-        }
-        
-        s_pSem = &s_sem;
-#endif
-        
-        s_requestQueue = new CCArray();
-        s_requestQueue->init();
-        
-        s_responseQueue = new CCArray();
-        s_responseQueue->init();
-        
-        pthread_mutex_init(&s_requestQueueMutex, NULL);
-        pthread_mutex_init(&s_responseQueueMutex, NULL);
-        
-        pthread_create(&s_networkThread, NULL, networkThread, NULL);
-        pthread_detach(s_networkThread);
-        
-        need_quit = false;
+    }
+    
+    // curl_easy_init() would do it lazily, but it isn't thread safe
+    if (curl_global_init(CURL_GLOBAL_ALL) != CURLE_OK) {
+        CCLog("Init HttpRequest curl failed");
+        return false;
+    }
+    
+    pthread_mutex_init(&s_requestQueueMutex, NULL);
+    pthread_cond_init(&s_requestQueueCondition, NULL);
+    need_quit = false;
+    
+    s_uWorkerCount = _maxConnections;
+    s_pWorkers = new tCCHttpWorker[s_uWorkerCount];
+    for (unsigned int i = 0; i < s_uWorkerCount; i++) {
+        tCCHttpWorker *worker = &s_pWorkers[i];
+        worker->curl = curl_easy_init();
+        worker->errorBuffer[0] = '\0';
+        worker->responseHead = 0;
+        worker->responseTail = 0;
+        worker->unqueuedResponse = NULL;
+        pthread_create(&worker->thread, NULL, networkThread, worker);
     }
     
     return true;
@@ -467,7 +509,7 @@ bool CCHttpClient::lazyInitThreadSemphore()
 //Add a get task to queue
 void CCHttpClient::send(CCHttpRequest* request)
 {    
-    if (false == lazyInitThreadSemphore()) 
+    if (false == lazyInitThreads()) 
     {
         return;
     }
@@ -477,47 +519,100 @@ void CCHttpClient::send(CCHttpRequest* request)
         return;
     }
         
-    ++s_asyncRequestCount;
+    if (0 == s_asyncRequestCount++)
+    {
+        CCDirector::sharedDirector()->getScheduler()->resumeTarget(this);
+    }
     
-    request->retain();
+    // the response holds the request until it has been dispatched
+    tCCHttpTask task;
+    task.response = new CCHttpResponse(request);
+    // a previous send of the request may still be in flight, cancelled or not
+    task.response->_sendNumber = ++request->_sendCount;
+    task.priority = request->getPriority();
+    task.order = s_uRequestOrder++;
         
     pthread_mutex_lock(&s_requestQueueMutex);
-    s_requestQueue->addObject(request);
+    s_requestQueue.push_back(task);
+    std::push_heap(s_requestQueue.begin(), s_requestQueue.end(), taskLess);
+    pthread_cond_signal(&s_requestQueueCondition);
     pthread_mutex_unlock(&s_requestQueueMutex);
-    
-    // Notify thread start to work
-    sem_post(s_pSem);
 }
 
-// Poll and notify main thread if responses exists in queue
-void CCHttpClient::dispatchResponseCallbacks(float delta)
+void CCHttpClient::cancel(CCHttpRequest* request)
 {
-    // CCLog("CCHttpClient::dispatchResponseCallbacks is running");
+    if (!request || s_pWorkers == NULL)
+    {
+        return;
+    }
     
-    CCHttpResponse* response = NULL;
+    // the sends of the request so far are aborted by progressData() if in flight,
+    // and skipped by dispatchResponseCallbacks() if already done
+    request->_cancelledSendCount = request->_sendCount;
     
-    pthread_mutex_lock(&s_responseQueueMutex);
-    if (s_responseQueue->count())
+    std::vector<CCHttpResponse*> cancelled;
+    
+    pthread_mutex_lock(&s_requestQueueMutex);
+    for (unsigned int i = 0; i < s_requestQueue.size(); )
+    {
+        if (s_requestQueue[i].response->getHttpRequest() == request)
+        {
+            cancelled.push_back(s_requestQueue[i].response);
+            s_requestQueue[i] = s_requestQueue.back();
+            s_requestQueue.pop_back();
+        }
+        else
+        {
+            ++i;
+        }
+    }
+    if (! cancelled.empty())
     {
-        response = dynamic_cast<CCHttpResponse*>(s_responseQueue->objectAtIndex(0));
-        s_responseQueue->removeObjectAtIndex(0);
+        std::make_heap(s_requestQueue.begin(), s_requestQueue.end(), taskLess);
     }
-    pthread_mutex_unlock(&s_responseQueueMutex);
+    pthread_mutex_unlock(&s_requestQueueMutex);
     
-    if (response)
+    for (unsigned int i = 0; i < cancelled.size(); i++)
     {
-        --s_asyncRequestCount;
-        
-        CCHttpRequest *request = response->getHttpRequest();
-        CCObject *pTarget = request->getTarget();
-        SEL_CallFuncND pSelector = request->getSelector();
+        cancelled[i]->release();
+    }
+    
+    s_asyncRequestCount -= cancelled.size();
+    if (0 == s_asyncRequestCount) 
+    {
+        CCDirector::sharedDirector()->getScheduler()->pauseTarget(this);
+    }
+}
 
-        if (pTarget && pSelector) 
+// Poll and notify main thread if responses exists in queue
+void CCHttpClient::dispatchResponseCallbacks(float delta)
+{
+    // CCLog("CCHttpClient::dispatchResponseCallbacks is running");
+    
+    for (unsigned int i = 0; i < s_uWorkerCount; i++)
+    {
+        tCCHttpWorker *worker = &s_pWorkers[i];
+        
+        while (worker->responseHead != worker->responseTail)
         {
-            (pTarget->*pSelector)((CCNode *)this, response);
+            __sync_synchronize();
+            CCHttpResponse *response = worker->responses[worker->responseHead % CC_HTTP_RESPONSE_QUEUE_SIZE];
+            __sync_synchronize();
+            worker->responseHead++;
+            
+            --s_asyncRequestCount;
+            
+            CCHttpRequest *request = response->getHttpRequest();
+            CCObject *pTarget = request->getTarget();
+            SEL_CallFuncND pSelector = request->getSelector();
+
+            if (pTarget && pSelector && !response->isCancelled()) 
+            {
+                (pTarget->*pSelector)((CCNode *)this, response);
+            }
+            
+            response->release();
         }
-        
-        response->release();
     }
     
     if (0 == s_asyncRequestCount) 
@@ -528,5 +623,3 @@ void CCHttpClient::dispatchResponseCallbacks(float delta)
 }
 
 NS_CC_EXT_END
-
-
@@ -42,6 +42,9 @@ NS_CC_EXT_BEGIN
 
 /** @brief Singleton that handles asynchrounous http requests
  * Once the request completed, a callback will issued in main thread when it provided during make request
+ *
+ * The requests are performed by a pool of network threads. Every thread keeps its curl handle,
+ * so consecutive requests to the same host reuse the connection.
  */
 class CCHttpClient : public CCObject
 {
@@ -59,6 +62,14 @@ public:
      * @return NULL
      */
     void send(CCHttpRequest* request);
+
+    /**
+     * Cancel a request sent by send(). A queued request is dropped, a request in flight is aborted.
+     * Either way its response callback isn't called.
+     * @param request the request to cancel
+     * @return NULL
+     */
+    void cancel(CCHttpRequest* request);
   
     
     /**
@@ -89,6 +100,20 @@ public:
      * @return int
      */
     inline int getTimeoutForRead() {return _timeoutForRead;};
+
+    /**
+     * Change the number of network threads, i.e. the number of requests performed at the same time.
+     * Only effective before the first request is sent. Default is 4.
+     * @param value
+     * @return NULL
+     */
+    inline void setMaxConnections(unsigned int value) {_maxConnections = value > 0 ? value : 1;};
+
+    /**
+     * Get the number of network threads
+     * @return unsigned int
+     */
+    inline unsigned int getMaxConnections() {return _maxConnections;};
         
 private:
     CCHttpClient();
@@ -96,16 +121,17 @@ private:
     bool init(void);
     
     /**
-     * Init pthread mutex, semaphore, and create new thread for http requests
+     * Init pthread mutex, condition, and create the network threads for http requests
      * @return bool
      */
-    bool lazyInitThreadSemphore();
+    bool lazyInitThreads();
     /** Poll function called from main thread to dispatch callbacks when http requests finished **/
     void dispatchResponseCallbacks(float delta);
     
 private:
     int _timeoutForConnect;
     int _timeoutForRead;
+    unsigned int _maxConnections;
     
     // std::string reqId;
 };
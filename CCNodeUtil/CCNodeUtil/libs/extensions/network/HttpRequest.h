@@ -61,6 +61,9 @@ public:
         _pTarget = NULL;
         _pSelector = NULL;
         _pUserData = NULL;
+        _priority = 0;
+        _sendCount = 0;
+        _cancelledSendCount = 0;
     };
     
     /** Destructor */
@@ -188,6 +191,18 @@ public:
    		return _headers;
    	}
 
+    /** Option field. Queued requests with a higher priority are sent first,
+        those with the same priority in the order they were sent. Default is 0.
+     */
+    inline void setPriority(int priority)
+    {
+        _priority = priority;
+    }
+    /** Get the priority back */
+    inline int getPriority()
+    {
+        return _priority;
+    }
 
 protected:
     // properties
@@ -199,6 +214,12 @@ protected:
     SEL_CallFuncND     _pSelector;      /// callback function, e.g. MyLayer::onHttpResponse(CCObject *sender, void *data)
     void*                       _pUserData;      /// You can add your customed data here 
     std::vector<std::string>    _headers;		      /// custom http headers
+    int                         _priority;       /// requests with a higher priority are sent first
+    unsigned int                _sendCount;      /// number of CCHttpClient::send() calls, main thread only
+    volatile unsigned int       _cancelledSendCount; /// the sends up to this one are cancelled, read by the network threads
+
+    friend class CCHttpClient;
+    friend class CCHttpResponse;
 };
 
 NS_CC_EXT_END
@@ -53,6 +53,7 @@ public:
         _succeed = false;
         _responseData.clear();
         _errorBuffer.clear();
+        _sendNumber = 0;
     }
     
     /** Destructor, it will be called in CCHttpClient internal,
@@ -113,6 +114,14 @@ public:
     {
         return _errorBuffer.c_str();
     }
+
+    /** Returns true once the send() which created this response has been cancelled by CCHttpClient::cancel().
+        Sending the request again doesn't bring it back.
+     */
+    inline bool isCancelled()
+    {
+        return _pHttpRequest && _sendNumber <= _pHttpRequest->_cancelledSendCount;
+    }
     
     // setters, will be called by CCHttpClient
     // users should avoid invoking these methods
@@ -157,11 +166,13 @@ protected:
     
     // properties
     CCHttpRequest*        _pHttpRequest;  /// the corresponding HttpRequest pointer who leads to this response 
+    unsigned int        _sendNumber;    /// which send() of the request this response belongs to, set by CCHttpClient
     bool                _succeed;       /// to indecate if the http reqeust is successful simply
     std::vector<char>   _responseData;  /// the returned raw data. You can also dump it as a string
     int                 _responseCode;    /// the status code returned from libcurl, e.g. 200, 404
     std::string         _errorBuffer;   /// if _responseCode != 200, please read _errorBuffer to find the reason 
-    
+
+    friend class CCHttpClient;
 };
 
 NS_CC_EXT_END
@@ -0,0 +1,154 @@
+#!/usr/bin/env python
+"""Converts a sprite sheet plist into a .ccframes index (see libs/cocos2dx/sprite_nodes/CCSpriteFrameCache.cpp).
+
+usage: ccframes.py <input.plist> [<output.ccframes>]
+
+The output defaults to the input with its .plist suffix replaced by .ccframes. Load it with
+CCSpriteFrameCache::addSpriteFramesWithFile() in place of the plist; the texture is found the same way.
+Rects and source sizes are stored as 16 bits integers, so they must be whole numbers of points.
+"""
+
+import os
+import plistlib
+import re
+import struct
+import sys
+
+VERSION = 1
+HEADER_SIZE = 32
+FRAME_SIZE = 32
+ALIAS_SIZE = 16
+FLAG_ROTATED = 0x1
+
+
+def fnv1a(data):
+    h = 2166136261
+    for b in bytearray(data):
+        h = ((h ^ b) * 16777619) & 0xffffffff
+    return h
+
+
+def numbers(text):
+    """Parses the numbers of a '{{x,y},{w,h}}' like string, as CCRectFromString and friends do."""
+    return [float(n) for n in re.findall(r'[-+]?[0-9]*\.?[0-9]+(?:[eE][-+]?[0-9]+)?', text)]
+
+
+def read_plist(path):
+    with open(path, 'rb') as f:
+        if hasattr(plistlib, 'load'):
+            return plistlib.load(f)
+        return plistlib.readPlist(f)
+
+
+def to_bool(value):
+    if isinstance(value, str):
+        return value.lower() in ('true', 'yes', '1')
+    return bool(value)
+
+
+def parse_frame(name, frame, fmt):
+    """Returns (x, y, width, height, rotated, offset x, offset y, source width, source height)."""
+    if fmt == 0:
+        ow = abs(int(frame.get('originalWidth', 0)))
+        oh = abs(int(frame.get('originalHeight', 0)))
+        if not ow or not oh:
+            sys.stderr.write('ccframes: originalWidth/Height not found on %s, its anchor point will be wrong\n' % name)
+        return (float(frame['x']), float(frame['y']), float(frame['width']), float(frame['height']), False,
+                float(frame.get('offsetX', 0)), float(frame.get('offsetY', 0)), ow, oh)
+    if fmt in (1, 2):
+        x, y, w, h = numbers(frame['frame'])
+        ox, oy = numbers(frame['offset'])
+        sw, sh = numbers(frame['sourceSize'])
+        rotated = fmt == 2 and to_bool(frame.get('rotated', False))
+        return (x, y, w, h, rotated, ox, oy, sw, sh)
+    # format 3: the rect is made of the texture rect's origin and the sprite size
+    x, y = numbers(frame['textureRect'])[:2]
+    w, h = numbers(frame['spriteSize'])
+    ox, oy = numbers(frame['spriteOffset'])
+    sw, sh = numbers(frame['spriteSourceSize'])
+    return (x, y, w, h, to_bool(frame.get('textureRotated', False)), ox, oy, sw, sh)
+
+
+def to_u16(name, value):
+    if value != int(value) or not 0 <= value <= 0xffff:
+        sys.exit('ccframes: %s: %g can\'t be stored as a 16 bits integer' % (name, value))
+    return int(value)
+
+
+def build(source, output):
+    plist = read_plist(source)
+    metadata = plist.get('metadata', {})
+    fmt = int(metadata.get('format', 0))
+    if not 0 <= fmt <= 3:
+        sys.exit('ccframes: format %d is not supported' % fmt)
+
+    names = bytearray()
+
+    def add_name(text):
+        data = text.encode('utf-8')
+        offset = len(names)
+        names.extend(data + b'\0')
+        return offset, data
+
+    texture_offset, texture_name = add_name(metadata.get('textureFileName', ''))
+
+    frames = []
+    aliases = []
+    seen = set()
+    for name in sorted(plist['frames']):
+        frame = plist['frames'][name]
+        x, y, w, h, rotated, ox, oy, sw, sh = parse_frame(name, frame, fmt)
+        offset, data = add_name(name)
+        if len(data) > 0xffff:
+            sys.exit('ccframes: the frame name %s is too long' % name)
+        seen.add(data)
+        frames.append((fnv1a(data), offset, len(data), FLAG_ROTATED if rotated else 0,
+                       to_u16(name, x), to_u16(name, y), to_u16(name, w), to_u16(name, h),
+                       to_u16(name, sw), to_u16(name, sh), ox, oy))
+        if fmt == 3:
+            for alias in frame.get('aliases', []):
+                aliases.append((alias, len(frames) - 1))
+
+    alias_records = []
+    for alias, frame_number in aliases:
+        if alias.encode('utf-8') in seen:
+            sys.stderr.write('ccframes: an alias with name %s already exists\n' % alias)
+            continue
+        offset, data = add_name(alias)
+        seen.add(data)
+        alias_records.append((fnv1a(data), offset, len(data), frame_number))
+
+    # at most 50% full, so probes stay short
+    entry_count = len(frames) + len(alias_records)
+    slot_count = 1
+    while slot_count < entry_count * 2:
+        slot_count *= 2
+
+    slots = [0] * slot_count
+    for number, h in enumerate([f[0] for f in frames] + [a[0] for a in alias_records]):
+        i = h & (slot_count - 1)
+        while slots[i]:
+            i = (i + 1) & (slot_count - 1)
+        slots[i] = number + 1
+
+    names_offset = HEADER_SIZE + len(frames) * FRAME_SIZE + len(alias_records) * ALIAS_SIZE + slot_count * 4
+    with open(output, 'wb') as out:
+        out.write(struct.pack('<4sIIIIII4x', b'CCSF', VERSION, len(frames), len(alias_records), slot_count,
+                              names_offset + texture_offset, len(texture_name)))
+        for h, offset, length, flags, x, y, w, h2, sw, sh, ox, oy in frames:
+            out.write(struct.pack('<IIHHHHHHHHff', h, names_offset + offset, length, flags, x, y, w, h2, sw, sh, ox, oy))
+        for h, offset, length, frame_number in alias_records:
+            out.write(struct.pack('<IIII', h, names_offset + offset, length, frame_number))
+        out.write(struct.pack('<%dI' % slot_count, *slots))
+        out.write(bytes(names))
+
+
+def main(argv):
+    if len(argv) not in (2, 3):
+        sys.exit(__doc__)
+    output = argv[2] if len(argv) == 3 else os.path.splitext(argv[1])[0] + '.ccframes'
+    build(argv[1], output)
+
+
+if __name__ == '__main__':
+    main(sys.argv)
@@ -0,0 +1,112 @@
+#!/usr/bin/env python
+"""Builds a CCAssetPack (see libs/cocos2dx/support/CCAssetPack.h) from a resources directory.
+
+usage: ccpack.py [-z EXT[,EXT...]] <resources dir> <output.pack>
+
+Every file below the resources directory is stored under its path relative to it.
+Files whose extension is listed with -z are deflated, unless that doesn't make them smaller.
+Already compressed formats (png, jpg, pvr.ccz, ...) are better stored as is: they can then
+be read in place from the mapped pack.
+"""
+
+import os
+import struct
+import sys
+import zlib
+
+VERSION = 1
+HEADER_SIZE = 32
+SLOT_SIZE = 32
+PAGE_SIZE = 4096
+FLAG_DEFLATED = 0x1
+
+
+def fnv1a(data):
+    h = 2166136261
+    for b in bytearray(data):
+        h = ((h ^ b) * 16777619) & 0xffffffff
+    return h
+
+
+def align(offset, alignment):
+    return (offset + alignment - 1) & ~(alignment - 1)
+
+
+def collect(root):
+    files = []
+    for dirpath, dirnames, filenames in os.walk(root):
+        dirnames.sort()
+        for name in sorted(filenames):
+            if name.startswith('.'):
+                continue
+            path = os.path.join(dirpath, name)
+            files.append((os.path.relpath(path, root).replace(os.sep, '/'), path))
+    return files
+
+
+def build(root, output, deflated_exts):
+    files = collect(root)
+
+    # at most 50% full, so probes stay short
+    slot_count = 1
+    while slot_count < len(files) * 2:
+        slot_count *= 2
+
+    names = b''
+    entries = []
+    for rel, path in files:
+        name = rel.encode('utf-8')
+        with open(path, 'rb') as f:
+            data = f.read()
+        flags = 0
+        stored = data
+        if os.path.splitext(rel)[1].lstrip('.').lower() in deflated_exts:
+            packed = zlib.compress(data, 9)
+            if len(packed) < len(data):
+                stored = packed
+                flags |= FLAG_DEFLATED
+        entries.append([fnv1a(name), len(names), len(name), flags, stored, len(data)])
+        names += name
+
+    names_offset = HEADER_SIZE + slot_count * SLOT_SIZE
+    offset = align(names_offset + len(names), PAGE_SIZE)
+    for entry in entries:
+        entry.append(offset)
+        offset = align(offset + len(entry[4]), PAGE_SIZE)
+    if offset > 0xffffffff:
+        sys.exit('ccpack: packs are limited to 4GB')
+
+    slots = [None] * slot_count
+    for entry in entries:
+        i = entry[0] & (slot_count - 1)
+        while slots[i] is not None:
+            i = (i + 1) & (slot_count - 1)
+        slots[i] = entry
+
+    with open(output, 'wb') as out:
+        out.write(struct.pack('<4sIII16x', b'CCPK', VERSION, slot_count, len(entries)))
+        for slot in slots:
+            if slot is None:
+                out.write(b'\0' * SLOT_SIZE)
+            else:
+                h, name_offset, name_length, flags, stored, size, data_offset = slot
+                out.write(struct.pack('<IIIIIIII', h, names_offset + name_offset, name_length, flags,
+                                      data_offset, len(stored), size, 0))
+        out.write(names)
+        for entry in entries:
+            out.write(b'\0' * (entry[6] - out.tell()))
+            out.write(entry[4])
+
+
+def main(argv):
+    deflated_exts = set()
+    if len(argv) > 2 and argv[1] == '-z':
+        deflated_exts = set(ext.lstrip('.').lower() for ext in argv[2].split(','))
+        argv = argv[:1] + argv[3:]
+    if len(argv) != 3:
+        sys.exit(__doc__)
+    build(argv[1], argv[2], deflated_exts)
+
+
+if __name__ == '__main__':
+    main(sys.argv)
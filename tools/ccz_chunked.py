@@ -0,0 +1,51 @@
+#!/usr/bin/env python
+"""Converts a file (or a CCZ file) into a chunked CCZ file, which ZipUtils inflates in parallel.
+
+usage: ccz_chunked.py [-s CHUNK_KB] <input> <output.ccz>
+
+The layout is described next to CCZHeader in libs/cocos2dx/support/zip_support/ZipUtils.h.
+"""
+
+import struct
+import sys
+import zlib
+
+CCZ_COMPRESSION_ZLIB = 0
+CCZ_COMPRESSION_ZLIB_CHUNKED = 4
+HEADER = '>4sHHII'
+
+
+def read_input(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[:4] == b'CCZ!':
+        sig, compression, version, reserved, length = struct.unpack(HEADER, data[:16])
+        if compression != CCZ_COMPRESSION_ZLIB:
+            sys.exit('ccz_chunked: %s is already chunked or uses an unsupported compression' % path)
+        data = zlib.decompress(data[16:])
+        assert len(data) == length
+    return data
+
+
+def main(argv):
+    chunk_size = 256 * 1024
+    if len(argv) > 2 and argv[1] == '-s':
+        chunk_size = int(argv[2]) * 1024
+        argv = argv[:1] + argv[3:]
+    if len(argv) != 3 or chunk_size <= 0:
+        sys.exit(__doc__)
+
+    data = read_input(argv[1])
+    chunks = [zlib.compress(data[i:i + chunk_size], 9) for i in range(0, len(data), chunk_size)]
+
+    with open(argv[2], 'wb') as out:
+        out.write(struct.pack(HEADER, b'CCZ!', CCZ_COMPRESSION_ZLIB_CHUNKED, 2, 0, len(data)))
+        out.write(struct.pack('>II', chunk_size, len(chunks)))
+        for chunk in chunks:
+            out.write(struct.pack('>I', len(chunk)))
+        for chunk in chunks:
+            out.write(chunk)
+
+
+if __name__ == '__main__':
+    main(sys.argv)